@@ -18,6 +18,7 @@ limitations under the License.
 #include "tensorflow/c/c_api.h"
 #include "tensorflow/c/eager/c_api_internal.h"
 #include "tensorflow/c/tf_status_helper.h"
+#include "tensorflow/core/common_runtime/eager/trace_window.h"
 #include "tensorflow/core/lib/monitoring/counter.h"
 #include "tensorflow/core/lib/monitoring/gauge.h"
 #include "tensorflow/core/lib/monitoring/sampler.h"
@@ -599,3 +600,10 @@ void TFE_ContextSetExecutorForThread(TFE_Context* ctx, TFE_Executor* executor) {
 TFE_Executor* TFE_ContextGetExecutorForThread(TFE_Context* ctx) {
   return new TFE_Executor(ctx->context->Executor());
 }
+
+void TFE_ContextSetLazyTraceWindow(TFE_Context* ctx, int window_size) {
+  ctx->context->SetLazyTraceWindow(
+      window_size,
+      std::unique_ptr<tensorflow::EagerNodeWindowRunner>(
+          new tensorflow::TraceWindowRunner(ctx->context)));
+}
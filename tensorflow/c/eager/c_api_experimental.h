@@ -397,6 +397,15 @@ TF_CAPI_EXPORT extern void TFE_ContextSetExecutorForThread(TFE_Context*,
 TF_CAPI_EXPORT extern TFE_Executor* TFE_ContextGetExecutorForThread(
     TFE_Context*);
 
+// Makes the async executors of `ctx` buffer up to `window_size` pending ops,
+// and run runs of consecutive stateless ops on the same device as a single
+// traced function. The traced functions are cached and optimized with
+// Grappler. Buffered ops start running when a result is waited on, when the
+// window is full, or when an op that cannot be traced is added. A
+// `window_size` of one or less turns this off.
+TF_CAPI_EXPORT extern void TFE_ContextSetLazyTraceWindow(TFE_Context* ctx,
+                                                         int window_size);
+
 #ifdef __cplusplus
 } /* end extern "C" */
 #endif
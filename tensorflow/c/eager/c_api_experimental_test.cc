@@ -17,11 +17,15 @@ limitations under the License.
 
 #include <string.h>
 
+#include <atomic>
+#include <memory>
+
 #include "tensorflow/c/eager/c_api.h"
 #include "tensorflow/c/eager/c_api_test_util.h"
 #include "tensorflow/cc/profiler/profiler.h"
 #include "tensorflow/core/lib/monitoring/collection_registry.h"
 #include "tensorflow/core/lib/strings/str_util.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/protobuf.h"
 #include "tensorflow/core/platform/test.h"
@@ -497,5 +501,116 @@ void Executor_MatMul_CPU(bool async) {
 TEST(CAPI, Executor_MatMul_CPU) { Executor_MatMul_CPU(false); }
 TEST(CAPI, Executor_MatMul_CPUAsync) { Executor_MatMul_CPU(true); }
 
+TEST(CAPI, LazyTraceWindow_MatMul_CPU) {
+  TF_Status* status = TF_NewStatus();
+  TFE_ContextOptions* opts = TFE_NewContextOptions();
+  TFE_Context* ctx = TFE_NewContext(opts, status);
+  CHECK_EQ(TF_OK, TF_GetCode(status)) << TF_Message(status);
+  TFE_DeleteContextOptions(opts);
+
+  TFE_Executor* old_executor = TFE_ContextGetExecutorForThread(ctx);
+  TFE_Executor* executor = TFE_NewExecutor(/*is_async=*/true);
+  TFE_ContextSetExecutorForThread(ctx, executor);
+  TFE_ContextSetLazyTraceWindow(ctx, 4);
+
+  TFE_TensorHandle* m = TestMatrixTensorHandle();
+  // The second run reuses the function traced by the first one.
+  for (int run = 0; run < 2; ++run) {
+    TFE_TensorHandle* square = nullptr;
+    TFE_TensorHandle* cube = nullptr;
+    int num_retvals = 1;
+    TFE_Op* matmul = MatMulOp(ctx, m, m);
+    TFE_Execute(matmul, &square, &num_retvals, status);
+    ASSERT_EQ(TF_OK, TF_GetCode(status)) << TF_Message(status);
+    TFE_DeleteOp(matmul);
+    matmul = MatMulOp(ctx, square, m);
+    TFE_Execute(matmul, &cube, &num_retvals, status);
+    ASSERT_EQ(TF_OK, TF_GetCode(status)) << TF_Message(status);
+    TFE_DeleteOp(matmul);
+
+    TF_Tensor* t = TFE_TensorHandleResolve(cube, status);
+    ASSERT_EQ(TF_OK, TF_GetCode(status)) << TF_Message(status);
+    float product[4] = {0};
+    EXPECT_EQ(sizeof(product), TF_TensorByteSize(t));
+    memcpy(&product[0], TF_TensorData(t), TF_TensorByteSize(t));
+    TF_DeleteTensor(t);
+    EXPECT_EQ(37, product[0]);
+    EXPECT_EQ(54, product[1]);
+    EXPECT_EQ(81, product[2]);
+    EXPECT_EQ(118, product[3]);
+    TFE_DeleteTensorHandle(square);
+    TFE_DeleteTensorHandle(cube);
+  }
+  TFE_DeleteTensorHandle(m);
+
+  TFE_ContextSetExecutorForThread(ctx, old_executor);
+  TFE_ExecutorWaitForAllPendingNodes(executor, status);
+  ASSERT_EQ(TF_OK, TF_GetCode(status)) << TF_Message(status);
+  TFE_DeleteExecutor(executor);
+  TFE_DeleteExecutor(old_executor);
+  TFE_DeleteContext(ctx);
+  TF_DeleteStatus(status);
+}
+
+// Changes the window and clears the caches while the executor is running
+// windows that wait on their inputs and register the functions they trace.
+TEST(CAPI, LazyTraceWindow_ToggleWhileRunning) {
+  TF_Status* status = TF_NewStatus();
+  TFE_ContextOptions* opts = TFE_NewContextOptions();
+  TFE_Context* ctx = TFE_NewContext(opts, status);
+  CHECK_EQ(TF_OK, TF_GetCode(status)) << TF_Message(status);
+  TFE_DeleteContextOptions(opts);
+
+  TFE_Executor* old_executor = TFE_ContextGetExecutorForThread(ctx);
+  TFE_Executor* executor = TFE_NewExecutor(/*is_async=*/true);
+  TFE_ContextSetExecutorForThread(ctx, executor);
+  TFE_ContextSetLazyTraceWindow(ctx, 4);
+
+  std::atomic<bool> done(false);
+  std::unique_ptr<Thread> toggler(Env::Default()->StartThread(
+      ThreadOptions(), "toggler", [ctx, &done]() {
+        for (int i = 0; !done; ++i) {
+          TFE_ContextSetLazyTraceWindow(ctx, i % 2 == 0 ? 0 : 4);
+          TFE_ContextClearCaches(ctx);
+        }
+      }));
+
+  TFE_TensorHandle* m = TestMatrixTensorHandle();
+  for (int run = 0; run < 100; ++run) {
+    TFE_TensorHandle* square = nullptr;
+    TFE_TensorHandle* cube = nullptr;
+    int num_retvals = 1;
+    TFE_Op* matmul = MatMulOp(ctx, m, m);
+    TFE_Execute(matmul, &square, &num_retvals, status);
+    ASSERT_EQ(TF_OK, TF_GetCode(status)) << TF_Message(status);
+    TFE_DeleteOp(matmul);
+    matmul = MatMulOp(ctx, square, m);
+    TFE_Execute(matmul, &cube, &num_retvals, status);
+    ASSERT_EQ(TF_OK, TF_GetCode(status)) << TF_Message(status);
+    TFE_DeleteOp(matmul);
+
+    TF_Tensor* t = TFE_TensorHandleResolve(cube, status);
+    ASSERT_EQ(TF_OK, TF_GetCode(status)) << TF_Message(status);
+    float product[4] = {0};
+    memcpy(&product[0], TF_TensorData(t), TF_TensorByteSize(t));
+    TF_DeleteTensor(t);
+    EXPECT_EQ(37, product[0]);
+    EXPECT_EQ(118, product[3]);
+    TFE_DeleteTensorHandle(square);
+    TFE_DeleteTensorHandle(cube);
+  }
+  TFE_DeleteTensorHandle(m);
+  done = true;
+  toggler.reset();
+
+  TFE_ContextSetExecutorForThread(ctx, old_executor);
+  TFE_ExecutorWaitForAllPendingNodes(executor, status);
+  ASSERT_EQ(TF_OK, TF_GetCode(status)) << TF_Message(status);
+  TFE_DeleteExecutor(executor);
+  TFE_DeleteExecutor(old_executor);
+  TFE_DeleteContext(ctx);
+  TF_DeleteStatus(status);
+}
+
 }  // namespace
 }  // namespace tensorflow
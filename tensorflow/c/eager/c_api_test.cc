@@ -128,6 +128,43 @@ void BM_Execute_Identity(int iters, int async) {
 }
 BENCHMARK(BM_Execute_Identity)->Arg(0)->Arg(1);
 
+// Creates a new op for every call, as the Python fast path does, so that each
+// call goes through the whole eager dispatch.
+void BM_Execute_NewOp(int iters, int async) {
+  tensorflow::testing::StopTiming();
+  tensorflow::testing::SetLabel(async ? "ExecuteNewOpAsync" : "ExecuteNewOp");
+  TF_Status* status = TF_NewStatus();
+  TFE_ContextOptions* opts = TFE_NewContextOptions();
+  TFE_ContextOptionsSetAsync(opts, static_cast<unsigned char>(async));
+  TFE_Context* ctx = TFE_NewContext(opts, status);
+  CHECK_EQ(TF_OK, TF_GetCode(status)) << TF_Message(status);
+  TFE_DeleteContextOptions(opts);
+
+  TFE_TensorHandle* m = TestMatrixTensorHandle();
+  TFE_TensorHandle* retvals[1];
+  int num_retvals = 1;
+  tensorflow::testing::StartTiming();
+  for (int i = 0; i < iters; ++i) {
+    TFE_Op* identity = IdentityOp(ctx, m);
+    TFE_Execute(identity, &retvals[0], &num_retvals, status);
+    CHECK_EQ(TF_OK, TF_GetCode(status)) << TF_Message(status);
+    TFE_DeleteOp(identity);
+    TFE_DeleteTensorHandle(retvals[0]);
+  }
+  if (async) {
+    TFE_Executor* executor = TFE_ContextGetExecutorForThread(ctx);
+    TFE_ExecutorWaitForAllPendingNodes(executor, status);
+    ASSERT_EQ(TF_OK, TF_GetCode(status)) << TF_Message(status);
+    TFE_DeleteExecutor(executor);
+  }
+  tensorflow::testing::StopTiming();
+  TFE_DeleteTensorHandle(m);
+  TFE_DeleteContext(ctx);
+  CHECK_EQ(TF_OK, TF_GetCode(status)) << TF_Message(status);
+  TF_DeleteStatus(status);
+}
+BENCHMARK(BM_Execute_NewOp)->Arg(0)->Arg(1);
+
 TEST(CAPI, Context) {
   TF_Status* status = TF_NewStatus();
   TFE_ContextOptions* opts = TFE_NewContextOptions();
@@ -1034,6 +1071,42 @@ void Execute_MatMul_CPU(bool async) {
 TEST(CAPI, Execute_MatMul_CPU) { Execute_MatMul_CPU(false); }
 TEST(CAPI, Execute_MatMul_CPUAsync) { Execute_MatMul_CPU(true); }
 
+// Runs MatMul twice with the same inputs but different attrs, to check that
+// the second call is not dispatched to the kernel of the first one.
+TEST(CAPI, Execute_MatMul_CPU_DispatchCacheRespectsAttrs) {
+  TF_Status* status = TF_NewStatus();
+  TFE_ContextOptions* opts = TFE_NewContextOptions();
+  TFE_Context* ctx = TFE_NewContext(opts, status);
+  CHECK_EQ(TF_OK, TF_GetCode(status)) << TF_Message(status);
+  TFE_DeleteContextOptions(opts);
+
+  TFE_TensorHandle* m = TestMatrixTensorHandle();
+  const float expected[2][4] = {{7, 10, 15, 22}, {10, 14, 14, 20}};
+  for (int transpose_a = 0; transpose_a < 2; ++transpose_a) {
+    TFE_Op* matmul = MatMulOp(ctx, m, m);
+    TFE_OpSetAttrBool(matmul, "transpose_a", transpose_a);
+    TFE_TensorHandle* retvals[1] = {nullptr};
+    int num_retvals = 1;
+    TFE_Execute(matmul, &retvals[0], &num_retvals, status);
+    ASSERT_EQ(TF_OK, TF_GetCode(status)) << TF_Message(status);
+    TFE_DeleteOp(matmul);
+
+    TF_Tensor* t = TFE_TensorHandleResolve(retvals[0], status);
+    ASSERT_EQ(TF_OK, TF_GetCode(status)) << TF_Message(status);
+    TFE_DeleteTensorHandle(retvals[0]);
+    float product[4] = {0};
+    EXPECT_EQ(sizeof(product), TF_TensorByteSize(t));
+    memcpy(&product[0], TF_TensorData(t), TF_TensorByteSize(t));
+    TF_DeleteTensor(t);
+    for (int i = 0; i < 4; ++i) {
+      EXPECT_EQ(expected[transpose_a][i], product[i]);
+    }
+  }
+  TFE_DeleteTensorHandle(m);
+  TFE_DeleteContext(ctx);
+  TF_DeleteStatus(status);
+}
+
 void Execute_MatMul_CPU_Runtime_Error(bool async) {
   TF_Status* status = TF_NewStatus();
   TFE_ContextOptions* opts = TFE_NewContextOptions();
@@ -24,6 +24,9 @@ constexpr char kSavedModelAssetsDirectory[] = "assets";
 /// SavedModel assets.extra directory.
 constexpr char kSavedModelAssetsExtraDirectory[] = "assets.extra";
 
+/// SavedModel session warm-up requests filename, in the assets.extra directory.
+constexpr char kSavedModelWarmupRequestsFilename[] = "session_warmup_requests";
+
 /// SavedModel assets key for graph collection-def.
 constexpr char kSavedModelAssetsKey[] = "saved_model_assets";
 
@@ -15,29 +15,42 @@ limitations under the License.
 
 #include "tensorflow/cc/saved_model/loader.h"
 
+#include <algorithm>
+#include <memory>
+#include <unordered_map>
 #include <unordered_set>
+#include <utility>
 
 #include "tensorflow/cc/saved_model/constants.h"
 #include "tensorflow/cc/saved_model/reader.h"
+#include "tensorflow/cc/saved_model/warmup.h"
 #include "tensorflow/core/framework/attr_value.pb.h"
 #include "tensorflow/core/framework/function.pb.h"
 #include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/framework/op.h"
 #include "tensorflow/core/framework/op_def.pb.h"
 #include "tensorflow/core/framework/tensor.pb.h"
+#include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/graph/default_device.h"
+#include "tensorflow/core/graph/tensor_id.h"
 #include "tensorflow/core/grappler/utils.h"
+#include "tensorflow/core/lib/core/blocking_counter.h"
 #include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/notification.h"
+#include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/lib/io/path.h"
 #include "tensorflow/core/lib/monitoring/counter.h"
 #include "tensorflow/core/lib/monitoring/sampler.h"
 #include "tensorflow/core/lib/strings/str_util.h"
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/protobuf_internal.h"
 #include "tensorflow/core/protobuf/saver.pb.h"
 #include "tensorflow/core/public/session.h"
 #include "tensorflow/core/public/session_options.h"
 #include "tensorflow/core/util/tensor_bundle/naming.h"
+#include "tensorflow/core/util/tensor_bundle/tensor_bundle.h"
 
 namespace tensorflow {
 namespace {
@@ -339,14 +352,479 @@ Status GetAssetFileDefs(const MetaGraphDef& meta_graph_def,
   return Status::OK();
 }
 
+// Restores one variable: runs `targets` (the ops that assign the variable)
+// with the RestoreV2 output `feed` fed with the checkpoint tensor `key`.
+struct VariableRestore {
+  string key;
+  string feed;
+  std::vector<string> targets;
+  // The variables (or resource handles) assigned by `targets`.
+  std::vector<string> variables;
+};
+
+// Returns the names of the nodes in `nodes` from which any of `roots` is
+// reachable, including `roots`.
+std::unordered_set<string> ReverseClosure(
+    const std::unordered_map<string, const NodeDef*>& nodes,
+    const std::vector<string>& roots) {
+  std::unordered_set<string> closure;
+  std::vector<string> stack;
+  for (const string& root : roots) {
+    stack.push_back(string(ParseTensorName(root).node()));
+  }
+  while (!stack.empty()) {
+    const string name = stack.back();
+    stack.pop_back();
+    const auto it = nodes.find(name);
+    if (it == nodes.end() || !closure.insert(name).second) continue;
+    for (const string& input : it->second->input()) {
+      stack.push_back(string(ParseTensorName(input).node()));
+    }
+  }
+  return closure;
+}
+
+Status GetConstStrings(const std::unordered_map<string, const NodeDef*>& nodes,
+                       const string& input, std::vector<tstring>* values) {
+  const auto it = nodes.find(string(ParseTensorName(input).node()));
+  if (it == nodes.end() || it->second->op() != "Const") {
+    return errors::Unimplemented("Input ", input, " is not a constant");
+  }
+  const auto value_it = it->second->attr().find("value");
+  Tensor tensor;
+  if (value_it == it->second->attr().end() ||
+      !tensor.FromProto(value_it->second.tensor()) ||
+      tensor.dtype() != DT_STRING) {
+    return errors::Unimplemented("Input ", input, " is not a string constant");
+  }
+  const auto flat = tensor.flat<tstring>();
+  values->assign(flat.data(), flat.data() + flat.size());
+  return Status::OK();
+}
+
+// Splits the restore op of `graph_def` into one restore per variable. Returns
+// Unimplemented if the restore graph is not shaped like those that
+// tf.train.Saver writes for unpartitioned variables, e.g. if it restores them
+// through a function call as TF2 SavedModels do.
+Status GetVariableRestores(const GraphDef& graph_def,
+                           const string& restore_op_name,
+                           std::vector<VariableRestore>* restores) {
+  std::unordered_map<string, const NodeDef*> nodes;
+  for (const NodeDef& node : graph_def.node()) {
+    nodes[node.name()] = &node;
+  }
+  const std::unordered_set<string> closure =
+      ReverseClosure(nodes, {restore_op_name});
+  // The data consumers of the nodes of the restore graph, with the index of
+  // the output they consume.
+  std::unordered_map<string, std::vector<std::pair<string, int>>> consumers;
+  for (const string& name : closure) {
+    for (const string& input : nodes[name]->input()) {
+      const TensorId id = ParseTensorName(input);
+      if (id.index() >= 0) {
+        consumers[string(id.node())].emplace_back(name, id.index());
+      }
+    }
+  }
+
+  std::unordered_set<string> all_targets;
+  for (const string& name : closure) {
+    const NodeDef& node = *nodes[name];
+    if (node.op() == "Restore" || node.op() == "RestoreSlice") {
+      return errors::Unimplemented("V1 checkpoints are restored as a whole");
+    }
+    if (node.op() != "RestoreV2") continue;
+    if (node.input_size() != 3) {
+      return errors::Unimplemented("Unexpected inputs of ", name);
+    }
+    std::vector<tstring> keys;
+    std::vector<tstring> slices;
+    TF_RETURN_IF_ERROR(GetConstStrings(nodes, node.input(1), &keys));
+    TF_RETURN_IF_ERROR(GetConstStrings(nodes, node.input(2), &slices));
+    for (const tstring& slice : slices) {
+      if (!slice.empty()) {
+        return errors::Unimplemented(
+            "Partitioned variables are restored as a whole");
+      }
+    }
+    std::vector<VariableRestore> node_restores(keys.size());
+    for (int k = 0; k < keys.size(); ++k) {
+      node_restores[k].key = keys[k];
+      node_restores[k].feed = strings::StrCat(name, ":", k);
+    }
+    // Follow each output to the ops that feed no other op of the restore
+    // graph, which are the assignments.
+    for (const auto& consumer : consumers[name]) {
+      if (consumer.second >= keys.size()) {
+        return errors::Unimplemented("Unexpected outputs of ", name);
+      }
+      VariableRestore* restore = &node_restores[consumer.second];
+      std::vector<string> stack = {consumer.first};
+      while (!stack.empty()) {
+        const string target = stack.back();
+        stack.pop_back();
+        const auto it = consumers.find(target);
+        if (it != consumers.end()) {
+          for (const auto& next : it->second) stack.push_back(next.first);
+          continue;
+        }
+        // An op that depends on several restored tensors cannot run with only
+        // one of them fed.
+        if (!all_targets.insert(target).second) {
+          return errors::Unimplemented(target,
+                                       " depends on several restored tensors");
+        }
+        restore->targets.push_back(target);
+        const NodeDef& target_node = *nodes[target];
+        if (target_node.input_size() > 0) {
+          restore->variables.push_back(
+              string(ParseTensorName(target_node.input(0)).node()));
+        }
+      }
+    }
+    for (VariableRestore& restore : node_restores) {
+      if (!restore.targets.empty()) restores->push_back(std::move(restore));
+    }
+  }
+  if (restores->empty()) {
+    return errors::Unimplemented("No RestoreV2 op of ", restore_op_name,
+                                 " assigns a variable");
+  }
+  // Running the assignments alone would skip any other stateful op of the
+  // restore graph, such as a function call that restores more variables.
+  std::unordered_set<string> variables;
+  for (const VariableRestore& restore : *restores) {
+    variables.insert(restore.variables.begin(), restore.variables.end());
+  }
+  for (const string& name : closure) {
+    const NodeDef& node = *nodes[name];
+    if (node.op() == "RestoreV2" || all_targets.count(name) > 0 ||
+        variables.count(name) > 0) {
+      continue;
+    }
+    const OpDef* op_def = nullptr;
+    if (!OpRegistry::Global()->LookUpOpDef(node.op(), &op_def).ok()) {
+      return errors::Unimplemented(name, " calls function ", node.op());
+    }
+    if (op_def->is_stateful()) {
+      return errors::Unimplemented(name, " is a stateful ", node.op(),
+                                   " op that is not a variable assignment");
+    }
+  }
+  return Status::OK();
+}
+
+// Splits `restores` into up to `num_shards` shards of about equal size in
+// bytes.
+Status ShardVariableRestores(
+    const string& variables_path,
+    const std::vector<const VariableRestore*>& restores, int num_shards,
+    std::vector<std::vector<const VariableRestore*>>* shards) {
+  if (restores.empty()) return Status::OK();
+  BundleReader reader(Env::Default(), variables_path);
+  TF_RETURN_IF_ERROR(reader.status());
+  std::vector<std::pair<int64, const VariableRestore*>> sizes;
+  for (const VariableRestore* restore : restores) {
+    DataType dtype;
+    TensorShape shape;
+    TF_RETURN_IF_ERROR(
+        reader.LookupDtypeAndShape(restore->key, &dtype, &shape));
+    // The size of strings is not known from the index; count them as one byte.
+    const int64 element_size = dtype == DT_STRING ? 1 : DataTypeSize(dtype);
+    sizes.emplace_back(shape.num_elements() * element_size, restore);
+  }
+  // Greedily add the largest remaining variable to the smallest shard.
+  std::sort(sizes.begin(), sizes.end(),
+            [](const std::pair<int64, const VariableRestore*>& a,
+               const std::pair<int64, const VariableRestore*>& b) {
+              return a.first > b.first;
+            });
+  shards->resize(std::min<size_t>(num_shards, sizes.size()));
+  std::vector<int64> shard_sizes(shards->size(), 0);
+  for (const auto& size : sizes) {
+    const int shard =
+        std::min_element(shard_sizes.begin(), shard_sizes.end()) -
+        shard_sizes.begin();
+    shard_sizes[shard] += size.first;
+    (*shards)[shard].push_back(size.second);
+  }
+  return Status::OK();
+}
+
+// Restores shards of variables on a thread pool. Each shard reads its tensors
+// from the checkpoint as soon as it runs, and assigns them once the session is
+// set, so that reading overlaps with creating the session. Tensors are read and
+// assigned in batches of about `max_batch_bytes`, which bounds the memory that
+// each shard holds.
+class ShardedRestore : public SavedModelBackgroundRestore {
+ public:
+  ShardedRestore(const RunOptions& run_options, const string& variables_path,
+                 std::vector<VariableRestore> restores, int num_threads,
+                 int64 max_batch_bytes)
+      : run_options_(run_options),
+        variables_path_(variables_path),
+        restores_(std::move(restores)),
+        max_batch_bytes_(max_batch_bytes),
+        pool_(Env::Default(), "saved_model_restore", num_threads) {}
+
+  ~ShardedRestore() override {
+    // Shards still waiting for a session fail without running.
+    SetSession(nullptr, errors::Cancelled("SavedModel loading failed"));
+    Wait().IgnoreError();
+  }
+
+  const std::vector<VariableRestore>& restores() const { return restores_; }
+
+  // Schedules restoring `shards` of restores(). The returned counter reaches
+  // zero once they are done.
+  std::shared_ptr<BlockingCounter> Schedule(
+      const std::vector<std::vector<const VariableRestore*>>& shards) {
+    auto counter = std::make_shared<BlockingCounter>(shards.size());
+    {
+      mutex_lock l(mu_);
+      counters_.push_back(counter);
+    }
+    for (const auto& shard : shards) {
+      pool_.Schedule([this, shard, counter]() {
+        const Status status = RestoreShard(shard);
+        {
+          mutex_lock l(mu_);
+          status_.Update(status);
+        }
+        counter->DecrementCount();
+      });
+    }
+    return counter;
+  }
+
+  // Lets the shards assign their variables on `session`, or makes them fail
+  // with `status` if it is not OK. Only the first call has an effect.
+  void SetSession(Session* session, const Status& status) {
+    {
+      mutex_lock l(mu_);
+      if (session_set_) return;
+      session_set_ = true;
+      session_ = session;
+      session_status_ = status;
+    }
+    session_ready_.Notify();
+  }
+
+  // Waits until the shards counted by `counter` are done, and returns the
+  // status of all shards done so far.
+  Status Wait(BlockingCounter* counter) {
+    counter->Wait();
+    mutex_lock l(mu_);
+    return status_;
+  }
+
+  Status Wait() override {
+    std::vector<std::shared_ptr<BlockingCounter>> counters;
+    {
+      mutex_lock l(mu_);
+      counters = counters_;
+    }
+    for (const auto& counter : counters) {
+      counter->Wait();
+    }
+    mutex_lock l(mu_);
+    return status_;
+  }
+
+ private:
+  Status RestoreShard(const std::vector<const VariableRestore*>& shard) {
+    BundleReader reader(Env::Default(), variables_path_);
+    TF_RETURN_IF_ERROR(reader.status());
+    std::vector<std::pair<string, Tensor>> inputs;
+    std::vector<string> targets;
+    int64 batch_bytes = 0;
+    for (int i = 0; i < shard.size(); ++i) {
+      const VariableRestore* restore = shard[i];
+      Tensor tensor;
+      TF_RETURN_IF_ERROR(reader.Lookup(restore->key, &tensor));
+      batch_bytes += tensor.TotalBytes();
+      inputs.emplace_back(restore->feed, std::move(tensor));
+      targets.insert(targets.end(), restore->targets.begin(),
+                     restore->targets.end());
+      if (batch_bytes >= max_batch_bytes_ || i + 1 == shard.size()) {
+        TF_RETURN_IF_ERROR(AssignBatch(inputs, targets));
+        inputs.clear();
+        targets.clear();
+        batch_bytes = 0;
+      }
+    }
+    return Status::OK();
+  }
+
+  // Assigns a batch of tensors read by RestoreShard once the session is set.
+  Status AssignBatch(const std::vector<std::pair<string, Tensor>>& inputs,
+                     const std::vector<string>& targets) {
+    session_ready_.WaitForNotification();
+    Session* session;
+    {
+      mutex_lock l(mu_);
+      TF_RETURN_IF_ERROR(session_status_);
+      session = session_;
+    }
+    // Each batch has its own feeds and targets. RunOnce runs them through a
+    // callable that it releases right away, so that the session does not keep
+    // an executor for every batch.
+    RunMetadata run_metadata;
+    return RunOnce(run_options_, inputs, {}, targets, nullptr /* outputs */,
+                   &run_metadata, session);
+  }
+
+  const RunOptions run_options_;
+  const string variables_path_;
+  const std::vector<VariableRestore> restores_;
+  const int64 max_batch_bytes_;
+
+  mutex mu_;
+  Notification session_ready_;
+  bool session_set_ GUARDED_BY(mu_) = false;
+  Session* session_ GUARDED_BY(mu_) = nullptr;
+  Status session_status_ GUARDED_BY(mu_);
+  Status status_ GUARDED_BY(mu_);
+  std::vector<std::shared_ptr<BlockingCounter>> counters_ GUARDED_BY(mu_);
+
+  // Declared last so that its threads are joined before the other members are
+  // destroyed.
+  thread::ThreadPool pool_;
+};
+
+// Plans restoring the variables of `meta_graph_def` in shards as set by
+// `load_options`. `warmup_shards` get the variables read by the warm-up
+// signature, or all variables if there is none, and `other_shards` the others.
+// Leaves `restore` unset if the variables are to be restored by running the
+// restore op.
+Status PrepareShardedRestore(
+    const RunOptions& run_options, const string& export_dir,
+    const MetaGraphDef& meta_graph_def,
+    const SavedModelLoadOptions& load_options,
+    std::unique_ptr<ShardedRestore>* restore,
+    std::vector<std::vector<const VariableRestore*>>* warmup_shards,
+    std::vector<std::vector<const VariableRestore*>>* other_shards) {
+  const bool lazy = !load_options.warmup_signature_key.empty();
+  if (load_options.num_restore_threads <= 1 && !lazy) {
+    return Status::OK();
+  }
+  const string variables_directory =
+      io::JoinPath(export_dir, kSavedModelVariablesDirectory);
+  const string variables_index_path = io::JoinPath(
+      variables_directory, MetaFilename(kSavedModelVariablesFilename));
+  if (!Env::Default()->FileExists(variables_index_path).ok()) {
+    return Status::OK();
+  }
+  const string variables_path =
+      io::JoinPath(variables_directory, kSavedModelVariablesFilename);
+
+  std::vector<VariableRestore> restores;
+  const Status status = GetVariableRestores(
+      meta_graph_def.graph_def(), meta_graph_def.saver_def().restore_op_name(),
+      &restores);
+  if (errors::IsUnimplemented(status)) {
+    LOG(INFO) << "Restoring SavedModel variables with the restore op: "
+              << status.error_message();
+    return Status::OK();
+  }
+  TF_RETURN_IF_ERROR(status);
+
+  std::unordered_set<string> needed;
+  if (lazy) {
+    const auto signature_it =
+        meta_graph_def.signature_def().find(load_options.warmup_signature_key);
+    if (signature_it == meta_graph_def.signature_def().end()) {
+      return errors::InvalidArgument("Could not find warm-up signature ",
+                                     load_options.warmup_signature_key);
+    }
+    std::unordered_map<string, const NodeDef*> nodes;
+    for (const NodeDef& node : meta_graph_def.graph_def().node()) {
+      nodes[node.name()] = &node;
+    }
+    std::vector<string> outputs;
+    for (const auto& output : signature_it->second.outputs()) {
+      outputs.push_back(output.second.name());
+    }
+    needed = ReverseClosure(nodes, outputs);
+  }
+
+  const int num_threads = std::max(load_options.num_restore_threads, 1);
+  restore->reset(new ShardedRestore(
+      run_options, variables_path, std::move(restores), num_threads,
+      std::max<int64>(load_options.max_restore_bytes_per_thread, 1)));
+  std::vector<const VariableRestore*> warmup_restores;
+  std::vector<const VariableRestore*> other_restores;
+  for (const VariableRestore& r : (*restore)->restores()) {
+    const bool is_needed =
+        !lazy || std::any_of(r.variables.begin(), r.variables.end(),
+                             [&needed](const string& variable) {
+                               return needed.count(variable) > 0;
+                             });
+    (is_needed ? warmup_restores : other_restores).push_back(&r);
+  }
+  VLOG(1) << "Restoring " << warmup_restores.size() << " variables before and "
+          << other_restores.size() << " variables after loading with "
+          << num_threads << " threads";
+  TF_RETURN_IF_ERROR(ShardVariableRestores(variables_path, warmup_restores,
+                                           num_threads, warmup_shards));
+  return ShardVariableRestores(variables_path, other_restores, num_threads,
+                               other_shards);
+}
+
+// Runs the warm-up requests of `load_options` on `session`.
+Status RunWarmup(const string& export_dir, const MetaGraphDef& meta_graph_def,
+                 const SavedModelLoadOptions& load_options, Session* session) {
+  std::vector<SessionWarmupRequest> requests;
+  if (load_options.run_saved_model_warmup_requests) {
+    const string warmup_path =
+        io::JoinPath(export_dir, kSavedModelAssetsExtraDirectory,
+                     kSavedModelWarmupRequestsFilename);
+    if (Env::Default()->FileExists(warmup_path).ok()) {
+      TF_RETURN_IF_ERROR(ReadSessionWarmupRequests(warmup_path, &requests));
+    }
+  }
+  requests.insert(requests.end(), load_options.warmup_requests.begin(),
+                  load_options.warmup_requests.end());
+  if (requests.empty()) return Status::OK();
+
+  LOG(INFO) << "Running " << requests.size()
+            << " warm-up requests on SavedModel bundle at path: "
+            << export_dir;
+  const uint64 warmup_start_microseconds = Env::Default()->NowMicros();
+  TF_RETURN_IF_ERROR(
+      RunSessionWarmupRequests(meta_graph_def, requests, session));
+  const uint64 warmup_walltime =
+      GetLatencyMicroseconds(warmup_start_microseconds);
+  load_latency_by_stage->GetCell(export_dir, "warmup")->Add(warmup_walltime);
+  VLOG(1) << "Running warm-up requests takes "
+          << static_cast<float>(warmup_walltime) / 1000 << "ms";
+  return Status::OK();
+}
+
 Status LoadSavedModelInternal(const SessionOptions& session_options,
                               const RunOptions& run_options,
                               const string& export_dir,
                               const std::unordered_set<string>& tags,
+                              const SavedModelLoadOptions& load_options,
                               SavedModelBundle* const bundle) {
   const uint64 read_start_microseconds = Env::Default()->NowMicros();
   TF_RETURN_IF_ERROR(ReadMetaGraphDefFromSavedModel(export_dir, tags,
                                                     &bundle->meta_graph_def));
+
+  // Start reading variables while the session is created.
+  std::unique_ptr<ShardedRestore> sharded_restore;
+  std::shared_ptr<BlockingCounter> warmup_restore_done;
+  {
+    std::vector<std::vector<const VariableRestore*>> warmup_shards;
+    std::vector<std::vector<const VariableRestore*>> other_shards;
+    TF_RETURN_IF_ERROR(PrepareShardedRestore(
+        run_options, export_dir, bundle->meta_graph_def, load_options,
+        &sharded_restore, &warmup_shards, &other_shards));
+    if (sharded_restore != nullptr) {
+      warmup_restore_done = sharded_restore->Schedule(warmup_shards);
+      sharded_restore->Schedule(other_shards);
+    }
+  }
   
   // If allocator starts with a '/' then it is being used to
   // communicate the CPU/GPU that the graph runs on.
@@ -367,8 +845,12 @@ Status LoadSavedModelInternal(const SessionOptions& session_options,
   }
 
   const uint64 load_meta_graph_into_sess_start_microseconds = Env::Default()->NowMicros();
-  TF_RETURN_IF_ERROR(LoadMetaGraphIntoSession(
-      bundle->meta_graph_def, lsession_options, &bundle->session));
+  const Status session_status = LoadMetaGraphIntoSession(
+      bundle->meta_graph_def, lsession_options, &bundle->session);
+  if (sharded_restore != nullptr) {
+    sharded_restore->SetSession(bundle->session.get(), session_status);
+  }
+  TF_RETURN_IF_ERROR(session_status);
   const uint64 load_meta_graph_into_sess_end_microseconds = Env::Default()->NowMicros();
   VLOG(1) << "Loading meta graph into session takes "
           << static_cast<float>(load_meta_graph_into_sess_end_microseconds -
@@ -378,11 +860,15 @@ Status LoadSavedModelInternal(const SessionOptions& session_options,
   std::vector<AssetFileDef> asset_file_defs;
   TF_RETURN_IF_ERROR(
       GetAssetFileDefs(bundle->meta_graph_def, &asset_file_defs));
-  TF_RETURN_IF_ERROR(
-      RunRestore(run_options, export_dir,
-                 bundle->meta_graph_def.saver_def().restore_op_name(),
-                 bundle->meta_graph_def.saver_def().filename_tensor_name(),
-                 asset_file_defs, bundle->session.get()));
+  if (sharded_restore != nullptr) {
+    TF_RETURN_IF_ERROR(sharded_restore->Wait(warmup_restore_done.get()));
+  } else {
+    TF_RETURN_IF_ERROR(
+        RunRestore(run_options, export_dir,
+                   bundle->meta_graph_def.saver_def().restore_op_name(),
+                   bundle->meta_graph_def.saver_def().filename_tensor_name(),
+                   asset_file_defs, bundle->session.get()));
+  }
   // Record walltime spent in restoring graph from disk, but postpone metric
   // increments until graph init finishes.
   const uint64 restore_graph_walltime =
@@ -406,6 +892,12 @@ Status LoadSavedModelInternal(const SessionOptions& session_options,
 
   VLOG(1) << "Running init op takes " << static_cast<float>(init_graph_walltime) / 1000 << "ms";
 
+  TF_RETURN_IF_ERROR(RunWarmup(export_dir, bundle->meta_graph_def,
+                               load_options, bundle->session.get()));
+
+  // Restores of variables not needed by the warm-up signature may still be
+  // running.
+  bundle->background_restore = std::move(sharded_restore);
   return Status::OK();
 }
 
@@ -415,10 +907,19 @@ Status LoadSavedModel(const SessionOptions& session_options,
                       const RunOptions& run_options, const string& export_dir,
                       const std::unordered_set<string>& tags,
                       SavedModelBundle* const bundle) {
+  return LoadSavedModel(session_options, run_options, export_dir, tags,
+                        SavedModelLoadOptions(), bundle);
+}
+
+Status LoadSavedModel(const SessionOptions& session_options,
+                      const RunOptions& run_options, const string& export_dir,
+                      const std::unordered_set<string>& tags,
+                      const SavedModelLoadOptions& load_options,
+                      SavedModelBundle* const bundle) {
   // TODO(robson): Add tests for the counters.
   const uint64 start_microseconds = Env::Default()->NowMicros();
-  const Status status = LoadSavedModelInternal(session_options, run_options,
-                                               export_dir, tags, bundle);
+  const Status status = LoadSavedModelInternal(
+      session_options, run_options, export_dir, tags, load_options, bundle);
   auto log_and_count = [&](const string& status_str) {
     LOG(INFO) << "SavedModel load for tags { " << absl::StrJoin(tags, " ")
               << " }; Status: " << status_str << ". Took "
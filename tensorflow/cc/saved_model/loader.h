@@ -20,21 +20,38 @@ limitations under the License.
 
 #include <string>
 #include <unordered_set>
+#include <vector>
 
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/protobuf/meta_graph.pb.h"
+#include "tensorflow/core/protobuf/session_warmup.pb.h"
 #include "tensorflow/core/public/session.h"
 
 namespace tensorflow {
 
+/// Restores the variables of a SavedModel that were not yet restored when
+/// LoadSavedModel returned (see SavedModelLoadOptions::warmup_signature_key).
+class SavedModelBackgroundRestore {
+ public:
+  virtual ~SavedModelBackgroundRestore() {}
+
+  /// Blocks until all variables are restored, and returns the status of
+  /// restoring them.
+  virtual Status Wait() = 0;
+};
+
 /// SavedModel representation once the SavedModel is loaded from storage.
 struct SavedModelBundle {
   std::unique_ptr<Session> session;
   MetaGraphDef meta_graph_def;
+  /// Set if some variables are still being restored in the background.
+  std::unique_ptr<SavedModelBackgroundRestore> background_restore;
 
   /// A TensorFlow Session does not Close itself on destruction. To avoid
   /// resource leaks, we explicitly call Close on Sessions that we create.
   ~SavedModelBundle() {
+    // Background restores run on the session, so finish them first.
+    background_restore.reset();
     if (session) {
       session->Close().IgnoreError();
     }
@@ -52,6 +69,47 @@ Status LoadSavedModel(const SessionOptions& session_options,
                       const std::unordered_set<string>& tags,
                       SavedModelBundle* const bundle);
 
+/// Options that control how LoadSavedModel restores variables.
+struct SavedModelLoadOptions {
+  /// The number of threads that restore variables. With more than one thread,
+  /// variables are split into shards of about equal size that are read from
+  /// the checkpoint and assigned in parallel, and reading starts while the
+  /// session is still being created. Models whose restore graph cannot be
+  /// split (e.g. because it restores partitioned variables) are restored with
+  /// their restore op as usual.
+  int num_restore_threads = 1;
+
+  /// How many bytes of checkpoint tensors each restore thread reads before
+  /// assigning them, so that at most about `num_restore_threads` times this
+  /// much (or the largest variable, if bigger) is held in memory at once.
+  int64 max_restore_bytes_per_thread = 64 << 20;
+
+  /// If set, LoadSavedModel returns as soon as the variables read by the
+  /// signature with this key are restored and the init op has run, and the
+  /// remaining variables are restored in the background (see
+  /// SavedModelBundle::background_restore). Until then, running other
+  /// signatures may fail because of uninitialized variables. The init op must
+  /// not read variables other than those of the signature.
+  string warmup_signature_key;
+
+  /// Requests to run on the session before LoadSavedModel returns, so that
+  /// the executors and kernels for their feeds, fetches and targets are ready
+  /// when the first such request is served (see RunSessionWarmupRequests).
+  /// Loading fails if any of them fails.
+  std::vector<SessionWarmupRequest> warmup_requests;
+
+  /// If true, also runs the warm-up requests recorded in the SavedModel, in
+  /// assets.extra/session_warmup_requests, if that file exists.
+  bool run_saved_model_warmup_requests = false;
+};
+
+/// Like LoadSavedModel above, but restores variables as set by `load_options`.
+Status LoadSavedModel(const SessionOptions& session_options,
+                      const RunOptions& run_options, const string& export_dir,
+                      const std::unordered_set<string>& tags,
+                      const SavedModelLoadOptions& load_options,
+                      SavedModelBundle* const bundle);
+
 /// Checks whether the provided directory could contain a SavedModel. Note that
 /// the method does not load any data by itself. If the method returns `false`,
 /// the export directory definitely does not contain a SavedModel. If the method
@@ -21,11 +21,15 @@ limitations under the License.
 #include "tensorflow/core/example/example.pb.h"
 #include "tensorflow/core/example/feature.pb.h"
 #include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/lib/io/path.h"
 #include "tensorflow/core/lib/strings/str_util.h"
+#include "tensorflow/core/platform/protobuf.h"
 #include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/protobuf/saved_model.pb.h"
+#include "tensorflow/core/util/tensor_bundle/tensor_bundle.h"
 
 namespace tensorflow {
 namespace {
@@ -126,6 +130,281 @@ TEST_F(LoaderTest, TagMatch) {
   CheckSavedModelBundle(export_dir, bundle);
 }
 
+TEST_F(LoaderTest, ParallelRestore) {
+  SavedModelBundle bundle;
+  SessionOptions session_options;
+  RunOptions run_options;
+  SavedModelLoadOptions load_options;
+  load_options.num_restore_threads = 4;
+
+  const string export_dir =
+      io::JoinPath(testing::TensorFlowSrcRoot(), kTestDataSharded);
+  TF_ASSERT_OK(LoadSavedModel(session_options, run_options, export_dir,
+                              {kSavedModelTagServe}, load_options, &bundle));
+  CheckSavedModelBundle(export_dir, bundle);
+}
+
+TEST_F(LoaderTest, ParallelRestoreInSmallBatches) {
+  SavedModelBundle bundle;
+  SessionOptions session_options;
+  RunOptions run_options;
+  SavedModelLoadOptions load_options;
+  load_options.num_restore_threads = 2;
+  // Assigns every variable on its own.
+  load_options.max_restore_bytes_per_thread = 1;
+
+  const string export_dir =
+      io::JoinPath(testing::TensorFlowSrcRoot(), kTestDataSharded);
+  TF_ASSERT_OK(LoadSavedModel(session_options, run_options, export_dir,
+                              {kSavedModelTagServe}, load_options, &bundle));
+  CheckSavedModelBundle(export_dir, bundle);
+}
+
+TEST_F(LoaderTest, LazyRestore) {
+  SavedModelBundle bundle;
+  SessionOptions session_options;
+  RunOptions run_options;
+  SavedModelLoadOptions load_options;
+  load_options.num_restore_threads = 2;
+  load_options.warmup_signature_key = "regress_x_to_y";
+
+  const string export_dir =
+      io::JoinPath(testing::TensorFlowSrcRoot(), kTestDataSharded);
+  TF_ASSERT_OK(LoadSavedModel(session_options, run_options, export_dir,
+                              {kSavedModelTagServe}, load_options, &bundle));
+  // The warm-up signature can be run right away.
+  CheckSavedModelBundle(export_dir, bundle);
+  ASSERT_NE(bundle.background_restore, nullptr);
+  TF_EXPECT_OK(bundle.background_restore->Wait());
+}
+
+TEST_F(LoaderTest, LazyRestoreMissingSignature) {
+  SavedModelBundle bundle;
+  SessionOptions session_options;
+  RunOptions run_options;
+  SavedModelLoadOptions load_options;
+  load_options.warmup_signature_key = "missing";
+
+  const string export_dir =
+      io::JoinPath(testing::TensorFlowSrcRoot(), kTestDataSharded);
+  const Status st =
+      LoadSavedModel(session_options, run_options, export_dir,
+                     {kSavedModelTagServe}, load_options, &bundle);
+  EXPECT_TRUE(errors::IsInvalidArgument(st)) << st;
+}
+
+// Writes a SavedModel whose restore op, like those of TF2 SavedModels, calls
+// a function that restores and assigns the resource variable "v".
+Status WriteFunctionRestoreSavedModel(const string& export_dir) {
+  const string variables_dir =
+      io::JoinPath(export_dir, kSavedModelVariablesDirectory);
+  TF_RETURN_IF_ERROR(Env::Default()->RecursivelyCreateDir(variables_dir));
+  const string prefix =
+      io::JoinPath(variables_dir, kSavedModelVariablesFilename);
+  BundleWriter writer(Env::Default(), prefix);
+  TF_RETURN_IF_ERROR(
+      writer.Add("v", test::AsTensor<float>({1, 2}, TensorShape({2}))));
+  TF_RETURN_IF_ERROR(writer.Finish());
+
+  SavedModel saved_model;
+  if (!protobuf::TextFormat::ParseFromString(R"pb(
+        meta_info_def { tags: "serve" }
+        saver_def {
+          filename_tensor_name: "save/Const:0"
+          restore_op_name: "save/restore_all"
+        }
+        graph_def {
+          node {
+            name: "v"
+            op: "VarHandleOp"
+            attr {
+              key: "dtype"
+              value { type: DT_FLOAT }
+            }
+            attr {
+              key: "shape"
+              value { shape { dim { size: 2 } } }
+            }
+            attr {
+              key: "shared_name"
+              value { s: "v" }
+            }
+          }
+          node {
+            name: "read"
+            op: "ReadVariableOp"
+            input: "v"
+            attr {
+              key: "dtype"
+              value { type: DT_FLOAT }
+            }
+          }
+          node {
+            name: "save/Const"
+            op: "Const"
+            attr {
+              key: "dtype"
+              value { type: DT_STRING }
+            }
+            attr {
+              key: "value"
+              value {
+                tensor {
+                  dtype: DT_STRING
+                  tensor_shape {}
+                  string_val: "model"
+                }
+              }
+            }
+          }
+          node {
+            name: "save/restore_all"
+            op: "StatefulPartitionedCall"
+            input: "save/Const"
+            input: "v"
+            attr {
+              key: "Tin"
+              value { list { type: [ DT_STRING, DT_RESOURCE ] } }
+            }
+            attr {
+              key: "Tout"
+              value { list {} }
+            }
+            attr {
+              key: "f"
+              value { func { name: "restore_fn" } }
+            }
+          }
+          library {
+            function {
+              signature {
+                name: "restore_fn"
+                input_arg { name: "prefix" type: DT_STRING }
+                input_arg { name: "handle" type: DT_RESOURCE }
+                is_stateful: true
+                control_output: "assign"
+              }
+              node_def {
+                name: "names"
+                op: "Const"
+                attr {
+                  key: "dtype"
+                  value { type: DT_STRING }
+                }
+                attr {
+                  key: "value"
+                  value {
+                    tensor {
+                      dtype: DT_STRING
+                      tensor_shape { dim { size: 1 } }
+                      string_val: "v"
+                    }
+                  }
+                }
+              }
+              node_def {
+                name: "slices"
+                op: "Const"
+                attr {
+                  key: "dtype"
+                  value { type: DT_STRING }
+                }
+                attr {
+                  key: "value"
+                  value {
+                    tensor {
+                      dtype: DT_STRING
+                      tensor_shape { dim { size: 1 } }
+                      string_val: ""
+                    }
+                  }
+                }
+              }
+              node_def {
+                name: "restore"
+                op: "RestoreV2"
+                input: "prefix"
+                input: "names:output:0"
+                input: "slices:output:0"
+                attr {
+                  key: "dtypes"
+                  value { list { type: DT_FLOAT } }
+                }
+              }
+              node_def {
+                name: "assign"
+                op: "AssignVariableOp"
+                input: "handle"
+                input: "restore:tensors:0"
+                attr {
+                  key: "dtype"
+                  value { type: DT_FLOAT }
+                }
+              }
+              control_ret { key: "assign" value: "assign" }
+            }
+          }
+        }
+      )pb",
+                                             saved_model.add_meta_graphs())) {
+    return errors::Internal("Could not parse the test MetaGraphDef");
+  }
+  saved_model.set_saved_model_schema_version(1);
+  return WriteBinaryProto(
+      Env::Default(), io::JoinPath(export_dir, kSavedModelFilenamePb),
+      saved_model);
+}
+
+TEST_F(LoaderTest, ParallelRestoreThroughFunctionCall) {
+  const string export_dir =
+      io::JoinPath(testing::TmpDir(), "function_restore");
+  TF_ASSERT_OK(WriteFunctionRestoreSavedModel(export_dir));
+
+  SavedModelBundle bundle;
+  SessionOptions session_options;
+  RunOptions run_options;
+  SavedModelLoadOptions load_options;
+  load_options.num_restore_threads = 4;
+  TF_ASSERT_OK(LoadSavedModel(session_options, run_options, export_dir,
+                              {kSavedModelTagServe}, load_options, &bundle));
+  // The restore op ran, rather than an empty set of sharded restores.
+  EXPECT_EQ(bundle.background_restore, nullptr);
+  std::vector<Tensor> outputs;
+  TF_ASSERT_OK(bundle.session->Run({}, {"read:0"}, {}, &outputs));
+  ASSERT_EQ(1, outputs.size());
+  test::ExpectTensorEqual<float>(
+      test::AsTensor<float>({1, 2}, TensorShape({2})), outputs[0]);
+}
+
+TEST_F(LoaderTest, WarmupRequests) {
+  SavedModelBundle bundle;
+  SessionOptions session_options;
+  RunOptions run_options;
+  SavedModelLoadOptions load_options;
+  load_options.run_saved_model_warmup_requests = true;
+  SessionWarmupRequest request;
+  request.set_signature_key("regress_x_to_y");
+  NamedTensorProto* feed = request.add_feed();
+  feed->set_name(kRegressInputs);
+  test::AsTensor<tstring>({MakeSerializedExample(1)}, TensorShape({1}))
+      .AsProtoTensorContent(feed->mutable_tensor());
+  load_options.warmup_requests.push_back(request);
+
+  const string export_dir =
+      io::JoinPath(testing::TensorFlowSrcRoot(), kTestDataSharded);
+  TF_ASSERT_OK(LoadSavedModel(session_options, run_options, export_dir,
+                              {kSavedModelTagServe}, load_options, &bundle));
+  CheckSavedModelBundle(export_dir, bundle);
+
+  // Loading fails if a warm-up request fails.
+  SavedModelBundle failed_bundle;
+  load_options.warmup_requests[0].set_signature_key("missing");
+  EXPECT_FALSE(LoadSavedModel(session_options, run_options, export_dir,
+                              {kSavedModelTagServe}, load_options,
+                              &failed_bundle)
+                   .ok());
+}
+
 TEST_F(LoaderTest, NoTagMatch) {
   SavedModelBundle bundle;
   RunOptions run_options;
@@ -0,0 +1,151 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/cc/saved_model/warmup.h"
+
+#include <algorithm>
+#include <memory>
+#include <utility>
+
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/io/record_reader.h"
+#include "tensorflow/core/lib/io/record_writer.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/protobuf.h"
+
+namespace tensorflow {
+namespace {
+
+// Sets `tensor_name` to the name of the tensor that `name` refers to among
+// the inputs or outputs `tensor_infos` of a signature, or to `name` if there
+// is no signature.
+Status ResolveName(const string& signature_key,
+                   const protobuf::Map<string, TensorInfo>& tensor_infos,
+                   const string& name, string* tensor_name) {
+  if (signature_key.empty()) {
+    *tensor_name = name;
+    return Status::OK();
+  }
+  const auto it = tensor_infos.find(name);
+  if (it == tensor_infos.end()) {
+    return errors::InvalidArgument("Signature ", signature_key,
+                                   " has no input or output ", name);
+  }
+  *tensor_name = it->second.name();
+  return Status::OK();
+}
+
+Status RunWarmupRequest(const MetaGraphDef& meta_graph_def,
+                        const SessionWarmupRequest& request,
+                        Session* session) {
+  SignatureDef signature_def;
+  if (!request.signature_key().empty()) {
+    const auto it =
+        meta_graph_def.signature_def().find(request.signature_key());
+    if (it == meta_graph_def.signature_def().end()) {
+      return errors::InvalidArgument("Could not find signature ",
+                                     request.signature_key());
+    }
+    signature_def = it->second;
+  }
+
+  std::vector<std::pair<string, Tensor>> inputs;
+  for (const NamedTensorProto& feed : request.feed()) {
+    string name;
+    TF_RETURN_IF_ERROR(ResolveName(request.signature_key(),
+                                   signature_def.inputs(), feed.name(), &name));
+    Tensor tensor;
+    if (!tensor.FromProto(feed.tensor())) {
+      return errors::InvalidArgument("Invalid tensor for feed ", feed.name());
+    }
+    inputs.emplace_back(name, std::move(tensor));
+  }
+  std::vector<string> output_names;
+  for (const string& fetch : request.fetch()) {
+    string name;
+    TF_RETURN_IF_ERROR(ResolveName(request.signature_key(),
+                                   signature_def.outputs(), fetch, &name));
+    output_names.push_back(name);
+  }
+  if (request.fetch().empty()) {
+    for (const auto& output : signature_def.outputs()) {
+      output_names.push_back(output.second.name());
+    }
+  }
+  const std::vector<string> target_names(request.target().begin(),
+                                         request.target().end());
+
+  const int num_runs = std::max(request.num_runs(), 1);
+  for (int i = 0; i < num_runs; ++i) {
+    std::vector<Tensor> outputs;
+    RunMetadata run_metadata;
+    TF_RETURN_IF_ERROR(session->Run(request.options(), inputs, output_names,
+                                    target_names, &outputs, &run_metadata));
+  }
+  return Status::OK();
+}
+
+}  // namespace
+
+Status ReadSessionWarmupRequests(const string& path,
+                                 std::vector<SessionWarmupRequest>* requests) {
+  std::unique_ptr<RandomAccessFile> file;
+  TF_RETURN_IF_ERROR(Env::Default()->NewRandomAccessFile(path, &file));
+  io::SequentialRecordReader reader(file.get());
+  while (true) {
+    string record;
+    const Status status = reader.ReadRecord(&record);
+    if (errors::IsOutOfRange(status)) break;
+    TF_RETURN_IF_ERROR(status);
+    SessionWarmupRequest request;
+    if (!request.ParseFromString(record)) {
+      return errors::DataLoss("Could not parse warm-up request ",
+                              requests->size(), " in ", path);
+    }
+    requests->push_back(std::move(request));
+  }
+  return Status::OK();
+}
+
+Status WriteSessionWarmupRequests(
+    const string& path, const std::vector<SessionWarmupRequest>& requests) {
+  std::unique_ptr<WritableFile> file;
+  TF_RETURN_IF_ERROR(Env::Default()->NewWritableFile(path, &file));
+  io::RecordWriter writer(file.get());
+  for (const SessionWarmupRequest& request : requests) {
+    TF_RETURN_IF_ERROR(writer.WriteRecord(request.SerializeAsString()));
+  }
+  TF_RETURN_IF_ERROR(writer.Close());
+  return file->Close();
+}
+
+Status RunSessionWarmupRequests(
+    const MetaGraphDef& meta_graph_def,
+    const std::vector<SessionWarmupRequest>& requests, Session* session) {
+  for (int i = 0; i < requests.size(); ++i) {
+    const Status status =
+        RunWarmupRequest(meta_graph_def, requests[i], session);
+    if (!status.ok()) {
+      return Status(status.code(),
+                    strings::StrCat("Warm-up request ", i,
+                                    " failed: ", status.error_message()));
+    }
+  }
+  return Status::OK();
+}
+
+}  // namespace tensorflow
@@ -0,0 +1,50 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+/// Functions to warm up sessions with recorded requests.
+
+#ifndef TENSORFLOW_CC_SAVED_MODEL_WARMUP_H_
+#define TENSORFLOW_CC_SAVED_MODEL_WARMUP_H_
+
+#include <string>
+#include <vector>
+
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/protobuf/meta_graph.pb.h"
+#include "tensorflow/core/protobuf/session_warmup.pb.h"
+#include "tensorflow/core/public/session.h"
+
+namespace tensorflow {
+
+/// Reads the warm-up requests stored in the TFRecord file at `path`, one
+/// serialized SessionWarmupRequest per record, and appends them to `requests`.
+Status ReadSessionWarmupRequests(const string& path,
+                                 std::vector<SessionWarmupRequest>* requests);
+
+/// Writes `requests` to a TFRecord file at `path` that can be read with
+/// ReadSessionWarmupRequests.
+Status WriteSessionWarmupRequests(
+    const string& path, const std::vector<SessionWarmupRequest>& requests);
+
+/// Runs each of `requests` on `session`, whose graph is that of
+/// `meta_graph_def`, so that later runs with the same feeds, fetches and
+/// targets find their executors and kernels ready. Returns the first error.
+Status RunSessionWarmupRequests(
+    const MetaGraphDef& meta_graph_def,
+    const std::vector<SessionWarmupRequest>& requests, Session* session);
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CC_SAVED_MODEL_WARMUP_H_
@@ -0,0 +1,94 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/cc/saved_model/warmup.h"
+
+#include "tensorflow/cc/framework/scope.h"
+#include "tensorflow/cc/ops/standard_ops.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/public/session_options.h"
+
+namespace tensorflow {
+namespace {
+
+// Returns a MetaGraphDef computing y = 2 * x, with a signature "double" that
+// maps input "x" and output "y" to those tensors.
+MetaGraphDef DoubleMetaGraph() {
+  Scope root = Scope::NewRootScope();
+  auto x = ops::Placeholder(root.WithOpName("x"), DT_FLOAT);
+  ops::Mul(root.WithOpName("y"), x, ops::Const(root, 2.0f));
+  MetaGraphDef meta_graph_def;
+  TF_CHECK_OK(root.ToGraphDef(meta_graph_def.mutable_graph_def()));
+  SignatureDef& signature = (*meta_graph_def.mutable_signature_def())["double"];
+  (*signature.mutable_inputs())["x"].set_name("x:0");
+  (*signature.mutable_outputs())["y"].set_name("y:0");
+  return meta_graph_def;
+}
+
+SessionWarmupRequest DoubleRequest(const string& input_alias) {
+  SessionWarmupRequest request;
+  request.set_signature_key("double");
+  NamedTensorProto* feed = request.add_feed();
+  feed->set_name(input_alias);
+  test::AsTensor<float>({1, 2, 3}).AsProtoTensorContent(feed->mutable_tensor());
+  request.set_num_runs(2);
+  return request;
+}
+
+TEST(WarmupTest, WriteAndReadRequests) {
+  const string path =
+      io::JoinPath(testing::TmpDir(), "write_and_read_warmup_requests");
+  SessionWarmupRequest fetch_request;
+  fetch_request.add_fetch("y:0");
+  TF_ASSERT_OK(WriteSessionWarmupRequests(
+      path, {DoubleRequest("x"), fetch_request}));
+
+  std::vector<SessionWarmupRequest> requests;
+  TF_ASSERT_OK(ReadSessionWarmupRequests(path, &requests));
+  ASSERT_EQ(requests.size(), 2);
+  EXPECT_EQ(requests[0].SerializeAsString(),
+            DoubleRequest("x").SerializeAsString());
+  EXPECT_EQ(requests[1].SerializeAsString(),
+            fetch_request.SerializeAsString());
+}
+
+TEST(WarmupTest, RunRequests) {
+  const MetaGraphDef meta_graph_def = DoubleMetaGraph();
+  std::unique_ptr<Session> session(NewSession(SessionOptions()));
+  ASSERT_NE(session, nullptr);
+  TF_ASSERT_OK(session->Create(meta_graph_def.graph_def()));
+
+  // A request by tensor names rather than by signature.
+  SessionWarmupRequest tensor_request;
+  NamedTensorProto* feed = tensor_request.add_feed();
+  feed->set_name("x:0");
+  test::AsScalar<float>(1).AsProtoTensorContent(feed->mutable_tensor());
+  tensor_request.add_fetch("y:0");
+
+  TF_EXPECT_OK(RunSessionWarmupRequests(
+      meta_graph_def, {DoubleRequest("x"), tensor_request}, session.get()));
+
+  const Status status = RunSessionWarmupRequests(
+      meta_graph_def, {DoubleRequest("missing")}, session.get());
+  EXPECT_TRUE(errors::IsInvalidArgument(status)) << status;
+  TF_EXPECT_OK(session->Close());
+}
+
+}  // namespace
+}  // namespace tensorflow
@@ -664,7 +664,8 @@ Status DirectSession::RunInternal(
   if (ShouldUseRunHandlerPool(run_options) &&
       run_options.experimental().use_run_handler_pool()) {
     VLOG(1) << "Using RunHandler to scheduler inter-op closures.";
-    handler = GetOrCreateRunHandlerPool(options_)->Get(step_id);
+    handler = GetOrCreateRunHandlerPool(options_)->Get(
+        step_id, run_options.experimental().run_handler_pool_options());
   }
   auto* handler_ptr = handler.get();
 
@@ -682,12 +683,25 @@ Status DirectSession::RunInternal(
     };
   }
 
+  // The node-local threadpools of NUMA-affine CPU devices only replace the
+  // session's default inter-op threadpool, not running in the caller thread, a
+  // RunHandler or a threadpool chosen by the options.
+  const bool use_cpu_device_thread_pools =
+      pool != nullptr && handler_ptr == nullptr &&
+      threadpool_wrapper == nullptr &&
+      run_options.inter_op_thread_pool() == 0 &&
+      options_.config.session_inter_op_thread_pool_size() == 0;
+
   for (const auto& item : executors_and_keys->items) {
     // TODO(azaks): support partial run.
     // TODO(azaks): if the device picks its own threadpool, we need to assign
     //     less threads to the main compute pool by default.
     thread::ThreadPool* device_thread_pool =
         item.device->tensorflow_device_thread_pool();
+    if (item.device->device_type() == DEVICE_CPU &&
+        !use_cpu_device_thread_pools) {
+      device_thread_pool = nullptr;
+    }
     // TODO(crk): Investigate usage of RunHandlerPool when using device specific
     // thread pool(s).
     if (!device_thread_pool) {
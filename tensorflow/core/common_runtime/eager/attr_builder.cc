@@ -15,6 +15,8 @@ limitations under the License.
 
 #include "tensorflow/core/common_runtime/eager/attr_builder.h"
 
+#include <cstring>
+
 #include "tensorflow/core/common_runtime/device_factory.h"
 #include "tensorflow/core/common_runtime/rendezvous_mgr.h"
 #include "tensorflow/core/framework/allocator.h"
@@ -127,6 +129,7 @@ Status AttrTypeMapForOp(const char* op_name, const AttrTypeMap** out,
     DCHECK(!node_def_finalized_) << "Calling Set() after BuildNodeDef.";     \
     value_field.push_back(std::make_pair(string(attr_name), value));         \
     cached_cache_key_ = absl::nullopt;                                       \
+    cached_dispatch_key_ = absl::nullopt;                                    \
     return *this;                                                            \
   }
 
@@ -300,6 +303,35 @@ tensorflow::Fprint128 AttrBuilder::BuildCacheKeyForDevice(
   return f;
 }
 
+bool AttrBuilder::DispatchKey(tensorflow::Fprint128* key) {
+  if (has_node_def_attrs_) return false;
+  if (cached_dispatch_key_.has_value()) {
+    *key = cached_dispatch_key_.value();
+    return true;
+  }
+  // Attrs are combined without regard to the order in which they were set.
+  tensorflow::Fprint128 f = tensorflow::Fingerprint128(op_name_);
+  for (const auto& p : int_attrs_) {
+    CombineUnordered(CacheKeyHelper(p.first, static_cast<uint64>(p.second)),
+                     &f);
+  }
+  for (const auto& p : float_attrs_) {
+    uint32 bits;
+    memcpy(&bits, &p.second, sizeof(bits));
+    CombineUnordered(CacheKeyHelper(p.first, static_cast<uint64>(bits)), &f);
+  }
+  for (const auto& p : bool_attrs_) {
+    CombineUnordered(CacheKeyHelper(p.first, p.second ? 1u : 0u), &f);
+  }
+  for (const auto& p : type_attrs_) {
+    CombineUnordered(CacheKeyHelper(p.first, static_cast<uint64>(p.second)),
+                     &f);
+  }
+  cached_dispatch_key_ = f;
+  *key = f;
+  return true;
+}
+
 void AttrBuilder::MayBeInitializeNodeDef() {
   if (node_def_ == nullptr) {
     node_def_.reset(new NodeDef());
@@ -88,7 +88,8 @@ class AttrBuilder {
       : op_name_(op),
         num_inputs_(0),
         node_def_(nullptr),
-        node_def_finalized_(false) {}
+        node_def_finalized_(false),
+        has_node_def_attrs_(false) {}
 
   // Needed to work around call to ValidateNodeDef in CreateOpKernel.
   AttrBuilder& NumInputs(int n);
@@ -97,7 +98,9 @@ class AttrBuilder {
   AttrBuilder& Set(StringPiece attr_name, T&& value) {
     MayBeInitializeNodeDef();
     SetInAttrValueMap(node_def_->mutable_attr(), string(attr_name), value);
+    has_node_def_attrs_ = true;
     cached_cache_key_ = absl::nullopt;
+    cached_dispatch_key_ = absl::nullopt;
     return *this;
   }
 
@@ -119,6 +122,12 @@ class AttrBuilder {
 
   tensorflow::Fprint128 CacheKey(const StringPiece device);
 
+  // Computes a 128-bit fingerprint of the op name and the attrs set so far,
+  // for use by the eager dispatch cache. Unlike CacheKey() it covers neither
+  // the device nor a NodeDef. Returns false if some attrs are only stored in
+  // the NodeDef, in which case the op cannot use that cache.
+  bool DispatchKey(tensorflow::Fprint128* key);
+
   void FillAttrValueMap(AttrValueMap* m) const { FillAttrValueMap(m, true); }
   const NodeDef& BuildNodeDef();
 
@@ -158,9 +167,12 @@ class AttrBuilder {
   int num_inputs_;
   std::unique_ptr<NodeDef> node_def_;
   bool node_def_finalized_;
+  // True if some attrs were set directly in `node_def_`.
+  bool has_node_def_attrs_;
 
   absl::optional<tensorflow::Fprint128> cached_cache_key_;
   string device_for_cached_cache_key_;
+  absl::optional<tensorflow::Fprint128> cached_dispatch_key_;
 };  // namespace tensorflow
 
 template <>
@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "tensorflow/core/common_runtime/eager/context.h"
 
+#include <unordered_set>
 #include <vector>
 
 // clang-format off
@@ -58,6 +59,9 @@ auto* eager_context_created =
     monitoring::Gauge<bool, 0>::New("/tensorflow/core/eager_context_created",
                                     "True if an eager context was created.");
 
+// The number of kernels the dispatch cache holds before it is cleared.
+constexpr size_t kMaxDispatchCacheSize = 4096;
+
 }  // namespace
 
 EagerContext::EagerContext(
@@ -143,20 +147,87 @@ EagerExecutor* EagerContext::Executor() {
 }
 
 void EagerContext::SetExecutorForThread(EagerExecutor* executor) {
-  tensorflow::mutex_lock l(executor_map_mu_);
-  if (executor == &default_executor_) {
-    thread_local_executor_.erase(std::this_thread::get_id());
-  } else {
-    thread_local_executor_[std::this_thread::get_id()] = executor;
+  mutex_lock window_lock(lazy_trace_window_mu_);
+  EagerExecutor* old_executor = nullptr;
+  EagerNodeWindowRunner* runner = nullptr;
+  {
+    tensorflow::mutex_lock l(executor_map_mu_);
+    auto it = thread_local_executor_.find(std::this_thread::get_id());
+    if (it != thread_local_executor_.end() && it->second != executor) {
+      old_executor = it->second;
+    }
+    if (executor == &default_executor_) {
+      thread_local_executor_.erase(std::this_thread::get_id());
+    } else {
+      thread_local_executor_[std::this_thread::get_id()] = executor;
+    }
+    runner = window_runner_.get();
+  }
+  // FlushLazyExecutors no longer reaches the old executor.
+  if (old_executor != nullptr) old_executor->SetLazyTraceWindow(0, nullptr);
+  if (executor != &default_executor_) {
+    executor->SetLazyTraceWindow(lazy_trace_window_size_.load(), runner);
+  }
+}
+
+std::vector<EagerExecutor*> EagerContext::ExecutorsLocked() const {
+  std::vector<EagerExecutor*> executors;
+  executors.reserve(thread_local_executor_.size() + 1);
+  executors.push_back(const_cast<EagerExecutor*>(&default_executor_));
+  for (const auto& entry : thread_local_executor_) {
+    executors.push_back(entry.second);
+  }
+  return executors;
+}
+
+void EagerContext::SetLazyTraceWindow(
+    int window_size, std::unique_ptr<EagerNodeWindowRunner> runner) {
+  if (window_size <= 1 || runner == nullptr) {
+    window_size = 0;
+    runner.reset();
+  }
+  mutex_lock window_lock(lazy_trace_window_mu_);
+  EagerNodeWindowRunner* new_runner = runner.get();
+  std::vector<EagerExecutor*> executors;
+  {
+    tensorflow::mutex_lock l(executor_map_mu_);
+    executors = ExecutorsLocked();
+    window_runner_.swap(runner);
+    lazy_trace_window_size_ = window_size;
+  }
+  // EagerExecutor::SetLazyTraceWindow waits for the running window, which
+  // may flush the lazy executors and so take executor_map_mu_. Once this
+  // returns, no executor runs windows with the old runner anymore.
+  for (EagerExecutor* executor : executors) {
+    executor->SetLazyTraceWindow(window_size, new_runner);
+  }
+  // Drop the functions traced by the old runner.
+  if (runner != nullptr) runner->ClearCache();
+}
+
+void EagerContext::FlushLazyExecutorsImpl() {
+  tf_shared_lock l(executor_map_mu_);
+  default_executor_.Flush();
+  for (auto& entry : thread_local_executor_) {
+    entry.second->Flush();
   }
 }
 
 void EagerContext::ClearCaches() {
+  mutex_lock window_lock(lazy_trace_window_mu_);
+  std::vector<EagerExecutor*> executors;
+  EagerNodeWindowRunner* runner = nullptr;
   {
-    mutex_lock ml(executor_map_mu_);
-    for (auto& entry : thread_local_executor_) {
-      entry.second->WaitForAllPendingNodes().IgnoreError();
-    }
+    tf_shared_lock l(executor_map_mu_);
+    executors = ExecutorsLocked();
+    runner = window_runner_.get();
+  }
+  // Run the pending nodes one by one before taking cache_mu_, since running
+  // windows register the functions they trace (cache_mu_) and wait for their
+  // inputs, which flushes the lazy executors (executor_map_mu_).
+  for (EagerExecutor* executor : executors) {
+    executor->SetLazyTraceWindow(0, nullptr);
+    executor->WaitForAllPendingNodes().IgnoreError();
   }
   {
     // The executor stores pointers to kernels, so we need to make sure that no
@@ -164,11 +235,17 @@ void EagerContext::ClearCaches() {
     // as well.
     mutex_lock ml(cache_mu_);
     default_executor_.WaitForAllPendingNodes().IgnoreError();
-    kernel_cache_.clear();
+    kernel_cache_.Clear();
+    dispatch_cache_.Clear();
     for (auto& entry : registered_functions_) {
       entry.second->cached_kernel_keys->clear();
     }
   }
+  if (runner != nullptr) runner->ClearCache();
+  const int window_size = lazy_trace_window_size_.load();
+  for (EagerExecutor* executor : executors) {
+    executor->SetLazyTraceWindow(window_size, runner);
+  }
 }
 
 void EagerContext::SetThreadLocalDevicePlacementPolicy(
@@ -445,9 +522,11 @@ Status EagerContext::RemoveFunction(const string& func) {
     }
     is_last_ref = registered_function->RefCountIsOne();
     if (is_last_ref) {
-      for (auto& key : *registered_function->cached_kernel_keys) {
-        kernel_cache_.erase(key);
-      }
+      std::unordered_set<Fprint128, Fprint128Hasher> keys(
+          registered_function->cached_kernel_keys->begin(),
+          registered_function->cached_kernel_keys->end());
+      kernel_cache_.RemoveIf(
+          [&keys](const Fprint128& key) { return keys.count(key) > 0; });
       registered_functions_.erase(func);
     }
     registered_function->Unref();
@@ -461,22 +540,13 @@ Status EagerContext::RemoveFunction(const string& func) {
 
 core::RefCountPtr<KernelAndDevice> EagerContext::GetCachedKernel(
     Fprint128 cache_key) {
-  tf_shared_lock l(cache_mu_);
-  auto iter = kernel_cache_.find(cache_key);
-  if (iter == kernel_cache_.end()) {
-    return nullptr;
-  }
-  core::RefCountPtr<KernelAndDevice> new_ref(iter->second.get());
-  new_ref->Ref();
-  return new_ref;
+  return kernel_cache_.Lookup(cache_key);
 }
 
 void EagerContext::AddKernelToCache(Fprint128 cache_key,
                                     KernelAndDevice* kernel) {
   mutex_lock ml(cache_mu_);
-  core::RefCountPtr<KernelAndDevice> new_ref(kernel);
-  new_ref->Ref();
-  kernel_cache_[cache_key] = std::move(new_ref);
+  kernel_cache_.Insert(cache_key, kernel);
   auto* registered_function =
       gtl::FindPtrOrNull(registered_functions_, kernel->name());
   // The kernel name can be either a primitive op or a function.
@@ -485,6 +555,22 @@ void EagerContext::AddKernelToCache(Fprint128 cache_key,
   }
 }
 
+core::RefCountPtr<KernelAndDevice> EagerContext::GetCachedDispatchKernel(
+    Fprint128 key) {
+  return dispatch_cache_.Lookup(key);
+}
+
+void EagerContext::AddKernelToDispatchCache(Fprint128 key,
+                                            KernelAndDevice* kernel) {
+  mutex_lock ml(cache_mu_);
+  if (dispatch_cache_.size() >= kMaxDispatchCacheSize) {
+    // Programs that keep calling ops with new attrs or input placements
+    // would otherwise grow the cache without bound.
+    dispatch_cache_.Clear();
+  }
+  dispatch_cache_.Insert(key, kernel);
+}
+
 bool EagerContext::ShouldStoreGraphs() { return should_store_graphs_.load(); }
 
 void EagerContext::SetShouldStoreGraphs(bool value) {
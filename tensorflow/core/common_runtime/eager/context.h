@@ -33,6 +33,7 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/device_mgr.h"
 #include "tensorflow/core/common_runtime/eager/eager_executor.h"
 #include "tensorflow/core/common_runtime/eager/kernel_and_device.h"
+#include "tensorflow/core/common_runtime/eager/kernel_cache.h"
 #include "tensorflow/core/common_runtime/function.h"
 #include "tensorflow/core/common_runtime/rendezvous_mgr.h"
 #include "tensorflow/core/example/example.pb.h"
@@ -139,6 +140,21 @@ class EagerContext : public core::RefCounted {
   // Specify a executor for this thread.
   void SetExecutorForThread(EagerExecutor* executor);
 
+  // Puts the async executors of this context in lazy mode (see
+  // EagerExecutor::SetLazyTraceWindow), running windows of up to `window_size`
+  // pending nodes with `runner`. A `window_size` of one or less turns lazy mode
+  // off.
+  void SetLazyTraceWindow(int window_size,
+                          std::unique_ptr<EagerNodeWindowRunner> runner);
+
+  // Starts running the nodes buffered by executors in lazy mode. Called before
+  // blocking on the result of an op.
+  void FlushLazyExecutors() {
+    if (lazy_trace_window_size_.load(std::memory_order_relaxed) > 1) {
+      FlushLazyExecutorsImpl();
+    }
+  }
+
   // TODO(apassos) make this return a constant reference
   gtl::FlatMap<string, Device*, StringPieceHasher>* device_map() {
     return &devices_map_;
@@ -193,6 +209,15 @@ class EagerContext : public core::RefCounted {
 
   void AddKernelToCache(Fprint128 cache_key, KernelAndDevice* kernel);
 
+  // The dispatch cache maps a compact key of a primitive op call (see
+  // EagerLocalExecute) directly to its kernel, so that repeated calls can skip
+  // computing the full kernel cache key and re-validating their inputs.
+  // The cache is cleared whenever it fills up; its kernels stay in the kernel
+  // cache.
+  core::RefCountPtr<KernelAndDevice> GetCachedDispatchKernel(Fprint128 key);
+
+  void AddKernelToDispatchCache(Fprint128 key, KernelAndDevice* kernel);
+
   bool LogDevicePlacement() const { return log_device_placement_; }
   bool AllowSoftPlacement() const { return allow_soft_placement_; }
   bool LogMemory() const { return log_memory_; }
@@ -386,9 +411,9 @@ class EagerContext : public core::RefCounted {
 
     std::unique_ptr<std::vector<Fprint128>> cached_kernel_keys;
   };
-  std::unordered_map<Fprint128, core::RefCountPtr<KernelAndDevice>,
-                     Fprint128Hasher>
-      kernel_cache_ GUARDED_BY(cache_mu_);
+  // Looked up without holding `cache_mu_`, but only modified with it held.
+  KernelCache<Fprint128, Fprint128Hasher> kernel_cache_;
+  KernelCache<Fprint128, Fprint128Hasher> dispatch_cache_;
   std::unordered_map<string, RegisteredFunction*> registered_functions_
       GUARDED_BY(cache_mu_);
 
@@ -405,6 +430,22 @@ class EagerContext : public core::RefCounted {
   std::atomic<int> num_active_steps_;
   std::unique_ptr<ScopedStepContainer> step_container_ GUARDED_BY(metadata_mu_);
 
+  void FlushLazyExecutorsImpl();
+
+  // Returns the default and thread local executors.
+  std::vector<EagerExecutor*> ExecutorsLocked() const
+      SHARED_LOCKS_REQUIRED(executor_map_mu_);
+
+  // Serializes the changes of the lazy trace window of the executors, which
+  // are made without holding executor_map_mu_ or cache_mu_ since they wait
+  // for running windows. Never acquired by the executors.
+  mutex lazy_trace_window_mu_ ACQUIRED_BEFORE(executor_map_mu_);
+  // The runner last passed to SetLazyTraceWindow. Declared before the
+  // executors so that it outlives them.
+  std::unique_ptr<EagerNodeWindowRunner> window_runner_
+      GUARDED_BY(executor_map_mu_);
+  std::atomic<int> lazy_trace_window_size_{0};
+
   EagerExecutor default_executor_;
   mutable mutex executor_map_mu_;
   // Not owned.
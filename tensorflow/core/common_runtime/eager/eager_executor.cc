@@ -68,7 +68,7 @@ void EagerExecutor::WaitForOrDestroyAllPendingNodes(mutex_lock* lock) {
     }
     while (!node_queue_.empty()) {
       node_queue_.front()->Abort(status);
-      node_queue_.pop();
+      node_queue_.pop_front();
     }
     return;
   }
@@ -110,11 +110,12 @@ Status EagerExecutor::Add(std::unique_ptr<EagerNode> node) {
       DCHECK(thread_) << "EnableAsync should have been called before Add";
       status = status_;
       if (status.ok()) {
-        node_queue_.push(std::move(node));
+        node_queue_.push_back(std::move(node));
 
         // If there were no previous nodes pending, wake the run thread to start
-        // processing requests again.
-        if (node_queue_.size() == 1) {
+        // processing requests again. In lazy mode, the thread may also be
+        // waiting for a window to fill.
+        if (node_queue_.size() == 1 || window_runner_ != nullptr) {
           nodes_pending_.notify_all();
         }
 
@@ -141,6 +142,10 @@ tensorflow::Status EagerExecutor::WaitForAllPendingNodesLocked(
   if (node_queue_.empty()) return tensorflow::Status::OK();
   EagerNode* last_node = node_queue_.back().get();
   node_done_notifications_.insert(std::make_pair(last_node, &cond));
+  if (window_runner_ != nullptr) {
+    // The run thread may be buffering nodes, see ReadyToRunLocked.
+    nodes_pending_.notify_all();
+  }
   cond.wait(*lock);
   // Note that we could be woken up if an error occurs, even though the node has
   // not actually executed.
@@ -164,36 +169,125 @@ tensorflow::Status EagerExecutor::status() const {
   return status_;
 }
 
+void EagerExecutor::SetLazyTraceWindow(int window_size,
+                                       EagerNodeWindowRunner* runner) {
+  tensorflow::mutex_lock l(node_queue_mutex_);
+  if (thread_ == nullptr || window_size <= 1) {
+    lazy_window_size_ = 0;
+    window_runner_ = nullptr;
+  } else {
+    lazy_window_size_ = window_size;
+    window_runner_ = runner;
+  }
+  nodes_pending_.notify_all();
+  while (window_running_) {
+    window_done_.wait(l);
+  }
+}
+
+void EagerExecutor::Flush() {
+  tensorflow::mutex_lock l(node_queue_mutex_);
+  if (window_runner_ == nullptr || node_queue_.empty()) return;
+  flush_requested_ = true;
+  nodes_pending_.notify_all();
+}
+
+bool EagerExecutor::ReadyToRunLocked() {
+  if (node_queue_.empty() || !status_.ok()) return false;
+  if (window_runner_ == nullptr || flush_requested_ ||
+      state_ != ExecutorState::kActive || !node_done_notifications_.empty()) {
+    return true;
+  }
+  // Wait while the queue only holds a partial window.
+  EagerNode* window_start = node_queue_.front().get();
+  if (!window_runner_->CanAddToWindow(nullptr, window_start)) return true;
+  for (int i = 1; i < node_queue_.size(); ++i) {
+    if (i >= lazy_window_size_ ||
+        !window_runner_->CanAddToWindow(window_start, node_queue_[i].get())) {
+      return true;
+    }
+  }
+  return false;
+}
+
+std::vector<EagerNode*> EagerExecutor::NextWindowLocked() {
+  std::vector<EagerNode*> window = {node_queue_.front().get()};
+  if (window_runner_ == nullptr ||
+      !window_runner_->CanAddToWindow(nullptr, window[0])) {
+    return window;
+  }
+  for (int i = 1; i < node_queue_.size() && i < lazy_window_size_; ++i) {
+    if (!window_runner_->CanAddToWindow(window[0], node_queue_[i].get())) {
+      break;
+    }
+    window.push_back(node_queue_[i].get());
+  }
+  return window;
+}
+
 void EagerExecutor::Run() {
   auto thread_exited_notifier =
       gtl::MakeCleanup([this] { thread_exited_notification_.Notify(); });
   while (true) {
-    EagerNode* curr_node_raw;
+    std::vector<EagerNode*> window;
+    EagerNodeWindowRunner* window_runner;
     {
       tensorflow::mutex_lock l(node_queue_mutex_);
-      while (node_queue_.empty() || !status_.ok()) {
+      while (!ReadyToRunLocked()) {
         if (state_ == ExecutorState::kShutDown) return;
         nodes_pending_.wait(l);
       }
-      // Obtain raw pointer since we don't want to remove from the queue until
-      // the node has been run. Otherwise, WaitForAllPendingNodes can return
+      // Obtain raw pointers since we don't want to remove from the queue until
+      // the nodes have been run. Otherwise, WaitForAllPendingNodes can return
       // too early.
       // Note, we don't std::move from the here because the front of the queue
       // will then contain a nullptr. This can be a problem in
       // WaitForAllPendingNodes where we get the top EagerNode pointer
       // and register a notification for its completion.
-      curr_node_raw = node_queue_.front().get();
+      window = NextWindowLocked();
+      window_runner = window_runner_;
+      window_running_ = window.size() > 1;
+    }
+    // Run the window as a whole if possible, and otherwise node by node until
+    // one of them fails.
+    tensorflow::Status status;
+    size_t num_done = 0;
+    bool ran_window = false;
+    if (window.size() > 1) {
+      ran_window = window_runner->RunWindow(window, &status).ok();
+      tensorflow::mutex_lock l(node_queue_mutex_);
+      window_running_ = false;
+      window_done_.notify_all();
+    }
+    if (ran_window) {
+      // On error, the last node of the window is treated as the failed one.
+      num_done = status.ok() ? window.size() : window.size() - 1;
+    } else {
+      status = Status::OK();
+      for (EagerNode* node : window) {
+        status = node->Run();
+        if (!status.ok()) break;
+        ++num_done;
+      }
     }
-    tensorflow::Status status = curr_node_raw->Run();
     const bool ok = status.ok();
 
-    std::unique_ptr<EagerNode> curr_node;
     std::vector<std::unique_ptr<EagerNode>> nodes_to_destroy;
     {
       tensorflow::mutex_lock l(node_queue_mutex_);
-      curr_node = std::move(node_queue_.front());
-      node_queue_.pop();
+      for (size_t i = 0; i < num_done; ++i) {
+        nodes_to_destroy.push_back(std::move(node_queue_.front()));
+        node_queue_.pop_front();
+        const auto range = node_done_notifications_.equal_range(window[i]);
+        for (auto it = range.first; it != range.second; ++it) {
+          it->second->notify_all();
+        }
+        node_done_notifications_.erase(range.first, range.second);
+      }
       if (!ok) {
+        // The failed node is at the front of the queue.
+        nodes_to_destroy.push_back(std::move(node_queue_.front()));
+        node_queue_.pop_front();
         status_ = status;
         // We remove any pending ops so that we don't try to execute them if
         // ClearError is called.
@@ -205,24 +299,21 @@ void EagerExecutor::Run() {
         while (!node_queue_.empty()) {
           node_queue_.front()->Abort(status);
           nodes_to_destroy.push_back(std::move(node_queue_.front()));
-          node_queue_.pop();
+          node_queue_.pop_front();
         }
-      }
-      if (!node_done_notifications_.empty()) {
         // Note that we notify all waiting threads in case an error has
         // occurred. These calling threads are responsible for checking status_
         // before proceeding.
-        const auto range =
-            ok ? node_done_notifications_.equal_range(curr_node_raw)
-               : make_pair(node_done_notifications_.begin(),
-                           node_done_notifications_.end());
-        for (auto it = range.first; it != range.second; ++it) {
-          it->second->notify_all();
+        for (auto& it : node_done_notifications_) {
+          it.second->notify_all();
         }
-        node_done_notifications_.erase(range.first, range.second);
+        node_done_notifications_.clear();
+      }
+      if (node_queue_.empty()) {
+        flush_requested_ = false;
       }
     }
-    // curr_node and nodes_to_destroy will be destructed here, while not holding
+    // nodes_to_destroy will be destructed here, while not holding
     // node_queue_mutex_. This is important because, unfortunately, some nodes'
     // destructors can enqueue more operations onto this executor and cause
     // a deadlock.
@@ -17,9 +17,9 @@ limitations under the License.
 
 #include <algorithm>
 #include <cstddef>
+#include <deque>
 #include <map>
 #include <memory>
-#include <queue>
 #include <string>
 #include <vector>
 
@@ -36,6 +36,8 @@ limitations under the License.
 
 namespace tensorflow {
 
+class ExecuteNode;
+
 // A unit of execution for the EagerExecutor class below. Example subclasses
 // encapsulate execution of a TFE_Op, or copying a TFE_TensorHandle from one
 // device to another.
@@ -57,6 +59,31 @@ class EagerNode {
   // For example, if the node would have computed some tensors in the Run(),
   // it should poison the corresponding tensor handles in this method.
   virtual void Abort(Status status) = 0;
+
+  // Returns this node as an ExecuteNode, if it is one.
+  virtual ExecuteNode* AsExecuteNode() { return nullptr; }
+};
+
+// Runs a window of consecutive EagerNodes together, e.g. by tracing them into a
+// single function, on behalf of an EagerExecutor in lazy mode.
+class EagerNodeWindowRunner {
+ public:
+  virtual ~EagerNodeWindowRunner() {}
+
+  // Returns true if `node` can be added to the window that starts with
+  // `window_start`. `window_start` is nullptr if `node` would start a window.
+  virtual bool CanAddToWindow(EagerNode* window_start, EagerNode* node) = 0;
+
+  // Runs all of `nodes`, in an order consistent with their data dependencies.
+  // If this returns an error, none of `nodes` must have been run, so that the
+  // caller can run them one by one instead. Otherwise all of `nodes` are done,
+  // and `*nodes_status` is set to the first error, if any, that finishing them
+  // ran into; that error fails the executor as if the last node had failed.
+  virtual Status RunWindow(const std::vector<EagerNode*>& nodes,
+                           Status* nodes_status) = 0;
+
+  // Drops anything cached by previous calls to RunWindow.
+  virtual void ClearCache() {}
 };
 
 // A class for handling async execution (see TFE_ContextSetAsync).
@@ -67,7 +94,6 @@ class EagerNode {
 // TODO(agarwal): Implement support for control dependencies.
 // TODO(agarwal): Support out-of-order execution and dispatching multiple
 // EagerNode in parallel.
-// TODO(agarwal): Implement optimizations over EagerNode traces.
 class EagerExecutor {
  public:
   explicit EagerExecutor(bool async);
@@ -101,6 +127,18 @@ class EagerExecutor {
   // Returns Status based on any errors that occurred during async execution.
   Status status() const;
 
+  // Enables lazy mode on an async executor: pending nodes that `runner` can
+  // run together are buffered until `window_size` of them are queued, or until
+  // Flush or WaitForAllPendingNodes is called, and are then run with a single
+  // call to `runner`. A `window_size` of one or less disables lazy mode.
+  // `runner` is not owned and must outlive this executor (or be replaced).
+  // Blocks until the run thread is done with any window it is running with
+  // the previous runner, which may then be destroyed.
+  void SetLazyTraceWindow(int window_size, EagerNodeWindowRunner* runner);
+
+  // Starts running all buffered nodes, without waiting for them.
+  void Flush();
+
  private:
   // Possible states for this executor.
   // Executor starts in kActive state. When Shutdown() is called, Executor
@@ -125,6 +163,15 @@ class EagerExecutor {
   // `status_` is not ok.
   void Run();
 
+  // Returns true if the run thread should start running the front of the
+  // queue, rather than wait for more nodes to fill a lazy trace window.
+  bool ReadyToRunLocked() EXCLUSIVE_LOCKS_REQUIRED(node_queue_mutex_);
+
+  // Returns the nodes at the front of the queue to run next: the front node
+  // and, in lazy mode, the traceable nodes that follow it.
+  std::vector<EagerNode*> NextWindowLocked()
+      EXCLUSIVE_LOCKS_REQUIRED(node_queue_mutex_);
+
   // The impl of WaitForAllPendingNodes
   // `lock` is the lock that holds node_queue_mutex_.
   Status WaitForAllPendingNodesLocked(mutex_lock* lock)
@@ -147,9 +194,20 @@ class EagerExecutor {
   condition_variable nodes_pending_ GUARDED_BY(node_queue_mutex_);
 
   // Queue of pending EagerNodes.
-  std::queue<std::unique_ptr<EagerNode>> node_queue_
+  std::deque<std::unique_ptr<EagerNode>> node_queue_
       GUARDED_BY(node_queue_mutex_);
 
+  // Lazy mode settings, see SetLazyTraceWindow.
+  int lazy_window_size_ GUARDED_BY(node_queue_mutex_) = 0;
+  EagerNodeWindowRunner* window_runner_ GUARDED_BY(node_queue_mutex_) =
+      nullptr;
+  // True while the run thread is calling RunWindow on a runner, which may no
+  // longer be `window_runner_`. Signaled on `window_done_` once cleared.
+  bool window_running_ GUARDED_BY(node_queue_mutex_) = false;
+  condition_variable window_done_ GUARDED_BY(node_queue_mutex_);
+  // Set by Flush, and cleared once the queue is empty.
+  bool flush_requested_ GUARDED_BY(node_queue_mutex_) = false;
+
   // `status_` is set based on any errors raised during execution of a
   // EagerNode.  It remains set until ClearError is called.
   Status status_ GUARDED_BY(node_queue_mutex_);
@@ -42,6 +42,7 @@ limitations under the License.
 #include "tensorflow/core/framework/node_def_util.h"
 #include "tensorflow/core/framework/types.pb.h"
 #include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/hash/hash.h"
 #include "tensorflow/core/profiler/lib/traceme.h"
 #include "tensorflow/core/util/device_name_utils.h"
 #if !defined(IS_MOBILE_PLATFORM)
@@ -452,14 +453,10 @@ Status ShouldCompileWithXLA(const EagerOperation* op, const EagerContext* ctx,
 //    runtime. In this case, we don't select a device because running
 //    a function with explicitly requested device has different behavior than
 //    running without an explicitly requested device.
-Status EagerLocalExecute(EagerOperation* op, TensorHandle** retvals,
-                         int* num_retvals) {
-  profiler::TraceMe activity(
-      [&] { return absl::StrCat("EagerLocalExecute: ", op->Name()); },
-      profiler::TraceMeLevel::kInfo);
+Status GetOrCreateKernelAndDevice(EagerOperation* op,
+                                  core::RefCountPtr<KernelAndDevice>* out) {
   EagerContext* ctx = op->EagerContext();
   auto* executor = op->Executor();
-  TF_RETURN_IF_ERROR(executor->status());
   Device* device = op->Device();
 
   Fprint128 cache_key = op->MutableAttrs()->CacheKey(
@@ -618,6 +615,94 @@ Status EagerLocalExecute(EagerOperation* op, TensorHandle** retvals,
 
     ctx->AddKernelToCache(cache_key, kernel.get());
   }
+  *out = std::move(kernel);
+  return Status::OK();
+}
+
+// Computes the key of `op` in the dispatch cache of its context: a 128-bit
+// fingerprint of the op name and attrs, the requested device, and the dtype
+// and device of every input. Like the kernel cache, the dispatch cache trusts
+// its fingerprints to be unique. The key is much cheaper to compute than the
+// kernel cache key, since it does not build a NodeDef or look at input shapes.
+// Returns false if the op cannot use the dispatch cache.
+bool GetDispatchKey(EagerOperation* op, Fprint128* key) {
+  if (!op->MutableAttrs()->DispatchKey(key)) {
+    return false;
+  }
+  EagerContext* ctx = op->EagerContext();
+  const DeviceNameUtils::ParsedName& name = op->GetDeviceName();
+  uint64 device_key = Hash64Combine(
+      reinterpret_cast<uintptr_t>(op->Device()),
+      (name.has_job ? 1 : 0) | (name.has_replica ? 2 : 0) |
+          (name.has_task ? 4 : 0) | (name.has_type ? 8 : 0) |
+          (name.has_id ? 16 : 0));
+  device_key = Hash64Combine(device_key, Hash64(name.job));
+  device_key = Hash64Combine(device_key, Hash64(name.type));
+  device_key = Hash64Combine(device_key, name.replica);
+  device_key = Hash64Combine(device_key, name.task);
+  device_key = Hash64Combine(device_key, name.id);
+  *key = FingerprintCat128(*key, device_key);
+  for (TensorHandle* input : op->Inputs()) {
+    if (input->IsRemote()) {
+      return false;
+    }
+    *key = FingerprintCat128(
+        *key, Hash64Combine(
+                  input->dtype,
+                  reinterpret_cast<uintptr_t>(input->DeviceOrHostCPU(ctx))));
+  }
+  return true;
+}
+
+// Returns true if `kernel`, found in the dispatch cache, can run `op` with its
+// current inputs as they are, i.e. if ValidateInputTypeAndPlacement would
+// neither copy an input nor fail. The first call of a key may have been
+// valid only after copying some inputs, in which case every later call of
+// that key still has to take the full path.
+bool DispatchKernelMatches(EagerOperation* op,
+                           const core::RefCountPtr<KernelAndDevice>& kernel) {
+  if (kernel->kernel() == nullptr ||
+      kernel->kernel()->type_string() != op->Name() ||
+      kernel->num_inputs() != op->Inputs().size()) {
+    return false;
+  }
+  EagerContext* ctx = op->EagerContext();
+  for (int i = 0; i < op->Inputs().size(); ++i) {
+    TensorHandle* input = op->Inputs()[i];
+    if (input->dtype != kernel->input_type(i) ||
+        input->DeviceOrHostCPU(ctx) != kernel->InputDevice(i)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+Status EagerLocalExecute(EagerOperation* op, TensorHandle** retvals,
+                         int* num_retvals) {
+  profiler::TraceMe activity(
+      [&] { return absl::StrCat("EagerLocalExecute: ", op->Name()); },
+      profiler::TraceMeLevel::kInfo);
+  EagerContext* ctx = op->EagerContext();
+  auto* executor = op->Executor();
+  TF_RETURN_IF_ERROR(executor->status());
+
+  // Repeated calls of a primitive op with the same attrs and input placement
+  // are dispatched straight from the dispatch cache, skipping the kernel
+  // cache key, device selection and input validation.
+  Fprint128 dispatch_key;
+  const bool use_dispatch_cache = GetDispatchKey(op, &dispatch_key);
+  core::RefCountPtr<KernelAndDevice> kernel;
+  if (use_dispatch_cache) {
+    kernel = ctx->GetCachedDispatchKernel(dispatch_key);
+    if (kernel != nullptr && !DispatchKernelMatches(op, kernel)) {
+      kernel.reset();
+    }
+  }
+  const bool dispatch_cache_hit = kernel != nullptr;
+  if (!dispatch_cache_hit) {
+    TF_RETURN_IF_ERROR(GetOrCreateKernelAndDevice(op, &kernel));
+  }
+
   const DataTypeVector& output_dtypes = kernel->output_dtypes();
   const size_t num_outputs = static_cast<int>(output_dtypes.size());
   if (num_outputs > *num_retvals) {
@@ -626,7 +711,15 @@ Status EagerLocalExecute(EagerOperation* op, TensorHandle** retvals,
                                    *num_retvals);
   }
   *num_retvals = num_outputs;
-  TF_RETURN_IF_ERROR(ValidateInputTypeAndPlacement(ctx, op, kernel));
+  if (!dispatch_cache_hit) {
+    TF_RETURN_IF_ERROR(ValidateInputTypeAndPlacement(ctx, op, kernel));
+    // Functions are not dispatched from the cache, since they can be
+    // redefined and multi-device ones are specialized to input shapes.
+    if (use_dispatch_cache && kernel->kernel() != nullptr &&
+        ctx->FindFunctionDef(op->Name()) == nullptr) {
+      ctx->AddKernelToDispatchCache(dispatch_key, kernel.get());
+    }
+  }
 
   StepStats* maybe_step_stats = nullptr;
   GraphCollector* graph_collector = nullptr;
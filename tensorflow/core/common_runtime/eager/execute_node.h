@@ -25,6 +25,7 @@ limitations under the License.
 #include "tensorflow/core/framework/step_stats.pb.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/gtl/inlined_vector.h"
 
@@ -96,6 +97,62 @@ class ExecuteNode : public EagerNode {
     }
   }
 
+  ExecuteNode* AsExecuteNode() override { return this; }
+
+  // Finishes this node with `outputs` that were computed without running its
+  // kernel, e.g. by a function that this node was traced into. Like Run, this
+  // must be called at most once, and not together with Run or Abort. If
+  // `outputs` do not match this node's outputs, poisons them and returns the
+  // error, as Run does when the kernel fails.
+  Status SetOutputs(absl::Span<const Tensor> outputs) {
+    Status status;
+    if (outputs.size() != retvals_.size()) {
+      status = errors::Internal("Expected ", retvals_.size(),
+                                " outputs for ", kernel_->name(), " but got ",
+                                outputs.size());
+    } else {
+      for (int i = 0; i < retvals_.size(); ++i) {
+        if (outputs[i].dtype() != retvals_[i]->dtype) {
+          status = errors::Internal(
+              "Output ", i, " of ", kernel_->name(), " has type ",
+              DataTypeString(outputs[i].dtype()), " but expected ",
+              DataTypeString(retvals_[i]->dtype));
+          break;
+        }
+      }
+    }
+    if (!status.ok()) {
+      Abort(status);
+      return status;
+    }
+
+    for (int i = 0; i < retvals_.size(); ++i) {
+      status.Update(retvals_[i]->SetTensor(outputs[i]));
+    }
+
+    for (auto handle : retvals_) {
+      handle->Unref();
+    }
+
+    for (auto handle : inputs_) {
+      handle->Unref();
+    }
+
+    return status;
+  }
+
+  const gtl::InlinedVector<TensorHandle*, 4>& inputs() const { return inputs_; }
+  const gtl::InlinedVector<TensorHandle*, 2>& retvals() const {
+    return retvals_;
+  }
+  const core::RefCountPtr<KernelAndDevice>& kernel() const { return kernel_; }
+
+  // True if this node records stats or graphs of its execution.
+  bool CollectsStats() const {
+    return maybe_stats_ != nullptr || maybe_step_stats_ != nullptr ||
+           graph_collector_ != nullptr;
+  }
+
  private:
   EagerContext* ctx_;
   gtl::InlinedVector<TensorHandle*, 4> inputs_;
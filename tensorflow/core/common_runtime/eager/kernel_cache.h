@@ -0,0 +1,250 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_COMMON_RUNTIME_EAGER_KERNEL_CACHE_H_
+#define TENSORFLOW_CORE_COMMON_RUNTIME_EAGER_KERNEL_CACHE_H_
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "tensorflow/core/common_runtime/eager/kernel_and_device.h"
+#include "tensorflow/core/lib/core/refcount.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+// A map from keys to kernels that is optimized for lookups from many threads.
+//
+// Lookups take no lock: the entries live in an open addressing table that is
+// only ever appended to in place, and is otherwise replaced as a whole (to
+// grow it or to remove entries) while lookups may still be reading the old
+// one. Old tables and removed kernels are released only after all lookups that
+// could have seen them are done, which is tracked with read-side counters that
+// are sharded by thread (a simple form of RCU).
+//
+// Inserts and removals are serialized by an internal mutex and may wait for
+// concurrent lookups, so they should be rare compared to lookups.
+template <typename Key, typename Hasher = std::hash<Key>>
+class KernelCache {
+ public:
+  KernelCache() : table_(new Table(kMinCapacity)) {}
+
+  ~KernelCache() {
+    Table* table = table_.load(std::memory_order_relaxed);
+    UnrefAll(*table);
+    delete table;
+  }
+
+  // Returns a new reference to the kernel cached for `key`, or nullptr.
+  core::RefCountPtr<KernelAndDevice> Lookup(const Key& key) const {
+    ReadLock l(this);
+    const Table* table = table_.load(std::memory_order_acquire);
+    const size_t mask = table->capacity - 1;
+    for (size_t i = Hasher()(key) & mask;; i = (i + 1) & mask) {
+      const Slot& slot = table->slots[i];
+      KernelAndDevice* kernel = slot.kernel.load(std::memory_order_acquire);
+      if (kernel == nullptr) {
+        return nullptr;
+      }
+      if (slot.key == key) {
+        kernel->Ref();
+        return core::RefCountPtr<KernelAndDevice>(kernel);
+      }
+    }
+  }
+
+  // Caches `kernel` for `key`, replacing any kernel cached for it. The cache
+  // takes a new reference to `kernel`.
+  void Insert(const Key& key, KernelAndDevice* kernel) LOCKS_EXCLUDED(mu_) {
+    kernel->Ref();
+    mutex_lock l(mu_);
+    Table* table = table_.load(std::memory_order_relaxed);
+    Slot* slot = FindSlot(table, key);
+    KernelAndDevice* old_kernel =
+        slot->kernel.load(std::memory_order_relaxed);
+    if (old_kernel != nullptr) {
+      slot->kernel.store(kernel, std::memory_order_release);
+      WaitForReaders();
+      old_kernel->Unref();
+      return;
+    }
+    if ((table->size + 1) * 4 > table->capacity * 3) {
+      Table* new_table = new Table(table->capacity * 2);
+      CopyEntries(*table, new_table, [](const Key&) { return true; });
+      Publish(new_table);
+      table = new_table;
+      slot = FindSlot(table, key);
+    }
+    // Lookups only read the key of slots whose kernel they saw set.
+    slot->key = key;
+    slot->kernel.store(kernel, std::memory_order_release);
+    ++table->size;
+  }
+
+  // Removes the kernels cached for all keys for which `pred` returns true.
+  void RemoveIf(const std::function<bool(const Key&)>& pred)
+      LOCKS_EXCLUDED(mu_) {
+    mutex_lock l(mu_);
+    const Table* table = table_.load(std::memory_order_relaxed);
+    Table* new_table = new Table(table->capacity);
+    std::vector<KernelAndDevice*> removed;
+    CopyEntries(
+        *table, new_table, [&pred](const Key& key) { return !pred(key); },
+        &removed);
+    if (removed.empty()) {
+      delete new_table;
+      return;
+    }
+    Publish(new_table);
+    for (KernelAndDevice* kernel : removed) {
+      kernel->Unref();
+    }
+  }
+
+  // Removes all cached kernels.
+  void Clear() LOCKS_EXCLUDED(mu_) {
+    RemoveIf([](const Key&) { return true; });
+  }
+
+  // Returns the number of cached kernels.
+  size_t size() const LOCKS_EXCLUDED(mu_) {
+    mutex_lock l(mu_);
+    return table_.load(std::memory_order_relaxed)->size;
+  }
+
+ private:
+  static constexpr size_t kMinCapacity = 64;
+  static constexpr int kNumReaderShards = 16;
+
+  struct Slot {
+    std::atomic<KernelAndDevice*> kernel{nullptr};
+    Key key;
+  };
+
+  struct Table {
+    explicit Table(size_t capacity)
+        : capacity(capacity), slots(new Slot[capacity]) {}
+
+    // Always a power of two.
+    const size_t capacity;
+    std::unique_ptr<Slot[]> slots;
+    // Only accessed with `mu_` held.
+    size_t size = 0;
+  };
+
+  // Counts the lookups in progress. Padded so that the counters of different
+  // threads do not share a cache line.
+  struct ReaderCount {
+    std::atomic<int64> count{0};
+    char padding[64 - sizeof(std::atomic<int64>)];
+  };
+
+  // Registers a lookup with the counters of the current epoch for its
+  // duration.
+  class ReadLock {
+   public:
+    explicit ReadLock(const KernelCache* cache) {
+      const size_t shard =
+          std::hash<std::thread::id>()(std::this_thread::get_id()) %
+          kNumReaderShards;
+      while (true) {
+        const uint64 epoch = cache->epoch_.load();
+        count_ = &cache->readers_[epoch & 1][shard].count;
+        count_->fetch_add(1);
+        // If the epoch changed meanwhile, a writer may not have seen this
+        // reader, so register again with the new epoch.
+        if (cache->epoch_.load() == epoch) break;
+        count_->fetch_sub(1);
+      }
+    }
+    ~ReadLock() { count_->fetch_sub(1, std::memory_order_release); }
+
+   private:
+    std::atomic<int64>* count_;
+  };
+
+  // Returns the slot that holds `key`, or the empty slot where it belongs.
+  static Slot* FindSlot(Table* table, const Key& key) {
+    const size_t mask = table->capacity - 1;
+    for (size_t i = Hasher()(key) & mask;; i = (i + 1) & mask) {
+      Slot* slot = &table->slots[i];
+      if (slot->kernel.load(std::memory_order_relaxed) == nullptr ||
+          slot->key == key) {
+        return slot;
+      }
+    }
+  }
+
+  // Copies the entries of `from` for which `keep` returns true to `to`, and
+  // appends the kernels of the other entries to `dropped`.
+  static void CopyEntries(const Table& from, Table* to,
+                          const std::function<bool(const Key&)>& keep,
+                          std::vector<KernelAndDevice*>* dropped = nullptr) {
+    for (size_t i = 0; i < from.capacity; ++i) {
+      const Slot& slot = from.slots[i];
+      KernelAndDevice* kernel = slot.kernel.load(std::memory_order_relaxed);
+      if (kernel == nullptr) continue;
+      if (keep(slot.key)) {
+        Slot* new_slot = FindSlot(to, slot.key);
+        new_slot->key = slot.key;
+        new_slot->kernel.store(kernel, std::memory_order_relaxed);
+        ++to->size;
+      } else if (dropped != nullptr) {
+        dropped->push_back(kernel);
+      }
+    }
+  }
+
+  static void UnrefAll(const Table& table) {
+    for (size_t i = 0; i < table.capacity; ++i) {
+      KernelAndDevice* kernel =
+          table.slots[i].kernel.load(std::memory_order_relaxed);
+      if (kernel != nullptr) kernel->Unref();
+    }
+  }
+
+  // Replaces the current table with `table`, and deletes the old one once no
+  // lookup can still be reading it.
+  void Publish(Table* table) EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    Table* old_table = table_.exchange(table, std::memory_order_acq_rel);
+    WaitForReaders();
+    delete old_table;
+  }
+
+  // Waits until all lookups that started before the call are done.
+  void WaitForReaders() EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    const uint64 epoch = epoch_.fetch_add(1);
+    for (const ReaderCount& reader : readers_[epoch & 1]) {
+      while (reader.count.load() != 0) {
+        std::this_thread::yield();
+      }
+    }
+  }
+
+  mutable mutex mu_;
+  std::atomic<Table*> table_;
+  std::atomic<uint64> epoch_{0};
+  mutable ReaderCount readers_[2][kNumReaderShards];
+
+  TF_DISALLOW_COPY_AND_ASSIGN(KernelCache);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_COMMON_RUNTIME_EAGER_KERNEL_CACHE_H_
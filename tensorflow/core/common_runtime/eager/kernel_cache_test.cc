@@ -0,0 +1,128 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/eager/kernel_cache.h"
+
+#include <atomic>
+#include <vector>
+
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+core::RefCountPtr<KernelAndDevice> NewKernel() {
+  return core::RefCountPtr<KernelAndDevice>(new KernelAndDeviceOp(
+      nullptr, false, nullptr, nullptr, nullptr, nullptr));
+}
+
+TEST(KernelCacheTest, InsertAndLookup) {
+  KernelCache<uint64> cache;
+  EXPECT_EQ(cache.Lookup(1).get(), nullptr);
+  core::RefCountPtr<KernelAndDevice> kernel = NewKernel();
+  cache.Insert(1, kernel.get());
+  EXPECT_FALSE(kernel->RefCountIsOne());
+  EXPECT_EQ(cache.Lookup(1).get(), kernel.get());
+  EXPECT_EQ(cache.Lookup(2).get(), nullptr);
+}
+
+TEST(KernelCacheTest, Grows) {
+  KernelCache<uint64> cache;
+  std::vector<core::RefCountPtr<KernelAndDevice>> kernels;
+  for (int i = 0; i < 1000; ++i) {
+    kernels.push_back(NewKernel());
+    cache.Insert(i, kernels.back().get());
+  }
+  for (int i = 0; i < 1000; ++i) {
+    EXPECT_EQ(cache.Lookup(i).get(), kernels[i].get());
+  }
+}
+
+TEST(KernelCacheTest, InsertReplacesKernel) {
+  KernelCache<uint64> cache;
+  core::RefCountPtr<KernelAndDevice> kernel1 = NewKernel();
+  core::RefCountPtr<KernelAndDevice> kernel2 = NewKernel();
+  cache.Insert(1, kernel1.get());
+  cache.Insert(1, kernel2.get());
+  EXPECT_TRUE(kernel1->RefCountIsOne());
+  EXPECT_EQ(cache.Lookup(1).get(), kernel2.get());
+}
+
+TEST(KernelCacheTest, RemoveIfAndClear) {
+  KernelCache<Fprint128, Fprint128Hasher> cache;
+  std::vector<core::RefCountPtr<KernelAndDevice>> kernels;
+  for (uint64 i = 0; i < 10; ++i) {
+    kernels.push_back(NewKernel());
+    cache.Insert({i, i}, kernels.back().get());
+  }
+  cache.RemoveIf([](const Fprint128& key) { return key.low64 % 2 == 0; });
+  for (uint64 i = 0; i < 10; ++i) {
+    if (i % 2 == 0) {
+      EXPECT_EQ(cache.Lookup({i, i}).get(), nullptr);
+      EXPECT_TRUE(kernels[i]->RefCountIsOne());
+    } else {
+      EXPECT_EQ(cache.Lookup({i, i}).get(), kernels[i].get());
+    }
+  }
+  cache.Clear();
+  for (uint64 i = 0; i < 10; ++i) {
+    EXPECT_EQ(cache.Lookup({i, i}).get(), nullptr);
+    EXPECT_TRUE(kernels[i]->RefCountIsOne());
+  }
+}
+
+TEST(KernelCacheTest, ConcurrentLookups) {
+  const int kNumKeys = 500;
+  KernelCache<uint64> cache;
+  std::vector<core::RefCountPtr<KernelAndDevice>> kernels;
+  for (int i = 0; i < kNumKeys; ++i) {
+    kernels.push_back(NewKernel());
+  }
+  std::atomic<bool> done(false);
+  std::atomic<int> mismatches(0);
+  {
+    thread::ThreadPool pool(Env::Default(), "lookups", 4);
+    for (int t = 0; t < 4; ++t) {
+      pool.Schedule([&]() {
+        while (!done.load()) {
+          for (int i = 0; i < kNumKeys; ++i) {
+            core::RefCountPtr<KernelAndDevice> kernel = cache.Lookup(i);
+            if (kernel != nullptr && kernel.get() != kernels[i].get()) {
+              ++mismatches;
+            }
+          }
+        }
+      });
+    }
+    // Inserts grow the table and removals replace it while the lookups run.
+    for (int round = 0; round < 3; ++round) {
+      for (int i = 0; i < kNumKeys; ++i) {
+        cache.Insert(i, kernels[i].get());
+      }
+      cache.RemoveIf([](const uint64& key) { return key % 3 == 0; });
+    }
+    done = true;
+  }
+  EXPECT_EQ(mismatches.load(), 0);
+  cache.Clear();
+  for (int i = 0; i < kNumKeys; ++i) {
+    EXPECT_TRUE(kernels[i]->RefCountIsOne());
+  }
+}
+
+}  // namespace
+}  // namespace tensorflow
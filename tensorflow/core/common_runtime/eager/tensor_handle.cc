@@ -269,6 +269,10 @@ TensorHandle::TensorHandle(OutputGraphNode symbolic_tensor, DataType dtype)
 }
 
 Status TensorHandle::WaitReady() {
+  if (ctx_ != nullptr && !is_ready_notification_.HasBeenNotified()) {
+    // The op computing this handle may be buffered by a lazy executor.
+    ctx_->FlushLazyExecutors();
+  }
   is_ready_notification_.WaitForNotification();
   return is_poisoned_;
 }
@@ -0,0 +1,318 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/eager/trace_window.h"
+
+#include <utility>
+
+#include "absl/types/span.h"
+#include "tensorflow/core/common_runtime/eager/execute_node.h"
+#include "tensorflow/core/common_runtime/eager/tensor_handle.h"
+#include "tensorflow/core/framework/function.pb.h"
+#include "tensorflow/core/framework/graph_to_functiondef.h"
+#include "tensorflow/core/framework/node_def_builder.h"
+#include "tensorflow/core/framework/node_def_util.h"
+#include "tensorflow/core/framework/op.h"
+#include "tensorflow/core/graph/graph.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/profiler/lib/traceme.h"
+#include "tensorflow/core/protobuf/config.pb.h"
+
+namespace tensorflow {
+namespace {
+
+// The maximum number of traced functions kept per runner. Windows with new
+// signatures are run op by op once it is reached.
+constexpr int kMaxTracedFunctions = 1000;
+
+template <typename T>
+void AppendToSignature(T value, string* signature) {
+  signature->append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+// Describes where an op in a window gets one of its inputs from.
+struct InputSource {
+  // The index of the producing op in the window, or -1 for a function input.
+  int op;
+  // The output index of the producing op, or the function input index.
+  int index;
+};
+
+// Traces the ops of `nodes`, whose inputs come from `sources`, into a
+// FunctionDef named `name` on `device`.
+Status TraceFunction(const std::vector<ExecuteNode*>& nodes,
+                     const std::vector<std::vector<InputSource>>& sources,
+                     const std::vector<TensorHandle*>& args,
+                     const Device* device, const string& name,
+                     FunctionDef* fdef) {
+  Graph graph(OpRegistry::Global());
+  Status status;
+  std::vector<Node*> arg_nodes;
+  for (int i = 0; i < args.size(); ++i) {
+    NodeDef def;
+    TF_RETURN_IF_ERROR(NodeDefBuilder(strings::StrCat("arg", i), "_Arg")
+                           .Attr("T", args[i]->dtype)
+                           .Attr("index", i)
+                           .Finalize(&def));
+    arg_nodes.push_back(graph.AddNode(def, &status));
+    TF_RETURN_IF_ERROR(status);
+  }
+  std::vector<Node*> op_nodes;
+  int num_retvals = 0;
+  for (int j = 0; j < nodes.size(); ++j) {
+    NodeDef def = nodes[j]->kernel()->kernel()->def();
+    def.clear_input();
+    def.set_name(strings::StrCat("op", j));
+    def.set_device(device->name());
+    Node* op_node = graph.AddNode(def, &status);
+    TF_RETURN_IF_ERROR(status);
+    for (int i = 0; i < sources[j].size(); ++i) {
+      const InputSource& source = sources[j][i];
+      if (source.op < 0) {
+        graph.AddEdge(arg_nodes[source.index], 0, op_node, i);
+      } else {
+        graph.AddEdge(op_nodes[source.op], source.index, op_node, i);
+      }
+    }
+    op_nodes.push_back(op_node);
+    for (int o = 0; o < op_node->num_outputs(); ++o) {
+      NodeDef retval_def;
+      TF_RETURN_IF_ERROR(
+          NodeDefBuilder(strings::StrCat("retval", num_retvals), "_Retval")
+              .Input(op_node->name(), o, op_node->output_type(o))
+              .Attr("T", op_node->output_type(o))
+              .Attr("index", num_retvals)
+              .Finalize(&retval_def));
+      Node* retval_node = graph.AddNode(retval_def, &status);
+      TF_RETURN_IF_ERROR(status);
+      graph.AddEdge(op_node, o, retval_node, 0);
+      ++num_retvals;
+    }
+  }
+  return GraphToFunctionDef(graph, name, fdef);
+}
+
+}  // namespace
+
+bool TraceWindowRunner::CanAddToWindow(EagerNode* window_start,
+                                       EagerNode* node) {
+  ExecuteNode* execute_node = node->AsExecuteNode();
+  if (execute_node == nullptr || execute_node->CollectsStats()) {
+    return false;
+  }
+  const KernelAndDevice* kernel = execute_node->kernel().get();
+  if (window_start != nullptr &&
+      window_start->AsExecuteNode()->kernel()->device() != kernel->device()) {
+    return false;
+  }
+  for (TensorHandle* input : execute_node->inputs()) {
+    if (input->IsRemote()) return false;
+  }
+  return IsTraceable(kernel);
+}
+
+bool TraceWindowRunner::IsTraceable(const KernelAndDevice* kernel) {
+  const OpKernel* op_kernel = kernel->kernel();
+  if (op_kernel == nullptr || kernel->device() == nullptr) {
+    return false;
+  }
+  // Tensors in host memory would need to be placed explicitly.
+  for (MemoryType type : op_kernel->input_memory_types()) {
+    if (type != DEVICE_MEMORY) return false;
+  }
+  for (MemoryType type : op_kernel->output_memory_types()) {
+    if (type != DEVICE_MEMORY) return false;
+  }
+  for (DataType dtype : op_kernel->input_types()) {
+    if (dtype == DT_RESOURCE) return false;
+  }
+  mutex_lock l(mu_);
+  auto it = stateless_ops_.find(op_kernel->type_string());
+  if (it == stateless_ops_.end()) {
+    const OpDef* op_def = nullptr;
+    const bool stateless =
+        OpRegistry::Global()->LookUpOpDef(op_kernel->type_string(), &op_def)
+            .ok() &&
+        !op_def->is_stateful();
+    it = stateless_ops_.emplace(op_kernel->type_string(), stateless).first;
+  }
+  return it->second;
+}
+
+Status TraceWindowRunner::RunWindow(const std::vector<EagerNode*>& nodes,
+                                    Status* nodes_status) {
+  profiler::TraceMe activity("TraceWindowRunner::RunWindow",
+                             profiler::TraceMeLevel::kInfo);
+  std::vector<ExecuteNode*> execute_nodes;
+  execute_nodes.reserve(nodes.size());
+  for (EagerNode* node : nodes) {
+    execute_nodes.push_back(node->AsExecuteNode());
+  }
+  Device* device = execute_nodes[0]->kernel()->device();
+
+  // Connect the ops of the window, and compute its signature.
+  string signature;
+  std::unordered_map<TensorHandle*, InputSource> outputs;
+  std::unordered_map<TensorHandle*, int> arg_indices;
+  std::vector<TensorHandle*> args;
+  std::vector<std::vector<InputSource>> sources(execute_nodes.size());
+  for (int j = 0; j < execute_nodes.size(); ++j) {
+    const ExecuteNode* node = execute_nodes[j];
+    AppendToSignature(node->kernel().get(), &signature);
+    for (TensorHandle* input : node->inputs()) {
+      auto it = outputs.find(input);
+      InputSource source;
+      if (it != outputs.end()) {
+        source = it->second;
+      } else {
+        auto inserted = arg_indices.emplace(input, args.size());
+        if (inserted.second) args.push_back(input);
+        source = {-1, inserted.first->second};
+      }
+      sources[j].push_back(source);
+      AppendToSignature(source.op, &signature);
+      AppendToSignature(source.index, &signature);
+    }
+    for (int o = 0; o < node->retvals().size(); ++o) {
+      outputs[node->retvals()[o]] = {j, o};
+    }
+  }
+  std::vector<Device*> input_devices;
+  std::unordered_map<int, TensorShape> input_tensor_shapes;
+  for (int i = 0; i < args.size(); ++i) {
+    input_devices.push_back(args[i]->DeviceOrHostCPU(ctx_));
+    TensorShape shape;
+    TF_RETURN_IF_ERROR(args[i]->Shape(&shape));
+    AppendToSignature(input_devices.back(), &signature);
+    AppendToSignature(args[i]->dtype, &signature);
+    AppendToSignature(shape.dims(), &signature);
+    for (int d = 0; d < shape.dims(); ++d) {
+      AppendToSignature(shape.dim_size(d), &signature);
+    }
+    input_tensor_shapes[i] = std::move(shape);
+  }
+
+  core::RefCountPtr<KernelAndDevice> kernel;
+  string name;
+  {
+    mutex_lock l(mu_);
+    auto it = functions_.find(signature);
+    if (it != functions_.end()) {
+      kernel.reset(it->second.kernel.get());
+      kernel->Ref();
+    } else if (functions_.size() >= kMaxTracedFunctions) {
+      return errors::ResourceExhausted("Too many traced eager functions");
+    } else {
+      name = strings::StrCat("__eager_trace_window_", next_function_id_++);
+    }
+  }
+
+  if (kernel == nullptr) {
+    VLOG(2) << "Tracing " << execute_nodes.size() << " eager ops into "
+            << name;
+    FunctionDef fdef;
+    TF_RETURN_IF_ERROR(
+        TraceFunction(execute_nodes, sources, args, device, name, &fdef));
+    TF_RETURN_IF_ERROR(ctx_->AddFunctionDef(fdef));
+
+    FunctionLibraryRuntime* flr = ctx_->func_lib(device);
+    auto runner = (flr != nullptr && flr->runner() != nullptr)
+                      ? flr->runner()
+                      : ctx_->runner();
+    EagerContext* ctx = ctx_;
+    kernel.reset(new KernelAndDeviceFunc(
+        flr, ctx_->pflr(), std::move(input_devices),
+        std::move(input_tensor_shapes), {}, runner,
+        ctx_->GetCollectiveExecutorHandle(), ctx_->HostCPU(), name,
+        [ctx](const int64 step_id) { return ctx->CreateRendezvous(step_id); }));
+
+    // Like tf.function calls, set the attrs that make the function go through
+    // Grappler.
+    NodeDef ndef;
+    ndef.set_name(name);
+    ndef.set_op(name);
+    ndef.set_device(device->name());
+    AddNodeAttr("executor_type", "", &ndef);
+    AddNodeAttr("config_proto", ConfigProto().SerializeAsString(), &ndef);
+    Status s = kernel->Init(ndef, /*graph_collector=*/nullptr);
+    if (!s.ok()) {
+      kernel.reset();
+      ctx_->RemoveFunction(name).IgnoreError();
+      return s;
+    }
+
+    TracedFunction traced;
+    traced.kernel.reset(kernel.get());
+    traced.kernel->Ref();
+    for (ExecuteNode* node : execute_nodes) {
+      traced.op_kernels.emplace_back(node->kernel().get());
+      node->kernel()->Ref();
+    }
+    mutex_lock l(mu_);
+    functions_.emplace(signature, std::move(traced));
+  }
+
+  gtl::InlinedVector<TensorValue, 4> inputs(args.size());
+  for (int i = 0; i < args.size(); ++i) {
+    TF_RETURN_IF_ERROR(args[i]->TensorValue(&inputs[i]));
+  }
+  std::vector<Tensor> retvals;
+  ScopedStepContainer* container = ctx_->StepContainer();
+  if (container == nullptr) {
+    TF_RETURN_IF_ERROR(kernel->Run(inputs, &retvals, nullptr, nullptr,
+                                   nullptr, nullptr));
+  } else {
+    TF_RETURN_IF_ERROR(kernel->Run(container, inputs, &retvals, nullptr,
+                                   nullptr, nullptr, nullptr));
+  }
+
+  int num_retvals = 0;
+  for (ExecuteNode* node : execute_nodes) {
+    num_retvals += node->retvals().size();
+  }
+  if (retvals.size() != num_retvals) {
+    return errors::Internal("Traced function ", kernel->name(), " returned ",
+                            retvals.size(), " outputs instead of ",
+                            num_retvals);
+  }
+
+  // Nothing was run yet as far as the nodes are concerned; hand each of them
+  // its outputs.
+  *nodes_status = Status::OK();
+  int offset = 0;
+  for (ExecuteNode* node : execute_nodes) {
+    const int num_outputs = node->retvals().size();
+    nodes_status->Update(
+        node->SetOutputs(absl::MakeConstSpan(&retvals[offset], num_outputs)));
+    offset += num_outputs;
+  }
+  return Status::OK();
+}
+
+void TraceWindowRunner::ClearCache() {
+  std::unordered_map<string, TracedFunction> functions;
+  {
+    mutex_lock l(mu_);
+    functions.swap(functions_);
+  }
+  for (auto& entry : functions) {
+    const string name = entry.second.kernel->name();
+    entry.second.kernel.reset();
+    ctx_->RemoveFunction(name).IgnoreError();
+  }
+}
+
+}  // namespace tensorflow
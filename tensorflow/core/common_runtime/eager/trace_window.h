@@ -0,0 +1,81 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_COMMON_RUNTIME_EAGER_TRACE_WINDOW_H_
+#define TENSORFLOW_CORE_COMMON_RUNTIME_EAGER_TRACE_WINDOW_H_
+
+#include <unordered_map>
+#include <vector>
+
+#include "tensorflow/core/common_runtime/eager/context.h"
+#include "tensorflow/core/common_runtime/eager/eager_executor.h"
+#include "tensorflow/core/common_runtime/eager/kernel_and_device.h"
+#include "tensorflow/core/lib/core/refcount.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+
+namespace tensorflow {
+
+// Runs windows of pending eager ops as a single function.
+//
+// A window is a run of consecutive ExecuteNodes of stateless primitive ops
+// placed on the same device. The first time a window with a given signature
+// (the kernels of its ops, how they feed each other, and the dtypes, shapes
+// and devices of the inputs from outside the window) is seen, it is traced
+// into a FunctionDef whose outputs are all outputs of the ops, and that
+// function is instantiated through the ProcessFunctionLibraryRuntime like any
+// multi-device function, so that Grappler optimizes it as a whole. Later
+// windows with the same signature reuse the instantiated function.
+//
+// Since only stateless ops are traced, running a window as a function has the
+// same effect as running its ops one by one.
+class TraceWindowRunner : public EagerNodeWindowRunner {
+ public:
+  explicit TraceWindowRunner(EagerContext* ctx) : ctx_(ctx) {}
+  ~TraceWindowRunner() override {}
+
+  bool CanAddToWindow(EagerNode* window_start, EagerNode* node) override;
+
+  Status RunWindow(const std::vector<EagerNode*>& nodes,
+                   Status* nodes_status) override;
+
+  void ClearCache() override;
+
+ private:
+  struct TracedFunction {
+    core::RefCountPtr<KernelAndDevice> kernel;
+    // The kernels of the traced ops. Holding references to them keeps their
+    // addresses, which are part of the signature, from being reused.
+    std::vector<core::RefCountPtr<KernelAndDevice>> op_kernels;
+  };
+
+  // Returns true if the ops run by `kernel` can be traced.
+  bool IsTraceable(const KernelAndDevice* kernel) LOCKS_EXCLUDED(mu_);
+
+  EagerContext* const ctx_;
+
+  mutex mu_;
+  // Whether each op type is stateless.
+  std::unordered_map<string, bool> stateless_ops_ GUARDED_BY(mu_);
+  // Traced functions by window signature.
+  std::unordered_map<string, TracedFunction> functions_ GUARDED_BY(mu_);
+  int64 next_function_id_ GUARDED_BY(mu_) = 0;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(TraceWindowRunner);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_COMMON_RUNTIME_EAGER_TRACE_WINDOW_H_
@@ -27,6 +27,7 @@ limitations under the License.
 
 #include "tensorflow/core/common_runtime/costmodel_manager.h"
 #include "tensorflow/core/common_runtime/executor_factory.h"
+#include "tensorflow/core/common_runtime/metrics.h"
 #include "tensorflow/core/common_runtime/node_shape_info.h"
 #include "tensorflow/core/common_runtime/pending_counts.h"
 #include "tensorflow/core/common_runtime/renamed_device.h"
@@ -162,6 +163,10 @@ struct NodeItem {
   // The kernel for this node.
   OpKernel* kernel = nullptr;
 
+  // The performance counters of the op type of this node, or nullptr if op
+  // counters were disabled when the executor was created.
+  const metrics::OpCounters* op_counters = nullptr;
+
   bool kernel_is_async : 1;     // True iff kernel->AsAsync() != nullptr
   bool is_merge : 1;            // True iff IsMerge(node)
   bool is_enter : 1;            // True iff IsEnter(node)
@@ -647,6 +652,9 @@ Status ExecutorImpl::Initialize() {
       return s;
     }
     CHECK(item->kernel);
+    if (metrics::OpCountersSamplingPeriod() > 0) {
+      item->op_counters = metrics::GetOpCounters(n->type_string());
+    }
     item->kernel_is_async = (item->kernel->AsAsync() != nullptr);
     item->is_merge = IsMerge(n);
     item->is_enter = IsEnter(n);
@@ -1339,6 +1347,9 @@ class ExecutorState {
   Status ProcessOutputs(const NodeItem& item, OpKernelContext* ctx,
                         EntryVector* outputs, NodeExecStatsInterface* stats);
 
+  // Returns the bytes of the tensors in `outputs`, for the op counters.
+  static int64 OutputBytes(const EntryVector& outputs);
+
   // After processing the outputs, propagates the outputs to their dsts.
   // Contents of *outputs are left in an indeterminate state after
   // returning from this method.
@@ -1592,6 +1603,9 @@ struct ExecutorState::AsyncState {
   Entry* first_input;
   OpKernelContext ctx;
   NodeExecStatsInterface* stats;
+  // Set if the execution is timed for the op counters.
+  bool sample_op = false;
+  uint64 op_start_usecs = 0;
 
  private:
   OpKernelContext::Params* ParamsButClearingEigenGPUDevice(
@@ -1790,6 +1804,12 @@ void ExecutorState::Process(TaggedNode tagged_node, int64 scheduled_nsec) {
           EntryVector outputs;
           Status s = ProcessOutputs(*state->item, &state->ctx, &outputs, stats);
           nodestats::SetMemory(stats, &state->ctx);
+          if (state->sample_op) {
+            metrics::RecordOpSample(
+                *state->item->op_counters,
+                Env::Default()->NowMicros() - state->op_start_usecs,
+                OutputBytes(outputs));
+          }
           if (vlog_) {
             VLOG(2) << "Async kernel done: " << state->item->node->id()
                     << " step " << step_id_ << " "
@@ -1827,6 +1847,11 @@ void ExecutorState::Process(TaggedNode tagged_node, int64 scheduled_nsec) {
           if (completed) ScheduleFinish();
         };
         nodestats::SetOpStart(stats);
+        if (item.op_counters != nullptr &&
+            metrics::RecordOpExecution(*item.op_counters)) {
+          state->sample_op = true;
+          state->op_start_usecs = Env::Default()->NowMicros();
+        }
         {
           profiler::TraceMe activity(
               [&] {
@@ -1842,6 +1867,10 @@ void ExecutorState::Process(TaggedNode tagged_node, int64 scheduled_nsec) {
         // Synchronous computes.
         OpKernelContext ctx(&params, item.num_outputs);
         nodestats::SetOpStart(stats);
+        const bool sample_op = item.op_counters != nullptr &&
+                               metrics::RecordOpExecution(*item.op_counters);
+        const uint64 op_start_usecs =
+            sample_op ? Env::Default()->NowMicros() : 0;
 
         if (TF_PREDICT_FALSE(MightTrace(item, event_collector_))) {
           const string& op_name = op_kernel->name();
@@ -1871,6 +1900,11 @@ void ExecutorState::Process(TaggedNode tagged_node, int64 scheduled_nsec) {
 
         nodestats::SetOpEnd(stats);
         s = ProcessOutputs(item, &ctx, &outputs, stats);
+        if (sample_op) {
+          metrics::RecordOpSample(*item.op_counters,
+                                  Env::Default()->NowMicros() - op_start_usecs,
+                                  OutputBytes(outputs));
+        }
         if (s.ok() && impl_->device_record_tensor_accesses_) {
           // Get the list of all tensors accessed during the execution
           ctx.retrieve_accessed_tensors(&accessed_tensors);
@@ -2008,6 +2042,14 @@ Status ExecutorState::PrepareInputs(const NodeItem& item, Entry* first_input,
   return Status::OK();
 }
 
+/*static*/ int64 ExecutorState::OutputBytes(const EntryVector& outputs) {
+  int64 bytes = 0;
+  for (const Entry& entry : outputs) {
+    if (entry.val_field_is_set) bytes += entry.val->TotalBytes();
+  }
+  return bytes;
+}
+
 Status ExecutorState::ProcessOutputs(const NodeItem& item, OpKernelContext* ctx,
                                      EntryVector* outputs,
                                      NodeExecStatsInterface* stats) {
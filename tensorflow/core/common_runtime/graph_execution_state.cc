@@ -609,12 +609,16 @@ Status GraphExecutionState::InitBaseGraph(std::unique_ptr<Graph>&& new_graph) {
   TF_RETURN_IF_ERROR(OptimizationPassRegistry::Global()->RunGrouping(
       OptimizationPassRegistry::PRE_PLACEMENT, optimization_options));
 
+  const bool use_numa_affinity =
+      session_options_ != nullptr &&
+      session_options_->config.experimental().use_numa_affinity();
   Placer placer(new_graph.get(), "", flib_def_.get(), device_set_,
                 /* default_local_device= */ nullptr,
                 session_options_ == nullptr ||
                     session_options_->config.allow_soft_placement(),
                 session_options_ != nullptr &&
-                    session_options_->config.log_device_placement());
+                    session_options_->config.log_device_placement(),
+                use_numa_affinity);
   // TODO(mrry): Consider making the Placer cancelable.
   TF_RETURN_IF_ERROR(placer.Run());
 
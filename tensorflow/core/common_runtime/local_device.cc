@@ -17,6 +17,8 @@ limitations under the License.
 
 #include "tensorflow/core/common_runtime/local_device.h"
 
+#include <algorithm>
+
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
 #include "tensorflow/core/common_runtime/process_state.h"
 #include "tensorflow/core/common_runtime/process_util.h"
@@ -99,9 +101,37 @@ struct LocalDevice::EigenThreadPoolInfo {
     }
     eigen_device_.reset(new Eigen::ThreadPoolDevice(
         threadpool, eigen_worker_threads_.num_threads, eigen_allocator_.get()));
+
+    // The executors of the CPU devices of a NUMA node schedule their ops on
+    // an inter-op threadpool pinned to the same node, in place of the
+    // session's default inter-op threadpool (see DirectSession::RunInternal).
+    // The session's inter-op thread budget is split evenly among the nodes.
+    // With a negative inter_op_parallelism_threads, ops run in the caller
+    // thread, and no pool is needed.
+    if (numa_node != port::kNUMANoAffinity &&
+        options.config.inter_op_parallelism_threads() >= 0) {
+      int32 inter_op_parallelism_threads =
+          options.config.inter_op_parallelism_threads();
+      if (inter_op_parallelism_threads == 0) {
+        static int env_num_threads = NumInterOpThreadsFromEnvironment();
+        inter_op_parallelism_threads = env_num_threads;
+        if (inter_op_parallelism_threads <= 0) {
+          inter_op_parallelism_threads = port::MaxParallelism();
+        }
+      }
+      inter_op_parallelism_threads = std::max(
+          inter_op_parallelism_threads / std::max(port::NUMANumNodes(), 1), 1);
+      inter_op_thread_pool_.reset(new thread::ThreadPool(
+          options.env, thread_opts,
+          strings::StrCat("numa_", numa_node, "_Compute"),
+          inter_op_parallelism_threads,
+          !options.config.experimental().disable_thread_spinning(),
+          /*allocator=*/nullptr));
+    }
   }
 
   ~EigenThreadPoolInfo() {
+    inter_op_thread_pool_.reset();
     eigen_device_.reset();
     delete eigen_worker_threads_.workers;
   }
@@ -109,6 +139,7 @@ struct LocalDevice::EigenThreadPoolInfo {
   DeviceBase::CpuWorkerThreads eigen_worker_threads_;
   std::unique_ptr<Eigen::ThreadPoolDevice> eigen_device_;
   std::unique_ptr<EigenAllocator> eigen_allocator_;
+  std::unique_ptr<thread::ThreadPool> inter_op_thread_pool_;
 };
 
 LocalDevice::LocalDevice(const SessionOptions& options,
@@ -139,6 +170,10 @@ LocalDevice::LocalDevice(const SessionOptions& options,
             options, numa_node, numa_allocator);
       }
       tp_info = global_tp_info_[numa_node];
+      if (attributes.device_type() == DEVICE_CPU) {
+        set_tensorflow_device_thread_pool(
+            tp_info->inter_op_thread_pool_.get());
+      }
     } else {
       if (global_tp_info_.empty()) {
         global_tp_info_.push_back(new LocalDevice::EigenThreadPoolInfo(
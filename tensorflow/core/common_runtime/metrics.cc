@@ -14,8 +14,15 @@ limitations under the License.
 ==============================================================================*/
 
 #include "tensorflow/core/common_runtime/metrics.h"
+
+#include <atomic>
+#include <unordered_map>
+
 #include "tensorflow/core/lib/monitoring/counter.h"
 #include "tensorflow/core/lib/monitoring/sampler.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/util/env_var.h"
 
 namespace tensorflow {
 namespace metrics {
@@ -87,6 +94,43 @@ auto* xla_compilation_time_usecs = monitoring::Counter<0>::New(
     "/tensorflow/core/xla_compilation_time_usecs",
     "The total time spent on compiling XLA graphs in microseconds.");
 
+auto* op_executions = monitoring::Counter<1>::New(
+    "/tensorflow/core/op_executions",
+    "The number of executions of kernels of each op type.", "op");
+
+auto* op_time_usecs = monitoring::Sampler<1>::New(
+    {"/tensorflow/core/op_time_usecs",
+     "The wall-clock time of a sample of the executions of kernels of each "
+     "op type in microseconds.",
+     "op"},
+    // Power of 2 with bucket count 30 (> 17 minutes)
+    {monitoring::Buckets::Exponential(1, 2, 30)});
+
+auto* op_output_bytes = monitoring::Sampler<1>::New(
+    {"/tensorflow/core/op_output_bytes",
+     "The size of the outputs of a sample of the executions of kernels of "
+     "each op type in bytes.",
+     "op"},
+    // Power of 4 with bucket count 20 (256G)
+    {monitoring::Buckets::Exponential(1, 4, 20)});
+
+int64 DefaultOpCountersSamplingPeriod() {
+  int64 period;
+  Status s = ReadInt64FromEnvVar("TF_OP_COUNTERS_SAMPLING_PERIOD",
+                                 /*default_val=*/0, &period);
+  if (!s.ok() || period < 0) {
+    LOG(ERROR) << "Invalid TF_OP_COUNTERS_SAMPLING_PERIOD: " << s;
+    return 0;
+  }
+  return period;
+}
+
+std::atomic<int64>* op_counters_sampling_period() {
+  static std::atomic<int64>* period =
+      new std::atomic<int64>(DefaultOpCountersSamplingPeriod());
+  return period;
+}
+
 }  // namespace
 
 void RecordTFDataAutotune(const string& name) {
@@ -135,5 +179,43 @@ void UpdateXlaCompilationTime(const uint64 compilation_time_usecs) {
   }
 }
 
+const OpCounters* GetOpCounters(const string& op_type) {
+  static mutex* mu = new mutex;
+  static auto* counters = new std::unordered_map<string, OpCounters>;
+  mutex_lock l(*mu);
+  auto it = counters->find(op_type);
+  if (it == counters->end()) {
+    OpCounters op_counters;
+    op_counters.executions = op_executions->GetCell(op_type);
+    op_counters.time_usecs = op_time_usecs->GetCell(op_type);
+    op_counters.output_bytes = op_output_bytes->GetCell(op_type);
+    it = counters->emplace(op_type, op_counters).first;
+  }
+  return &it->second;
+}
+
+int64 OpCountersSamplingPeriod() {
+  return op_counters_sampling_period()->load(std::memory_order_relaxed);
+}
+
+void SetOpCountersSamplingPeriod(int64 period) {
+  op_counters_sampling_period()->store(period, std::memory_order_relaxed);
+}
+
+bool RecordOpExecution(const OpCounters& counters) {
+  const int64 period = OpCountersSamplingPeriod();
+  if (period <= 0) return false;
+  counters.executions->IncrementBy(1);
+  // Counted per thread rather than per op, so that it is uncontended.
+  static thread_local uint64 num_executions = 0;
+  return num_executions++ % period == 0;
+}
+
+void RecordOpSample(const OpCounters& counters, uint64 time_usecs,
+                    int64 output_bytes) {
+  counters.time_usecs->Add(time_usecs);
+  counters.output_bytes->Add(output_bytes);
+}
+
 }  // namespace metrics
 }  // namespace tensorflow
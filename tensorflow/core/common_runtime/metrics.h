@@ -19,6 +19,11 @@ limitations under the License.
 #include "tensorflow/core/platform/types.h"
 
 namespace tensorflow {
+namespace monitoring {
+class CounterCell;
+class SamplerCell;
+}  // namespace monitoring
+
 namespace metrics {
 
 // Records that a tf.data.Dataset executed by the program used autotuning.
@@ -67,6 +72,37 @@ void UpdateGraphBuildTime(const uint64 running_time_usecs);
 // Updates the metrics stored about time XLA spents compiling graphs.
 void UpdateXlaCompilationTime(const uint64 compilation_time_usecs);
 
+// Opt-in performance counters of the kernels of one op type, updated by the
+// executors. Only one in OpCountersSamplingPeriod() executions is timed,
+// so the time and bytes samplers hold a sample of the executions, while
+// `executions` counts all of them.
+struct OpCounters {
+  // The number of executions of the op.
+  monitoring::CounterCell* executions;
+  // The wall-clock time of sampled executions in microseconds.
+  monitoring::SamplerCell* time_usecs;
+  // The bytes of the outputs of sampled executions.
+  monitoring::SamplerCell* output_bytes;
+};
+
+// Returns the counters of `op_type`. Takes a lock, so callers should look up
+// the counters once per kernel rather than once per execution.
+const OpCounters* GetOpCounters(const string& op_type);
+
+// Returns how many op executions there are per timed execution, or 0 if op
+// counters are disabled. Defaults to the TF_OP_COUNTERS_SAMPLING_PERIOD
+// environment variable, or 0: counting every execution increments a cell
+// shared by all threads running the op type, which contends on hot ops.
+int64 OpCountersSamplingPeriod();
+void SetOpCountersSamplingPeriod(int64 period);
+
+// Counts an execution of an op, and returns whether it should be timed with
+// RecordOpSample(). Does nothing and returns false if op counters have been
+// disabled since `counters` was looked up.
+bool RecordOpExecution(const OpCounters& counters);
+void RecordOpSample(const OpCounters& counters, uint64 time_usecs,
+                    int64 output_bytes);
+
 }  // namespace metrics
 }  // namespace tensorflow
 
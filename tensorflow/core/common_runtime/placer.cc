@@ -74,14 +74,16 @@ Status AssignAndLog(int assigned_device, Node* node,
 Placer::Placer(Graph* graph, const string& function_name,
                const FunctionLibraryDefinition* flib_def,
                const DeviceSet* devices, const Device* default_local_device,
-               bool allow_soft_placement, bool log_device_placement)
+               bool allow_soft_placement, bool log_device_placement,
+               bool use_numa_affinity)
     : graph_(graph),
       function_name_(function_name),
       flib_def_(flib_def),
       devices_(devices),
       default_local_device_(default_local_device),
       allow_soft_placement_(allow_soft_placement),
-      log_device_placement_(log_device_placement) {}
+      log_device_placement_(log_device_placement),
+      use_numa_affinity_(use_numa_affinity) {}
 
 Placer::Placer(Graph* graph, const string& function_name,
                const DeviceSet* devices, const Device* default_local_device)
@@ -178,6 +180,14 @@ Status Placer::Run() {
       }
     }
 
+    // Heuristic C: With NUMA affinity, if the data inputs of the node
+    // are all on a host device that is on another NUMA node than the
+    // default device, then place the node with its inputs, so that a
+    // graph pinned to one NUMA node is not pulled back to the first one.
+    if (assigned_device == -1 && use_numa_affinity_) {
+      assigned_device = GetNUMALocalInputDevice(node, *devices);
+    }
+
     // Provide the default, if necessary.
     if (assigned_device == -1) {
       assigned_device = graph_->InternDeviceName((*devices)[0]->name());
@@ -250,4 +260,34 @@ bool Placer::CanAssignToDevice(const string& candidate_device_name,
   return false;
 }
 
+int Placer::GetNUMALocalInputDevice(const Node* node,
+                                    const std::vector<Device*>& devices) const {
+  const Node* input = nullptr;
+  for (const Edge* edge : node->in_edges()) {
+    if (edge->IsControlEdge()) continue;
+    if (!edge->src()->has_assigned_device_name()) return -1;
+    if (input != nullptr && edge->src()->assigned_device_name_index() !=
+                                input->assigned_device_name_index()) {
+      return -1;
+    }
+    input = edge->src();
+  }
+  if (input == nullptr ||
+      !CanAssignToDevice(input->assigned_device_name(), devices)) {
+    return -1;
+  }
+  const Device* input_device =
+      devices_->FindDeviceByName(input->assigned_device_name());
+  const Device* default_device = devices[0];
+  // Accelerators also report the NUMA node they are attached to, which says
+  // nothing about where their ops run.
+  if (input_device->tensorflow_gpu_device_info() != nullptr ||
+      input_device->device_type() != default_device->device_type() ||
+      input_device->attributes().locality().numa_node() ==
+          default_device->attributes().locality().numa_node()) {
+    return -1;
+  }
+  return input->assigned_device_name_index();
+}
+
 }  // namespace tensorflow
@@ -66,12 +66,16 @@ class Placer {
   // would otherwise be higher priority. default_local_device should be on the
   // local host so that its FLR is directly accessible by the current process.
   //
+  // If "use_numa_affinity" is true (see ConfigProto.Experimental), nodes
+  // without other constraints follow their inputs to host devices of another
+  // NUMA node than the default device.
+  //
   // The "graph", "devices", and "default_local_device" pointer arguments are
   // borrowed by this Placer, and must outlive it.
   Placer(Graph* graph, const string& function_name,
          const FunctionLibraryDefinition* flib_def, const DeviceSet* devices,
          const Device* default_local_device, bool allow_soft_placement,
-         bool log_device_placement);
+         bool log_device_placement, bool use_numa_affinity = false);
 
   Placer(Graph* graph, const string& function_name, const DeviceSet* devices,
          const Device* default_local_device);
@@ -93,6 +97,13 @@ class Placer {
   bool CanAssignToDevice(const string& candidate_device_name,
                          const std::vector<Device*>& devices) const;
 
+  // Returns the device name index of the data inputs of 'node' when they
+  // are all assigned to one of 'devices', a host (non-accelerator) device of
+  // the same type as the default devices[0] but on another NUMA node. Returns
+  // -1 otherwise.
+  int GetNUMALocalInputDevice(const Node* node,
+                              const std::vector<Device*>& devices) const;
+
   Graph* const graph_;  // Not owned.
   const string function_name_;
   const FunctionLibraryDefinition* const flib_def_;  // Not owned.
@@ -100,6 +111,7 @@ class Placer {
   const Device* default_local_device_;               // Not owned.
   const bool allow_soft_placement_;
   const bool log_device_placement_;
+  const bool use_numa_affinity_;
 
   TF_DISALLOW_COPY_AND_ASSIGN(Placer);
 };
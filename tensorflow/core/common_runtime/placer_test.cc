@@ -92,10 +92,12 @@ class FakeDevice : public Device {
 
   Allocator* GetAllocator(AllocatorAttributes attr) override { return nullptr; }
 
-  static std::unique_ptr<Device> MakeCPU(const string& name) {
+  static std::unique_ptr<Device> MakeCPU(const string& name,
+                                         int numa_node = 0) {
     DeviceAttributes device_attributes;
     device_attributes.set_name(name);
     device_attributes.set_device_type(DeviceType("FakeCPU").type());
+    device_attributes.mutable_locality()->set_numa_node(numa_node);
     return std::unique_ptr<Device>(new FakeDevice(device_attributes));
   }
 
@@ -242,9 +244,11 @@ class PlacerTest : public ::testing::Test {
   //
   // REQUIRES: "*graph" was produced by the most recent call to BuildGraph.
   Status Place(Graph* graph, DeviceSet* devices, Device* default_local_device,
-               bool allow_soft_placement, bool log_device_placement) {
+               bool allow_soft_placement, bool log_device_placement,
+               bool use_numa_affinity = false) {
     Placer placer(graph, "", &graph->flib_def(), devices, default_local_device,
-                  allow_soft_placement, log_device_placement);
+                  allow_soft_placement, log_device_placement,
+                  use_numa_affinity);
     return placer.Run();
   }
 
@@ -780,6 +784,87 @@ TEST_F(PlacerTest, TestIgnoreGeneratorHeuristicIfWrongPartialDevice) {
   EXPECT_DEVICE_CONTAINS(g, "var_cpu", "/device:FakeCPU:0");
 }
 
+// With NUMA affinity, Heuristic C places nodes with their inputs when they are
+// on a device of another NUMA node than the default device.
+TEST_F(PlacerTest, TestHeuristicFollowsInputsOnOtherNUMANode) {
+  Graph g(OpRegistry::Global());
+  {  // Scope for temporary variables used to construct g.
+    GraphDefBuilder b(GraphDefBuilder::kFailImmediately);
+    Node* input = ops::SourceOp(
+        "TestInput", b.opts().WithName("in").WithDevice("/device:FakeCPU:1"));
+    Node* relu = ops::UnaryOp("TestRelu", ops::NodeOut(input, 0),
+                              b.opts().WithName("n1"));
+    ops::BinaryOp("TestAdd", relu, ops::NodeOut(input, 1),
+                  b.opts().WithName("n2"));
+    TF_EXPECT_OK(BuildGraph(b, &g));
+  }
+
+  std::vector<std::unique_ptr<Device>> devices;
+  DeviceSet device_set;
+  for (int i = 0; i < 2; ++i) {
+    devices.push_back(FakeDevice::MakeCPU(
+        strings::StrCat("/job:a/replica:0/task:0/device:FakeCPU:", i), i));
+    device_set.AddDevice(devices.back().get());
+  }
+
+  TF_EXPECT_OK(Place(&g, &device_set, nullptr, true, false,
+                     /*use_numa_affinity=*/true));
+  EXPECT_DEVICE_CONTAINS(g, "in", "/device:FakeCPU:1");
+  EXPECT_DEVICE_CONTAINS(g, "n1", "/device:FakeCPU:1");
+  EXPECT_DEVICE_CONTAINS(g, "n2", "/device:FakeCPU:1");
+}
+
+// Without NUMA affinity, device localities do not affect placement.
+TEST_F(PlacerTest, TestHeuristicIgnoresNUMANodeWithoutNUMAAffinity) {
+  Graph g(OpRegistry::Global());
+  {  // Scope for temporary variables used to construct g.
+    GraphDefBuilder b(GraphDefBuilder::kFailImmediately);
+    Node* input = ops::SourceOp(
+        "TestInput", b.opts().WithName("in").WithDevice("/device:FakeCPU:1"));
+    ops::UnaryOp("TestRelu", ops::NodeOut(input, 0), b.opts().WithName("n1"));
+    TF_EXPECT_OK(BuildGraph(b, &g));
+  }
+
+  std::vector<std::unique_ptr<Device>> devices;
+  DeviceSet device_set;
+  for (int i = 0; i < 2; ++i) {
+    devices.push_back(FakeDevice::MakeCPU(
+        strings::StrCat("/job:a/replica:0/task:0/device:FakeCPU:", i), i));
+    device_set.AddDevice(devices.back().get());
+  }
+
+  TF_EXPECT_OK(Place(&g, &device_set));
+  EXPECT_DEVICE_CONTAINS(g, "in", "/device:FakeCPU:1");
+  EXPECT_DEVICE_CONTAINS(g, "n1", "/device:FakeCPU:0");
+}
+
+
+
+// Without distinct NUMA localities, nodes keep the default device.
+TEST_F(PlacerTest, TestHeuristicIgnoresInputsOnSameNUMANode) {
+  Graph g(OpRegistry::Global());
+  {  // Scope for temporary variables used to construct g.
+    GraphDefBuilder b(GraphDefBuilder::kFailImmediately);
+    Node* input = ops::SourceOp(
+        "TestInput", b.opts().WithName("in").WithDevice("/device:FakeCPU:1"));
+    ops::UnaryOp("TestRelu", ops::NodeOut(input, 0), b.opts().WithName("n1"));
+    TF_EXPECT_OK(BuildGraph(b, &g));
+  }
+
+  std::vector<std::unique_ptr<Device>> devices;
+  DeviceSet device_set;
+  for (int i = 0; i < 2; ++i) {
+    devices.push_back(FakeDevice::MakeCPU(
+        strings::StrCat("/job:a/replica:0/task:0/device:FakeCPU:", i)));
+    device_set.AddDevice(devices.back().get());
+  }
+
+  TF_EXPECT_OK(Place(&g, &device_set, nullptr, true, false,
+                     /*use_numa_affinity=*/true));
+  EXPECT_DEVICE_CONTAINS(g, "in", "/device:FakeCPU:1");
+  EXPECT_DEVICE_CONTAINS(g, "n1", "/device:FakeCPU:0");
+}
+
 // Test that a graph with partial device specifications on the ops
 // will successfully
 TEST_F(PlacerTest, TestPartialSpec) {
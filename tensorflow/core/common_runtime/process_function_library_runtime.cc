@@ -669,7 +669,8 @@ Status ProcessFunctionLibraryRuntime::InstantiateMultiDevice(
   Placer placer(graph.get(), function_name, optimization_options.flib_def,
                 &device_set_, default_device,
                 options.config_proto.allow_soft_placement(),
-                options.config_proto.log_device_placement());
+                options.config_proto.log_device_placement(),
+                options.config_proto.experimental().use_numa_affinity());
   TF_RETURN_IF_ERROR(placer.Run());
 
   DumpGraph("Before running POST_PLACEMENT passes", graph.get());
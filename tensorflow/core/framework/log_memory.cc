@@ -17,18 +17,22 @@ limitations under the License.
 
 #include "tensorflow/core/framework/log_memory.pb_text.h"
 #include "tensorflow/core/framework/log_memory.pb.h"
+#include "tensorflow/core/framework/memory_timeline.h"
 
 namespace tensorflow {
 
 const string LogMemory::kLogMemoryLabel = "__LOG_MEMORY__";
 
-bool LogMemory::IsEnabled() { return VLOG_IS_ON(2); }
+bool LogMemory::IsEnabled() {
+  return VLOG_IS_ON(2) || MemoryTimeline::IsActive();
+}
 
 namespace {
 
 // Write the proto entry to LOG(INFO).
 template <typename T>
 void OutputToLog(const T& proto) {
+  if (!VLOG_IS_ON(2)) return;
   string type_name = proto.GetTypeName();
   const size_t index = type_name.find_last_of(".");
   if (index != string::npos) type_name = type_name.substr(index + 1);
@@ -52,6 +56,7 @@ void LogMemory::RecordTensorAllocation(const string& kernel_name,
   allocation.set_step_id(step_id);
   allocation.set_kernel_name(kernel_name);
   tensor.FillDescription(allocation.mutable_tensor());
+  MemoryTimeline::Record(allocation);
   OutputToLog(allocation);
 }
 
@@ -60,6 +65,7 @@ void LogMemory::RecordTensorDeallocation(const int64 allocation_id,
   MemoryLogTensorDeallocation deallocation;
   deallocation.set_allocation_id(allocation_id);
   deallocation.set_allocator_name(allocator_name);
+  MemoryTimeline::Record(deallocation);
   OutputToLog(deallocation);
 }
 
@@ -71,6 +77,7 @@ void LogMemory::RecordTensorOutput(const string& kernel_name,
   output.set_kernel_name(kernel_name);
   output.set_index(index);
   tensor.FillDescription(output.mutable_tensor());
+  MemoryTimeline::Record(output);
   OutputToLog(output);
 }
 
@@ -84,6 +91,7 @@ void LogMemory::RecordRawAllocation(const string& operation,
   allocation.set_ptr(reinterpret_cast<uintptr_t>(ptr));
   allocation.set_allocation_id(allocator->AllocationId(ptr));
   allocation.set_allocator_name(allocator->Name());
+  MemoryTimeline::Record(allocation);
   OutputToLog(allocation);
 }
 
@@ -96,6 +104,7 @@ void LogMemory::RecordRawDeallocation(const string& operation,
   deallocation.set_allocation_id(allocator->AllocationId(ptr));
   deallocation.set_allocator_name(allocator->Name());
   deallocation.set_deferred(deferred);
+  MemoryTimeline::Record(deallocation);
   OutputToLog(deallocation);
 }
 
@@ -24,7 +24,8 @@ namespace tensorflow {
 // LogMemory contains methods for recording memory allocations and
 // frees, associating each allocation with a step identified by a
 // process-wide id. For now, logging is enabled whenever VLOG_IS_ON(1)
-// for the log_memory module.
+// for the log_memory module, or a MemoryTimeline is started. The
+// MemoryTimeline receives the events instead of the log in the latter case.
 //
 // Limitations: We don't log memory allocations by Eigen on the CPU
 // since that would require major changes to plumb through to the
@@ -55,7 +56,8 @@ class LogMemory {
   static const string kLogMemoryLabel;
 
   // Test to see if memory logging is enabled. For now, logging is
-  // enabled whenever VLOG_IS_ON(1) for the log_memory module.
+  // enabled whenever VLOG_IS_ON(1) for the log_memory module, or a
+  // MemoryTimeline is started.
   static bool IsEnabled();
 
   // Log the beginning of a step.
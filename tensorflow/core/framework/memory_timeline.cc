@@ -0,0 +1,380 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/framework/memory_timeline.h"
+
+#include <algorithm>
+#include <atomic>
+#include <unordered_map>
+
+#include "tensorflow/core/framework/allocation_description.pb.h"
+#include "tensorflow/core/framework/tensor_description.pb.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/strings/str_util.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/lib/strings/stringprintf.h"
+#include "tensorflow/core/platform/env.h"
+
+namespace tensorflow {
+namespace {
+
+std::atomic<bool> timeline_active(false);
+
+mutex* active_timeline_mu() {
+  static mutex* mu = new mutex;
+  return mu;
+}
+
+// The started timeline, guarded by active_timeline_mu(). Recording only takes
+// a shared lock on it; the timeline's own mutex serializes the updates.
+MemoryTimeline* active_timeline = nullptr;
+
+// Whether `op` is a placeholder name, used for tensors allocated outside of
+// an OpKernelContext.
+bool IsUnknownOp(const string& op) {
+  return str_util::StartsWith(op, "Unknown");
+}
+
+MemoryTimeline::Allocation FromDescription(
+    const string& op, int64 step_id, const AllocationDescription& desc) {
+  MemoryTimeline::Allocation allocation;
+  allocation.step_id = step_id;
+  allocation.op = op;
+  allocation.allocator = desc.allocator_name();
+  allocation.allocation_id = desc.allocation_id();
+  allocation.requested_bytes = desc.requested_bytes();
+  allocation.allocated_bytes = desc.allocated_bytes() > 0
+                                   ? desc.allocated_bytes()
+                                   : desc.requested_bytes();
+  return allocation;
+}
+
+string JsonEscape(const string& value) {
+  string result;
+  for (char c : value) {
+    if (c == '"' || c == '\\') {
+      result.push_back('\\');
+      result.push_back(c);
+    } else if (static_cast<unsigned char>(c) < 0x20) {
+      strings::Appendf(&result, "\\u%04x", c);
+    } else {
+      result.push_back(c);
+    }
+  }
+  return result;
+}
+
+}  // namespace
+
+MemoryTimeline::MemoryTimeline(int max_steps)
+    : max_steps_(std::max(max_steps, 1)) {}
+
+MemoryTimeline::~MemoryTimeline() { Stop(); }
+
+Status MemoryTimeline::Start() {
+  mutex_lock l(*active_timeline_mu());
+  if (active_timeline != nullptr) {
+    return errors::FailedPrecondition("A MemoryTimeline is already started");
+  }
+  active_timeline = this;
+  timeline_active.store(true, std::memory_order_release);
+  return Status::OK();
+}
+
+void MemoryTimeline::Stop() {
+  mutex_lock l(*active_timeline_mu());
+  if (active_timeline == this) {
+    active_timeline = nullptr;
+    timeline_active.store(false, std::memory_order_release);
+  }
+}
+
+/*static*/ bool MemoryTimeline::IsActive() {
+  return timeline_active.load(std::memory_order_acquire);
+}
+
+void MemoryTimeline::AddAllocation(Allocation allocation) {
+  // Without an id, the deallocation of the buffer can't be matched.
+  if (allocation.allocation_id == 0) return;
+  allocation.alloc_micros = Env::Default()->NowMicros();
+  mutex_lock l(mu_);
+  AllocationKey key(allocation.allocator, allocation.allocation_id);
+  auto it = live_.find(key);
+  if (it != live_.end()) {
+    // Tensors allocated by kernels are reported again with the kernel name.
+    Allocation& existing = allocations_[it->second];
+    if (IsUnknownOp(existing.op)) {
+      existing.op = std::move(allocation.op);
+      existing.step_id = allocation.step_id;
+      AddStepLocked(existing.step_id);
+    }
+    return;
+  }
+  AddStepLocked(allocation.step_id);
+  live_.emplace(std::move(key), allocations_.size());
+  events_.push_back({allocations_.size(), true});
+  allocations_.push_back(std::move(allocation));
+}
+
+void MemoryTimeline::AddDeallocation(const string& allocator,
+                                     int64 allocation_id) {
+  const int64 now = Env::Default()->NowMicros();
+  mutex_lock l(mu_);
+  auto it = live_.find(AllocationKey(allocator, allocation_id));
+  if (it == live_.end()) return;
+  allocations_[it->second].dealloc_micros = now;
+  events_.push_back({it->second, false});
+  live_.erase(it);
+}
+
+void MemoryTimeline::AddStepLocked(int64 step_id) {
+  if (std::find(steps_.begin(), steps_.end(), step_id) != steps_.end()) {
+    return;
+  }
+  steps_.push_back(step_id);
+  if (steps_.size() > static_cast<size_t>(max_steps_)) {
+    const int64 oldest = steps_.front();
+    steps_.pop_front();
+    DropDeallocatedLocked(oldest);
+  }
+}
+
+void MemoryTimeline::DropDeallocatedLocked(int64 step_id) {
+  // Live buffers are kept, so that their deallocation can be matched.
+  constexpr size_t kDropped = ~size_t{0};
+  std::vector<size_t> new_indices(allocations_.size(), kDropped);
+  size_t num_kept = 0;
+  for (size_t i = 0; i < allocations_.size(); ++i) {
+    if (allocations_[i].step_id == step_id &&
+        allocations_[i].dealloc_micros != 0) {
+      continue;
+    }
+    new_indices[i] = num_kept;
+    if (i != num_kept) allocations_[num_kept] = std::move(allocations_[i]);
+    ++num_kept;
+  }
+  if (num_kept == allocations_.size()) return;
+  allocations_.resize(num_kept);
+  size_t num_events = 0;
+  for (const Event& event : events_) {
+    const size_t index = new_indices[event.allocation];
+    if (index != kDropped) events_[num_events++] = {index, event.is_allocation};
+  }
+  events_.resize(num_events);
+  for (auto& entry : live_) {
+    entry.second = new_indices[entry.second];
+  }
+}
+
+/*static*/ void MemoryTimeline::Record(
+    const MemoryLogTensorAllocation& allocation) {
+  tf_shared_lock l(*active_timeline_mu());
+  if (active_timeline == nullptr) return;
+  active_timeline->AddAllocation(
+      FromDescription(allocation.kernel_name(), allocation.step_id(),
+                      allocation.tensor().allocation_description()));
+}
+
+/*static*/ void MemoryTimeline::Record(
+    const MemoryLogTensorDeallocation& deallocation) {
+  tf_shared_lock l(*active_timeline_mu());
+  if (active_timeline == nullptr) return;
+  active_timeline->AddDeallocation(deallocation.allocator_name(),
+                                   deallocation.allocation_id());
+}
+
+/*static*/ void MemoryTimeline::Record(const MemoryLogTensorOutput& output) {
+  tf_shared_lock l(*active_timeline_mu());
+  if (active_timeline == nullptr) return;
+  const AllocationDescription& desc = output.tensor().allocation_description();
+  mutex_lock timeline_lock(active_timeline->mu_);
+  auto it = active_timeline->live_.find(
+      AllocationKey(desc.allocator_name(), desc.allocation_id()));
+  if (it == active_timeline->live_.end()) return;
+  Allocation& allocation = active_timeline->allocations_[it->second];
+  // Outputs forwarded from an input keep the name of the first output.
+  if (allocation.tensor.empty()) {
+    allocation.tensor = strings::StrCat(output.kernel_name(), ":",
+                                        output.index());
+  }
+  if (IsUnknownOp(allocation.op)) {
+    allocation.op = output.kernel_name();
+    allocation.step_id = output.step_id();
+    // May move `allocation`.
+    active_timeline->AddStepLocked(output.step_id());
+  }
+}
+
+/*static*/ void MemoryTimeline::Record(
+    const MemoryLogRawAllocation& allocation) {
+  Allocation raw;
+  raw.step_id = allocation.step_id();
+  raw.op = allocation.operation();
+  raw.allocator = allocation.allocator_name();
+  raw.allocation_id = allocation.allocation_id();
+  raw.requested_bytes = allocation.num_bytes();
+  raw.allocated_bytes = allocation.num_bytes();
+  tf_shared_lock l(*active_timeline_mu());
+  if (active_timeline == nullptr) return;
+  active_timeline->AddAllocation(std::move(raw));
+}
+
+/*static*/ void MemoryTimeline::Record(
+    const MemoryLogRawDeallocation& deallocation) {
+  // A deferred deallocation is followed by the actual one.
+  if (deallocation.deferred()) return;
+  tf_shared_lock l(*active_timeline_mu());
+  if (active_timeline == nullptr) return;
+  active_timeline->AddDeallocation(deallocation.allocator_name(),
+                                   deallocation.allocation_id());
+}
+
+void MemoryTimeline::GetStepEvents(int64 step_id,
+                                   std::vector<Allocation>* allocations,
+                                   std::vector<Event>* events) const {
+  std::unordered_map<size_t, size_t> step_indices;
+  mutex_lock l(mu_);
+  for (const Event& event : events_) {
+    const Allocation& allocation = allocations_[event.allocation];
+    if (allocation.step_id != step_id) continue;
+    auto inserted = step_indices.emplace(event.allocation, allocations->size());
+    if (inserted.second) allocations->push_back(allocation);
+    events->push_back({inserted.first->second, event.is_allocation});
+  }
+}
+
+std::vector<MemoryTimeline::Allocation> MemoryTimeline::GetAllocations(
+    int64 step_id) const {
+  std::vector<Allocation> allocations;
+  std::vector<Event> events;
+  GetStepEvents(step_id, &allocations, &events);
+  return allocations;
+}
+
+std::vector<MemoryTimeline::PeakMemory> MemoryTimeline::SummarizePeakMemory(
+    int64 step_id) const {
+  std::vector<Allocation> step_allocations;
+  std::vector<Event> step_events;
+  GetStepEvents(step_id, &step_allocations, &step_events);
+  std::map<string, std::vector<size_t>> by_allocator;
+  for (size_t i = 0; i < step_allocations.size(); ++i) {
+    by_allocator[step_allocations[i].allocator].push_back(i);
+  }
+  std::vector<PeakMemory> result;
+  for (const auto& entry : by_allocator) {
+    std::vector<Allocation> allocations;
+    std::unordered_map<size_t, size_t> indices;
+    for (size_t i : entry.second) {
+      indices[i] = allocations.size();
+      allocations.push_back(step_allocations[i]);
+    }
+    std::vector<Event> events;
+    for (const Event& event : step_events) {
+      auto it = indices.find(event.allocation);
+      if (it != indices.end()) {
+        events.push_back({it->second, event.is_allocation});
+      }
+    }
+    PeakMemory peak;
+    peak.allocator = entry.first;
+    int64 bytes = 0;
+    size_t peak_event = 0;
+    for (size_t i = 0; i < events.size(); ++i) {
+      const Allocation& allocation = allocations[events[i].allocation];
+      bytes += events[i].is_allocation ? allocation.allocated_bytes
+                                       : -allocation.allocated_bytes;
+      if (bytes > peak.peak_bytes) {
+        peak.peak_bytes = bytes;
+        peak.peak_micros = allocation.alloc_micros;
+        peak_event = i;
+      }
+    }
+    // The buffers live at the peak were allocated by the peak event or
+    // before, and deallocated after it.
+    std::vector<bool> live_at_peak(allocations.size(), false);
+    for (size_t i = 0; i <= peak_event && i < events.size(); ++i) {
+      live_at_peak[events[i].allocation] = events[i].is_allocation;
+    }
+    std::unordered_map<string, OpMemory> ops;
+    for (size_t i = 0; i < allocations.size(); ++i) {
+      OpMemory& op = ops[allocations[i].op];
+      ++op.num_allocations;
+      op.total_allocated_bytes += allocations[i].allocated_bytes;
+      if (peak.peak_bytes > 0 && live_at_peak[i]) {
+        op.allocated_bytes_at_peak += allocations[i].allocated_bytes;
+        op.requested_bytes_at_peak += allocations[i].requested_bytes;
+      }
+    }
+    for (auto& op : ops) {
+      op.second.op = op.first;
+      peak.ops.push_back(std::move(op.second));
+    }
+    std::sort(peak.ops.begin(), peak.ops.end(),
+              [](const OpMemory& a, const OpMemory& b) {
+                if (a.allocated_bytes_at_peak != b.allocated_bytes_at_peak) {
+                  return a.allocated_bytes_at_peak > b.allocated_bytes_at_peak;
+                }
+                return a.op < b.op;
+              });
+    result.push_back(std::move(peak));
+  }
+  return result;
+}
+
+string MemoryTimeline::ToChromeTrace(int64 step_id) const {
+  std::vector<Allocation> allocations;
+  std::vector<Event> memory_events;
+  GetStepEvents(step_id, &allocations, &memory_events);
+  std::vector<string> events;
+  events.push_back(strings::StrCat(
+      "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":0,\"args\":{\"name\":"
+      "\"Memory of step ",
+      step_id, "\"}}"));
+  // Async events of a buffer lifetime are matched by category and id.
+  for (size_t i = 0; i < allocations.size(); ++i) {
+    const Allocation& allocation = allocations[i];
+    const string name = JsonEscape(
+        allocation.tensor.empty() ? allocation.op : allocation.tensor);
+    const string common = strings::StrCat(
+        "\"name\":\"", name, "\",\"cat\":\"", JsonEscape(allocation.allocator),
+        "\",\"pid\":0,\"id\":", i);
+    events.push_back(strings::StrCat(
+        "{", common, ",\"ph\":\"b\",\"ts\":", allocation.alloc_micros,
+        ",\"args\":{\"op\":\"", JsonEscape(allocation.op),
+        "\",\"requested_bytes\":", allocation.requested_bytes,
+        ",\"allocated_bytes\":", allocation.allocated_bytes, "}}"));
+    if (allocation.dealloc_micros != 0) {
+      events.push_back(strings::StrCat("{", common, ",\"ph\":\"e\",\"ts\":",
+                                       allocation.dealloc_micros, "}"));
+    }
+  }
+  std::map<string, int64> bytes_in_use;
+  for (const Event& event : memory_events) {
+    const Allocation& allocation = allocations[event.allocation];
+    int64& bytes = bytes_in_use[allocation.allocator];
+    bytes += event.is_allocation ? allocation.allocated_bytes
+                                 : -allocation.allocated_bytes;
+    const int64 micros = event.is_allocation ? allocation.alloc_micros
+                                             : allocation.dealloc_micros;
+    events.push_back(strings::StrCat(
+        "{\"name\":\"", JsonEscape(allocation.allocator),
+        "\",\"ph\":\"C\",\"pid\":0,\"ts\":", micros,
+        ",\"args\":{\"bytes_in_use\":", bytes, "}}"));
+  }
+  return strings::StrCat("{\"traceEvents\":[",
+                         str_util::Join(events, ",\n"), "]}");
+}
+
+}  // namespace tensorflow
@@ -0,0 +1,154 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_FRAMEWORK_MEMORY_TIMELINE_H_
+#define TENSORFLOW_CORE_FRAMEWORK_MEMORY_TIMELINE_H_
+
+#include <deque>
+#include <map>
+#include <utility>
+#include <vector>
+
+#include "tensorflow/core/framework/log_memory.pb.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+// MemoryTimeline records the allocations and deallocations reported by
+// LogMemory while it is started, as a timeline of buffers with the op that
+// allocated them. It can summarize which ops hold the memory of a step when
+// its usage peaks, and export the timeline of a step to the Chrome trace
+// format.
+//
+// Buffers are matched to their deallocation by allocation id, so only
+// allocators that track allocation ids are recorded (e.g. BFCAllocator). The
+// CPU allocator is made to track them when LogMemory is enabled before its
+// first use.
+//
+// This is meant for debugging the memory usage of a few steps, not to be left
+// started during long runs: recording serializes all allocations on a mutex.
+// Only the buffers of the last `max_steps` steps that allocated memory are
+// kept; of older steps, only the buffers that are still live are kept.
+class MemoryTimeline {
+ public:
+  // A buffer allocated by the kernel or operation `op`.
+  struct Allocation {
+    int64 step_id = 0;
+    string op;
+    // "op:index" if the buffer was output by op, or empty.
+    string tensor;
+    string allocator;
+    int64 allocation_id = 0;
+    int64 requested_bytes = 0;
+    int64 allocated_bytes = 0;
+    int64 alloc_micros = 0;
+    // 0 while the buffer is live.
+    int64 dealloc_micros = 0;
+  };
+
+  // The memory allocated by an op during a step.
+  struct OpMemory {
+    string op;
+    // The bytes allocated by the op that are live when the memory usage of
+    // the allocator peaks, and the part of them that was requested.
+    int64 allocated_bytes_at_peak = 0;
+    int64 requested_bytes_at_peak = 0;
+    int64 num_allocations = 0;
+    int64 total_allocated_bytes = 0;
+  };
+
+  // The peak memory allocated by a step from an allocator.
+  struct PeakMemory {
+    string allocator;
+    int64 peak_bytes = 0;
+    int64 peak_micros = 0;
+    // Sorted by decreasing allocated_bytes_at_peak.
+    std::vector<OpMemory> ops;
+  };
+
+  explicit MemoryTimeline(int max_steps = 8);
+  ~MemoryTimeline();
+
+  // Starts and stops receiving the events of LogMemory. Only one timeline
+  // can be started at a time.
+  Status Start();
+  void Stop();
+
+  // Returns whether a timeline is started. Cheap.
+  static bool IsActive();
+
+  // Returns the allocations made by step `step_id`, in the order they were
+  // made.
+  std::vector<Allocation> GetAllocations(int64 step_id) const;
+
+  // Returns the peak memory allocated by step `step_id` from each allocator,
+  // ordered by allocator name. Memory allocated by other steps, e.g. the
+  // memory of variables, is not included.
+  std::vector<PeakMemory> SummarizePeakMemory(int64 step_id) const;
+
+  // Returns the allocations of step `step_id` in the Chrome trace format: a
+  // counter of the bytes in use from each allocator, and an async event per
+  // buffer lifetime.
+  string ToChromeTrace(int64 step_id) const;
+
+  // Called by LogMemory for the events of the started timeline, if any.
+  static void Record(const MemoryLogTensorAllocation& allocation);
+  static void Record(const MemoryLogTensorDeallocation& deallocation);
+  static void Record(const MemoryLogTensorOutput& output);
+  static void Record(const MemoryLogRawAllocation& allocation);
+  static void Record(const MemoryLogRawDeallocation& deallocation);
+
+ private:
+  using AllocationKey = std::pair<string, int64>;
+
+  // An allocation or deallocation of allocations_[allocation].
+  struct Event {
+    size_t allocation;
+    bool is_allocation;
+  };
+
+  void AddAllocation(Allocation allocation);
+  void AddDeallocation(const string& allocator, int64 allocation_id);
+
+  // Notes that `step_id` allocated memory. If this makes more than
+  // `max_steps_` steps, drops the deallocated buffers of the oldest one.
+  void AddStepLocked(int64 step_id) EXCLUSIVE_LOCKS_REQUIRED(mu_);
+  void DropDeallocatedLocked(int64 step_id) EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  // Returns the allocations of step `step_id`, and their events in the order
+  // they were recorded, with indices into the returned allocations.
+  void GetStepEvents(int64 step_id, std::vector<Allocation>* allocations,
+                     std::vector<Event>* events) const;
+
+  const int max_steps_;
+
+  mutable mutex mu_;
+  // The steps that allocated memory, oldest first.
+  std::deque<int64> steps_ GUARDED_BY(mu_);
+  std::vector<Allocation> allocations_ GUARDED_BY(mu_);
+  std::vector<Event> events_ GUARDED_BY(mu_);
+  // Indices in allocations_ of the live buffers.
+  std::map<AllocationKey, size_t> live_ GUARDED_BY(mu_);
+
+  TF_DISALLOW_COPY_AND_ASSIGN(MemoryTimeline);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_FRAMEWORK_MEMORY_TIMELINE_H_
@@ -0,0 +1,157 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/framework/memory_timeline.h"
+
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/framework/log_memory.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tracking_allocator.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/strings/str_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+constexpr int64 kStepId = 7;
+
+class MemoryTimelineTest : public ::testing::Test {
+ protected:
+  MemoryTimelineTest()
+      : allocator_(new TrackingAllocator(cpu_allocator(), true)) {}
+
+  ~MemoryTimelineTest() override { allocator_->GetRecordsAndUnRef(); }
+
+  // Allocates a tensor of `bytes` on behalf of `op`.
+  Tensor Allocate(const string& op, int64 step_id, int64 bytes) {
+    Tensor tensor(allocator_, DT_INT8, TensorShape({bytes}));
+    LogMemory::RecordTensorAllocation(op, step_id, tensor);
+    return tensor;
+  }
+
+  TrackingAllocator* allocator_;
+};
+
+TEST_F(MemoryTimelineTest, RecordsOnlyWhileStarted) {
+  MemoryTimeline timeline;
+  EXPECT_FALSE(MemoryTimeline::IsActive());
+  { Tensor before = Allocate("before", kStepId, 16); }
+  TF_ASSERT_OK(timeline.Start());
+  EXPECT_TRUE(MemoryTimeline::IsActive());
+  EXPECT_TRUE(LogMemory::IsEnabled());
+  MemoryTimeline other;
+  EXPECT_FALSE(other.Start().ok());
+  { Tensor during = Allocate("during", kStepId, 16); }
+  timeline.Stop();
+  EXPECT_FALSE(MemoryTimeline::IsActive());
+  { Tensor after = Allocate("after", kStepId, 16); }
+
+  std::vector<MemoryTimeline::Allocation> allocations =
+      timeline.GetAllocations(kStepId);
+  ASSERT_EQ(allocations.size(), 1);
+  EXPECT_EQ(allocations[0].op, "during");
+  EXPECT_EQ(allocations[0].requested_bytes, 16);
+  EXPECT_GE(allocations[0].allocated_bytes, 16);
+  EXPECT_NE(allocations[0].dealloc_micros, 0);
+  EXPECT_GE(allocations[0].dealloc_micros, allocations[0].alloc_micros);
+}
+
+TEST_F(MemoryTimelineTest, PeakMemoryByOp) {
+  MemoryTimeline timeline;
+  TF_ASSERT_OK(timeline.Start());
+  {
+    Tensor a = Allocate("a", kStepId, 1024);
+    LogMemory::RecordTensorOutput("a", kStepId, 0, a);
+    { Tensor b = Allocate("b", kStepId, 4096); }
+    // The peak is reached while a, c and d are live.
+    Tensor c1 = Allocate("c", kStepId, 2048);
+    Tensor c2 = Allocate("c", kStepId, 2048);
+    Tensor d = Allocate("d", kStepId, 256);
+    // Other steps are not included.
+    Tensor other = Allocate("other", kStepId + 1, 1 << 20);
+  }
+  timeline.Stop();
+
+  std::vector<MemoryTimeline::Allocation> allocations =
+      timeline.GetAllocations(kStepId);
+  ASSERT_EQ(allocations.size(), 5);
+  EXPECT_EQ(allocations[0].tensor, "a:0");
+  EXPECT_EQ(allocations[1].tensor, "");
+
+  std::vector<MemoryTimeline::PeakMemory> peaks =
+      timeline.SummarizePeakMemory(kStepId);
+  ASSERT_EQ(peaks.size(), 1);
+  EXPECT_EQ(peaks[0].allocator, allocator_->Name());
+  int64 bytes_at_peak = 0;
+  for (const auto& op : peaks[0].ops) {
+    bytes_at_peak += op.allocated_bytes_at_peak;
+  }
+  EXPECT_EQ(peaks[0].peak_bytes, bytes_at_peak);
+  ASSERT_EQ(peaks[0].ops.size(), 4);
+  EXPECT_EQ(peaks[0].ops[0].op, "c");
+  EXPECT_EQ(peaks[0].ops[0].num_allocations, 2);
+  EXPECT_EQ(peaks[0].ops[0].requested_bytes_at_peak, 4096);
+  EXPECT_EQ(peaks[0].ops[1].op, "a");
+  EXPECT_EQ(peaks[0].ops[1].requested_bytes_at_peak, 1024);
+  EXPECT_EQ(peaks[0].ops[2].op, "d");
+  EXPECT_EQ(peaks[0].ops[3].op, "b");
+  EXPECT_EQ(peaks[0].ops[3].allocated_bytes_at_peak, 0);
+  EXPECT_GE(peaks[0].ops[3].total_allocated_bytes, 4096);
+}
+
+TEST_F(MemoryTimelineTest, ChromeTrace) {
+  MemoryTimeline timeline;
+  TF_ASSERT_OK(timeline.Start());
+  {
+    Tensor a = Allocate("a", kStepId, 64);
+    LogMemory::RecordTensorOutput("a", kStepId, 1, a);
+  }
+  timeline.Stop();
+
+  const string trace = timeline.ToChromeTrace(kStepId);
+  EXPECT_TRUE(str_util::StartsWith(trace, "{\"traceEvents\":["));
+  EXPECT_TRUE(str_util::StrContains(trace, "\"name\":\"a:1\""));
+  EXPECT_TRUE(str_util::StrContains(trace, "\"ph\":\"b\""));
+  EXPECT_TRUE(str_util::StrContains(trace, "\"ph\":\"e\""));
+  EXPECT_TRUE(str_util::StrContains(trace, "\"ph\":\"C\""));
+}
+
+TEST_F(MemoryTimelineTest, KeepsOnlyLiveBuffersOfOldSteps) {
+  MemoryTimeline timeline(/*max_steps=*/2);
+  TF_ASSERT_OK(timeline.Start());
+  Tensor live = Allocate("live", kStepId, 16);
+  { Tensor freed = Allocate("freed", kStepId, 16); }
+  { Tensor next = Allocate("next", kStepId + 1, 16); }
+  EXPECT_EQ(timeline.GetAllocations(kStepId).size(), 2);
+  // A third step drops the deallocated buffers of the first one.
+  { Tensor last = Allocate("last", kStepId + 2, 16); }
+  std::vector<MemoryTimeline::Allocation> allocations =
+      timeline.GetAllocations(kStepId);
+  ASSERT_EQ(allocations.size(), 1);
+  EXPECT_EQ(allocations[0].op, "live");
+  EXPECT_EQ(timeline.GetAllocations(kStepId + 1).size(), 1);
+  EXPECT_EQ(timeline.GetAllocations(kStepId + 2).size(), 1);
+
+  // The deallocation of the kept buffer is still matched.
+  live = Tensor();
+  timeline.Stop();
+  allocations = timeline.GetAllocations(kStepId);
+  ASSERT_EQ(allocations.size(), 1);
+  EXPECT_NE(allocations[0].dealloc_micros, 0);
+}
+
+}  // namespace
+}  // namespace tensorflow
@@ -19,10 +19,13 @@ limitations under the License.
 
 #include <algorithm>
 #include <cmath>
+#include <limits>
 
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
 #include "tensorflow/core/framework/run_handler_util.h"
 #include "tensorflow/core/lib/core/threadpool_interface.h"
+#include "tensorflow/core/lib/monitoring/counter.h"
+#include "tensorflow/core/lib/monitoring/sampler.h"
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/context.h"
 #include "tensorflow/core/platform/denormal.h"
@@ -37,6 +40,21 @@ namespace tensorflow {
 namespace {
 static constexpr int32 kMaxConcurrentHandlers = 128;
 
+auto* queueing_delay_usecs = monitoring::Sampler<1>::New(
+    {"/tensorflow/core/run_handler/queueing_delay_usecs",
+     "The average time that the inter-op and intra-op closures of a run "
+     "waited in the run handler queues in microseconds, per priority of the "
+     "run.",
+     "priority"},
+    // Power of 2 with bucket count 30 (> 17 minutes)
+    {monitoring::Buckets::Exponential(1, 2, 30)});
+
+auto* starved_runs = monitoring::Counter<1>::New(
+    "/tensorflow/core/run_handler/starved_runs",
+    "The number of runs scheduled ahead of higher priority runs after waiting "
+    "for longer than the starvation threshold, per priority of the run.",
+    "priority");
+
 // TODO(azaks): Refactor with thread:ThreadPool
 class RunHandlerEnvironment {
   typedef Thread EnvThread;
@@ -44,6 +62,7 @@ class RunHandlerEnvironment {
     std::function<void()> f;
     Context context;
     uint64 trace_id;
+    uint64 enqueue_time_us;
   };
   Env* const env_;
   const ThreadOptions thread_options_;
@@ -82,10 +101,18 @@ class RunHandlerEnvironment {
             std::move(f),
             Context(ContextKind::kThread),
             id,
+            env_->NowMicros(),
         }),
     };
   }
 
+  uint64 NowMicros() { return env_->NowMicros(); }
+
+  // Returns the time spent by "t" in a queue until "now", in microseconds.
+  static uint64 QueueingDelayMicros(const Task& t, uint64 now) {
+    return now > t.f->enqueue_time_us ? now - t.f->enqueue_time_us : 0;
+  }
+
   void ExecuteTask(const Task& t) {
     WithContext wc(t.f->context);
     tracing::ScopedRegion region(tracing::EventCategory::kRunClosure,
@@ -104,6 +131,9 @@ class ThreadWorkSource {
         non_blocking_work_queues_(non_blocking_work_sharding_factor_),
         blocking_inflight_(0),
         non_blocking_inflight_(0),
+        queueing_delay_us_(0),
+        num_dequeued_tasks_(0),
+        waiting_since_us_(0),
         traceme_id_(0) {
     queue_waiters_.next = &queue_waiters_;
     queue_waiters_.prev = &queue_waiters_;
@@ -122,6 +152,7 @@ class ThreadWorkSource {
     mutex* mu = nullptr;
     Queue* task_queue = nullptr;
     thread_local int64 closure_counter = 0;
+    const uint64 enqueue_time_us = t.f->enqueue_time_us;
 
     if (!is_blocking) {
       int queue_index = ++closure_counter % non_blocking_work_sharding_factor_;
@@ -137,6 +168,11 @@ class ThreadWorkSource {
       // For a given queue, only one thread can call PushFront.
       t = task_queue->PushFront(std::move(t));
     }
+    if (!t.f) {
+      uint64 not_waiting = 0;
+      waiting_since_us_.compare_exchange_strong(not_waiting, enqueue_time_us,
+                                                std::memory_order_relaxed);
+    }
 
     // Only wake up the thread that can take tasks from both blocking and
     // non-blocking queues. The rational is that we don't want to wake up more
@@ -212,10 +248,57 @@ class ThreadWorkSource {
     counter->fetch_sub(1, std::memory_order_relaxed);
   }
 
+  void RecordQueueingDelay(uint64 delay_us) {
+    queueing_delay_us_.fetch_add(delay_us, std::memory_order_relaxed);
+    num_dequeued_tasks_.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  // Returns the average queueing delay of the dequeued tasks, in
+  // microseconds, or -1 if no task was dequeued since the last reset.
+  double GetAverageQueueingDelay() {
+    const int64 num_tasks = num_dequeued_tasks_.load(std::memory_order_relaxed);
+    if (num_tasks == 0) return -1;
+    return static_cast<double>(
+               queueing_delay_us_.load(std::memory_order_relaxed)) /
+           num_tasks;
+  }
+
+  void ResetQueueingDelay() {
+    queueing_delay_us_ = 0;
+    num_dequeued_tasks_ = 0;
+    waiting_since_us_ = 0;
+  }
+
+  // Records that a worker dequeued a task at "now_us", so that the tasks
+  // still queued start waiting from then.
+  void RecordDequeue(uint64 now_us) {
+    waiting_since_us_.store(HasQueuedTasks() ? now_us : 0,
+                            std::memory_order_relaxed);
+  }
+
+  // Returns how long the queued tasks have waited for a worker until
+  // "now_us", since the last dequeue or since the first of them was
+  // enqueued, in microseconds. Returns 0 when no task is queued.
+  uint64 GetWaitingMicros(uint64 now_us) {
+    if (!HasQueuedTasks()) return 0;
+    uint64 since = 0;
+    // A task enqueued while a concurrent dequeue found the queues empty
+    // starts waiting now.
+    if (waiting_since_us_.compare_exchange_strong(since, now_us,
+                                                  std::memory_order_relaxed)) {
+      return 0;
+    }
+    return now_us > since ? now_us - since : 0;
+  }
+
   unsigned NonBlockingWorkShardingFactor() {
     return non_blocking_work_sharding_factor_;
   }
 
+  bool HasQueuedTasks() {
+    return TaskQueueSize(true) > 0 || TaskQueueSize(false) > 0;
+  }
+
   std::string ToString() {
     return strings::StrCat("traceme_id = ", GetTracemeId(),
                            ", inter queue size = ", TaskQueueSize(true),
@@ -245,6 +328,11 @@ class ThreadWorkSource {
 
   std::atomic<int64> blocking_inflight_;
   std::atomic<int64> non_blocking_inflight_;
+  std::atomic<uint64> queueing_delay_us_;
+  std::atomic<int64> num_dequeued_tasks_;
+  // Time since unix epoch at which the queued tasks started waiting for a
+  // worker, or 0 when no task is queued.
+  std::atomic<uint64> waiting_since_us_;
 
   Queue blocking_work_queue_;
   mutex blocking_queue_op_mu_;
@@ -446,6 +534,10 @@ void RunHandlerThreadPool::WorkerLoop(int thread_id,
           profiler::TraceMeLevel::kInfo);
       VLOG(2) << "Running " << (task_from_blocking_queue ? "inter" : "intra")
               << " work from " << tws->GetTracemeId();
+      const uint64 dequeue_time_us = env_.NowMicros();
+      tws->RecordQueueingDelay(
+          RunHandlerEnvironment::QueueingDelayMicros(t, dequeue_time_us));
+      tws->RecordDequeue(dequeue_time_us);
       tws->IncrementInflightTaskCount(task_from_blocking_queue);
       env_.ExecuteTask(t);
       tws->DecrementInflightTaskCount(task_from_blocking_queue);
@@ -518,10 +610,19 @@ class RunHandler::Impl {
   // requested via RunHandlerPool::Get().
   uint64 start_time_us() const { return start_time_us_; }
   int64 step_id() const { return step_id_; }
+  int64 priority() const { return priority_; }
+  // The deadline in microseconds since unix epoch, or the largest uint64 when
+  // the run has no deadline.
+  uint64 deadline_us() const { return deadline_us_; }
+  // Whether the queued closures of the handler waited for a worker for
+  // longer than the starvation threshold.
+  bool starved() const { return starved_; }
+  void set_starved(bool starved) { starved_ = starved; }
   void ScheduleInterOpClosure(std::function<void()> fn);
   void ScheduleIntraOpClosure(std::function<void()> fn);
 
-  void Reset(int64 step_id);
+  void Reset(int64 step_id,
+             const RunOptions::Experimental::RunHandlerPoolOptions& options);
 
   RunHandlerPool::Impl* pool_impl() { return pool_impl_; }
 
@@ -544,6 +645,9 @@ class RunHandler::Impl {
   RunHandlerPool::Impl* pool_impl_;  // NOT OWNED.
   uint64 start_time_us_;
   int64 step_id_;
+  int64 priority_;
+  uint64 deadline_us_;
+  bool starved_;
   std::unique_ptr<thread::ThreadPoolInterface> thread_pool_interface_;
   ThreadWorkSource tws_;
 };
@@ -555,15 +659,22 @@ class RunHandlerPool::Impl {
  public:
   explicit Impl(int num_inter_op_threads, int num_intra_op_threads)
       : max_handlers_(kMaxConcurrentHandlers),
+        starvation_threshold_us_(static_cast<uint64>(
+            1000 * ParamFromEnvWithDefault(
+                       "TF_RUN_HANDLER_STARVATION_THRESHOLD_MS", 1000))),
         run_handler_thread_pool_(new RunHandlerThreadPool(
             num_inter_op_threads, num_intra_op_threads, Env::Default(),
             ThreadOptions(), "tf_run_handler_pool")),
-        iterations_(0) {
+        iterations_(0),
+        stop_starvation_monitor_(false) {
     VLOG(1) << "Creating a RunHandlerPool with max handlers: " << max_handlers_;
     for (int i = 0; i < max_handlers_; ++i) {
       handlers_.emplace_back(new RunHandler::Impl(this));
       free_handlers_.push_back(handlers_.back().get());
     }
+    starvation_monitor_.reset(Env::Default()->StartThread(
+        ThreadOptions(), "tf_run_handler_starvation_monitor",
+        [this]() { MonitorStarvation(); }));
   }
 
   ~Impl() {
@@ -572,6 +683,12 @@ class RunHandlerPool::Impl {
     DCHECK_EQ(handlers_.size(), max_handlers_);
     DCHECK_EQ(free_handlers_.size(), handlers_.size());
     DCHECK_EQ(sorted_active_handlers_.size(), 0);
+    {
+      mutex_lock l(mu_);
+      stop_starvation_monitor_ = true;
+    }
+    starvation_monitor_cv_.notify_all();
+    starvation_monitor_.reset();
     // Stop the threads in run_handler_thread_pool_ before freeing other
     // pointers. Otherwise a thread may try to access a pointer after the
     // pointer has been freed.
@@ -582,17 +699,18 @@ class RunHandlerPool::Impl {
     return run_handler_thread_pool_.get();
   }
 
-  std::unique_ptr<RunHandler> Get(int64 step_id) LOCKS_EXCLUDED(mu_) {
+  std::unique_ptr<RunHandler> Get(
+      int64 step_id,
+      const RunOptions::Experimental::RunHandlerPoolOptions& options)
+      LOCKS_EXCLUDED(mu_) {
     mutex_lock l(mu_);
     while (free_handlers_.empty()) {
       one_handler_free_.wait(l);
     }
     // Remove the last entry from free_handlers_ and add to the end of
-    // sorted_active_handlers_.
+    // sorted_active_handlers_, which RecomputePoolStatsLocked() sorts.
     auto* handler_impl = free_handlers_.back();
-    handler_impl->Reset(step_id);
-    // Sortedness isn't violated if we simply add at the end of the list, since
-    // handlers are expected to be obtained in increasing order of time.
+    handler_impl->Reset(step_id, options);
     sorted_active_handlers_.push_back(handler_impl);
     DCHECK_LE(sorted_active_handlers_.size(), max_handlers_);
     free_handlers_.pop_back();
@@ -602,6 +720,11 @@ class RunHandlerPool::Impl {
   }
 
   void ReleaseHandler(RunHandler::Impl* handler) LOCKS_EXCLUDED(mu_) {
+    const double queueing_delay = handler->tws()->GetAverageQueueingDelay();
+    if (queueing_delay >= 0) {
+      queueing_delay_usecs->GetCell(strings::StrCat(handler->priority()))
+          ->Add(queueing_delay);
+    }
     {
       mutex_lock l(mu_);
       DCHECK_GT(sorted_active_handlers_.size(), 0);
@@ -633,6 +756,19 @@ class RunHandlerPool::Impl {
   }
 
  private:
+  // Marks the active handlers whose queued closures waited for longer than
+  // the starvation threshold as starved, and the others as not starved.
+  // Returns true if any handler changed state.
+  bool UpdateStarvationLocked() EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  // Sorts sorted_active_handlers_ in scheduling order.
+  void SortActiveHandlersLocked() EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  // Body of starvation_monitor_: re-evaluates the starvation of the active
+  // handlers periodically, since no Get() or Release() may happen while
+  // a handler starves.
+  void MonitorStarvation() LOCKS_EXCLUDED(mu_);
+
   void RecomputePoolStatsLocked() EXCLUSIVE_LOCKS_REQUIRED(mu_);
 
   // Maximum number of handlers pre-created during pool construction time. The
@@ -641,10 +777,14 @@ class RunHandlerPool::Impl {
   // inference).
   const int max_handlers_;
 
+  // Handlers whose queued closures waited for longer than this are
+  // scheduled first.
+  const uint64 starvation_threshold_us_;
+
   std::unique_ptr<RunHandlerThreadPool> run_handler_thread_pool_;
   // Thread compatible part used only by lock under RunHandlerPool.
-  // Handlers are sorted by start time.
-  // TODO(azaks): sort by the remaining latency budget.
+  // Handlers are sorted by priority, deadline and start time, with the
+  // starved handlers first.
   std::vector<RunHandler::Impl*> sorted_active_handlers_ GUARDED_BY(mu_);
   std::vector<RunHandler::Impl*> free_handlers_ GUARDED_BY(mu_);
   std::vector<std::unique_ptr<RunHandler::Impl>> handlers_ GUARDED_BY(mu_);
@@ -653,12 +793,71 @@ class RunHandlerPool::Impl {
 
   int64 iterations_ GUARDED_BY(mu_);
   condition_variable one_handler_free_;
+  bool stop_starvation_monitor_ GUARDED_BY(mu_);
+  condition_variable starvation_monitor_cv_;
   mutex mu_;
+  std::unique_ptr<Thread> starvation_monitor_;
 };
 
+bool RunHandlerPool::Impl::UpdateStarvationLocked() {
+  const uint64 now = Env::Default()->NowMicros();
+  bool changed = false;
+  for (RunHandler::Impl* handler : sorted_active_handlers_) {
+    const bool starved =
+        handler->tws()->GetWaitingMicros(now) > starvation_threshold_us_;
+    if (starved == handler->starved()) continue;
+    handler->set_starved(starved);
+    changed = true;
+    if (!starved) continue;
+    const bool preempts_higher_priority = std::any_of(
+        sorted_active_handlers_.begin(), sorted_active_handlers_.end(),
+        [handler](const RunHandler::Impl* other) {
+          return !other->starved() && other->priority() > handler->priority();
+        });
+    if (preempts_higher_priority) {
+      starved_runs->GetCell(strings::StrCat(handler->priority()))
+          ->IncrementBy(1);
+    }
+  }
+  return changed;
+}
+
+void RunHandlerPool::Impl::SortActiveHandlersLocked() {
+  UpdateStarvationLocked();
+  std::stable_sort(
+      sorted_active_handlers_.begin(), sorted_active_handlers_.end(),
+      [](const RunHandler::Impl* a, const RunHandler::Impl* b) {
+        if (a->starved() != b->starved()) return a->starved();
+        if (!a->starved()) {
+          if (a->priority() != b->priority()) {
+            return a->priority() > b->priority();
+          }
+          if (a->deadline_us() != b->deadline_us()) {
+            return a->deadline_us() < b->deadline_us();
+          }
+        }
+        return a->start_time_us() < b->start_time_us();
+      });
+}
+
+void RunHandlerPool::Impl::MonitorStarvation() {
+  // Check a few times per threshold so that a starved handler is promoted
+  // soon after it crosses it.
+  const int64 interval_us =
+      std::max<int64>(1000, starvation_threshold_us_ / 4);
+  mutex_lock l(mu_);
+  while (!stop_starvation_monitor_) {
+    starvation_monitor_cv_.wait_for(l, std::chrono::microseconds(interval_us));
+    if (!stop_starvation_monitor_ && UpdateStarvationLocked()) {
+      RecomputePoolStatsLocked();
+    }
+  }
+}
+
 void RunHandlerPool::Impl::RecomputePoolStatsLocked() {
   int num_active_requests = sorted_active_handlers_.size();
   if (num_active_requests == 0) return;
+  SortActiveHandlersLocked();
   Eigen::MaxSizeVector<ThreadWorkSource*> thread_work_sources(
       num_active_requests);
 
@@ -731,7 +930,7 @@ void RunHandler::Impl::ThreadPoolInterfaceWrapper::Schedule(
 RunHandler::Impl::Impl(RunHandlerPool::Impl* pool_impl)
     : pool_impl_(pool_impl) {
   thread_pool_interface_.reset(new ThreadPoolInterfaceWrapper(this));
-  Reset(0);
+  Reset(0, RunOptions::Experimental::RunHandlerPoolOptions());
 }
 
 void RunHandler::Impl::ScheduleInterOpClosure(std::function<void()> fn) {
@@ -746,10 +945,18 @@ void RunHandler::Impl::ScheduleIntraOpClosure(std::function<void()> fn) {
                                                         std::move(fn));
 }
 
-void RunHandler::Impl::Reset(int64 step_id) {
+void RunHandler::Impl::Reset(
+    int64 step_id,
+    const RunOptions::Experimental::RunHandlerPoolOptions& options) {
   start_time_us_ = tensorflow::Env::Default()->NowMicros();
   step_id_ = step_id;
+  priority_ = options.priority();
+  deadline_us_ = options.deadline_in_ms() > 0
+                     ? start_time_us_ + 1000 * options.deadline_in_ms()
+                     : std::numeric_limits<uint64>::max();
+  starved_ = false;
   tws_.SetTracemeId(step_id);
+  tws_.ResetQueueingDelay();
 }
 
 RunHandlerPool::RunHandlerPool(int num_inter_op_threads)
@@ -761,8 +968,10 @@ RunHandlerPool::RunHandlerPool(int num_inter_op_threads,
 
 RunHandlerPool::~RunHandlerPool() {}
 
-std::unique_ptr<RunHandler> RunHandlerPool::Get(int64 step_id) {
-  return impl_->Get(step_id);
+std::unique_ptr<RunHandler> RunHandlerPool::Get(
+    int64 step_id,
+    const RunOptions::Experimental::RunHandlerPoolOptions& options) {
+  return impl_->Get(step_id, options);
 }
 
 RunHandler::RunHandler(Impl* impl) : impl_(impl) {}
@@ -62,7 +62,19 @@ class RunHandlerPool {
   // unique_ptr is destroyed.
   //
   // Will block unless there is an inactive handler.
-  std::unique_ptr<RunHandler> Get(int64 step_id = 0);
+  //
+  // The inter-op and intra-op work of the active handlers is scheduled by
+  // decreasing options.priority, then by earliest deadline, then by the
+  // time of the Get() call. A handler whose queued closures have waited for
+  // a worker for longer than TF_RUN_HANDLER_STARVATION_THRESHOLD_MS
+  // milliseconds (1000 by default) since it was last served is scheduled
+  // ahead of the other handlers regardless of its priority, until one of its
+  // closures is dequeued, so that a sustained load of higher priority runs
+  // cannot starve it.
+  std::unique_ptr<RunHandler> Get(
+      int64 step_id = 0,
+      const RunOptions::Experimental::RunHandlerPoolOptions& options =
+          RunOptions::Experimental::RunHandlerPoolOptions());
 
  private:
   class Impl;
@@ -74,7 +86,7 @@ class RunHandlerPool {
 // RunHandler can be used to schedule inter/intra-op closures to run on a global
 // pool shared across all Session::Run(s). The closures are enqueued to a
 // handler specific queue, from which the work is stolen in a priority order
-// (time of the Get() call).
+// (priority and deadline of the run, then time of the Get() call).
 //
 // It can only be created via RunHandlerPool::Get().
 //
@@ -25,10 +25,13 @@ limitations under the License.
 #include "absl/synchronization/barrier.h"
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
 #include "tensorflow/core/lib/core/blocking_counter.h"
+#include "tensorflow/core/lib/core/notification.h"
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/protobuf/config.pb.h"
 
 namespace tensorflow {
 namespace {
@@ -72,5 +75,124 @@ TEST(RunHandlerUtilTest, TestBasicScheduling) {
   counter.Wait();
 }
 
+RunOptions::Experimental::RunHandlerPoolOptions MakeOptions(
+    int64 priority, int64 deadline_in_ms) {
+  RunOptions::Experimental::RunHandlerPoolOptions options;
+  options.set_priority(priority);
+  options.set_deadline_in_ms(deadline_in_ms);
+  return options;
+}
+
+// Gets a handler with each of "options", sleeping for "sleep_micros" between
+// the calls, and returns the order in which the single inter-op thread of
+// "pool" runs the closures that they schedule.
+std::vector<int> RunClosuresInSchedulingOrder(
+    RunHandlerPool* pool,
+    const std::vector<RunOptions::Experimental::RunHandlerPoolOptions>&
+        options,
+    int64 sleep_micros) {
+  // Keep the thread busy until all the closures are enqueued.
+  auto blocking_handler = pool->Get(0);
+  Notification blocking_closure_started;
+  Notification unblock;
+  blocking_handler->ScheduleInterOpClosure([&]() {
+    blocking_closure_started.Notify();
+    unblock.WaitForNotification();
+  });
+  blocking_closure_started.WaitForNotification();
+
+  mutex mu;
+  std::vector<int> order;
+  BlockingCounter counter(options.size());
+  std::vector<std::unique_ptr<RunHandler>> handlers;
+  for (int i = 0; i < options.size(); ++i) {
+    if (i > 0) Env::Default()->SleepForMicroseconds(sleep_micros);
+    handlers.push_back(pool->Get(i + 1, options[i]));
+    handlers.back()->ScheduleInterOpClosure([&mu, &order, &counter, i]() {
+      {
+        mutex_lock l(mu);
+        order.push_back(i);
+      }
+      counter.DecrementCount();
+    });
+  }
+  unblock.Notify();
+  counter.Wait();
+  return order;
+}
+
+TEST(RunHandlerTest, SchedulesByPriority) {
+  RunHandlerPool pool(1, 0);
+  EXPECT_EQ(RunClosuresInSchedulingOrder(
+                &pool, {MakeOptions(0, 0), MakeOptions(2, 0),
+                        MakeOptions(1, 0), MakeOptions(2, 0)},
+                0),
+            std::vector<int>({1, 3, 2, 0}));
+}
+
+TEST(RunHandlerTest, SchedulesByDeadlineWithinPriority) {
+  RunHandlerPool pool(1, 0);
+  EXPECT_EQ(RunClosuresInSchedulingOrder(
+                &pool, {MakeOptions(0, 0), MakeOptions(0, 100000),
+                        MakeOptions(0, 10), MakeOptions(1, 100000)},
+                0),
+            std::vector<int>({3, 2, 1, 0}));
+}
+
+TEST(RunHandlerTest, SchedulesStarvedRunsFirst) {
+  setenv("TF_RUN_HANDLER_STARVATION_THRESHOLD_MS", "10", 1);
+  RunHandlerPool pool(1, 0);
+  unsetenv("TF_RUN_HANDLER_STARVATION_THRESHOLD_MS");
+  // The low priority run has waited for more than 10ms when the high
+  // priority one arrives.
+  EXPECT_EQ(RunClosuresInSchedulingOrder(
+                &pool, {MakeOptions(0, 0), MakeOptions(1, 0)}, 50000),
+            std::vector<int>({0, 1}));
+}
+
+TEST(RunHandlerTest, DoesNotPromoteLongRunningRunsThatAreServed) {
+  setenv("TF_RUN_HANDLER_STARVATION_THRESHOLD_MS", "10", 1);
+  RunHandlerPool pool(1, 0);
+  unsetenv("TF_RUN_HANDLER_STARVATION_THRESHOLD_MS");
+  auto low_priority_handler = pool.Get(1, MakeOptions(0, 0));
+
+  mutex mu;
+  std::vector<int> order;
+  BlockingCounter counter(2);
+  auto record = [&mu, &order, &counter](int i) {
+    {
+      mutex_lock l(mu);
+      order.push_back(i);
+    }
+    counter.DecrementCount();
+  };
+
+  // The low priority run keeps the single inter-op thread busy with short
+  // closures for much longer than the threshold, then enqueues one more and
+  // blocks the thread until the high priority run has enqueued its own.
+  const uint64 end_time_us = Env::Default()->NowMicros() + 50000;
+  Notification last_closure_started;
+  Notification unblock;
+  std::function<void()> step;
+  step = [&]() {
+    if (Env::Default()->NowMicros() < end_time_us) {
+      Env::Default()->SleepForMicroseconds(1000);
+      low_priority_handler->ScheduleInterOpClosure(step);
+      return;
+    }
+    low_priority_handler->ScheduleInterOpClosure([&record]() { record(0); });
+    last_closure_started.Notify();
+    unblock.WaitForNotification();
+  };
+  low_priority_handler->ScheduleInterOpClosure(step);
+  last_closure_started.WaitForNotification();
+
+  auto high_priority_handler = pool.Get(2, MakeOptions(1, 0));
+  high_priority_handler->ScheduleInterOpClosure([&record]() { record(1); });
+  unblock.Notify();
+  counter.Wait();
+  EXPECT_EQ(order, std::vector<int>({1, 0}));
+}
+
 }  // namespace
 }  // namespace tensorflow
@@ -0,0 +1,412 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/optimizers/fake_quant_to_int8.h"
+
+#include <algorithm>
+#include <cmath>
+#include <set>
+#include <vector>
+
+#include "absl/strings/str_cat.h"
+#include "tensorflow/core/framework/attr_value.pb.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/framework/node_def_util.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor.pb.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/grappler/op_types.h"
+#include "tensorflow/core/grappler/optimizers/custom_graph_optimizer_registry.h"
+#include "tensorflow/core/grappler/utils.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/lite/experimental/ruy/platform.h"
+
+namespace tensorflow {
+namespace grappler {
+
+namespace {
+
+constexpr char kQuantizedInt8MatMul[] = "_QuantizedInt8MatMul";
+constexpr char kQuantizedInt8Conv2D[] = "_QuantizedInt8Conv2D";
+
+// Whether ruy, which runs the int8 kernels, has an optimized path in this
+// build.
+constexpr bool kRuyHasSimdPath = RUY_PLATFORM(NEON) || RUY_PLATFORM(AVX512);
+
+// A contraction with fake-quantized input and weights, and an optional
+// BiasAdd.
+struct Int8Contraction {
+  NodeDef* contraction = nullptr;
+  NodeDef* bias_add = nullptr;
+  const NodeDef* input_fake_quant = nullptr;
+  const NodeDef* weights_fake_quant = nullptr;
+  // The int8 weights, and the ranges of their symmetric per-channel
+  // quantization.
+  Tensor weights;
+  Tensor weights_min;
+  Tensor weights_max;
+};
+
+bool IsFakeQuantWithMinMaxVars(const NodeDef& node) {
+  return node.op() == "FakeQuantWithMinMaxVars" ||
+         node.op() == "FakeQuantWithMinMaxVarsPerChannel";
+}
+
+// Returns the value of the constant node producing `input`.
+bool GetConstantInput(const NodeMap& node_map, const string& input,
+                      Tensor* tensor) {
+  int position;
+  const NodeDef* node = node_map.GetNode(ParseNodeName(input, &position));
+  if (node == nullptr || position != 0 || !IsConstant(*node) ||
+      HasControlInputs(*node)) {
+    return false;
+  }
+  const auto value = node->attr().find("value");
+  return value != node->attr().end() &&
+         tensor->FromProto(value->second.tensor()) &&
+         tensor->dtype() == DT_FLOAT;
+}
+
+// Returns the input of `node` at `index` if it is an 8 bits
+// FakeQuantWithMinMaxVars with constant ranges.
+const NodeDef* GetFakeQuantInput(const NodeMap& node_map, const NodeDef& node,
+                                 int index, Tensor* min, Tensor* max,
+                                 bool* narrow_range) {
+  int position;
+  const NodeDef* fake_quant =
+      node_map.GetNode(ParseNodeName(node.input(index), &position));
+  if (fake_quant == nullptr || position != 0 ||
+      !IsFakeQuantWithMinMaxVars(*fake_quant) ||
+      HasControlInputs(*fake_quant)) {
+    return nullptr;
+  }
+  int num_bits = 8;
+  TryGetNodeAttr(*fake_quant, "num_bits", &num_bits);
+  *narrow_range = false;
+  TryGetNodeAttr(*fake_quant, "narrow_range", narrow_range);
+  if (num_bits != 8 || !GetConstantInput(node_map, fake_quant->input(1), min) ||
+      !GetConstantInput(node_map, fake_quant->input(2), max) ||
+      min->NumElements() != max->NumElements()) {
+    return nullptr;
+  }
+  return fake_quant;
+}
+
+// Same as Nudge() in kernels/fake_quant_ops_functor.h. Returns false for an
+// empty range.
+bool NudgeRange(float min, float max, int quant_min, int quant_max,
+                float* nudged_min, float* scale, int* zero_point) {
+  if (!(min < max)) return false;
+  const float quant_min_float = static_cast<float>(quant_min);
+  const float quant_max_float = static_cast<float>(quant_max);
+  *scale = (max - min) / (quant_max_float - quant_min_float);
+  const float zero_point_from_min = quant_min_float - min / *scale;
+  if (zero_point_from_min < quant_min_float) {
+    *zero_point = quant_min;
+  } else if (zero_point_from_min > quant_max_float) {
+    *zero_point = quant_max;
+  } else {
+    *zero_point = static_cast<int>(std::round(zero_point_from_min));
+  }
+  *nudged_min = (quant_min_float - *zero_point) * (*scale);
+  return true;
+}
+
+// Quantizes the fake-quantized `weights` of `num_channels` output channels to
+// symmetric int8 values, which the kernels multiply by the per-channel scale
+// max(|min[c]|, |max[c]|) / 127. Fails if a fake-quantized value can not be
+// represented, which happens when the range is far from symmetric.
+bool QuantizeWeights(const Tensor& weights, const Tensor& min,
+                     const Tensor& max, bool narrow_range, int64 num_channels,
+                     Int8Contraction* matched) {
+  const int64 num_ranges = min.NumElements();
+  const int quant_min = narrow_range ? 1 : 0;
+  const int quant_max = 255;
+  std::vector<float> nudged_min(num_ranges);
+  std::vector<float> scale(num_ranges);
+  std::vector<int> zero_point(num_ranges);
+  for (int64 r = 0; r < num_ranges; ++r) {
+    if (!NudgeRange(min.flat<float>()(r), max.flat<float>()(r), quant_min,
+                    quant_max, &nudged_min[r], &scale[r], &zero_point[r])) {
+      return false;
+    }
+  }
+
+  // Per-channel ranges apply to the last dimension, which holds the output
+  // channels of the supported contractions.
+  matched->weights = Tensor(DT_QINT8, weights.shape());
+  auto weights_flat = weights.flat<float>();
+  auto quantized_flat = matched->weights.flat<qint8>();
+  for (int64 i = 0; i < weights.NumElements(); ++i) {
+    const int64 r = num_ranges == 1 ? 0 : i % num_ranges;
+    const float nudged_max = (quant_max - zero_point[r]) * scale[r];
+    const float clamped =
+        std::min(std::max(weights_flat(i), nudged_min[r]), nudged_max);
+    const int quantized =
+        static_cast<int>(
+            std::floor((clamped - nudged_min[r]) / scale[r] + 0.5f)) -
+        zero_point[r];
+    if (quantized < -127 || quantized > 127) return false;
+    quantized_flat(i) = static_cast<int8>(quantized);
+  }
+
+  matched->weights_min = Tensor(DT_FLOAT, TensorShape({num_channels}));
+  matched->weights_max = Tensor(DT_FLOAT, TensorShape({num_channels}));
+  for (int64 c = 0; c < num_channels; ++c) {
+    const int64 r = num_ranges == 1 ? 0 : c;
+    matched->weights_min.flat<float>()(c) = -127.0f * scale[r];
+    matched->weights_max.flat<float>()(c) = 127.0f * scale[r];
+  }
+  return true;
+}
+
+bool FindInt8Contraction(const NodeMap& node_map,
+                         const std::set<string>& nodes_to_preserve,
+                         NodeDef* node, Int8Contraction* matched) {
+  const bool is_matmul = IsMatMul(*node);
+  if ((!is_matmul && !IsConv2D(*node)) || !NodeIsOnCpu(node) ||
+      HasControlInputs(*node)) {
+    return false;
+  }
+  DataType dtype;
+  if (!TryGetNodeAttr(*node, "T", &dtype) || dtype != DT_FLOAT) return false;
+
+  bool transpose_weights = false;
+  if (is_matmul) {
+    bool transpose_a = false;
+    TryGetNodeAttr(*node, "transpose_a", &transpose_a);
+    TryGetNodeAttr(*node, "transpose_b", &transpose_weights);
+    if (transpose_a) return false;
+  } else {
+    string data_format = "NHWC";
+    string padding;
+    TryGetNodeAttr(*node, "data_format", &data_format);
+    TryGetNodeAttr(*node, "padding", &padding);
+    if (data_format != "NHWC" || (padding != "SAME" && padding != "VALID")) {
+      return false;
+    }
+  }
+
+  Tensor input_min, input_max;
+  bool input_narrow_range;
+  matched->input_fake_quant = GetFakeQuantInput(
+      node_map, *node, 0, &input_min, &input_max, &input_narrow_range);
+  // The kernels quantize their input like a FakeQuantWithMinMaxVars that is
+  // not narrow range.
+  if (matched->input_fake_quant == nullptr ||
+      matched->input_fake_quant->op() != "FakeQuantWithMinMaxVars" ||
+      input_narrow_range) {
+    return false;
+  }
+
+  Tensor weights_min, weights_max;
+  bool weights_narrow_range;
+  matched->weights_fake_quant = GetFakeQuantInput(
+      node_map, *node, 1, &weights_min, &weights_max, &weights_narrow_range);
+  Tensor weights;
+  if (matched->weights_fake_quant == nullptr ||
+      !GetConstantInput(node_map, matched->weights_fake_quant->input(0),
+                        &weights)) {
+    return false;
+  }
+  const int rank = is_matmul ? 2 : 4;
+  if (weights.dims() != rank) return false;
+  const int64 num_channels =
+      weights.dim_size(transpose_weights ? 0 : rank - 1);
+  const int64 num_ranges = weights_min.NumElements();
+  if (num_ranges != 1 && (transpose_weights || num_ranges != num_channels)) {
+    return false;
+  }
+  if (!QuantizeWeights(weights, weights_min, weights_max,
+                       weights_narrow_range, num_channels, matched)) {
+    return false;
+  }
+
+  matched->contraction = node;
+  matched->bias_add = nullptr;
+  const auto& fanout = node_map.GetOutputs(node->name());
+  if (fanout.size() == 1 && nodes_to_preserve.count(node->name()) == 0) {
+    NodeDef* bias_add = *fanout.begin();
+    Tensor bias;
+    string data_format = "NHWC";
+    TryGetNodeAttr(*bias_add, "data_format", &data_format);
+    if (IsBiasAdd(*bias_add) && NodeName(bias_add->input(0)) == node->name() &&
+        !HasControlInputs(*bias_add) && data_format == "NHWC" &&
+        GetConstantInput(node_map, bias_add->input(1), &bias)) {
+      matched->bias_add = bias_add;
+    }
+  }
+  return true;
+}
+
+NodeDef MakeConstNode(const string& name, const string& device,
+                      const Tensor& value) {
+  NodeDef node;
+  node.set_name(name);
+  node.set_op("Const");
+  node.set_device(device);
+  (*node.mutable_attr())["dtype"].set_type(value.dtype());
+  value.AsProtoTensorContent((*node.mutable_attr())["value"].mutable_tensor());
+  return node;
+}
+
+// Replaces the BiasAdd, or the contraction if there is none, with the int8
+// contraction, and returns the constant nodes it needs.
+void RewriteInt8Contraction(const Int8Contraction& matched,
+                            std::vector<NodeDef>* new_nodes) {
+  const NodeDef& contraction = *matched.contraction;
+  NodeDef* fused = matched.bias_add != nullptr ? matched.bias_add
+                                               : matched.contraction;
+  const string& device = contraction.device();
+
+  const string weights_name = absl::StrCat(fused->name(), "/int8_weights");
+  const string weights_min_name = absl::StrCat(fused->name(), "/int8_min");
+  const string weights_max_name = absl::StrCat(fused->name(), "/int8_max");
+  new_nodes->push_back(MakeConstNode(weights_name, device, matched.weights));
+  new_nodes->push_back(
+      MakeConstNode(weights_min_name, device, matched.weights_min));
+  new_nodes->push_back(
+      MakeConstNode(weights_max_name, device, matched.weights_max));
+
+  string bias_name;
+  if (matched.bias_add != nullptr) {
+    bias_name = matched.bias_add->input(1);
+  } else {
+    bias_name = absl::StrCat(fused->name(), "/int8_bias");
+    Tensor bias(DT_FLOAT, TensorShape({matched.weights_min.NumElements()}));
+    bias.flat<float>().setZero();
+    new_nodes->push_back(MakeConstNode(bias_name, device, bias));
+  }
+
+  NodeDef int8_contraction;
+  int8_contraction.set_name(fused->name());
+  int8_contraction.set_device(device);
+  const NodeDef& input_fake_quant = *matched.input_fake_quant;
+  int8_contraction.add_input(input_fake_quant.input(0));
+  int8_contraction.add_input(weights_name);
+  int8_contraction.add_input(bias_name);
+  int8_contraction.add_input(input_fake_quant.input(1));
+  int8_contraction.add_input(input_fake_quant.input(2));
+  int8_contraction.add_input(weights_min_name);
+  int8_contraction.add_input(weights_max_name);
+  // The output range is only used by a qint8 output.
+  int8_contraction.add_input(input_fake_quant.input(1));
+  int8_contraction.add_input(input_fake_quant.input(2));
+
+  auto* attr = int8_contraction.mutable_attr();
+  (*attr)["Tinput"].set_type(DT_FLOAT);
+  (*attr)["Toutput"].set_type(DT_FLOAT);
+  if (IsMatMul(contraction)) {
+    int8_contraction.set_op(kQuantizedInt8MatMul);
+    for (const char* name : {"transpose_a", "transpose_b"}) {
+      const auto it = contraction.attr().find(name);
+      if (it != contraction.attr().end()) (*attr)[name] = it->second;
+    }
+  } else {
+    int8_contraction.set_op(kQuantizedInt8Conv2D);
+    for (const char* name :
+         {"strides", "padding", "data_format", "dilations"}) {
+      const auto it = contraction.attr().find(name);
+      if (it != contraction.attr().end()) (*attr)[name] = it->second;
+    }
+  }
+  fused->Swap(&int8_contraction);
+}
+
+}  // namespace
+
+Status FakeQuantToInt8::Init(
+    const tensorflow::RewriterConfig_CustomGraphOptimizer* config) {
+  if (config == nullptr) return Status::OK();
+  const auto it = config->parameter_map().find("rewrite_without_simd");
+  if (it != config->parameter_map().end()) {
+    rewrite_without_simd_ = it->second.b();
+  }
+  return Status::OK();
+}
+
+Status FakeQuantToInt8::Optimize(Cluster* cluster, const GrapplerItem& item,
+                                 GraphDef* optimized_graph) {
+  if (!kRuyHasSimdPath && !rewrite_without_simd_) {
+    return errors::Aborted(
+        "The int8 kernels only have a portable path in this build");
+  }
+  *optimized_graph = item.graph;
+  const std::set<string> nodes_to_preserve(item.NodesToPreserve().begin(),
+                                           item.NodesToPreserve().end());
+
+  // Nodes are rewritten in place, and the new constant nodes are added once
+  // all the rewrites are done, so that the NodeDef pointers stay valid.
+  std::vector<NodeDef> new_nodes;
+  std::set<string> maybe_dead_nodes;
+  {
+    NodeMap node_map(optimized_graph);
+    std::vector<Int8Contraction> matches;
+    for (NodeDef& node : *optimized_graph->mutable_node()) {
+      Int8Contraction matched;
+      if (FindInt8Contraction(node_map, nodes_to_preserve, &node, &matched)) {
+        matches.push_back(matched);
+      }
+    }
+    for (const Int8Contraction& matched : matches) {
+      if (matched.bias_add != nullptr) {
+        maybe_dead_nodes.insert(matched.contraction->name());
+      }
+      maybe_dead_nodes.insert(matched.input_fake_quant->name());
+      maybe_dead_nodes.insert(matched.weights_fake_quant->name());
+      for (const string& input : matched.weights_fake_quant->input()) {
+        maybe_dead_nodes.insert(NodeName(input));
+      }
+    }
+    for (const Int8Contraction& matched : matches) {
+      RewriteInt8Contraction(matched, &new_nodes);
+    }
+  }
+  if (new_nodes.empty()) {
+    return errors::Aborted("Nothing to do.");
+  }
+  for (NodeDef& node : new_nodes) {
+    optimized_graph->add_node()->Swap(&node);
+  }
+
+  // Removes the replaced nodes once all their consumers are removed.
+  NodeMap node_map(optimized_graph);
+  std::set<string> nodes_to_delete;
+  bool changed = true;
+  while (changed) {
+    changed = false;
+    for (const string& name : maybe_dead_nodes) {
+      if (nodes_to_delete.count(name) > 0 ||
+          nodes_to_preserve.count(name) > 0) {
+        continue;
+      }
+      const auto& fanout = node_map.GetOutputs(name);
+      if (std::all_of(fanout.begin(), fanout.end(),
+                      [&nodes_to_delete](const NodeDef* output) {
+                        return nodes_to_delete.count(output->name()) > 0;
+                      })) {
+        nodes_to_delete.insert(name);
+        changed = true;
+      }
+    }
+  }
+  EraseNodesFromGraph(nodes_to_delete, optimized_graph);
+  return Status::OK();
+}
+
+REGISTER_GRAPH_OPTIMIZER_AS(FakeQuantToInt8, "fake_quant_to_int8");
+
+}  // end namespace grappler
+}  // end namespace tensorflow
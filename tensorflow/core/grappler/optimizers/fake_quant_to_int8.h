@@ -0,0 +1,67 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_FAKE_QUANT_TO_INT8_H_
+#define TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_FAKE_QUANT_TO_INT8_H_
+
+#include "tensorflow/core/grappler/optimizers/custom_graph_optimizer.h"
+
+namespace tensorflow {
+namespace grappler {
+
+// Rewrites the MatMul and Conv2D nodes of quantization-aware trained graphs
+// into _QuantizedInt8MatMul and _QuantizedInt8Conv2D nodes running on CPU.
+//
+// A contraction is rewritten when its input is an 8 bits
+// FakeQuantWithMinMaxVars with constant ranges, and its weights are constants
+// fake-quantized with constant ranges, per tensor or per output channel. The
+// weights are quantized to int8 by the rewrite, and a following BiasAdd with a
+// constant bias is fused. The output stays in float.
+//
+// The optimizer is not enabled by default, and runs when "fake_quant_to_int8"
+// is listed in the custom optimizers of the RewriterConfig.
+//
+// The int8 kernels are only faster than the float ones when ruy has an
+// optimized path for the CPU, so graphs are left as is in builds where ruy
+// only has its portable C++ path, unless the "rewrite_without_simd" parameter
+// is true. On x86, ruy builds its AVX-512 path with Clang on Linux or with
+// RUY_FORCE_ENABLE_X86_ENHANCEMENTS defined, and with AVX-512 enabled (e.g.
+// --copt=-march=skylake-avx512).
+class FakeQuantToInt8 : public CustomGraphOptimizer {
+ public:
+  FakeQuantToInt8() = default;
+  ~FakeQuantToInt8() override = default;
+
+  string name() const override { return "fake_quant_to_int8"; }
+
+  bool UsesFunctionLibrary() const override { return false; }
+
+  Status Init(
+      const tensorflow::RewriterConfig_CustomGraphOptimizer* config) override;
+
+  Status Optimize(Cluster* cluster, const GrapplerItem& item,
+                  GraphDef* optimized_graph) override;
+
+  void Feedback(Cluster* cluster, const GrapplerItem& item,
+                const GraphDef& optimized_graph, double result) override {}
+
+ private:
+  bool rewrite_without_simd_ = false;
+};
+
+}  // end namespace grappler
+}  // end namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_FAKE_QUANT_TO_INT8_H_
@@ -0,0 +1,180 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/optimizers/fake_quant_to_int8.h"
+
+#include "tensorflow/cc/ops/standard_ops.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/grappler/optimizers/custom_graph_optimizer_registry.h"
+#include "tensorflow/core/grappler/utils/grappler_test.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace {
+
+class FakeQuantToInt8Test : public GrapplerTest {
+ protected:
+  // Returns random weights that are fake-quantized per channel with narrow
+  // range, like quantization-aware training does.
+  Output FakeQuantWeights(const Scope& s, const TensorShape& shape) {
+    const int64 num_channels = shape.dim_size(shape.dims() - 1);
+    Tensor weights = GenerateRandomTensor<DT_FLOAT>(shape);
+    Tensor min(DT_FLOAT, TensorShape({num_channels}));
+    Tensor max(DT_FLOAT, TensorShape({num_channels}));
+    for (int64 c = 0; c < num_channels; ++c) {
+      max.flat<float>()(c) = 0.5f + 0.1f * c;
+      min.flat<float>()(c) = -max.flat<float>()(c);
+    }
+    auto weights_const = ops::Const(s.WithOpName("weights"), weights);
+    auto min_const = ops::Const(s.WithOpName("weights_min"), min);
+    auto max_const = ops::Const(s.WithOpName("weights_max"), max);
+    return ops::FakeQuantWithMinMaxVarsPerChannel(
+        s.WithOpName("weights_fq"), weights_const, min_const, max_const,
+        ops::FakeQuantWithMinMaxVarsPerChannel::NarrowRange(true));
+  }
+
+  Output FakeQuantInput(const Scope& s, const Output& input) {
+    auto min = ops::Const(s.WithOpName("input_min"), -1.5f);
+    auto max = ops::Const(s.WithOpName("input_max"), 2.5f);
+    return ops::FakeQuantWithMinMaxVars(s.WithOpName("input_fq"), input, min,
+                                        max);
+  }
+
+  // Optimizes `item` with the registered optimizer, and checks that the
+  // rewritten graph computes the same values.
+  void OptimizeAndVerify(GrapplerItem* item, GraphDef* output) {
+    // Place all nodes on CPU.
+    for (int i = 0; i < item->graph.node_size(); ++i) {
+      item->graph.mutable_node(i)->set_device("/device:CPU:0");
+    }
+
+    auto optimizer =
+        CustomGraphOptimizerRegistry::CreateByNameOrNull("fake_quant_to_int8");
+    ASSERT_NE(optimizer, nullptr);
+    // Also rewrites with ruy's portable path, which computes the same values.
+    RewriterConfig_CustomGraphOptimizer config;
+    (*config.mutable_parameter_map())["rewrite_without_simd"].set_b(true);
+    TF_ASSERT_OK(optimizer->Init(&config));
+    TF_ASSERT_OK(optimizer->Optimize(nullptr, *item, output));
+
+    auto tensors_expected =
+        EvaluateNodes(item->graph, item->fetch, item->feed);
+    ASSERT_EQ(tensors_expected.size(), 1);
+    auto tensors = EvaluateNodes(*output, item->fetch, item->feed);
+    ASSERT_EQ(tensors.size(), 1);
+    test::ExpectTensorNear<float>(tensors[0], tensors_expected[0], 1e-3);
+  }
+};
+
+TEST_F(FakeQuantToInt8Test, MatMulWithBias) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  auto input = ops::Placeholder(s.WithOpName("input"), DT_FLOAT,
+                                ops::Placeholder::Shape({4, 32}));
+  auto weights = FakeQuantWeights(s, TensorShape({32, 16}));
+  auto matmul =
+      ops::MatMul(s.WithOpName("matmul"), FakeQuantInput(s, input), weights);
+  auto bias = ops::Const(s.WithOpName("bias"),
+                         GenerateRandomTensor<DT_FLOAT>(TensorShape({16})));
+  auto bias_add = ops::BiasAdd(s.WithOpName("bias_add"), matmul, bias);
+  auto fetch = ops::Identity(s.WithOpName("fetch"), bias_add);
+
+  GrapplerItem item;
+  item.fetch = {"fetch"};
+  item.feed = {
+      {"input", GenerateRandomTensor<DT_FLOAT>(TensorShape({4, 32}))}};
+  TF_ASSERT_OK(s.ToGraphDef(&item.graph));
+
+  GraphDef output;
+  OptimizeAndVerify(&item, &output);
+
+  int found = 0;
+  for (const NodeDef& node : output.node()) {
+    EXPECT_NE(node.name(), "matmul");
+    EXPECT_NE(node.name(), "input_fq");
+    EXPECT_NE(node.name(), "weights_fq");
+    EXPECT_NE(node.name(), "weights");
+    if (node.name() == "bias_add") {
+      EXPECT_EQ(node.op(), "_QuantizedInt8MatMul");
+      ASSERT_EQ(node.input_size(), 9);
+      EXPECT_EQ(node.input(0), "input");
+      EXPECT_EQ(node.input(2), "bias");
+      EXPECT_EQ(node.input(3), "input_min");
+      EXPECT_EQ(node.input(4), "input_max");
+      found++;
+    }
+  }
+  EXPECT_EQ(found, 1);
+}
+
+TEST_F(FakeQuantToInt8Test, Conv2DWithoutBias) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  auto input = ops::Placeholder(s.WithOpName("input"), DT_FLOAT,
+                                ops::Placeholder::Shape({2, 9, 9, 3}));
+  auto filter = FakeQuantWeights(s, TensorShape({3, 3, 3, 8}));
+  auto conv = ops::Conv2D(s.WithOpName("conv"), FakeQuantInput(s, input),
+                          filter, {1, 2, 2, 1}, "SAME");
+  auto fetch = ops::Identity(s.WithOpName("fetch"), conv);
+
+  GrapplerItem item;
+  item.fetch = {"fetch"};
+  item.feed = {
+      {"input", GenerateRandomTensor<DT_FLOAT>(TensorShape({2, 9, 9, 3}))}};
+  TF_ASSERT_OK(s.ToGraphDef(&item.graph));
+
+  GraphDef output;
+  OptimizeAndVerify(&item, &output);
+
+  int found = 0;
+  for (const NodeDef& node : output.node()) {
+    if (node.name() == "conv") {
+      EXPECT_EQ(node.op(), "_QuantizedInt8Conv2D");
+      EXPECT_EQ(node.input(0), "input");
+      EXPECT_EQ(node.input(2), "conv/int8_bias");
+      found++;
+    }
+  }
+  EXPECT_EQ(found, 1);
+}
+
+TEST_F(FakeQuantToInt8Test, KeepsUnquantizedWeights) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  auto input = ops::Placeholder(s.WithOpName("input"), DT_FLOAT,
+                                ops::Placeholder::Shape({4, 32}));
+  auto weights = ops::Const(
+      s.WithOpName("weights"),
+      GenerateRandomTensor<DT_FLOAT>(TensorShape({32, 16})));
+  auto matmul =
+      ops::MatMul(s.WithOpName("matmul"), FakeQuantInput(s, input), weights);
+  auto fetch = ops::Identity(s.WithOpName("fetch"), matmul);
+
+  GrapplerItem item;
+  item.fetch = {"fetch"};
+  TF_ASSERT_OK(s.ToGraphDef(&item.graph));
+  for (int i = 0; i < item.graph.node_size(); ++i) {
+    item.graph.mutable_node(i)->set_device("/device:CPU:0");
+  }
+
+  FakeQuantToInt8 optimizer;
+  GraphDef output;
+  Status status = optimizer.Optimize(nullptr, item, &output);
+  EXPECT_TRUE(errors::IsAborted(status));
+}
+
+}  // namespace
+}  // namespace grappler
+}  // namespace tensorflow
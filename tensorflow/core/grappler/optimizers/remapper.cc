@@ -16,6 +16,8 @@ limitations under the License.
 #include "tensorflow/core/grappler/optimizers/remapper.h"
 
 #include "absl/container/flat_hash_set.h"
+#include "absl/strings/str_cat.h"
+#include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/versions.pb.h"
 #include "tensorflow/core/grappler/costs/graph_properties.h"
 #include "tensorflow/core/grappler/graph_view.h"
@@ -41,11 +43,17 @@ namespace grappler {
 //
 // Conv2D + ... -> _FusedConv2D
 //   (1) Conv2D + BiasAdd + <Activation>
-//   (2) Conv2D + FusedBatchNorm + <Activation>
-//   (3) Conv2D + Squeeze + BiasAdd
+//   (2) Conv2D + BiasAdd + Add + <Relu>
+//   (3) Conv2D + FusedBatchNorm + <Activation>
+//   (4) Conv2D + Squeeze + BiasAdd
 //
 // MatMul + ... -> _FusedMatMul:
 //   (1) MatMul + BiasAdd + <Activation>
+//   (2) MatMul + BiasAdd + Add + <Relu>
+//
+// Besides the activation ops, Swish (x * Sigmoid(x)) and the exact and tanh
+// approximated GeLU are matched as the subgraphs of elementwise ops computing
+// them after a BiasAdd (CPU only).
 //
 // FusedBatchNorm[$is_training] + ... -> _FusedBatchNormEx[$is_training]
 //   (1) FusedBatchNorm + <Activation>
@@ -53,14 +61,32 @@ namespace grappler {
 //
 // Both Conv2D and MatMul implemented as Tensor contraction (on CPU), so all the
 // patterns are "ContractionWith...".
+//
+// GatherV2 + ... -> _FusedSparseSegment{Sum,Mean,SqrtN,SumGrad} (CPU only):
+//   (1) GatherV2 + <Identity> + SparseSegment{Sum,Mean,SqrtN}
+//   (2) GatherV2 + UnsortedSegmentSum (gradient of SparseSegmentSum)
+//
+// These are the embedding_lookup_sparse forward and backward passes; the
+// fused kernels never materialize the gathered [nnz, dim] tensor.
+//
+// StringSplit + StringToHashBucketFast -> _StringSplitToHashBucketFast (CPU)
+//   The hashed tokens replace the string tokens output, so the token strings
+//   are never copied into a tensor.
+//
+// Conv2D and MatMul nodes that are not fused, and whose weights are a Const,
+// are marked with the `_is_weight_const` attribute (CPU only). Their kernels
+// can then cache the weights in a packed layout (see kernels/packed_matmul.h).
 namespace {
 
 constexpr char kFusedConv2D[] = "_FusedConv2D";
 constexpr char kFusedMatMul[] = "_FusedMatMul";
 constexpr char kFusedBatchNormEx[] = "_FusedBatchNormEx";
+constexpr char kFusedSparseSegmentSumGrad[] = "_FusedSparseSegmentSumGrad";
+constexpr char kStringSplitToHashBucketFast[] = "_StringSplitToHashBucketFast";
 
 constexpr char kDataFormat[] = "data_format";
 constexpr char kIsTraining[] = "is_training";
+constexpr char kIsWeightConst[] = "_is_weight_const";
 
 constexpr int kMissingIndex = -1;
 
@@ -99,6 +125,33 @@ struct FusedBatchNormEx {
   int invalidated = kMissingIndex;
 };
 
+// GatherV2 along axis 0 followed by an optional Identity and a
+// SparseSegment{Sum,Mean,SqrtN} reduction of the gathered rows.
+struct GatherWithSparseSegmentReduction {
+  GatherWithSparseSegmentReduction() = default;
+
+  int gather = kMissingIndex;
+  int identity = kMissingIndex;
+  int reduction = kMissingIndex;
+};
+
+// GatherV2 along axis 0 followed by an UnsortedSegmentSum, which is how the
+// gradient of SparseSegmentSum is expressed.
+struct GatherWithUnsortedSegmentSum {
+  GatherWithUnsortedSegmentSum() = default;
+
+  int gather = kMissingIndex;
+  int segment_sum = kMissingIndex;
+};
+
+// StringSplit whose tokens are only consumed by a StringToHashBucketFast.
+struct StringSplitWithHashBucket {
+  StringSplitWithHashBucket() = default;
+
+  int string_split = kMissingIndex;
+  int hash_bucket = kMissingIndex;
+};
+
 // Contraction node followed by a BiasAdd.
 struct ContractionWithBiasAdd {
   ContractionWithBiasAdd() = default;
@@ -162,7 +215,33 @@ struct ContractionWithBatchNormAndActivation {
   float epsilon = 0.0;
 };
 
-#ifdef INTEL_MKL
+// Contraction node followed by a BiasAdd and Swish: Mul(x, Sigmoid(x)).
+struct ContractionWithBiasAddAndSwish {
+  ContractionWithBiasAddAndSwish() = default;
+  ContractionWithBiasAddAndSwish(int contraction, int bias_add, int sigmoid,
+                                 int mul)
+      : contraction(contraction),
+        bias_add(bias_add),
+        sigmoid(sigmoid),
+        mul(mul) {}
+
+  int contraction = kMissingIndex;
+  int bias_add = kMissingIndex;
+  int sigmoid = kMissingIndex;
+  int mul = kMissingIndex;
+};
+
+// Contraction node followed by a BiasAdd and the subgraph computing GeLU,
+// which has the final Mul at its root.
+struct ContractionWithBiasAddAndGelu {
+  int contraction = kMissingIndex;
+  int bias_add = kMissingIndex;
+  int gelu = kMissingIndex;
+  bool approximate = false;
+  // The other nodes of the GeLU subgraph.
+  std::vector<int> gelu_nodes;
+};
+
 // Contraction node followed by a BiasAdd and Add.
 struct ContractionWithBiasAddAndAdd {
   ContractionWithBiasAddAndAdd() = default;
@@ -196,7 +275,6 @@ struct ContractionWithBiasAndAddActivation {
   int port_id = 0;
   int activation = kMissingIndex;
 };
-#endif  // INTEL_MKL
 
 bool IsInPreserveSet(const RemapperContext& ctx, const NodeDef* node) {
   return ctx.nodes_to_preserve.count(node->name()) > 0;
@@ -334,9 +412,49 @@ bool IsDeviceCompatible(const RemapperContext& ctx, Pattern& matched) {
 }
 
 bool IsSupportedActivation(const NodeDef& node) {
+#ifndef INTEL_MKL
+  if (IsLeakyRelu(node)) return true;
+#endif  // !INTEL_MKL
   return IsRelu(node) || IsRelu6(node) || IsElu(node);
 }
 
+// Returns true if `node` is an Add of two tensors of the same shape, so that
+// a fused kernel can read the addend with the layout of its output. Requires
+// inferred shapes.
+bool IsAddWithNoBroadcast(const RemapperContext& ctx, const NodeDef& node) {
+  if (!IsAdd(node)) return false;
+
+  const auto& props = ctx.graph_properties.GetInputProperties(node.name());
+  return props.size() == 2 &&
+         ShapesSymbolicallyEqual(props[0].shape(), props[1].shape());
+}
+
+// Returns true if `node` is a constant with a single element equal to
+// `value`, up to the precision of float.
+bool IsScalarConstWithValue(const NodeDef& node, double value) {
+  if (!IsConstant(node)) return false;
+
+  const auto value_attr = node.attr().find("value");
+  if (value_attr == node.attr().end()) return false;
+  Tensor tensor;
+  if (!tensor.FromProto(value_attr->second.tensor()) ||
+      tensor.NumElements() != 1)
+    return false;
+
+  double scalar;
+  switch (tensor.dtype()) {
+    case DT_FLOAT:
+      scalar = tensor.flat<float>()(0);
+      break;
+    case DT_DOUBLE:
+      scalar = tensor.flat<double>()(0);
+      break;
+    default:
+      return false;
+  }
+  return std::abs(scalar - value) <= 1e-6 * std::abs(value);
+}
+
 inline bool HasControlFaninOrFanout(const utils::MutableNodeView& node_view) {
   return node_view.NumControllingFanins() > 0 ||
          node_view.NumControlledFanouts() > 0;
@@ -421,6 +539,192 @@ bool FindContractionWithBiasAndActivation(
   return true;
 }
 
+// Returns the input of the binary op `node_view` that is not the scalar
+// constant `value`, or nullptr if no input is. If `commutative` is false,
+// only the second input may be the constant.
+const utils::MutableNodeView* GetOperandOfBinaryOpWithConst(
+    const utils::MutableNodeView& node_view, double value,
+    bool commutative = true) {
+  if (node_view.NumRegularFanins() != 2) return nullptr;
+  const auto* lhs = node_view.GetRegularFanin(0).node_view();
+  const auto* rhs = node_view.GetRegularFanin(1).node_view();
+
+  if (IsScalarConstWithValue(*rhs->node(), value)) return lhs;
+  if (commutative && IsScalarConstWithValue(*lhs->node(), value)) return rhs;
+  return nullptr;
+}
+
+// Returns true if the output of `node_view` can be computed inside a fused
+// op: it has no other consumers, and must not be preserved.
+bool IsFusableIntermediate(const RemapperContext& ctx,
+                           const utils::MutableNodeView& node_view) {
+  return !HasControlFaninOrFanout(node_view) &&
+         node_view.GetRegularFanout(0).size() == 1 &&
+         !IsInPreserveSet(ctx, node_view.node());
+}
+
+// Returns true if `bias_add_view` is a BiasAdd fusable into a contraction,
+// whose output is consumed `num_fanouts` times by the ops of an activation
+// subgraph rooted at `root`.
+bool FindContractionWithBiasForSubgraph(
+    const RemapperContext& ctx, const utils::MutableNodeView& bias_add_view,
+    int num_fanouts, const NodeDef& root, ContractionWithBiasAdd* base) {
+  const auto* bias_add_node_def = bias_add_view.node();
+  if (!FindContractionWithBias(ctx, bias_add_view.node_index(), base,
+                               /*check_device_compatible=*/false) ||
+      bias_add_view.GetRegularFanout(0).size() != num_fanouts ||
+      !HaveSameDataType(&root, bias_add_node_def) ||
+      IsInPreserveSet(ctx, bias_add_node_def))
+    return false;
+
+  return IsCpuCompatible(ctx, *base);
+}
+
+bool FindContractionWithBiasAndSwish(const RemapperContext& ctx,
+                                     int node_index,
+                                     ContractionWithBiasAddAndSwish* matched) {
+  const auto* node_view = ctx.graph_view.GetNode(node_index);
+  // TODO(lyandy): Forward controls for patterns with control dependencies.
+  if (HasControlFaninOrFanout(*node_view)) return false;
+
+  // Root of the pattern must be a Mul(x, Sigmoid(x)).
+  const auto* node_def = node_view->node();
+  if (!IsMul(*node_def) || node_view->NumRegularFanins() != 2) return false;
+
+  for (int sigmoid_port : {0, 1}) {
+    const auto* sigmoid_view =
+        node_view->GetRegularFanin(sigmoid_port).node_view();
+    const auto* bias_add_view =
+        node_view->GetRegularFanin(1 - sigmoid_port).node_view();
+    if (!IsSigmoid(*sigmoid_view->node()) ||
+        sigmoid_view->NumRegularFanins() != 1 ||
+        sigmoid_view->GetRegularFanin(0).node_view() != bias_add_view ||
+        !IsFusableIntermediate(ctx, *sigmoid_view))
+      continue;
+
+    ContractionWithBiasAdd base;
+    if (!FindContractionWithBiasForSubgraph(ctx, *bias_add_view,
+                                            /*num_fanouts=*/2, *node_def,
+                                            &base))
+      return false;
+
+    // We successfully found a {Conv2D, MatMul}+BiasAdd+Swish pattern.
+    *matched = ContractionWithBiasAddAndSwish(
+        base.contraction, base.bias_add, sigmoid_view->node_index(),
+        node_index);
+    return true;
+  }
+
+  return false;
+}
+
+// Matches the subgraph computing GeLU at the argument of its Erf or Tanh:
+//   exact:        x / sqrt(2)
+//   approximate:  sqrt(2 / pi) * (x + 0.044715 * Pow(x, 3))
+// Returns x, and appends the matched nodes to `gelu_nodes`.
+const utils::MutableNodeView* MatchGeluArgument(
+    const RemapperContext& ctx, const utils::MutableNodeView& arg_view,
+    bool approximate, std::vector<int>* gelu_nodes) {
+  const NodeDef& arg = *arg_view.node();
+  if (!IsFusableIntermediate(ctx, arg_view)) return nullptr;
+  gelu_nodes->push_back(arg_view.node_index());
+
+  if (!approximate) {
+    if (IsRealDiv(arg))
+      return GetOperandOfBinaryOpWithConst(arg_view, M_SQRT2,
+                                           /*commutative=*/false);
+    if (IsMul(arg)) return GetOperandOfBinaryOpWithConst(arg_view, M_SQRT1_2);
+    return nullptr;
+  }
+
+  if (!IsMul(arg)) return nullptr;
+  const auto* sum_view =
+      GetOperandOfBinaryOpWithConst(arg_view, M_2_SQRTPI * M_SQRT1_2);
+  if (sum_view == nullptr || !IsAdd(*sum_view->node()) ||
+      sum_view->NumRegularFanins() != 2 ||
+      !IsFusableIntermediate(ctx, *sum_view))
+    return nullptr;
+  gelu_nodes->push_back(sum_view->node_index());
+
+  for (int cube_port : {0, 1}) {
+    const auto* scaled_cube_view =
+        sum_view->GetRegularFanin(cube_port).node_view();
+    const auto* x_view = sum_view->GetRegularFanin(1 - cube_port).node_view();
+    if (!IsMul(*scaled_cube_view->node()) ||
+        !IsFusableIntermediate(ctx, *scaled_cube_view))
+      continue;
+    const auto* cube_view =
+        GetOperandOfBinaryOpWithConst(*scaled_cube_view, 0.044715);
+    if (cube_view == nullptr || !IsPow(*cube_view->node()) ||
+        !IsFusableIntermediate(ctx, *cube_view) ||
+        GetOperandOfBinaryOpWithConst(*cube_view, 3.0,
+                                      /*commutative=*/false) != x_view)
+      continue;
+    gelu_nodes->push_back(scaled_cube_view->node_index());
+    gelu_nodes->push_back(cube_view->node_index());
+    return x_view;
+  }
+  return nullptr;
+}
+
+bool FindContractionWithBiasAndGelu(const RemapperContext& ctx, int node_index,
+                                    ContractionWithBiasAddAndGelu* matched) {
+  const auto* node_view = ctx.graph_view.GetNode(node_index);
+  // TODO(lyandy): Forward controls for patterns with control dependencies.
+  if (HasControlFaninOrFanout(*node_view)) return false;
+
+  // Root of the pattern must be a Mul(0.5 * x, 1 + {Erf,Tanh}(...)).
+  const auto* node_def = node_view->node();
+  if (!IsMul(*node_def) || node_view->NumRegularFanins() != 2) return false;
+
+  for (int half_port : {0, 1}) {
+    const auto* half_view = node_view->GetRegularFanin(half_port).node_view();
+    const auto* one_plus_view =
+        node_view->GetRegularFanin(1 - half_port).node_view();
+    if (!IsMul(*half_view->node()) || !IsAdd(*one_plus_view->node()) ||
+        !IsFusableIntermediate(ctx, *half_view) ||
+        !IsFusableIntermediate(ctx, *one_plus_view))
+      continue;
+
+    const auto* bias_add_view = GetOperandOfBinaryOpWithConst(*half_view, 0.5);
+    const auto* function_view =
+        GetOperandOfBinaryOpWithConst(*one_plus_view, 1.0);
+    if (bias_add_view == nullptr || function_view == nullptr ||
+        function_view->NumRegularFanins() != 1 ||
+        !IsFusableIntermediate(ctx, *function_view))
+      continue;
+
+    const NodeDef& function = *function_view->node();
+    if (!IsErf(function) && !IsTanh(function)) continue;
+    const bool approximate = IsTanh(function);
+
+    std::vector<int> gelu_nodes = {half_view->node_index(),
+                                   one_plus_view->node_index(),
+                                   function_view->node_index()};
+    if (MatchGeluArgument(ctx, *function_view->GetRegularFanin(0).node_view(),
+                          approximate, &gelu_nodes) != bias_add_view)
+      continue;
+
+    // BiasAdd output is consumed by 0.5 * x, and by the argument of Erf, or by
+    // the sum and the Pow of the argument of Tanh.
+    ContractionWithBiasAdd base;
+    if (!FindContractionWithBiasForSubgraph(ctx, *bias_add_view,
+                                            /*num_fanouts=*/approximate ? 3 : 2,
+                                            *node_def, &base))
+      return false;
+
+    // We successfully found a {Conv2D, MatMul}+BiasAdd+GeLU pattern.
+    matched->contraction = base.contraction;
+    matched->bias_add = base.bias_add;
+    matched->gelu = node_index;
+    matched->approximate = approximate;
+    matched->gelu_nodes = std::move(gelu_nodes);
+    return true;
+  }
+
+  return false;
+}
+
 bool FindConv2DWithSqueezeAndBias(const RemapperContext& ctx, int node_index,
                                   ContractionWithSqueezeAndBiasAdd* matched) {
   const auto* node_view = ctx.graph_view.GetNode(node_index);
@@ -561,7 +865,6 @@ bool FindConv2DWithBatchNormAndActivation(
   return true;
 }
 
-#ifdef INTEL_MKL
 // As AddN has multiple inputs, this function tries to find Conv2D + Bias
 // pattern in specific input port.
 bool FindContractionWithBiasInPort(const RemapperContext& ctx,
@@ -594,10 +897,16 @@ bool FindContractionWithBiasAddAndAdd(const RemapperContext& ctx,
 
   // Root of the pattern must be a AddN
   const auto* node_def = node_view.node();
+#ifdef INTEL_MKL
   if (!IsAddN(*node_def)) return false;
 
   // MKL AddN ops only support float data type.
   if (!HasDataType(node_def, DT_FLOAT)) return false;
+#else
+  // Or an Add without broadcasting.
+  if (!IsAddN(*node_def) && !IsAddWithNoBroadcast(ctx, *node_def))
+    return false;
+#endif  // INTEL_MKL
 
   ContractionWithBiasAdd base;
   matched->port_id = 0;
@@ -617,6 +926,10 @@ bool FindContractionWithBiasAddAndAdd(const RemapperContext& ctx,
   matched->bias_add = base.bias_add;
   matched->add = node_view.node_index();
 
+#ifndef INTEL_MKL
+  if (!IsCpuCompatible(ctx, *matched)) return false;
+#endif  // !INTEL_MKL
+
   return true;
 }
 
@@ -638,8 +951,13 @@ bool FindContractionWithBiasAndAddActivation(
   const auto* node_def = node_view->node();
   if (!IsSupportedActivation(*node_def)) return false;
 
+#ifdef INTEL_MKL
   // MKL activation op only supports float data type.
   if (!HasDataType(node_def, DT_FLOAT)) return false;
+#else
+  // Fused kernels support only Relu after the Add.
+  if (!IsRelu(*node_def)) return false;
+#endif  // INTEL_MKL
 
   // And input to activation must match ContractionWithBiasAddAndAdd pattern.
   if (node_view->NumRegularFanins() < 1) return false;
@@ -648,7 +966,9 @@ bool FindContractionWithBiasAndAddActivation(
 
   ContractionWithBiasAddAndAdd base;
 
-  if (!FindContractionWithBiasAddAndAdd(ctx, *add_node_view, &base)) {
+  if (!FindContractionWithBiasAddAndAdd(ctx, *add_node_view, &base) ||
+      !HasAtMostOneFanoutAtPort0(*add_node_view) ||
+      IsInPreserveSet(ctx, add_node_view->node())) {
     return false;
   }
 
@@ -659,7 +979,161 @@ bool FindContractionWithBiasAndAddActivation(
 
   return true;
 }
-#endif
+
+bool IsSparseSegmentReduction(const NodeDef& node) {
+  const auto& op = node.op();
+  return op == "SparseSegmentSum" || op == "SparseSegmentMean" ||
+         op == "SparseSegmentSqrtN";
+}
+
+// Returns true if `gather_view` is a GatherV2 of vector indices along axis 0
+// on CPU, whose only consumer is the node we reached it from, so it can be
+// folded into that consumer.
+bool IsFusableGather(const RemapperContext& ctx,
+                     const utils::MutableNodeView& gather_view,
+                     const DataType& dtype) {
+  const auto* gather_def = gather_view.node();
+  if (gather_def->op() != "GatherV2") return false;
+  if (HasControlFaninOrFanout(gather_view) ||
+      !HasAtMostOneFanoutAtPort0(gather_view) ||
+      IsInPreserveSet(ctx, gather_def) || !NodeIsOnCpu(gather_def) ||
+      !HasDataType(gather_def, dtype, "Tparams"))
+    return false;
+
+  int batch_dims = 0;
+  if (TryGetNodeAttr(*gather_def, "batch_dims", &batch_dims) &&
+      batch_dims != 0)
+    return false;
+
+  const auto& props =
+      ctx.graph_properties.GetInputProperties(gather_def->name());
+  if (props.size() != 3 || Rank(props[1].shape()) != 1 ||
+      !props[2].has_value())
+    return false;
+
+  Tensor axis;
+  if (!axis.FromProto(props[2].value()) || axis.NumElements() != 1)
+    return false;
+  const int64 axis_value = axis.dtype() == DT_INT32
+                               ? axis.flat<int32>()(0)
+                               : axis.flat<int64>()(0);
+  return axis_value == 0;
+}
+
+bool FindGatherWithSparseSegmentReduction(
+    const RemapperContext& ctx, int node_index,
+    GatherWithSparseSegmentReduction* matched) {
+  const auto* node_view = ctx.graph_view.GetNode(node_index);
+  // Root of the pattern must be a SparseSegment{Sum,Mean,SqrtN}.
+  if (HasControlFaninOrFanout(*node_view)) return false;
+
+  const auto* node_def = node_view->node();
+  if (!IsSparseSegmentReduction(*node_def) || !NodeIsOnCpu(node_def))
+    return false;
+
+  // Fused kernels are only available for these types.
+  const DataType dtype = GetDataTypeFromAttr(*node_def, "T");
+  if ((dtype != DT_FLOAT && dtype != DT_DOUBLE) ||
+      !HasDataType(node_def, DT_INT32, "Tidx"))
+    return false;
+
+  // Data input must be a GatherV2, possibly behind an Identity.
+  if (node_view->NumRegularFanins() < 3) return false;
+  const auto& regular_fanin_0 = node_view->GetRegularFanin(0);
+  if (regular_fanin_0.index() != 0) return false;
+  const auto* data_node_view = regular_fanin_0.node_view();
+
+  GatherWithSparseSegmentReduction pattern;
+  if (IsIdentity(*data_node_view->node())) {
+    if (HasControlFaninOrFanout(*data_node_view) ||
+        !HasAtMostOneFanoutAtPort0(*data_node_view) ||
+        IsInPreserveSet(ctx, data_node_view->node()) ||
+        data_node_view->NumRegularFanins() < 1)
+      return false;
+    const auto& identity_fanin_0 = data_node_view->GetRegularFanin(0);
+    if (identity_fanin_0.index() != 0) return false;
+    pattern.identity = data_node_view->node_index();
+    data_node_view = identity_fanin_0.node_view();
+  }
+
+  if (!IsFusableGather(ctx, *data_node_view, dtype)) return false;
+
+  // We successfully found a GatherV2+SparseSegmentReduction pattern.
+  pattern.gather = data_node_view->node_index();
+  pattern.reduction = node_index;
+  *matched = pattern;
+
+  return true;
+}
+
+bool FindGatherWithUnsortedSegmentSum(const RemapperContext& ctx,
+                                      int node_index,
+                                      GatherWithUnsortedSegmentSum* matched) {
+  const auto* node_view = ctx.graph_view.GetNode(node_index);
+  // Root of the pattern must be an UnsortedSegmentSum.
+  if (HasControlFaninOrFanout(*node_view)) return false;
+
+  const auto* node_def = node_view->node();
+  if (!IsUnsortedSegmentSum(*node_def) || !NodeIsOnCpu(node_def))
+    return false;
+
+  // The fused kernel takes int32 indices and segment ids, and an int32 number
+  // of output rows.
+  const DataType dtype = GetDataTypeFromAttr(*node_def, "T");
+  if ((dtype != DT_FLOAT && dtype != DT_DOUBLE) ||
+      !HasDataType(node_def, DT_INT32, "Tindices") ||
+      !HasDataType(node_def, DT_INT32, "Tnumsegments"))
+    return false;
+
+  // Segment ids must be a vector, i.e. one id per gathered row.
+  const auto& props = ctx.graph_properties.GetInputProperties(node_def->name());
+  if (props.size() != 3 || Rank(props[1].shape()) != 1) return false;
+
+  if (node_view->NumRegularFanins() < 3) return false;
+  const auto& regular_fanin_0 = node_view->GetRegularFanin(0);
+  if (regular_fanin_0.index() != 0) return false;
+  const auto* gather_node_view = regular_fanin_0.node_view();
+
+  if (!IsFusableGather(ctx, *gather_node_view, dtype) ||
+      !HasDataType(gather_node_view->node(), DT_INT32, "Tindices"))
+    return false;
+
+  // We successfully found a GatherV2+UnsortedSegmentSum pattern.
+  matched->gather = gather_node_view->node_index();
+  matched->segment_sum = node_index;
+
+  return true;
+}
+
+bool FindStringSplitWithHashBucket(const RemapperContext& ctx, int node_index,
+                                   StringSplitWithHashBucket* matched) {
+  const auto* node_view = ctx.graph_view.GetNode(node_index);
+  // Root of the pattern must be a StringToHashBucketFast.
+  if (HasControlFaninOrFanout(*node_view)) return false;
+
+  const auto* node_def = node_view->node();
+  if (node_def->op() != "StringToHashBucketFast" || !NodeIsOnCpu(node_def))
+    return false;
+
+  // Input must be the tokens output of a StringSplit, which nothing else
+  // reads: the fused node produces bucket ids in place of the tokens.
+  if (node_view->NumRegularFanins() < 1) return false;
+  const auto& regular_fanin_0 = node_view->GetRegularFanin(0);
+  if (regular_fanin_0.index() != 1) return false;
+  const auto* split_node_view = regular_fanin_0.node_view();
+  const auto* split_node_def = split_node_view->node();
+  if (split_node_def->op() != "StringSplit" || !NodeIsOnCpu(split_node_def) ||
+      HasControlFaninOrFanout(*split_node_view) ||
+      IsInPreserveSet(ctx, split_node_def) ||
+      split_node_view->GetRegularFanout(1).size() != 1)
+    return false;
+
+  // We successfully found a StringSplit+StringToHashBucketFast pattern.
+  matched->string_split = split_node_view->node_index();
+  matched->hash_bucket = node_index;
+
+  return true;
+}
 
 bool FindFusedBatchNorm(const RemapperContext& ctx, int node_index,
                         FusedBatchNorm* matched) {
@@ -703,6 +1177,21 @@ bool FindFusedBatchNorm(const RemapperContext& ctx, int node_index,
   return true;
 }
 
+bool FindContractionWithConstWeights(const RemapperContext& ctx,
+                                     int node_index) {
+  const auto* node_view = ctx.graph_view.GetNode(node_index);
+  const auto* node_def = node_view->node();
+  if (!IsConv2D(*node_def) && !IsMatMul(*node_def)) return false;
+  if (!NodeIsOnCpu(node_def)) return false;
+  if (GetDataTypeFromAttr(*node_def, "T") != DT_FLOAT) return false;
+  if (HasNodeAttr(*node_def, kIsWeightConst)) return false;
+
+  if (node_view->NumRegularFanins() < 2) return false;
+  const auto* weights_node_def =
+      node_view->GetRegularFanin(1).node_view()->node();
+  return IsConstant(*weights_node_def);
+}
+
 // NOTE(ezhulenev): See `BatchnormSpatialPersistentEnabled` documentation in the
 // `tensorflow/stream_executor/cuda/cuda_dnn.cc` for details.
 bool BatchnormSpatialPersistentEnabled() {
@@ -889,6 +1378,14 @@ void CopyMatMulAttributes(const NodeDef& matmul, NodeDef* fused_matmul) {
   (*attr)["transpose_b"] = src_attr.at("transpose_b");
 }
 
+// Copies the attributes of `activation` that parametrize the fused activation.
+void CopyActivationAttributes(const NodeDef& activation, NodeDef* fused) {
+  if (IsLeakyRelu(activation)) {
+    auto* attr = fused->mutable_attr();
+    (*attr)["leakyrelu_alpha"] = activation.attr().at("alpha");
+  }
+}
+
 void SetFusedOpAttributes(NodeDef* fused,
                           const absl::Span<const absl::string_view> fused_ops,
                           int num_args = 1, float epsilon = 0.0) {
@@ -971,6 +1468,7 @@ Status AddFusedContractionNode(
   }
 
   SetFusedOpAttributes(&fused_op, {"BiasAdd", activation.op()});
+  CopyActivationAttributes(activation, &fused_op);
 
   utils::Mutation* mutation = ctx->graph_view.GetMutationBuilder();
   Status status;
@@ -985,6 +1483,97 @@ Status AddFusedContractionNode(
   return Status::OK();
 }
 
+Status AddFusedContractionNode(RemapperContext* ctx,
+                               const ContractionWithBiasAddAndSwish& matched,
+                               std::vector<bool>* invalidated_nodes,
+                               std::vector<bool>* nodes_to_delete) {
+  const GraphDef* graph = ctx->graph_view.graph();
+  const NodeDef& contraction = graph->node(matched.contraction);
+  const NodeDef& bias_add = graph->node(matched.bias_add);
+  const NodeDef& mul = graph->node(matched.mul);
+  VLOG(2) << "Fuse " << contraction.op() << " with BiasAdd and Swish:"
+          << " mul=" << mul.name() << " bias_add=" << bias_add.name()
+          << " contraction=" << contraction.name();
+
+  NodeDef fused_op;
+  fused_op.set_name(mul.name());
+  fused_op.set_device(contraction.device());
+  fused_op.add_input(contraction.input(0));  // 0: input
+  fused_op.add_input(contraction.input(1));  // 1: filter
+  fused_op.add_input(bias_add.input(1));     // 2: bias
+
+  if (IsConv2D(contraction)) {
+    fused_op.set_op(kFusedConv2D);
+    CopyConv2DAttributes(contraction, &fused_op);
+  } else if (IsMatMul(contraction)) {
+    fused_op.set_op(kFusedMatMul);
+    CopyMatMulAttributes(contraction, &fused_op);
+  }
+
+  SetFusedOpAttributes(&fused_op, {"BiasAdd", "Swish"});
+
+  utils::Mutation* mutation = ctx->graph_view.GetMutationBuilder();
+  Status status;
+  mutation->AddNode(std::move(fused_op), &status);
+  TF_RETURN_IF_ERROR(status);
+  TF_RETURN_IF_ERROR(mutation->Apply());
+
+  (*nodes_to_delete)[matched.contraction] = true;
+  (*nodes_to_delete)[matched.bias_add] = true;
+  (*nodes_to_delete)[matched.sigmoid] = true;
+  (*invalidated_nodes)[matched.mul] = true;
+
+  return Status::OK();
+}
+
+Status AddFusedContractionNode(RemapperContext* ctx,
+                               const ContractionWithBiasAddAndGelu& matched,
+                               std::vector<bool>* invalidated_nodes,
+                               std::vector<bool>* nodes_to_delete) {
+  const GraphDef* graph = ctx->graph_view.graph();
+  const NodeDef& contraction = graph->node(matched.contraction);
+  const NodeDef& bias_add = graph->node(matched.bias_add);
+  const NodeDef& gelu = graph->node(matched.gelu);
+  VLOG(2) << "Fuse " << contraction.op() << " with BiasAdd and "
+          << (matched.approximate ? "approximate" : "exact") << " GeLU:"
+          << " gelu=" << gelu.name() << " bias_add=" << bias_add.name()
+          << " contraction=" << contraction.name();
+
+  NodeDef fused_op;
+  fused_op.set_name(gelu.name());
+  fused_op.set_device(contraction.device());
+  fused_op.add_input(contraction.input(0));  // 0: input
+  fused_op.add_input(contraction.input(1));  // 1: filter
+  fused_op.add_input(bias_add.input(1));     // 2: bias
+
+  if (IsConv2D(contraction)) {
+    fused_op.set_op(kFusedConv2D);
+    CopyConv2DAttributes(contraction, &fused_op);
+  } else if (IsMatMul(contraction)) {
+    fused_op.set_op(kFusedMatMul);
+    CopyMatMulAttributes(contraction, &fused_op);
+  }
+
+  SetFusedOpAttributes(&fused_op, {"BiasAdd", matched.approximate
+                                                  ? "GeluApproximate"
+                                                  : "GeluExact"});
+
+  utils::Mutation* mutation = ctx->graph_view.GetMutationBuilder();
+  Status status;
+  mutation->AddNode(std::move(fused_op), &status);
+  TF_RETURN_IF_ERROR(status);
+  TF_RETURN_IF_ERROR(mutation->Apply());
+
+  (*nodes_to_delete)[matched.contraction] = true;
+  (*nodes_to_delete)[matched.bias_add] = true;
+  for (int gelu_node : matched.gelu_nodes) {
+    (*nodes_to_delete)[gelu_node] = true;
+  }
+  (*invalidated_nodes)[matched.gelu] = true;
+
+  return Status::OK();
+}
+
 Status AddFusedConv2DNode(RemapperContext* ctx,
                           const ContractionWithSqueezeAndBiasAdd& matched,
                           std::vector<bool>* invalidated_nodes,
@@ -1102,6 +1691,7 @@ Status AddFusedConv2DNode(RemapperContext* ctx,
   CopyConv2DAttributes(contraction, &fused_conv2d);
   SetFusedOpAttributes(&fused_conv2d, {"FusedBatchNorm", activation.op()},
                        /*num_args=*/4, /*epsilon=*/matched.epsilon);
+  CopyActivationAttributes(activation, &fused_conv2d);
 
   utils::Mutation* mutation = ctx->graph_view.GetMutationBuilder();
   Status status;
@@ -1116,7 +1706,6 @@ Status AddFusedConv2DNode(RemapperContext* ctx,
   return Status::OK();
 }
 
-#ifdef INTEL_MKL
 Status AddFusedContractionNode(RemapperContext* ctx,
                                const ContractionWithBiasAddAndAdd& matched,
                                std::vector<bool>* invalidated_nodes,
@@ -1125,28 +1714,35 @@ Status AddFusedContractionNode(RemapperContext* ctx,
   const NodeDef& contraction = graph->node(matched.contraction);
   const NodeDef& bias_add = graph->node(matched.bias_add);
 
+#ifdef INTEL_MKL
   // MKL version only support fusion for Conv2D
   DCHECK(IsConv2D(contraction));
+#endif  // INTEL_MKL
 
-  NodeDef fused_conv2d;
+  NodeDef fused_op;
   const NodeDef& add = graph->node(matched.add);
-  fused_conv2d.set_name(add.name());
-  fused_conv2d.set_op(kFusedConv2D);
-  fused_conv2d.set_device(contraction.device());
-  fused_conv2d.add_input(contraction.input(0));  // 0: input
-  fused_conv2d.add_input(contraction.input(1));  // 1: filter
-  fused_conv2d.add_input(bias_add.input(1));     // 2: bias
+  fused_op.set_name(add.name());
+  fused_op.set_device(contraction.device());
+  fused_op.add_input(contraction.input(0));  // 0: input
+  fused_op.add_input(contraction.input(1));  // 1: filter
+  fused_op.add_input(bias_add.input(1));     // 2: bias
 
   // Add OP has two inputs, one is conv+bias pattern matched previously,
   // the other input to add is fused here.
-  fused_conv2d.add_input(add.input(1 - matched.port_id));
+  fused_op.add_input(add.input(1 - matched.port_id));
 
-  CopyConv2DAttributes(contraction, &fused_conv2d);
-  SetFusedOpAttributes(&fused_conv2d, {"BiasAdd", "Add"}, 2);
+  if (IsConv2D(contraction)) {
+    fused_op.set_op(kFusedConv2D);
+    CopyConv2DAttributes(contraction, &fused_op);
+  } else if (IsMatMul(contraction)) {
+    fused_op.set_op(kFusedMatMul);
+    CopyMatMulAttributes(contraction, &fused_op);
+  }
+  SetFusedOpAttributes(&fused_op, {"BiasAdd", "Add"}, 2);
 
   utils::Mutation* mutation = ctx->graph_view.GetMutationBuilder();
   Status status;
-  mutation->AddNode(std::move(fused_conv2d), &status);
+  mutation->AddNode(std::move(fused_op), &status);
   TF_RETURN_IF_ERROR(status);
   TF_RETURN_IF_ERROR(mutation->Apply());
 
@@ -1161,31 +1757,38 @@ Status AddFusedContractionNode(
     RemapperContext* ctx, const ContractionWithBiasAndAddActivation& matched,
     std::vector<bool>* invalidated_nodes, std::vector<bool>* nodes_to_delete) {
   const GraphDef* graph = ctx->graph_view.graph();
-  // MKL version only support fusion for Conv2D
   const NodeDef& contraction = graph->node(matched.contraction);
+#ifdef INTEL_MKL
+  // MKL version only support fusion for Conv2D
   DCHECK(IsConv2D(contraction));
+#endif  // INTEL_MKL
   const NodeDef& activation = graph->node(matched.activation);
 
-  NodeDef fused_conv2d;
-  fused_conv2d.set_name(activation.name());
-  fused_conv2d.set_op(kFusedConv2D);
-  fused_conv2d.set_device(contraction.device());
-  fused_conv2d.add_input(contraction.input(0));  // 0: input
-  fused_conv2d.add_input(contraction.input(1));  // 1: filter
+  NodeDef fused_op;
+  fused_op.set_name(activation.name());
+  fused_op.set_device(contraction.device());
+  fused_op.add_input(contraction.input(0));  // 0: input
+  fused_op.add_input(contraction.input(1));  // 1: filter
   const NodeDef& bias_add = graph->node(matched.bias_add);
-  fused_conv2d.add_input(bias_add.input(1));  // 2: bias
+  fused_op.add_input(bias_add.input(1));  // 2: bias
 
   // Add OP has two inputs, one is conv+bias pattern matched previously,
   // the other input to add is fused here.
   const NodeDef& add = graph->node(matched.add);
-  fused_conv2d.add_input(add.input(1 - matched.port_id));
+  fused_op.add_input(add.input(1 - matched.port_id));
 
-  CopyConv2DAttributes(contraction, &fused_conv2d);
-  SetFusedOpAttributes(&fused_conv2d, {"BiasAdd", "Add", "Relu"}, 2);
+  if (IsConv2D(contraction)) {
+    fused_op.set_op(kFusedConv2D);
+    CopyConv2DAttributes(contraction, &fused_op);
+  } else if (IsMatMul(contraction)) {
+    fused_op.set_op(kFusedMatMul);
+    CopyMatMulAttributes(contraction, &fused_op);
+  }
+  SetFusedOpAttributes(&fused_op, {"BiasAdd", "Add", "Relu"}, 2);
 
   utils::Mutation* mutation = ctx->graph_view.GetMutationBuilder();
   Status status;
-  mutation->AddNode(std::move(fused_conv2d), &status);
+  mutation->AddNode(std::move(fused_op), &status);
   TF_RETURN_IF_ERROR(status);
   TF_RETURN_IF_ERROR(mutation->Apply());
 
@@ -1196,7 +1799,6 @@ Status AddFusedContractionNode(
 
   return Status::OK();
 }
-#endif
 
 Status AddFusedBatchNormExNode(RemapperContext* ctx,
                                const FusedBatchNormEx& matched,
@@ -1267,6 +1869,132 @@ Status AddFusedBatchNormExNode(RemapperContext* ctx,
   return Status::OK();
 }
 
+Status AddFusedSparseSegmentReductionNode(
+    RemapperContext* ctx, const GatherWithSparseSegmentReduction& matched,
+    std::vector<bool>* invalidated_nodes, std::vector<bool>* nodes_to_delete) {
+  const GraphDef* graph = ctx->graph_view.graph();
+  const NodeDef& gather = graph->node(matched.gather);
+  const NodeDef& reduction = graph->node(matched.reduction);
+
+  VLOG(2) << "Fuse " << reduction.op() << " with GatherV2:"
+          << " reduction=" << reduction.name() << " gather=" << gather.name();
+
+  NodeDef fused_op;
+  fused_op.set_op(absl::StrCat("_Fused", reduction.op()));
+  fused_op.set_name(reduction.name());
+  fused_op.set_device(reduction.device());
+
+  fused_op.add_input(gather.input(0));     // 0: params
+  fused_op.add_input(gather.input(1));     // 1: gather_indices
+  fused_op.add_input(reduction.input(1));  // 2: indices
+  fused_op.add_input(reduction.input(2));  // 3: segment_ids
+
+  auto* attrs = fused_op.mutable_attr();
+  (*attrs)["T"] = reduction.attr().at("T");
+  (*attrs)["Tidx"] = reduction.attr().at("Tidx");
+  (*attrs)["Tgather"] = gather.attr().at("Tindices");
+
+  utils::Mutation* mutation = ctx->graph_view.GetMutationBuilder();
+  Status status;
+  mutation->AddNode(std::move(fused_op), &status);
+  TF_RETURN_IF_ERROR(status);
+  TF_RETURN_IF_ERROR(mutation->Apply());
+
+  (*invalidated_nodes)[matched.reduction] = true;
+  (*nodes_to_delete)[matched.gather] = true;
+  if (matched.identity != kMissingIndex) {
+    (*nodes_to_delete)[matched.identity] = true;
+  }
+
+  return Status::OK();
+}
+
+Status AddFusedSparseSegmentSumGradNode(
+    RemapperContext* ctx, const GatherWithUnsortedSegmentSum& matched,
+    std::vector<bool>* invalidated_nodes, std::vector<bool>* nodes_to_delete) {
+  const GraphDef* graph = ctx->graph_view.graph();
+  const NodeDef& gather = graph->node(matched.gather);
+  const NodeDef& segment_sum = graph->node(matched.segment_sum);
+
+  VLOG(2) << "Fuse UnsortedSegmentSum with GatherV2:"
+          << " segment_sum=" << segment_sum.name()
+          << " gather=" << gather.name();
+
+  NodeDef fused_op;
+  fused_op.set_op(kFusedSparseSegmentSumGrad);
+  fused_op.set_name(segment_sum.name());
+  fused_op.set_device(segment_sum.device());
+
+  fused_op.add_input(gather.input(0));       // 0: grad
+  fused_op.add_input(segment_sum.input(1));  // 1: indices
+  fused_op.add_input(gather.input(1));       // 2: segment_ids
+  fused_op.add_input(segment_sum.input(2));  // 3: output_dim0
+
+  auto* attrs = fused_op.mutable_attr();
+  (*attrs)["T"] = segment_sum.attr().at("T");
+  SetAttrValue(DT_INT32, &(*attrs)["Tidx"]);
+
+  utils::Mutation* mutation = ctx->graph_view.GetMutationBuilder();
+  Status status;
+  mutation->AddNode(std::move(fused_op), &status);
+  TF_RETURN_IF_ERROR(status);
+  TF_RETURN_IF_ERROR(mutation->Apply());
+
+  (*invalidated_nodes)[matched.segment_sum] = true;
+  (*nodes_to_delete)[matched.gather] = true;
+
+  return Status::OK();
+}
+
+Status AddStringSplitToHashBucketFastNode(
+    RemapperContext* ctx, const StringSplitWithHashBucket& matched,
+    std::vector<bool>* invalidated_nodes, std::vector<bool>* nodes_to_delete) {
+  const GraphDef* graph = ctx->graph_view.graph();
+  const NodeDef& string_split = graph->node(matched.string_split);
+  const NodeDef& hash_bucket = graph->node(matched.hash_bucket);
+
+  VLOG(2) << "Fuse StringToHashBucketFast with StringSplit:"
+          << " hash_bucket=" << hash_bucket.name()
+          << " string_split=" << string_split.name();
+
+  // The fused node takes over the StringSplit name, so consumers of the
+  // indices and shape outputs are unchanged.
+  NodeDef fused_op;
+  fused_op.set_op(kStringSplitToHashBucketFast);
+  fused_op.set_name(string_split.name());
+  fused_op.set_device(string_split.device());
+
+  fused_op.add_input(string_split.input(0));  // 0: input
+  fused_op.add_input(string_split.input(1));  // 1: delimiter
+
+  auto* attrs = fused_op.mutable_attr();
+  if (HasNodeAttr(string_split, "skip_empty")) {
+    (*attrs)["skip_empty"] = string_split.attr().at("skip_empty");
+  }
+  (*attrs)["num_buckets"] = hash_bucket.attr().at("num_buckets");
+
+  // The bucket ids now come straight out of the fused node.
+  NodeDef identity;
+  identity.set_op("Identity");
+  identity.set_name(hash_bucket.name());
+  identity.set_device(hash_bucket.device());
+  identity.add_input(absl::StrCat(string_split.name(), ":1"));
+  SetAttrValue(DT_INT64, &(*identity.mutable_attr())["T"]);
+
+  utils::Mutation* mutation = ctx->graph_view.GetMutationBuilder();
+  Status status;
+  mutation->AddNode(std::move(fused_op), &status);
+  TF_RETURN_IF_ERROR(status);
+  mutation->AddNode(std::move(identity), &status);
+  TF_RETURN_IF_ERROR(status);
+  TF_RETURN_IF_ERROR(mutation->Apply());
+
+  (*invalidated_nodes)[matched.string_split] = true;
+  (*invalidated_nodes)[matched.hash_bucket] = true;
+
+  return Status::OK();
+}
+
 Status AddBatchNormNodes(RemapperContext* ctx, const FusedBatchNorm& matched) {
   const GraphDef* graph = ctx->graph_view.graph();
   const NodeDef& fused_node = graph->node(matched.fused_batch_norm);
@@ -1466,6 +2194,8 @@ Status AddBatchNormNodes(RemapperContext* ctx, const FusedBatchNorm& matched) {
 // shapes:
 //   (1) Splitting FusedBatchNorm into primitives.
 //   (2) Fusing side input and/or activation into FusedBatchNorm.
+//   (3) Fusing GatherV2 into a sparse segment reduction.
+//   (4) Fusing Add into a contraction with BiasAdd.
 bool RequiresInferredShapes(const RemapperContext& ctx, int node_index) {
   // Candidate for a FusedBatchNorm splitting.
   const auto* node_view = ctx.graph_view.GetNode(node_index);
@@ -1511,7 +2241,39 @@ bool RequiresInferredShapes(const RemapperContext& ctx, int node_index) {
     return false;
   };
 
-  return is_batch_norm_candidate() || is_batch_norm_fusion_candidate();
+  // Candidate for a GatherV2 + sparse segment reduction fusion.
+  const auto is_gather_fusion_candidate = [&]() -> bool {
+    if (!IsSparseSegmentReduction(*node_def) &&
+        !IsUnsortedSegmentSum(*node_def))
+      return false;
+
+    if (node_view->NumRegularFanins() < 1) return false;
+    const auto* fanin_0_node_view = node_view->GetRegularFanin(0).node_view();
+    const auto* fanin_0_node_def = fanin_0_node_view->node();
+    if (IsIdentity(*fanin_0_node_def) &&
+        fanin_0_node_view->NumRegularFanins() >= 1) {
+      fanin_0_node_def =
+          fanin_0_node_view->GetRegularFanin(0).node_view()->node();
+    }
+    return IsGather(*fanin_0_node_def);
+  };
+
+  // Candidate for a {Conv2D,MatMul} + BiasAdd + Add + <Relu> fusion.
+  const auto is_contraction_with_add_candidate = [&]() -> bool {
+    const auto* add_node_view = node_view;
+    if (IsRelu(*node_def) && node_view->NumRegularFanins() >= 1) {
+      add_node_view = node_view->GetRegularFanin(0).node_view();
+    }
+    if (!IsAdd(*add_node_view->node()) ||
+        add_node_view->NumRegularFanins() != 2)
+      return false;
+
+    return IsBiasAdd(*add_node_view->GetRegularFanin(0).node_view()->node()) ||
+           IsBiasAdd(*add_node_view->GetRegularFanin(1).node_view()->node());
+  };
+
+  return is_batch_norm_candidate() || is_batch_norm_fusion_candidate() ||
+         is_gather_fusion_candidate() || is_contraction_with_add_candidate();
 }
 
 }  // namespace
@@ -1589,6 +2351,29 @@ Status Remapper::Optimize(Cluster* cluster, const GrapplerItem& item,
       continue;
     }
 
+#ifndef INTEL_MKL
+    // Remap {Conv2D,MatMul}+BiasAdd+Swish into the _Fused{Conv2D,MatMul}.
+    ContractionWithBiasAddAndSwish contract_with_bias_and_swish;
+    if (allow_non_differentiable_rewrites &&
+        FindContractionWithBiasAndSwish(ctx, i,
+                                        &contract_with_bias_and_swish)) {
+      TF_RETURN_IF_ERROR(
+          AddFusedContractionNode(&ctx, contract_with_bias_and_swish,
+                                  &invalidated_nodes, &nodes_to_delete));
+      continue;
+    }
+
+    // Remap {Conv2D,MatMul}+BiasAdd+GeLU into the _Fused{Conv2D,MatMul}.
+    ContractionWithBiasAddAndGelu contract_with_bias_and_gelu;
+    if (allow_non_differentiable_rewrites &&
+        FindContractionWithBiasAndGelu(ctx, i, &contract_with_bias_and_gelu)) {
+      TF_RETURN_IF_ERROR(
+          AddFusedContractionNode(&ctx, contract_with_bias_and_gelu,
+                                  &invalidated_nodes, &nodes_to_delete));
+      continue;
+    }
+#endif  // !INTEL_MKL
+
 // NOTE: We can only fuse BatchNorm into Conv2D nodes. In theory we can do
 // it for MatMul as well, but in practice this pattern does not appear in
 // real Tensorflow graphs.
@@ -1640,6 +2425,29 @@ Status Remapper::Optimize(Cluster* cluster, const GrapplerItem& item,
       ctx.inferred_graph_properties = true;
     }
 
+#ifndef INTEL_MKL
+    // Remap {Conv2D,MatMul}+BiasAdd+Add+Relu into the _Fused{Conv2D,MatMul}.
+    ContractionWithBiasAndAddActivation contract_with_bias_and_add_activation;
+    if (allow_non_differentiable_rewrites &&
+        FindContractionWithBiasAndAddActivation(
+            ctx, i, &contract_with_bias_and_add_activation)) {
+      TF_RETURN_IF_ERROR(
+          AddFusedContractionNode(&ctx, contract_with_bias_and_add_activation,
+                                  &invalidated_nodes, &nodes_to_delete));
+      continue;
+    }
+
+    // Remap {Conv2D,MatMul}+BiasAdd+Add into the _Fused{Conv2D,MatMul}.
+    ContractionWithBiasAddAndAdd contract_with_bias_and_add;
+    if (allow_non_differentiable_rewrites &&
+        FindContractionWithBiasAddAndAdd(ctx, i, &contract_with_bias_and_add)) {
+      TF_RETURN_IF_ERROR(
+          AddFusedContractionNode(&ctx, contract_with_bias_and_add,
+                                  &invalidated_nodes, &nodes_to_delete));
+      continue;
+    }
+#endif  // !INTEL_MKL
+
     // Remap FusedBatchNorm+<SideInput>+<Activation> into the _FusedBatchNormEx.
     FusedBatchNormEx fused_batch_norm_ex;
     if (allow_non_differentiable_rewrites &&
@@ -1649,6 +2457,35 @@ Status Remapper::Optimize(Cluster* cluster, const GrapplerItem& item,
       continue;
     }
 
+    // Remap GatherV2+<Identity>+SparseSegment{Sum,Mean,SqrtN} into the
+    // _FusedSparseSegment{Sum,Mean,SqrtN}.
+    GatherWithSparseSegmentReduction gather_with_reduction;
+    if (allow_non_differentiable_rewrites &&
+        FindGatherWithSparseSegmentReduction(ctx, i, &gather_with_reduction)) {
+      TF_RETURN_IF_ERROR(AddFusedSparseSegmentReductionNode(
+          &ctx, gather_with_reduction, &invalidated_nodes, &nodes_to_delete));
+      continue;
+    }
+
+    // Remap GatherV2+UnsortedSegmentSum into the _FusedSparseSegmentSumGrad.
+    GatherWithUnsortedSegmentSum gather_with_segment_sum;
+    if (allow_non_differentiable_rewrites &&
+        FindGatherWithUnsortedSegmentSum(ctx, i, &gather_with_segment_sum)) {
+      TF_RETURN_IF_ERROR(AddFusedSparseSegmentSumGradNode(
+          &ctx, gather_with_segment_sum, &invalidated_nodes, &nodes_to_delete));
+      continue;
+    }
+
+    // Remap StringSplit+StringToHashBucketFast into the
+    // _StringSplitToHashBucketFast.
+    StringSplitWithHashBucket string_split_with_hash_bucket;
+    if (FindStringSplitWithHashBucket(ctx, i, &string_split_with_hash_bucket)) {
+      TF_RETURN_IF_ERROR(AddStringSplitToHashBucketFastNode(
+          &ctx, string_split_with_hash_bucket, &invalidated_nodes,
+          &nodes_to_delete));
+      continue;
+    }
+
     // During inference, most of the inputs to FusedBatchNorm are constant, and
     // we can therefore replace the op with a much cheaper set of primitives.
     FusedBatchNorm fused_batch_norm;
@@ -1656,6 +2493,13 @@ Status Remapper::Optimize(Cluster* cluster, const GrapplerItem& item,
       TF_RETURN_IF_ERROR(AddBatchNormNodes(&ctx, fused_batch_norm));
       continue;
     }
+
+    // Mark {Conv2D,MatMul} with constant weights, so that their kernels can
+    // pack the weights once. Contractions fused above were already skipped.
+    if (FindContractionWithConstWeights(ctx, i)) {
+      NodeDef* contraction = ctx.graph_view.GetNode(i)->node();
+      SetAttrValue(true, &(*contraction->mutable_attr())[kIsWeightConst]);
+    }
   }
 
   // Remove invalidated nodes.
@@ -15,6 +15,8 @@ limitations under the License.
 
 #include "tensorflow/core/grappler/optimizers/remapper.h"
 
+#include "absl/strings/str_cat.h"
+#include "tensorflow/cc/ops/nn_ops_internal.h"
 #include "tensorflow/cc/ops/standard_ops.h"
 #include "tensorflow/core/framework/tensor_testutil.h"
 #include "tensorflow/core/framework/types.pb.h"
@@ -454,7 +456,7 @@ TEST_F(RemapperTest, FuseMatMulWithBias) {
 TEST_F(RemapperTest, FuseConv2DWithBiasAndActivation) {
   using ::tensorflow::ops::Placeholder;
 
-  for (const string& activation : {"Relu", "Relu6", "Elu"}) {
+  for (const string& activation : {"Relu", "Relu6", "Elu", "LeakyRelu"}) {
     tensorflow::Scope s = tensorflow::Scope::NewRootScope();
 
     auto input_shape = Placeholder::Shape({8, 32, 32, 3});
@@ -480,6 +482,10 @@ TEST_F(RemapperTest, FuseConv2DWithBiasAndActivation) {
         return ops::Identity(fetch, ops::Relu6(activate, bias_add));
       } else if (activation == "Elu") {
         return ops::Identity(fetch, ops::Elu(activate, bias_add));
+      } else if (activation == "LeakyRelu") {
+        auto attrs = ops::internal::LeakyRelu::Alpha(0.3f);
+        return ops::Identity(
+            fetch, ops::internal::LeakyRelu(activate, bias_add, attrs));
       }
 
       return ops::Identity(fetch, bias);
@@ -518,6 +524,9 @@ TEST_F(RemapperTest, FuseConv2DWithBiasAndActivation) {
         ASSERT_EQ(fused_ops.size(), 2);
         EXPECT_EQ(fused_ops[0], "BiasAdd");
         EXPECT_EQ(fused_ops[1], activation);
+        if (activation == "LeakyRelu") {
+          EXPECT_FLOAT_EQ(node.attr().at("leakyrelu_alpha").f(), 0.3f);
+        }
         found++;
       }
     }
@@ -534,7 +543,7 @@ TEST_F(RemapperTest, FuseConv2DWithBiasAndActivation) {
 TEST_F(RemapperTest, FuseMatMulWithBiasAndActivation) {
   using ::tensorflow::ops::Placeholder;
 
-  for (const string& activation : {"Relu", "Relu6", "Elu"}) {
+  for (const string& activation : {"Relu", "Relu6", "Elu", "LeakyRelu"}) {
     tensorflow::Scope s = tensorflow::Scope::NewRootScope();
 
     auto lhs_shape = ops::Placeholder::Shape({8, 32});
@@ -558,6 +567,10 @@ TEST_F(RemapperTest, FuseMatMulWithBiasAndActivation) {
         return ops::Identity(fetch, ops::Relu6(activate, bias_add));
       } else if (activation == "Elu") {
         return ops::Identity(fetch, ops::Elu(activate, bias_add));
+      } else if (activation == "LeakyRelu") {
+        auto attrs = ops::internal::LeakyRelu::Alpha(0.3f);
+        return ops::Identity(
+            fetch, ops::internal::LeakyRelu(activate, bias_add, attrs));
       }
 
       return ops::Identity(fetch, bias);
@@ -596,6 +609,9 @@ TEST_F(RemapperTest, FuseMatMulWithBiasAndActivation) {
         ASSERT_EQ(fused_ops.size(), 2);
         EXPECT_EQ(fused_ops[0], "BiasAdd");
         EXPECT_EQ(fused_ops[1], activation);
+        if (activation == "LeakyRelu") {
+          EXPECT_FLOAT_EQ(node.attr().at("leakyrelu_alpha").f(), 0.3f);
+        }
         found++;
       }
     }
@@ -609,6 +625,234 @@ TEST_F(RemapperTest, FuseMatMulWithBiasAndActivation) {
   }
 }
 
+TEST_F(RemapperTest, FuseConv2DWithBiasAndAdd) {
+  using ::tensorflow::ops::Placeholder;
+
+  for (bool with_relu : {false, true}) {
+    tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+
+    auto input_shape = Placeholder::Shape({8, 32, 32, 3});
+    auto filter_shape = Placeholder::Shape({1, 1, 3, 128});
+    auto bias_shape = Placeholder::Shape({128});
+    auto residual_shape = Placeholder::Shape({8, 32, 32, 128});
+
+    auto input = Placeholder(s.WithOpName("input"), DT_FLOAT, input_shape);
+    auto filter = Placeholder(s.WithOpName("filter"), DT_FLOAT, filter_shape);
+    auto bias = Placeholder(s.WithOpName("bias"), DT_FLOAT, bias_shape);
+    auto residual =
+        Placeholder(s.WithOpName("residual"), DT_FLOAT, residual_shape);
+
+    std::vector<int> strides = {1, 1, 1, 1};
+    auto conv =
+        ops::Conv2D(s.WithOpName("conv"), input, filter, strides, "SAME");
+    auto bias_add = ops::BiasAdd(s.WithOpName("bias_add"), conv, bias);
+    auto add = ops::AddV2(s.WithOpName("add"), residual, bias_add);
+
+    string fused_name = "add";
+    if (with_relu) {
+      ops::Identity(s.WithOpName("fetch"),
+                    ops::Relu(s.WithOpName("activation"), add));
+      fused_name = "activation";
+    } else {
+      ops::Identity(s.WithOpName("fetch"), add);
+    }
+
+    auto input_t = GenerateRandomTensor<DT_FLOAT>({8, 32, 32, 3});
+    auto filter_t = GenerateRandomTensor<DT_FLOAT>({1, 1, 3, 128});
+    auto bias_t = GenerateRandomTensor<DT_FLOAT>({128});
+    auto residual_t = GenerateRandomTensor<DT_FLOAT>({8, 32, 32, 128});
+
+    GrapplerItem item;
+    item.fetch = {"fetch"};
+    item.feed = {{"input", input_t},
+                 {"filter", filter_t},
+                 {"bias", bias_t},
+                 {"residual", residual_t}};
+    TF_ASSERT_OK(s.ToGraphDef(&item.graph));
+
+    // Place all nodes on CPU.
+    for (int i = 0; i < item.graph.node_size(); ++i) {
+      item.graph.mutable_node(i)->set_device("/device:CPU:0");
+    }
+
+    Remapper optimizer(RewriterConfig::ON);
+    GraphDef output;
+    TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+
+    int found = 0;
+    for (const NodeDef& node : output.node()) {
+      if (node.name() == fused_name) {
+        EXPECT_EQ(node.op(), "_FusedConv2D");
+        ASSERT_GE(node.input_size(), 4);
+        EXPECT_EQ(node.input(0), "input");
+        EXPECT_EQ(node.input(1), "filter");
+
+        EXPECT_EQ(node.attr().at("num_args").i(), 2);
+        EXPECT_EQ(node.input(2), "bias");
+        EXPECT_EQ(node.input(3), "residual");
+
+        const auto fused_ops = node.attr().at("fused_ops").list().s();
+        ASSERT_EQ(fused_ops.size(), with_relu ? 3 : 2);
+        EXPECT_EQ(fused_ops[0], "BiasAdd");
+        EXPECT_EQ(fused_ops[1], "Add");
+        if (with_relu) EXPECT_EQ(fused_ops[2], "Relu");
+        found++;
+      }
+    }
+    EXPECT_EQ(found, 1);
+
+    auto tensors_expected = EvaluateNodes(item.graph, item.fetch, item.feed);
+    ASSERT_EQ(tensors_expected.size(), 1);
+    auto tensors = EvaluateNodes(output, item.fetch, item.feed);
+    ASSERT_EQ(tensors.size(), 1);
+    test::ExpectTensorNear<float>(tensors[0], tensors_expected[0], 1e-6);
+  }
+}
+
+TEST_F(RemapperTest, FuseMatMulWithBiasAndSwish) {
+  using ::tensorflow::ops::Placeholder;
+
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+
+  auto lhs_shape = ops::Placeholder::Shape({8, 32});
+  auto rhs_shape = ops::Placeholder::Shape({32, 64});
+  auto bias_shape = ops::Placeholder::Shape({64});
+
+  auto lhs = Placeholder(s.WithOpName("lhs"), DT_FLOAT, lhs_shape);
+  auto rhs = Placeholder(s.WithOpName("rhs"), DT_FLOAT, rhs_shape);
+  auto bias = Placeholder(s.WithOpName("bias"), DT_FLOAT, bias_shape);
+
+  auto matmul = ops::MatMul(s.WithOpName("matmul"), lhs, rhs);
+  auto bias_add = ops::BiasAdd(s.WithOpName("bias_add"), matmul, bias);
+  auto sigmoid = ops::Sigmoid(s.WithOpName("sigmoid"), bias_add);
+  auto swish = ops::Mul(s.WithOpName("swish"), bias_add, sigmoid);
+  auto fetch = ops::Identity(s.WithOpName("fetch"), swish);
+
+  auto lhs_t = GenerateRandomTensor<DT_FLOAT>({8, 32});
+  auto rhs_t = GenerateRandomTensor<DT_FLOAT>({32, 64});
+  auto bias_t = GenerateRandomTensor<DT_FLOAT>({64});
+
+  GrapplerItem item;
+  item.fetch = {"fetch"};
+  item.feed = {{"lhs", lhs_t}, {"rhs", rhs_t}, {"bias", bias_t}};
+  TF_ASSERT_OK(s.ToGraphDef(&item.graph));
+
+  // Place all nodes on CPU.
+  for (int i = 0; i < item.graph.node_size(); ++i) {
+    item.graph.mutable_node(i)->set_device("/device:CPU:0");
+  }
+
+  Remapper optimizer(RewriterConfig::ON);
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  int found = 0;
+  for (const NodeDef& node : output.node()) {
+    EXPECT_NE(node.name(), "sigmoid");
+    if (node.name() == "swish") {
+      EXPECT_EQ(node.op(), "_FusedMatMul");
+      ASSERT_GE(node.input_size(), 3);
+      EXPECT_EQ(node.input(0), "lhs");
+      EXPECT_EQ(node.input(1), "rhs");
+      EXPECT_EQ(node.input(2), "bias");
+
+      const auto fused_ops = node.attr().at("fused_ops").list().s();
+      ASSERT_EQ(fused_ops.size(), 2);
+      EXPECT_EQ(fused_ops[0], "BiasAdd");
+      EXPECT_EQ(fused_ops[1], "Swish");
+      found++;
+    }
+  }
+  EXPECT_EQ(found, 1);
+
+  auto tensors_expected = EvaluateNodes(item.graph, item.fetch, item.feed);
+  ASSERT_EQ(tensors_expected.size(), 1);
+  auto tensors = EvaluateNodes(output, item.fetch, item.feed);
+  ASSERT_EQ(tensors.size(), 1);
+  test::ExpectTensorNear<float>(tensors[0], tensors_expected[0], 1e-6);
+}
+
+TEST_F(RemapperTest, FuseMatMulWithBiasAndGelu) {
+  using ::tensorflow::ops::Placeholder;
+
+  for (bool approximate : {false, true}) {
+    tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+
+    auto lhs_shape = ops::Placeholder::Shape({8, 32});
+    auto rhs_shape = ops::Placeholder::Shape({32, 64});
+    auto bias_shape = ops::Placeholder::Shape({64});
+
+    auto lhs = Placeholder(s.WithOpName("lhs"), DT_FLOAT, lhs_shape);
+    auto rhs = Placeholder(s.WithOpName("rhs"), DT_FLOAT, rhs_shape);
+    auto bias = Placeholder(s.WithOpName("bias"), DT_FLOAT, bias_shape);
+
+    auto matmul = ops::MatMul(s.WithOpName("matmul"), lhs, rhs);
+    auto x = ops::BiasAdd(s.WithOpName("bias_add"), matmul, bias);
+
+    // The GeLU subgraphs built by tf.nn.gelu.
+    Output function;
+    if (approximate) {
+      auto cube = ops::Pow(s.WithOpName("pow"), x, 3.0f);
+      auto scaled_cube = ops::Mul(s.WithOpName("scaled_cube"), 0.044715f, cube);
+      auto sum = ops::AddV2(s.WithOpName("sum"), x, scaled_cube);
+      auto scaled_sum =
+          ops::Mul(s.WithOpName("scaled_sum"), 0.7978845608028654f, sum);
+      function = ops::Tanh(s.WithOpName("tanh"), scaled_sum);
+    } else {
+      auto div = ops::RealDiv(s.WithOpName("div"), x, 1.4142135623730951f);
+      function = ops::Erf(s.WithOpName("erf"), div);
+    }
+    auto half_x = ops::Mul(s.WithOpName("half_x"), 0.5f, x);
+    auto one_plus = ops::AddV2(s.WithOpName("one_plus"), 1.0f, function);
+    auto gelu = ops::Mul(s.WithOpName("gelu"), half_x, one_plus);
+    auto fetch = ops::Identity(s.WithOpName("fetch"), gelu);
+
+    auto lhs_t = GenerateRandomTensor<DT_FLOAT>({8, 32});
+    auto rhs_t = GenerateRandomTensor<DT_FLOAT>({32, 64});
+    auto bias_t = GenerateRandomTensor<DT_FLOAT>({64});
+
+    GrapplerItem item;
+    item.fetch = {"fetch"};
+    item.feed = {{"lhs", lhs_t}, {"rhs", rhs_t}, {"bias", bias_t}};
+    TF_ASSERT_OK(s.ToGraphDef(&item.graph));
+
+    // Place all nodes on CPU.
+    for (int i = 0; i < item.graph.node_size(); ++i) {
+      item.graph.mutable_node(i)->set_device("/device:CPU:0");
+    }
+
+    Remapper optimizer(RewriterConfig::ON);
+    GraphDef output;
+    TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+
+    int found = 0;
+    for (const NodeDef& node : output.node()) {
+      EXPECT_NE(node.name(), "half_x");
+      EXPECT_NE(node.name(), "one_plus");
+      if (node.name() == "gelu") {
+        EXPECT_EQ(node.op(), "_FusedMatMul");
+        ASSERT_GE(node.input_size(), 3);
+        EXPECT_EQ(node.input(0), "lhs");
+        EXPECT_EQ(node.input(1), "rhs");
+        EXPECT_EQ(node.input(2), "bias");
+
+        const auto fused_ops = node.attr().at("fused_ops").list().s();
+        ASSERT_EQ(fused_ops.size(), 2);
+        EXPECT_EQ(fused_ops[0], "BiasAdd");
+        EXPECT_EQ(fused_ops[1], approximate ? "GeluApproximate" : "GeluExact");
+        found++;
+      }
+    }
+    EXPECT_EQ(found, 1);
+
+    auto tensors_expected = EvaluateNodes(item.graph, item.fetch, item.feed);
+    ASSERT_EQ(tensors_expected.size(), 1);
+    auto tensors = EvaluateNodes(output, item.fetch, item.feed);
+    ASSERT_EQ(tensors.size(), 1);
+    test::ExpectTensorNear<float>(tensors[0], tensors_expected[0], 1e-5);
+  }
+}
+
 TEST_F(RemapperTest, FuseConv2DWithBatchNorm) {
   using ops::Placeholder;
 
@@ -690,7 +934,7 @@ TEST_F(RemapperTest, FuseConv2DWithBatchNorm) {
 TEST_F(RemapperTest, FuseConv2DWithBatchNormAndActivation) {
   using ops::Placeholder;
 
-  for (const string& activation : {"Relu", "Relu6", "Elu"}) {
+  for (const string& activation : {"Relu", "Relu6", "Elu", "LeakyRelu"}) {
     tensorflow::Scope s = tensorflow::Scope::NewRootScope();
 
     auto input_shape = ops::Placeholder::Shape({8, 32, 32, 3});
@@ -723,6 +967,10 @@ TEST_F(RemapperTest, FuseConv2DWithBatchNormAndActivation) {
         return ops::Identity(fetch, ops::Relu6(activate, batch_norm.y));
       } else if (activation == "Elu") {
         return ops::Identity(fetch, ops::Elu(activate, batch_norm.y));
+      } else if (activation == "LeakyRelu") {
+        auto attrs = ops::internal::LeakyRelu::Alpha(0.3f);
+        return ops::Identity(
+            fetch, ops::internal::LeakyRelu(activate, batch_norm.y, attrs));
       }
 
       return ops::Identity(fetch, batch_norm.y);
@@ -769,6 +1017,9 @@ TEST_F(RemapperTest, FuseConv2DWithBatchNormAndActivation) {
         ASSERT_EQ(fused_ops.size(), 2);
         EXPECT_EQ(fused_ops[0], "FusedBatchNorm");
         EXPECT_EQ(fused_ops[1], activation);
+        if (activation == "LeakyRelu") {
+          EXPECT_FLOAT_EQ(node.attr().at("leakyrelu_alpha").f(), 0.3f);
+        }
         found++;
       }
     }
@@ -853,5 +1104,251 @@ TEST_F(RemapperTest, FuseConv2DWithSqueezeAndBias) {
   test::ExpectTensorNear<float>(tensors[0], tensors_expected[0], 1e-6);
 }
 
+TEST_F(RemapperTest, FuseGatherWithSparseSegmentReduction) {
+  using ::tensorflow::ops::Placeholder;
+
+  for (const string& reduction :
+       {"SparseSegmentSum", "SparseSegmentMean", "SparseSegmentSqrtN"}) {
+    tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+
+    auto params = Placeholder(s.WithOpName("params"), DT_FLOAT,
+                              Placeholder::Shape({16, 8}));
+    auto ids = ops::Const(s.WithOpName("ids"), {3, 7, 1, 12}, {4});
+    auto axis = ops::Const(s.WithOpName("axis"), 0);
+    auto gather = ops::GatherV2(s.WithOpName("gather"), params, ids, axis);
+    // embedding_lookup wraps the gather in an Identity.
+    auto identity = ops::Identity(s.WithOpName("identity"), gather);
+    auto indices = ops::Const(s.WithOpName("indices"), {0, 1, 2, 3, 1}, {5});
+    auto segment_ids =
+        ops::Const(s.WithOpName("segment_ids"), {0, 0, 1, 3, 3}, {5});
+
+    Output reduced;
+    if (reduction == "SparseSegmentSum") {
+      reduced = ops::SparseSegmentSum(s.WithOpName("reduction"), identity,
+                                      indices, segment_ids);
+    } else if (reduction == "SparseSegmentMean") {
+      reduced = ops::SparseSegmentMean(s.WithOpName("reduction"), identity,
+                                       indices, segment_ids);
+    } else {
+      reduced = ops::SparseSegmentSqrtN(s.WithOpName("reduction"), identity,
+                                        indices, segment_ids);
+    }
+    auto fetch = ops::Identity(s.WithOpName("fetch"), reduced);
+
+    auto params_t = GenerateRandomTensor<DT_FLOAT>({16, 8});
+
+    GrapplerItem item;
+    item.fetch = {"fetch"};
+    item.feed = {{"params", params_t}};
+    TF_ASSERT_OK(s.ToGraphDef(&item.graph));
+
+    // Place all nodes on CPU.
+    for (int i = 0; i < item.graph.node_size(); ++i) {
+      item.graph.mutable_node(i)->set_device("/device:CPU:0");
+    }
+
+    Remapper optimizer(RewriterConfig::ON);
+    GraphDef output;
+    TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+
+    int found = 0;
+    for (const NodeDef& node : output.node()) {
+      EXPECT_NE(node.name(), "gather");
+      EXPECT_NE(node.name(), "identity");
+      if (node.name() == "reduction") {
+        EXPECT_EQ(node.op(), absl::StrCat("_Fused", reduction));
+        ASSERT_EQ(node.input_size(), 4);
+        EXPECT_EQ(node.input(0), "params");
+        EXPECT_EQ(node.input(1), "ids");
+        EXPECT_EQ(node.input(2), "indices");
+        EXPECT_EQ(node.input(3), "segment_ids");
+        EXPECT_EQ(node.attr().at("Tgather").type(), DT_INT32);
+        found++;
+      }
+    }
+    EXPECT_EQ(1, found);
+
+    auto tensors_expected = EvaluateNodes(item.graph, item.fetch, item.feed);
+    ASSERT_EQ(tensors_expected.size(), 1);
+    auto tensors = EvaluateNodes(output, item.fetch, item.feed);
+    ASSERT_EQ(tensors.size(), 1);
+    test::ExpectTensorNear<float>(tensors[0], tensors_expected[0], 1e-6);
+  }
+}
+
+TEST_F(RemapperTest, FuseGatherWithUnsortedSegmentSum) {
+  using ::tensorflow::ops::Placeholder;
+
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+
+  // This is the gradient of SparseSegmentSum with respect to its data.
+  auto grad = Placeholder(s.WithOpName("grad"), DT_FLOAT,
+                          Placeholder::Shape({4, 8}));
+  auto segment_ids =
+      ops::Const(s.WithOpName("segment_ids"), {0, 0, 1, 3, 3}, {5});
+  auto axis = ops::Const(s.WithOpName("axis"), 0);
+  auto gather =
+      ops::GatherV2(s.WithOpName("gather"), grad, segment_ids, axis);
+  auto indices = ops::Const(s.WithOpName("indices"), {0, 1, 2, 3, 1}, {5});
+  auto num_segments = ops::Const(s.WithOpName("num_segments"), 6);
+  auto segment_sum = ops::UnsortedSegmentSum(s.WithOpName("segment_sum"),
+                                             gather, indices, num_segments);
+  auto fetch = ops::Identity(s.WithOpName("fetch"), segment_sum);
+
+  auto grad_t = GenerateRandomTensor<DT_FLOAT>({4, 8});
+
+  GrapplerItem item;
+  item.fetch = {"fetch"};
+  item.feed = {{"grad", grad_t}};
+  TF_ASSERT_OK(s.ToGraphDef(&item.graph));
+
+  // Place all nodes on CPU.
+  for (int i = 0; i < item.graph.node_size(); ++i) {
+    item.graph.mutable_node(i)->set_device("/device:CPU:0");
+  }
+
+  Remapper optimizer(RewriterConfig::ON);
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  int found = 0;
+  for (const NodeDef& node : output.node()) {
+    EXPECT_NE(node.name(), "gather");
+    if (node.name() == "segment_sum") {
+      EXPECT_EQ(node.op(), "_FusedSparseSegmentSumGrad");
+      ASSERT_EQ(node.input_size(), 4);
+      EXPECT_EQ(node.input(0), "grad");
+      EXPECT_EQ(node.input(1), "indices");
+      EXPECT_EQ(node.input(2), "segment_ids");
+      EXPECT_EQ(node.input(3), "num_segments");
+      found++;
+    }
+  }
+  EXPECT_EQ(1, found);
+
+  auto tensors_expected = EvaluateNodes(item.graph, item.fetch, item.feed);
+  ASSERT_EQ(tensors_expected.size(), 1);
+  auto tensors = EvaluateNodes(output, item.fetch, item.feed);
+  ASSERT_EQ(tensors.size(), 1);
+  test::ExpectTensorNear<float>(tensors[0], tensors_expected[0], 1e-6);
+}
+
+TEST_F(RemapperTest, FuseStringSplitWithHashBucket) {
+  using ::tensorflow::ops::Placeholder;
+
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+
+  auto input =
+      Placeholder(s.WithOpName("input"), DT_STRING, Placeholder::Shape({3}));
+  auto delimiter = ops::Const(s.WithOpName("delimiter"), string(" "));
+  auto split = ops::StringSplit(s.WithOpName("split"), input, delimiter);
+  auto hash_bucket = ops::StringToHashBucketFast(s.WithOpName("hash_bucket"),
+                                                 split.values, 1000);
+  auto fetch_indices = ops::Identity(s.WithOpName("fetch_indices"),
+                                     split.indices);
+  auto fetch_values = ops::Identity(s.WithOpName("fetch_values"), hash_bucket);
+  auto fetch_shape = ops::Identity(s.WithOpName("fetch_shape"), split.shape);
+
+  Tensor input_t(DT_STRING, TensorShape({3}));
+  test::FillValues<tstring>(&input_t, {"a b  c", "", "hello world"});
+
+  GrapplerItem item;
+  item.fetch = {"fetch_indices", "fetch_values", "fetch_shape"};
+  item.feed = {{"input", input_t}};
+  TF_ASSERT_OK(s.ToGraphDef(&item.graph));
+
+  // Place all nodes on CPU.
+  for (int i = 0; i < item.graph.node_size(); ++i) {
+    item.graph.mutable_node(i)->set_device("/device:CPU:0");
+  }
+
+  Remapper optimizer(RewriterConfig::ON);
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  int found = 0;
+  for (const NodeDef& node : output.node()) {
+    if (node.name() == "split") {
+      EXPECT_EQ(node.op(), "_StringSplitToHashBucketFast");
+      ASSERT_EQ(node.input_size(), 2);
+      EXPECT_EQ(node.input(0), "input");
+      EXPECT_EQ(node.input(1), "delimiter");
+      found++;
+    } else if (node.name() == "hash_bucket") {
+      EXPECT_EQ(node.op(), "Identity");
+      ASSERT_EQ(node.input_size(), 1);
+      EXPECT_EQ(node.input(0), "split:1");
+      found++;
+    }
+  }
+  EXPECT_EQ(2, found);
+
+  auto tensors_expected = EvaluateNodes(item.graph, item.fetch, item.feed);
+  ASSERT_EQ(tensors_expected.size(), 3);
+  auto tensors = EvaluateNodes(output, item.fetch, item.feed);
+  ASSERT_EQ(tensors.size(), 3);
+  for (int i = 0; i < 3; ++i) {
+    test::ExpectTensorEqual<int64>(tensors[i], tensors_expected[i]);
+  }
+}
+
+TEST_F(RemapperTest, MarkContractionWithConstWeights) {
+  using ::tensorflow::ops::Placeholder;
+
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+
+  auto lhs_shape = ops::Placeholder::Shape({8, 32});
+  auto rhs_shape = ops::Placeholder::Shape({32, 64});
+
+  auto weights_t = GenerateRandomTensor<DT_FLOAT>({32, 64});
+
+  auto lhs = Placeholder(s.WithOpName("lhs"), DT_FLOAT, lhs_shape);
+  auto rhs = Placeholder(s.WithOpName("rhs"), DT_FLOAT, rhs_shape);
+  auto weights = ops::Const(s.WithOpName("weights"),
+                            Input::Initializer(weights_t));
+
+  auto const_matmul = ops::MatMul(s.WithOpName("const_matmul"), lhs, weights);
+  auto matmul = ops::MatMul(s.WithOpName("matmul"), lhs, rhs);
+  auto fetch = ops::AddN(s.WithOpName("fetch"), {const_matmul, matmul});
+
+  auto lhs_t = GenerateRandomTensor<DT_FLOAT>({8, 32});
+  auto rhs_t = GenerateRandomTensor<DT_FLOAT>({32, 64});
+
+  GrapplerItem item;
+  item.fetch = {"fetch"};
+  item.feed = {{"lhs", lhs_t}, {"rhs", rhs_t}};
+  TF_ASSERT_OK(s.ToGraphDef(&item.graph));
+
+  // Place all nodes on CPU.
+  for (int i = 0; i < item.graph.node_size(); ++i) {
+    item.graph.mutable_node(i)->set_device("/device:CPU:0");
+  }
+
+  Remapper optimizer(RewriterConfig::ON);
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  int found = 0;
+  for (const NodeDef& node : output.node()) {
+    if (node.name() == "const_matmul") {
+      EXPECT_EQ(node.op(), "MatMul");
+      ASSERT_EQ(node.attr().count("_is_weight_const"), 1);
+      EXPECT_TRUE(node.attr().at("_is_weight_const").b());
+      found++;
+    } else if (node.name() == "matmul") {
+      EXPECT_EQ(node.op(), "MatMul");
+      EXPECT_EQ(node.attr().count("_is_weight_const"), 0);
+      found++;
+    }
+  }
+  EXPECT_EQ(found, 2);
+
+  auto tensors_expected = EvaluateNodes(item.graph, item.fetch, item.feed);
+  ASSERT_EQ(tensors_expected.size(), 1);
+  auto tensors = EvaluateNodes(output, item.fetch, item.feed);
+  ASSERT_EQ(tensors.size(), 1);
+  test::ExpectTensorNear<float>(tensors[0], tensors_expected[0], 1e-6);
+}
+
 }  // namespace grappler
 }  // namespace tensorflow
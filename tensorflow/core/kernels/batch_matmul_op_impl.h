@@ -20,6 +20,7 @@ limitations under the License.
 
 #define EIGEN_USE_THREADS
 
+#include <type_traits>
 #include <vector>
 
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
@@ -197,6 +198,162 @@ struct SequentialMatMulKernel {
   }
 };
 
+// Calls f(0), ..., f(N - 1), unrolled at compile time so that arrays indexed by
+// the argument can stay in registers.
+template <int N>
+struct Unroll {
+  template <typename F>
+  static EIGEN_ALWAYS_INLINE void Run(const F& f) {
+    Unroll<N - 1>::Run(f);
+    f(N - 1);
+  }
+};
+
+template <>
+struct Unroll<0> {
+  template <typename F>
+  static EIGEN_ALWAYS_INLINE void Run(const F& f) {}
+};
+
+// Sequential batch matmul kernel for small real matrices, like the many
+// 64x64 products of attention layers. Each product is computed by
+// register-blocked microkernels whose block sizes are compile-time constants,
+// which avoids the per-product setup and packing costs of the Eigen matmul.
+template <typename Scalar,
+          bool IsSupported = std::is_same<Scalar, float>::value ||
+                             std::is_same<Scalar, double>::value>
+struct SmallMatMulKernel {
+  static bool IsSmall(int64 m, int64 k, int64 n) { return false; }
+
+  static void Run(const Tensor& in_x, const Tensor& in_y, bool adj_x,
+                  bool adj_y, const MatMulBCast& bcast, Tensor* out, int start,
+                  int limit) {}
+};
+
+template <typename Scalar>
+struct SmallMatMulKernel<Scalar, true> {
+  using Packet = typename Eigen::internal::packet_traits<Scalar>::type;
+  static constexpr int kPacketSize =
+      Eigen::internal::packet_traits<Scalar>::size;
+  // The number of output rows computed together by a microkernel.
+  static constexpr int kRowBlock = 4;
+  // Larger products are faster with the Eigen matmul, which packs its
+  // operands for the caches.
+  static constexpr int64 kMaxCost = 64 * 64 * 64;
+
+  static bool IsSmall(int64 m, int64 k, int64 n) {
+    return m >= kRowBlock && n >= kPacketSize && m * k * n <= kMaxCost;
+  }
+
+  static void Run(const Tensor& in_x, const Tensor& in_y, bool adj_x,
+                  bool adj_y, const MatMulBCast& bcast, Tensor* out, int start,
+                  int limit) {
+    const int64 m = out->dim_size(1);
+    const int64 n = out->dim_size(2);
+    const int64 k = in_x.dim_size(adj_x ? 1 : 2);
+    const Scalar* x_data = in_x.flat<Scalar>().data();
+    const Scalar* y_data = in_y.flat<Scalar>().data();
+    Scalar* z_data = out->flat<Scalar>().data();
+    // The microkernels load rows of y, so an adjoint y is transposed first.
+    std::vector<Scalar> y_transposed(adj_y ? k * n : 0);
+
+    const bool should_bcast = bcast.IsBroadcastingRequired();
+    const auto& x_batch_indices = bcast.x_batch_indices();
+    const auto& y_batch_indices = bcast.y_batch_indices();
+    for (int64 i = start; i < limit; ++i) {
+      const int64 x_batch_index = should_bcast ? x_batch_indices[i] : i;
+      const int64 y_batch_index = should_bcast ? y_batch_indices[i] : i;
+      const Scalar* x = x_data + x_batch_index * m * k;
+      const Scalar* y = y_data + y_batch_index * k * n;
+      if (adj_y) {
+        for (int64 row = 0; row < k; ++row) {
+          for (int64 col = 0; col < n; ++col) {
+            y_transposed[row * n + col] = y[col * k + row];
+          }
+        }
+        y = y_transposed.data();
+      }
+      // An adjoint x is read in place, with swapped strides.
+      Multiply(x, adj_x ? 1 : k, adj_x ? m : 1, y, m, k, n,
+               z_data + i * m * n);
+    }
+  }
+
+  // Computes kRows x (kPackets * kPacketSize) elements of the output `z`.
+  template <int kRows, int kPackets>
+  static void MicroKernel(const Scalar* x, int64 x_row_stride,
+                          int64 x_col_stride, const Scalar* y, int64 n,
+                          int64 k, Scalar* z) {
+    using Eigen::internal::pmadd;
+    using Eigen::internal::pset1;
+    using Eigen::internal::ploadu;
+    using Eigen::internal::pstoreu;
+
+    Packet acc[kRows][kPackets];
+    Unroll<kRows>::Run([&](int r) {
+      Unroll<kPackets>::Run(
+          [&](int p) { acc[r][p] = pset1<Packet>(Scalar(0)); });
+    });
+    for (int64 l = 0; l < k; ++l) {
+      Packet y_l[kPackets];
+      Unroll<kPackets>::Run([&](int p) {
+        y_l[p] = ploadu<Packet>(y + l * n + p * kPacketSize);
+      });
+      Unroll<kRows>::Run([&](int r) {
+        const Packet x_rl =
+            pset1<Packet>(x[r * x_row_stride + l * x_col_stride]);
+        Unroll<kPackets>::Run(
+            [&](int p) { acc[r][p] = pmadd(x_rl, y_l[p], acc[r][p]); });
+      });
+    }
+    Unroll<kRows>::Run([&](int r) {
+      Unroll<kPackets>::Run([&](int p) {
+        pstoreu(z + r * n + p * kPacketSize, acc[r][p]);
+      });
+    });
+  }
+
+  // Computes the kPackets * kPacketSize columns of the output `z`.
+  template <int kPackets>
+  static void MultiplyColumns(const Scalar* x, int64 x_row_stride,
+                              int64 x_col_stride, const Scalar* y, int64 m,
+                              int64 k, int64 n, Scalar* z) {
+    int64 row = 0;
+    for (; row + kRowBlock <= m; row += kRowBlock) {
+      MicroKernel<kRowBlock, kPackets>(x + row * x_row_stride, x_row_stride,
+                                       x_col_stride, y, n, k, z + row * n);
+    }
+    for (; row < m; ++row) {
+      MicroKernel<1, kPackets>(x + row * x_row_stride, x_row_stride,
+                               x_col_stride, y, n, k, z + row * n);
+    }
+  }
+
+  // Computes the [m, n] row-major `z` = x * y, where x(i, l) is
+  // x[i * x_row_stride + l * x_col_stride] and y is [k, n] row-major.
+  static void Multiply(const Scalar* x, int64 x_row_stride, int64 x_col_stride,
+                       const Scalar* y, int64 m, int64 k, int64 n, Scalar* z) {
+    int64 col = 0;
+    for (; col + 2 * kPacketSize <= n; col += 2 * kPacketSize) {
+      MultiplyColumns<2>(x, x_row_stride, x_col_stride, y + col, m, k, n,
+                         z + col);
+    }
+    for (; col + kPacketSize <= n; col += kPacketSize) {
+      MultiplyColumns<1>(x, x_row_stride, x_col_stride, y + col, m, k, n,
+                         z + col);
+    }
+    for (; col < n; ++col) {
+      for (int64 row = 0; row < m; ++row) {
+        Scalar sum(0);
+        for (int64 l = 0; l < k; ++l) {
+          sum += x[row * x_row_stride + l * x_col_stride] * y[l * n + col];
+        }
+        z[row * n + col] = sum;
+      }
+    }
+  }
+};
+
 }  // namespace
 
 template <typename Device, typename Scalar>
@@ -227,6 +384,17 @@ struct LaunchBatchMatMul<CPUDevice, Scalar> {
       ParallelMatMulKernel::Run(context, in_x, in_y, adj_x, adj_y, bcast, out,
                                 0, batch_size);
       conjugate_result = adj_x;
+    } else if (SmallMatMulKernel<Scalar>::IsSmall(
+                   out->dim_size(1), in_x.dim_size(adj_x ? 1 : 2),
+                   out->dim_size(2))) {
+      // Parallelize over outer dims, with the microkernels for small
+      // matrices.
+      Shard(worker_threads.num_threads, worker_threads.workers, batch_size,
+            cost_per_unit,
+            [&in_x, &in_y, adj_x, adj_y, &bcast, out](int start, int limit) {
+              SmallMatMulKernel<Scalar>::Run(in_x, in_y, adj_x, adj_y, bcast,
+                                             out, start, limit);
+            });
     } else {
       // Parallelize over outer dims. For small matrices and large batches, it
       // is counter-productive to parallelize the inner matrix multiplies.
@@ -253,5 +253,16 @@ BM_BatchMatmul(1, 1, 200, 10000, true, true);
 BM_BatchMatmul(8, 1, 200, 10000, true, true);
 BM_BatchMatmul(32, 1, 200, 10000, true, true);
 
+// Attention-like shapes: many small products of queries and keys, and of
+// attention weights and values, per batch and head.
+BM_BatchMatmul(384, 128, 64, 128, false, true);
+BM_BatchMatmul(384, 128, 128, 64, false, false);
+BM_BatchMatmul(1024, 64, 64, 64, false, true);
+BM_BatchMatmul(1024, 64, 64, 64, false, false);
+BM_BatchMatmul(1024, 32, 32, 32, false, false);
+BM_BatchMatmul(1024, 32, 32, 32, true, false);
+BM_BatchMatmul(4096, 16, 16, 16, false, false);
+BM_BatchMatmul(512, 8, 64, 8, false, true);
+
 }  // namespace
 }  // namespace tensorflow
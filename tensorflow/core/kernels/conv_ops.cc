@@ -43,6 +43,7 @@ limitations under the License.
 #include "tensorflow/core/kernels/conv_2d.h"
 #include "tensorflow/core/kernels/deep_conv2d.h"
 #include "tensorflow/core/kernels/ops_util.h"
+#include "tensorflow/core/kernels/packed_matmul.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/gtl/array_slice.h"
 #include "tensorflow/core/lib/strings/numbers.h"
@@ -479,6 +480,9 @@ class Conv2DOp : public BinaryOp<T> {
     OP_REQUIRES_OK(context, context->GetAttr("use_cudnn_on_gpu", &use_cudnn_));
     use_cudnn_ &= CanUseCudnn();
     cudnn_use_autotune_ = CudnnUseAutotune();
+    if (ShouldPackConstantWeights(context)) {
+      packed_filter_.reset(new PackedMatMulWeightsCache());
+    }
   }
 
   void Compute(OpKernelContext* context) override {
@@ -520,6 +524,11 @@ class Conv2DOp : public BinaryOp<T> {
       return;
     }
 
+    if (packed_filter_ != nullptr && LaunchPackedConv2D(context, input, filter,
+                                                        dimensions, output)) {
+      return;
+    }
+
 #ifdef TENSORFLOW_USE_LIBXSMM_CONVOLUTIONS
     if (params_.padding != EXPLICIT &&
         LaunchXsmmConvOp<Device, T>::Run(
@@ -553,9 +562,49 @@ class Conv2DOp : public BinaryOp<T> {
   }
 
  private:
+  // Small convolutions that reduce to a matrix multiplication (see
+  // LaunchGeneric) multiply with the packed layout of a constant filter that
+  // is cached by the kernel. Returns false for other convolutions.
+  bool LaunchPackedConv2D(OpKernelContext* context, const Tensor& input,
+                          const Tensor& filter,
+                          const Conv2DDimensions& dimensions, Tensor* output) {
+    if (params_.data_format != FORMAT_NHWC ||
+        dimensions.in_depth != dimensions.patch_depth) {
+      return false;
+    }
+
+    int64 m;
+    if (dimensions.filter_rows == 1 && dimensions.filter_cols == 1 &&
+        dimensions.stride_rows == 1 && dimensions.stride_cols == 1 &&
+        (params_.padding == SAME || params_.padding == VALID)) {
+      m = dimensions.batch * dimensions.out_rows * dimensions.out_cols;
+    } else if (dimensions.filter_rows == dimensions.input_rows &&
+               dimensions.filter_cols == dimensions.input_cols &&
+               dimensions.dilation_rows == 1 &&
+               dimensions.dilation_cols == 1 && params_.padding == VALID) {
+      m = dimensions.batch;
+    } else {
+      return false;
+    }
+    if (m > PackedMatMulWeights::kMaxRows) return false;
+
+    const int64 k = static_cast<int64>(dimensions.filter_rows) *
+                    dimensions.filter_cols * dimensions.patch_depth;
+    const TensorShape filter_matrix_shape({k, dimensions.out_depth});
+    Tensor filter_matrix;
+    if (!filter_matrix.CopyFrom(filter, filter_matrix_shape)) return false;
+    packed_filter_->Get(filter_matrix, /*transpose=*/false)
+        ->Multiply(context->eigen_device<CPUDevice>(),
+                   input.flat<float>().data(), m,
+                   output->flat<float>().data());
+    return true;
+  }
+
   Conv2DParameters params_;
   bool use_cudnn_;
   bool cudnn_use_autotune_;
+  // Set if the filter is a constant that should be packed.
+  std::unique_ptr<PackedMatMulWeightsCache> packed_filter_;
 
   LaunchConv2DOp<Device, T> launcher_;
 
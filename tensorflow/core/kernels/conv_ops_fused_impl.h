@@ -188,7 +188,8 @@ struct LaunchFusedConv2DOp<CPUDevice, T> {
 
     BiasAddArgs<T> bias_add_args;
     if (BiasAddArgs<T>::IsSupported(fusion)) {
-      OP_REQUIRES_OK(context, InitBiasAddArgs(context, &bias_add_args));
+      OP_REQUIRES_OK(context,
+                     InitBiasAddArgs(context, *output, &bias_add_args));
     }
 
     FusedBatchNormArgs<T> fused_batch_norm_args;
@@ -222,6 +223,31 @@ struct LaunchFusedConv2DOp<CPUDevice, T> {
         conv2d(WithBiasAddAndElu<T>(bias_add_args), context, input, filter,
                output);
         break;
+      case FusedComputationType::kBiasAddWithLeakyRelu:
+        conv2d(WithBiasAddAndLeakyRelu<T>(
+                   bias_add_args, LeakyRelu(fusion_args.leakyrelu_alpha)),
+               context, input, filter, output);
+        break;
+      case FusedComputationType::kBiasAddWithGeluApproximate:
+        conv2d(WithBiasAddAndGeluApproximate<T>(bias_add_args), context, input,
+               filter, output);
+        break;
+      case FusedComputationType::kBiasAddWithGeluExact:
+        conv2d(WithBiasAddAndGeluExact<T>(bias_add_args), context, input,
+               filter, output);
+        break;
+      case FusedComputationType::kBiasAddWithSwish:
+        conv2d(WithBiasAddAndSwish<T>(bias_add_args), context, input, filter,
+               output);
+        break;
+      case FusedComputationType::kBiasAddWithAdd:
+        conv2d(WithBiasAddAndAdd<T>(bias_add_args), context, input, filter,
+               output);
+        break;
+      case FusedComputationType::kBiasAddWithAddAndRelu:
+        conv2d(WithBiasAddAndAddAndRelu<T>(bias_add_args), context, input,
+               filter, output);
+        break;
       case FusedComputationType::kFusedBatchNorm:
         conv2d(
             WithFusedBatchNorm<T>(fusion_args.epsilon, fused_batch_norm_args),
@@ -242,6 +268,12 @@ struct LaunchFusedConv2DOp<CPUDevice, T> {
                                            fused_batch_norm_args),
                context, input, filter, output);
         break;
+      case FusedComputationType::kFusedBatchNormWithLeakyRelu:
+        conv2d(WithFusedBatchNormAndLeakyRelu<T>(
+                   fusion_args.epsilon, fused_batch_norm_args,
+                   LeakyRelu(fusion_args.leakyrelu_alpha)),
+               context, input, filter, output);
+        break;
     }
   }
 };
@@ -885,10 +917,17 @@ class FusedConv2DOp : public OpKernel {
           {FCT::kBiasAddWithRelu, {"BiasAdd", "Relu"}},
           {FCT::kBiasAddWithRelu6, {"BiasAdd", "Relu6"}},
           {FCT::kBiasAddWithElu, {"BiasAdd", "Elu"}},
+          {FCT::kBiasAddWithLeakyRelu, {"BiasAdd", "LeakyRelu"}},
+          {FCT::kBiasAddWithGeluApproximate, {"BiasAdd", "GeluApproximate"}},
+          {FCT::kBiasAddWithGeluExact, {"BiasAdd", "GeluExact"}},
+          {FCT::kBiasAddWithSwish, {"BiasAdd", "Swish"}},
+          {FCT::kBiasAddWithAdd, {"BiasAdd", "Add"}},
+          {FCT::kBiasAddWithAddAndRelu, {"BiasAdd", "Add", "Relu"}},
           {FCT::kFusedBatchNorm, {"FusedBatchNorm"}},
           {FCT::kFusedBatchNormWithRelu, {"FusedBatchNorm", "Relu"}},
           {FCT::kFusedBatchNormWithRelu6, {"FusedBatchNorm", "Relu6"}},
           {FCT::kFusedBatchNormWithElu, {"FusedBatchNorm", "Elu"}},
+          {FCT::kFusedBatchNormWithLeakyRelu, {"FusedBatchNorm", "LeakyRelu"}},
       };
     }
 
@@ -20,6 +20,7 @@ limitations under the License.
 #include "tensorflow/cc/ops/const_op.h"
 #include "tensorflow/cc/ops/image_ops.h"
 #include "tensorflow/cc/ops/nn_ops.h"
+#include "tensorflow/cc/ops/nn_ops_internal.h"
 #include "tensorflow/cc/ops/standard_ops.h"
 #include "tensorflow/core/common_runtime/kernel_benchmark_testlib.h"
 #include "tensorflow/core/framework/fake_input.h"
@@ -651,6 +652,8 @@ class FusedConv2DOpTest : public OpsTestBase {
       ops::Relu6(root.WithOpName("with_activation"), with_bias);
     } else if (activation_type == "Elu") {
       ops::Elu(root.WithOpName("with_activation"), with_bias);
+    } else if (activation_type == "LeakyRelu") {
+      ops::internal::LeakyRelu(root.WithOpName("with_activation"), with_bias);
     } else {
       ops::Identity(root.WithOpName("with_activation"), with_bias);
     }
@@ -658,6 +661,36 @@ class FusedConv2DOpTest : public OpsTestBase {
     RunAndFetch(root, "with_activation", output, allow_gpu_device);
   }
 
+  void RunConv2DWithBiasAndAdd(const Tensor& input_data,
+                               const Tensor& filter_data,
+                               const Tensor& bias_data,
+                               const Tensor& addend_data, bool with_relu,
+                               Tensor* output) {
+    Scope root = tensorflow::Scope::NewRootScope();
+
+    ops::Conv2D conv = ops::Conv2D(
+        root.WithOpName("conv"),
+        ops::Const(root.WithOpName("input"), Input::Initializer(input_data)),
+        ops::Const(root.WithOpName("filter"), Input::Initializer(filter_data)),
+        {1, 1, 1, 1}, "SAME");
+
+    ops::BiasAdd with_bias = ops::BiasAdd(
+        root.WithOpName("with_bias"), conv,
+        ops::Const(root.WithOpName("bias"), Input::Initializer(bias_data)));
+
+    ops::AddV2 with_add = ops::AddV2(
+        root.WithOpName("with_add"), with_bias,
+        ops::Const(root.WithOpName("addend"), Input::Initializer(addend_data)));
+
+    if (with_relu) {
+      ops::Relu(root.WithOpName("with_activation"), with_add);
+    } else {
+      ops::Identity(root.WithOpName("with_activation"), with_add);
+    }
+
+    RunAndFetch(root, "with_activation", output, /*allow_gpu_device=*/false);
+  }
+
   void RunConv2DWithBatchNorm(
       const Tensor& input_data, const Tensor& filter_data,
       const Tensor& scale_data, const Tensor& offset_data,
@@ -720,6 +753,9 @@ class FusedConv2DOpTest : public OpsTestBase {
       ops::Relu6(root.WithOpName("with_activation"), with_fused_batch_norm.y);
     } else if (activation_type == "Elu") {
       ops::Elu(root.WithOpName("with_activation"), with_fused_batch_norm.y);
+    } else if (activation_type == "LeakyRelu") {
+      ops::internal::LeakyRelu(root.WithOpName("with_activation"),
+                               with_fused_batch_norm.y);
     } else {
       ops::Identity(root.WithOpName("with_activation"),
                     with_fused_batch_norm.y);
@@ -921,6 +957,42 @@ class FusedConv2DOpTest : public OpsTestBase {
                              run_default, run_fused);
   }
 
+  // Verifies that computing Conv2D+BiasAdd+Add+{Relu} in a graph is identical
+  // to FusedConv2D.
+  void VerifyConv2DWithBiasAndAdd(bool with_relu, int filter_size,
+                                  int filter_count) {
+    DataType dtype = DataTypeToEnum<T>::v();
+
+    // Shape of the output of the convolution with "SAME" padding.
+    Tensor addend(dtype,
+                  {kImageBatchCount, kImageHeight, kImageWidth, filter_count});
+    addend.flat<T>() = addend.flat<T>().setRandom();
+    addend.flat<T>() -= addend.flat<T>().constant(static_cast<T>(0.5f));
+
+    std::vector<string> fused_ops = {"BiasAdd", "Add"};
+    if (with_relu) fused_ops.push_back("Relu");
+
+    const BiasAddGraphRunner run_default =
+        [this, &addend, with_relu](const Tensor& input_data,
+                                   const Tensor& filter_data,
+                                   const Tensor& bias_data, Tensor* out) {
+          RunConv2DWithBiasAndAdd(input_data, filter_data, bias_data, addend,
+                                  with_relu, out);
+        };
+
+    const BiasAddGraphRunner run_fused =
+        [this, &addend, &fused_ops](const Tensor& input_data,
+                                    const Tensor& filter_data,
+                                    const Tensor& bias_data, Tensor* out) {
+          RunFusedConv2DOp(input_data, filter_data, {bias_data, addend},
+                           fused_ops, "SAME", {}, out);
+        };
+
+    VerifyBiasAddTensorsNear(kDepth, kImageWidth, kImageHeight,
+                             kImageBatchCount, filter_size, filter_count,
+                             run_default, run_fused);
+  }
+
   // Verifies that computing Conv2D+FusedBatchNorm in a graph is identical to
   // FusedConv2D.
   void VerifyConv2DWithBatchNorm(int filter_size, int filter_count,
@@ -1037,7 +1109,7 @@ TYPED_TEST_P(FusedConv2DWithBiasOpTest, ExplicitPaddingConvolution) {
 TYPED_TEST_P(FusedConv2DWithBiasOpTest, OneByOneConvolutionAndActivation) {
   const int filter_size = 1;
   const int filter_count = 12;
-  for (const string& activation : {"Relu", "Relu6", "Elu"}) {
+  for (const string& activation : {"Relu", "Relu6", "Elu", "LeakyRelu"}) {
     this->VerifyConv2DWithBiasAndActivation(activation, filter_size,
                                             filter_count);
   }
@@ -1046,7 +1118,7 @@ TYPED_TEST_P(FusedConv2DWithBiasOpTest, OneByOneConvolutionAndActivation) {
 TYPED_TEST_P(FusedConv2DWithBiasOpTest, ImageSizeConvolutionAndActivation) {
   const int filter_size = TestFixture::kImageWidth;
   const int filter_count = 12;
-  for (const string& activation : {"Relu", "Relu6", "Elu"}) {
+  for (const string& activation : {"Relu", "Relu6", "Elu", "LeakyRelu"}) {
     this->VerifyConv2DWithBiasAndActivation(activation, filter_size,
                                             filter_count);
   }
@@ -1055,7 +1127,7 @@ TYPED_TEST_P(FusedConv2DWithBiasOpTest, ImageSizeConvolutionAndActivation) {
 TYPED_TEST_P(FusedConv2DWithBiasOpTest, SpatialConvolutionAndActivation) {
   const int filter_size = 3;
   const int filter_count = 12;
-  for (const string& activation : {"Relu", "Relu6", "Elu"}) {
+  for (const string& activation : {"Relu", "Relu6", "Elu", "LeakyRelu"}) {
     this->VerifyConv2DWithBiasAndActivation(activation, filter_size,
                                             filter_count);
   }
@@ -1065,13 +1137,31 @@ TYPED_TEST_P(FusedConv2DWithBiasOpTest,
              ExplicitPaddingConvolutionAndActivation) {
   const int filter_size = 3;
   const int filter_count = 12;
-  for (const string& activation : {"Relu", "Relu6", "Elu"}) {
+  for (const string& activation : {"Relu", "Relu6", "Elu", "LeakyRelu"}) {
     this->VerifyConv2DWithBiasAndActivation(
         activation, filter_size, filter_count,
         /*explicit_paddings=*/{0, 0, 1, 2, 3, 4, 0, 0});
   }
 }
 
+TYPED_TEST_P(FusedConv2DWithBiasOpTest, OneByOneConvolutionAndAdd) {
+  const int filter_size = 1;
+  const int filter_count = 12;
+  this->VerifyConv2DWithBiasAndAdd(/*with_relu=*/false, filter_size,
+                                   filter_count);
+  this->VerifyConv2DWithBiasAndAdd(/*with_relu=*/true, filter_size,
+                                   filter_count);
+}
+
+TYPED_TEST_P(FusedConv2DWithBiasOpTest, SpatialConvolutionAndAdd) {
+  const int filter_size = 3;
+  const int filter_count = 12;
+  this->VerifyConv2DWithBiasAndAdd(/*with_relu=*/false, filter_size,
+                                   filter_count);
+  this->VerifyConv2DWithBiasAndAdd(/*with_relu=*/true, filter_size,
+                                   filter_count);
+}
+
 // -------------------------------------------------------------------------- //
 // Conv2D + FusedBatchNorm + {Activation}                                     //
 // -------------------------------------------------------------------------- //
@@ -1105,7 +1195,7 @@ TYPED_TEST_P(FusedConv2DWithBatchNormOpTest, ExplicitPaddingConvolution) {
 TYPED_TEST_P(FusedConv2DWithBatchNormOpTest, OneByOneConvolutionAndActivation) {
   const int filter_size = 1;
   const int filter_count = 12;
-  for (const string& activation : {"Relu", "Relu6", "Elu"}) {
+  for (const string& activation : {"Relu", "Relu6", "Elu", "LeakyRelu"}) {
     this->VerifyConv2DWithBatchNormAndActivation(activation, filter_size,
                                                  filter_count);
   }
@@ -1115,7 +1205,7 @@ TYPED_TEST_P(FusedConv2DWithBatchNormOpTest,
              ImageSizeConvolutionAndActivation) {
   const int filter_size = TestFixture::kImageWidth;
   const int filter_count = 12;
-  for (const string& activation : {"Relu", "Relu6", "Elu"}) {
+  for (const string& activation : {"Relu", "Relu6", "Elu", "LeakyRelu"}) {
     this->VerifyConv2DWithBatchNormAndActivation(activation, filter_size,
                                                  filter_count);
   }
@@ -1124,7 +1214,7 @@ TYPED_TEST_P(FusedConv2DWithBatchNormOpTest,
 TYPED_TEST_P(FusedConv2DWithBatchNormOpTest, SpatialConvolutionAndActivation) {
   const int filter_size = 3;
   const int filter_count = 12;
-  for (const string& activation : {"Relu", "Relu6", "Elu"}) {
+  for (const string& activation : {"Relu", "Relu6", "Elu", "LeakyRelu"}) {
     this->VerifyConv2DWithBatchNormAndActivation(activation, filter_size,
                                                  filter_count);
   }
@@ -1134,22 +1224,24 @@ TYPED_TEST_P(FusedConv2DWithBatchNormOpTest,
              ExplicitPaddingConvolutionAndActivation) {
   const int filter_size = 3;
   const int filter_count = 12;
-  for (const string& activation : {"Relu", "Relu6", "Elu"}) {
+  for (const string& activation : {"Relu", "Relu6", "Elu", "LeakyRelu"}) {
     this->VerifyConv2DWithBatchNormAndActivation(
         activation, filter_size, filter_count,
         /*explicit_paddings=*/{0, 0, 1, 2, 3, 4, 0, 0});
   }
 }
 
-REGISTER_TYPED_TEST_SUITE_P(FusedConv2DWithBiasOpTest,          //
-                            OneByOneConvolution,                //
-                            ImageSizeConvolution,               //
-                            SpatialConvolution,                 //
-                            ExplicitPaddingConvolution,         //
-                            OneByOneConvolutionAndActivation,   //
-                            ImageSizeConvolutionAndActivation,  //
-                            SpatialConvolutionAndActivation,    //
-                            ExplicitPaddingConvolutionAndActivation);
+REGISTER_TYPED_TEST_SUITE_P(FusedConv2DWithBiasOpTest,                //
+                            OneByOneConvolution,                      //
+                            ImageSizeConvolution,                     //
+                            SpatialConvolution,                       //
+                            ExplicitPaddingConvolution,               //
+                            OneByOneConvolutionAndActivation,         //
+                            ImageSizeConvolutionAndActivation,        //
+                            SpatialConvolutionAndActivation,          //
+                            ExplicitPaddingConvolutionAndActivation,  //
+                            OneByOneConvolutionAndAdd,                //
+                            SpatialConvolutionAndAdd);
 
 REGISTER_TYPED_TEST_SUITE_P(FusedConv2DWithBatchNormOpTest,     //
                             OneByOneConvolution,                //
@@ -21,6 +21,7 @@ limitations under the License.
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/strings/numbers.h"
+#include "tensorflow/core/util/string_arena.h"
 
 namespace tensorflow {
 
@@ -81,9 +82,12 @@ class DecodeCSVOp : public OpKernel {
       OP_REQUIRES_OK(ctx, output.allocate(i, records->shape(), &out));
     }
 
+    // Fields of the current record. The arena is reused across records, so
+    // parsing does not allocate per field.
+    StringArena fields;
     for (int64 i = 0; i < records_size; ++i) {
       const StringPiece record(records_t(i));
-      std::vector<string> fields;
+      fields.Clear();
       ExtractFields(ctx, record, &fields);
       OP_REQUIRES(ctx, fields.size() == out_type_.size(),
                   errors::InvalidArgument("Expect ", out_type_.size(),
@@ -184,7 +188,7 @@ class DecodeCSVOp : public OpKernel {
               output[f]->flat<tstring>()(i) =
                   record_defaults[f].flat<tstring>()(0);
             } else {
-              output[f]->flat<tstring>()(i) = std::move(fields[f]);
+              fields.CopyTo(f, &output[f]->flat<tstring>()(i));
             }
             break;
           }
@@ -206,7 +210,7 @@ class DecodeCSVOp : public OpKernel {
   string na_value_;
 
   void ExtractFields(OpKernelContext* ctx, StringPiece input,
-                     std::vector<string>* result) {
+                     StringArena* result) {
     int64 current_idx = 0;
     int64 num_fields_parsed = 0;
     int64 selector_idx = 0;  // Keep track of index into select_cols
@@ -228,8 +232,7 @@ class DecodeCSVOp : public OpKernel {
           current_idx++;
         }
 
-        // This is the body of the field;
-        string field;
+        // This is the body of the field, appended to `result` in place.
         if (!quoted) {
           while (static_cast<size_t>(current_idx) < input.size() &&
                  input[current_idx] != delim_) {
@@ -239,7 +242,7 @@ class DecodeCSVOp : public OpKernel {
                             input[current_idx] != '\r',
                         errors::InvalidArgument(
                             "Unquoted fields cannot have quotes/CRLFs inside"));
-            if (include) field += input[current_idx];
+            if (include) result->Append(input[current_idx]);
             current_idx++;
           }
 
@@ -251,14 +254,14 @@ class DecodeCSVOp : public OpKernel {
               (static_cast<size_t>(current_idx) < input.size() - 1) &&
               (input[current_idx] != '"' || input[current_idx + 1] != delim_)) {
             if (input[current_idx] != '"') {
-              if (include) field += input[current_idx];
+              if (include) result->Append(input[current_idx]);
               current_idx++;
             } else {
               OP_REQUIRES(
                   ctx, input[current_idx + 1] == '"',
                   errors::InvalidArgument("Quote inside a string has to be "
                                           "escaped by another quote"));
-              if (include) field += '"';
+              if (include) result->Append('"');
               current_idx += 2;
             }
           }
@@ -277,7 +280,7 @@ class DecodeCSVOp : public OpKernel {
 
         num_fields_parsed++;
         if (include) {
-          result->push_back(field);
+          result->FinishString();
           selector_idx++;
           if (selector_idx == select_cols_.size()) return;
         }
@@ -288,7 +291,7 @@ class DecodeCSVOp : public OpKernel {
                                    static_cast<size_t>(num_fields_parsed));
       // Check if the last field is missing
       if (include && input[input.size() - 1] == delim_)
-        result->push_back(string());
+        result->FinishString();
     }
   }
 };
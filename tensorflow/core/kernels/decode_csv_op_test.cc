@@ -0,0 +1,109 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <vector>
+
+#include "tensorflow/core/common_runtime/kernel_benchmark_testlib.h"
+#include "tensorflow/core/framework/fake_input.h"
+#include "tensorflow/core/framework/node_def_builder.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/graph/node_builder.h"
+#include "tensorflow/core/graph/testlib.h"
+#include "tensorflow/core/kernels/ops_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+
+namespace tensorflow {
+namespace {
+
+class DecodeCSVOpTest : public OpsTestBase {};
+
+TEST_F(DecodeCSVOpTest, MixedTypes) {
+  TF_ASSERT_OK(NodeDefBuilder("decode_csv", "DecodeCSV")
+                   .Input(FakeInput(DT_STRING))
+                   .Input(FakeInput({DT_INT32, DT_FLOAT, DT_STRING}))
+                   .Finalize(node_def()));
+  TF_ASSERT_OK(InitOp());
+  AddInputFromArray<tstring>(TensorShape({3}),
+                             {"1,2.5,abc", "-7,,\"x,\"\"y\"\"\"", "3,0.25,"});
+  AddInputFromArray<int32>(TensorShape({1}), {0});
+  AddInputFromArray<float>(TensorShape({1}), {-1.0f});
+  AddInputFromArray<tstring>(TensorShape({1}), {"default"});
+  TF_ASSERT_OK(RunOpKernel());
+
+  test::ExpectTensorEqual<int32>(
+      *GetOutput(0), test::AsTensor<int32>({1, -7, 3}, TensorShape({3})));
+  test::ExpectTensorEqual<float>(
+      *GetOutput(1),
+      test::AsTensor<float>({2.5f, -1.0f, 0.25f}, TensorShape({3})));
+  test::ExpectTensorEqual<tstring>(
+      *GetOutput(2), test::AsTensor<tstring>({"abc", "x,\"y\"", "default"},
+                                             TensorShape({3})));
+}
+
+// A batch of `num_records` records, each with `num_numeric` int64 fields
+// followed by `num_string` string fields.
+static Graph* DecodeCSVGraph(int num_records, int num_numeric,
+                             int num_string) {
+  Graph* g = new Graph(OpRegistry::Global());
+  Tensor records(DT_STRING, TensorShape({num_records}));
+  auto records_t = records.flat<tstring>();
+  for (int r = 0; r < num_records; ++r) {
+    string record;
+    for (int f = 0; f < num_numeric + num_string; ++f) {
+      if (f > 0) strings::StrAppend(&record, ",");
+      if (f < num_numeric) {
+        strings::StrAppend(&record, r * 31 + f * 7);
+      } else {
+        strings::StrAppend(&record, "category_", (r * f) % 97);
+      }
+    }
+    records_t(r) = record;
+  }
+  std::vector<NodeBuilder::NodeOut> defaults;
+  for (int f = 0; f < num_numeric + num_string; ++f) {
+    Tensor value(f < num_numeric ? DT_INT64 : DT_STRING, TensorShape({1}));
+    if (f < num_numeric) {
+      value.flat<int64>()(0) = 0;
+    } else {
+      value.flat<tstring>()(0) = "";
+    }
+    defaults.emplace_back(test::graph::Constant(g, value));
+  }
+  Node* node;
+  TF_CHECK_OK(NodeBuilder(g->NewName("n"), "DecodeCSV")
+                  .Input(test::graph::Constant(g, records))
+                  .Input(defaults)
+                  .Finalize(g, &node));
+  return g;
+}
+
+#define BM_DecodeCSV(RECORDS, NUMERIC, STRING)                             \
+  static void BM_DecodeCSV_##RECORDS##_##NUMERIC##_##STRING(int iters) {   \
+    testing::ItemsProcessed(static_cast<int64>(iters) * RECORDS);          \
+    test::Benchmark("cpu", DecodeCSVGraph(RECORDS, NUMERIC, STRING))       \
+        .Run(iters);                                                       \
+  }                                                                        \
+  BENCHMARK(BM_DecodeCSV_##RECORDS##_##NUMERIC##_##STRING);
+
+BM_DecodeCSV(1024, 8, 2);
+BM_DecodeCSV(1024, 32, 0);
+BM_DecodeCSV(1024, 0, 16);
+
+}  // namespace
+}  // namespace tensorflow
@@ -60,7 +60,11 @@ Status InitializeFusedComputation(
   if (*fused_computation == FusedComputationType::kBiasAdd ||
       *fused_computation == FusedComputationType::kBiasAddWithRelu ||
       *fused_computation == FusedComputationType::kBiasAddWithRelu6 ||
-      *fused_computation == FusedComputationType::kBiasAddWithElu) {
+      *fused_computation == FusedComputationType::kBiasAddWithElu ||
+      *fused_computation == FusedComputationType::kBiasAddWithLeakyRelu ||
+      *fused_computation == FusedComputationType::kBiasAddWithGeluApproximate ||
+      *fused_computation == FusedComputationType::kBiasAddWithGeluExact ||
+      *fused_computation == FusedComputationType::kBiasAddWithSwish) {
     if (num_args != 1) {
       return errors::InvalidArgument(
           "Fused ", kernel_name,
@@ -68,10 +72,21 @@ Status InitializeFusedComputation(
     }
   }
 
+  if (*fused_computation == FusedComputationType::kBiasAddWithAdd ||
+      *fused_computation == FusedComputationType::kBiasAddWithAddAndRelu) {
+    if (num_args != 2) {
+      return errors::InvalidArgument(
+          "Fused ", kernel_name,
+          " with BiasAdd and Add must have two extra arguments: bias, add.");
+    }
+  }
+
   if (*fused_computation == FusedComputationType::kFusedBatchNorm ||
       *fused_computation == FusedComputationType::kFusedBatchNormWithRelu ||
       *fused_computation == FusedComputationType::kFusedBatchNormWithRelu6 ||
-      *fused_computation == FusedComputationType::kFusedBatchNormWithElu) {
+      *fused_computation == FusedComputationType::kFusedBatchNormWithElu ||
+      *fused_computation ==
+          FusedComputationType::kFusedBatchNormWithLeakyRelu) {
     if (num_args != 4) {
       return errors::InvalidArgument(
           "Fused ", kernel_name,
@@ -82,6 +97,13 @@ Status InitializeFusedComputation(
         context->GetAttr("epsilon", &fused_computation_args->epsilon));
   }
 
+  if (*fused_computation == FusedComputationType::kBiasAddWithLeakyRelu ||
+      *fused_computation ==
+          FusedComputationType::kFusedBatchNormWithLeakyRelu) {
+    TF_RETURN_IF_ERROR(context->GetAttr(
+        "leakyrelu_alpha", &fused_computation_args->leakyrelu_alpha));
+  }
+
   return Status::OK();
 }
 
@@ -19,9 +19,10 @@ limitations under the License.
 //
 // Supported fused computations:
 //   (1) {Conv2D/MatMul} + BiasAdd + <Activation>
-//   (2) {Conv2D/MatMul} + FusedBatchNorm + <Activation>
+//   (2) {Conv2D/MatMul} + BiasAdd + Add + <Activation>
+//   (3) {Conv2D/MatMul} + FusedBatchNorm + <Activation>
 //
-// Activation: Relu, Relu6, Elu, etc...
+// Activation: Relu, Relu6, Elu, LeakyRelu, GeLU, Swish, etc...
 
 #ifndef TENSORFLOW_CORE_KERNELS_FUSED_EIGEN_OUTPUT_KERNELS_H_
 #define TENSORFLOW_CORE_KERNELS_FUSED_EIGEN_OUTPUT_KERNELS_H_
@@ -39,15 +40,23 @@ enum class FusedComputationType {
   kBiasAddWithRelu,
   kBiasAddWithRelu6,
   kBiasAddWithElu,
+  kBiasAddWithLeakyRelu,
+  kBiasAddWithGeluApproximate,
+  kBiasAddWithGeluExact,
+  kBiasAddWithSwish,
+  kBiasAddWithAdd,
+  kBiasAddWithAddAndRelu,
   kFusedBatchNorm,
   kFusedBatchNormWithRelu,
   kFusedBatchNormWithRelu6,
-  kFusedBatchNormWithElu
+  kFusedBatchNormWithElu,
+  kFusedBatchNormWithLeakyRelu
 };
 
 // We have to pass around additional arguments for all possible fusion types.
 struct FusedComputationArgs {
-  float epsilon = 0.0;  // Used by `FusedBatchNorm` fusion only
+  float epsilon = 0.0;          // Used by `FusedBatchNorm` fusion only
+  float leakyrelu_alpha = 0.2;  // Used by `LeakyRelu` fusion only
 };
 
 struct FusedComputationPattern {
@@ -111,15 +120,77 @@ struct Elu {
   };
 };
 
+// Applies `LeakyRelu` to the passed input expression. Unlike the other
+// activations it has a parameter, so output kernels apply it through an
+// instance.
+struct LeakyRelu {
+  explicit LeakyRelu(float alpha = 0.2) : alpha(alpha) {}
+
+  template <typename XprType>
+  auto apply(XprType expr) const -> decltype(
+      (expr < std::declval<typename XprType::Scalar>())
+          .select(expr * std::declval<typename XprType::Scalar>(), expr)) {
+    return (expr < static_cast<typename XprType::Scalar>(0))
+        .select(expr * static_cast<typename XprType::Scalar>(alpha), expr);
+  };
+
+  float alpha;
+};
+
+// Applies the tanh approximation of `GeLU` to the passed input expression:
+//   0.5 * x * (1 + tanh(sqrt(2 / pi) * (x + 0.044715 * x^3)))
+struct GeluApproximate {
+  template <typename XprType>
+  static auto apply(XprType expr) {
+    using Scalar = typename XprType::Scalar;
+    const Scalar kSqrtTwoOverPi = static_cast<Scalar>(0.7978845608028654);
+    const Scalar kCoefficient = static_cast<Scalar>(0.044715);
+    const auto inner = (expr + expr.cube() * kCoefficient) * kSqrtTwoOverPi;
+    return expr * static_cast<Scalar>(0.5) *
+           (inner.tanh() + static_cast<Scalar>(1));
+  };
+};
+
+// Applies the exact `GeLU` to the passed input expression:
+//   0.5 * x * (1 + erf(x / sqrt(2)))
+struct GeluExact {
+  template <typename XprType>
+  static auto apply(XprType expr) {
+    using Scalar = typename XprType::Scalar;
+    const Scalar kSqrtHalf = static_cast<Scalar>(0.7071067811865476);
+    return expr * static_cast<Scalar>(0.5) *
+           ((expr * kSqrtHalf).erf() + static_cast<Scalar>(1));
+  };
+};
+
+// Applies `Swish` (x * sigmoid(x)) to the passed input expression.
+struct Swish {
+  template <typename XprType>
+  static auto apply(XprType expr) -> decltype(expr * expr.sigmoid()) {
+    return expr * expr.sigmoid();
+  };
+};
+
 template <typename T>
 struct BiasAddArgs {
   const T* bias_add_data = nullptr;
+  // The size of the bias, which is the innermost dimension of the output.
+  int64 bias_add_size = 0;
+  // Tensor with the shape of the output that is added after the bias (e.g. a
+  // residual connection). Used by `BiasAdd + Add` fusions only.
+  const T* add_data = nullptr;
 
   static bool IsSupported(FusedComputationType fusion) {
     return fusion == FusedComputationType::kBiasAdd ||
            fusion == FusedComputationType::kBiasAddWithRelu ||
            fusion == FusedComputationType::kBiasAddWithRelu6 ||
-           fusion == FusedComputationType::kBiasAddWithElu;
+           fusion == FusedComputationType::kBiasAddWithElu ||
+           fusion == FusedComputationType::kBiasAddWithLeakyRelu ||
+           fusion == FusedComputationType::kBiasAddWithGeluApproximate ||
+           fusion == FusedComputationType::kBiasAddWithGeluExact ||
+           fusion == FusedComputationType::kBiasAddWithSwish ||
+           fusion == FusedComputationType::kBiasAddWithAdd ||
+           fusion == FusedComputationType::kBiasAddWithAddAndRelu;
   }
 };
 
@@ -138,7 +209,8 @@ struct FusedBatchNormArgs {
     return fusion == FusedComputationType::kFusedBatchNorm ||
            fusion == FusedComputationType::kFusedBatchNormWithRelu ||
            fusion == FusedComputationType::kFusedBatchNormWithRelu6 ||
-           fusion == FusedComputationType::kFusedBatchNormWithElu;
+           fusion == FusedComputationType::kFusedBatchNormWithElu ||
+           fusion == FusedComputationType::kFusedBatchNormWithLeakyRelu;
   }
 };
 
@@ -173,13 +245,18 @@ struct FusedBatchNormArgs {
 //   Example: In Tensorflow MatMul [8x32] * [32x64], each output block column
 //   will correspond to MatMul output row of size 64 (because Tensorflow uses
 //   row major storage order).
+//
+// In both cases column 'j' of the output matrix is stored at offset
+// 'j * output_channels' of the output tensor, which lets output kernels read
+// other tensors with the output shape (e.g. a residual connection).
 
 // Output kernel that fuses BiasAdd operation into the output of tensor
 // contraction + activation function defined by Activation.
 template <typename T, typename Activation = Identity>
 struct BiasAddOutputKernel {
-  explicit BiasAddOutputKernel(const BiasAddArgs<T>& args)
-      : bias_data(args.bias_add_data) {}
+  explicit BiasAddOutputKernel(const BiasAddArgs<T>& args,
+                               Activation activation = Activation())
+      : bias_data(args.bias_add_data), activation(activation) {}
 
   template <typename StorageIndex, typename Scalar>
   EIGEN_ALWAYS_INLINE void operator()(
@@ -195,23 +272,64 @@ struct BiasAddOutputKernel {
       T* output_base = &output_mapper(0, col);
       typename TTypes<T>::UnalignedTensor output(output_base, num_rows);
       const auto expr = output + bias;
-      output = Activation::template apply<decltype(expr)>(expr);
+      output = activation.template apply<decltype(expr)>(expr);
     }
   }
 
  private:
   const T* bias_data;
+  Activation activation;
+};
+
+// Output kernel that fuses BiasAdd and Add operations into the output of
+// tensor contraction + activation function defined by Activation.
+template <typename T, typename Activation = Identity>
+struct BiasAddWithAddOutputKernel {
+  explicit BiasAddWithAddOutputKernel(const BiasAddArgs<T>& args,
+                                      Activation activation = Activation())
+      : bias_data(args.bias_add_data),
+        add_data(args.add_data),
+        row_size(args.bias_add_size),
+        activation(activation) {}
+
+  template <typename StorageIndex, typename Scalar>
+  EIGEN_ALWAYS_INLINE void operator()(
+      const ContractionOutputMapper<Scalar, StorageIndex>& output_mapper,
+      const Eigen::TensorContractionParams& params, StorageIndex i,
+      StorageIndex j, StorageIndex num_rows, StorageIndex num_cols) const {
+    DCHECK(params.swapped_arguments);
+
+    const T* bias_base = bias_data + i;
+    typename TTypes<T>::UnalignedConstTensor bias(bias_base, num_rows);
+
+    for (int col = 0; col < num_cols; ++col) {
+      T* output_base = &output_mapper(0, col);
+      typename TTypes<T>::UnalignedTensor output(output_base, num_rows);
+      const T* add_base = add_data + (j + col) * row_size + i;
+      typename TTypes<T>::UnalignedConstTensor add(add_base, num_rows);
+      const auto expr = output + bias + add;
+      output = activation.template apply<decltype(expr)>(expr);
+    }
+  }
+
+ private:
+  const T* bias_data;
+  const T* add_data;
+  int64 row_size;
+  Activation activation;
 };
 
 // Output kernel that fuses FusedBatchNorm operation into the output of tensor
 // contraction + activation function defined by Activation.
 template <typename T, typename Activation = Identity>
 struct FusedBatchNormOutputKernel {
-  FusedBatchNormOutputKernel(T epsilon, const FusedBatchNormArgs<T>& args)
+  FusedBatchNormOutputKernel(T epsilon, const FusedBatchNormArgs<T>& args,
+                             Activation activation = Activation())
       : epsilon(epsilon),
         scaling_factor_data(args.scaling_factor.data()),
         offset_data(args.offset_data),
-        estimated_mean_data(args.estimated_mean_data) {}
+        estimated_mean_data(args.estimated_mean_data),
+        activation(activation) {}
 
   template <typename StorageIndex, typename Scalar>
   EIGEN_ALWAYS_INLINE void operator()(
@@ -236,7 +354,7 @@ struct FusedBatchNormOutputKernel {
       auto scaled = (output - mean) * scaling_factor;
       auto shifted = scaled + offset;
 
-      output = Activation::template apply<decltype(shifted)>(shifted);
+      output = activation.template apply<decltype(shifted)>(shifted);
     }
   }
 
@@ -245,6 +363,7 @@ struct FusedBatchNormOutputKernel {
   const T* scaling_factor_data;
   const T* offset_data;
   const T* estimated_mean_data;
+  Activation activation;
 };
 
 // Type aliases for the output kernels, purely for the sake of better launch
@@ -258,6 +377,18 @@ using WithBiasAddAndRelu6 = BiasAddOutputKernel<T, Relu6>;
 template <typename T>
 using WithBiasAddAndElu = BiasAddOutputKernel<T, Elu>;
 template <typename T>
+using WithBiasAddAndLeakyRelu = BiasAddOutputKernel<T, LeakyRelu>;
+template <typename T>
+using WithBiasAddAndGeluApproximate = BiasAddOutputKernel<T, GeluApproximate>;
+template <typename T>
+using WithBiasAddAndGeluExact = BiasAddOutputKernel<T, GeluExact>;
+template <typename T>
+using WithBiasAddAndSwish = BiasAddOutputKernel<T, Swish>;
+template <typename T>
+using WithBiasAddAndAdd = BiasAddWithAddOutputKernel<T>;
+template <typename T>
+using WithBiasAddAndAddAndRelu = BiasAddWithAddOutputKernel<T, Relu>;
+template <typename T>
 using WithFusedBatchNorm = FusedBatchNormOutputKernel<T>;
 template <typename T>
 using WithFusedBatchNormAndRelu = FusedBatchNormOutputKernel<T, Relu>;
@@ -265,21 +396,42 @@ template <typename T>
 using WithFusedBatchNormAndRelu6 = FusedBatchNormOutputKernel<T, Relu6>;
 template <typename T>
 using WithFusedBatchNormAndElu = FusedBatchNormOutputKernel<T, Elu>;
+template <typename T>
+using WithFusedBatchNormAndLeakyRelu = FusedBatchNormOutputKernel<T, LeakyRelu>;
 
+// Initializes the arguments of a BiasAdd fusion of the op with output
+// `output`. The tensor to add after the bias, if any, is the extra argument
+// that follows the bias.
 template <typename T>
-Status InitBiasAddArgs(OpKernelContext* context, BiasAddArgs<T>* args) {
+Status InitBiasAddArgs(OpKernelContext* context, const Tensor& output,
+                       BiasAddArgs<T>* args) {
   // Bias of the following dimensions: [ output_depth ]
   const Tensor& bias = context->input(2);
 
   if (bias.dims() != 1)
     return errors::InvalidArgument("bias must be 1-dimensional",
                                    bias.shape().DebugString());
+  if (output.dims() == 0 ||
+      bias.dim_size(0) != output.dim_size(output.dims() - 1))
+    return errors::InvalidArgument(
+        "bias size must match the innermost output dimension: ",
+        bias.shape().DebugString(), " vs. ", output.shape().DebugString());
 
   const auto data_ptr = [](const Tensor& tensor) -> const T* {
     return reinterpret_cast<const T*>(tensor.tensor_data().data());
   };
 
   args->bias_add_data = data_ptr(bias);
+  args->bias_add_size = bias.dim_size(0);
+
+  if (context->num_inputs() > 3) {
+    const Tensor& add = context->input(3);
+    if (add.shape() != output.shape())
+      return errors::InvalidArgument(
+          "tensor to add must have the output shape: ",
+          add.shape().DebugString(), " vs. ", output.shape().DebugString());
+    args->add_data = data_ptr(add);
+  }
 
   return Status::OK();
 }
@@ -25,6 +25,7 @@ limitations under the License.
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/register_types.h"
 #include "tensorflow/core/kernels/fill_functor.h"
+#include "tensorflow/core/kernels/packed_matmul.h"
 #include "tensorflow/core/util/matmul_autotune.h"
 #if GOOGLE_CUDA
 #include "third_party/gpus/cuda/include/cuda.h"
@@ -456,6 +457,9 @@ class MatMulOp : public OpKernel {
     LaunchMatMul<Device, T, USE_CUBLAS>::GetBlasGemmAlgorithm(
         ctx, &algorithms_, &algorithms_set_already_);
     use_autotune_ = MatmulAutotuneEnable();
+    if (ShouldPackConstantWeights(ctx)) {
+      packed_weights_.reset(new PackedMatMulWeightsCache());
+    }
   }
 
   void Compute(OpKernelContext* ctx) override {
@@ -502,6 +506,17 @@ class MatMulOp : public OpKernel {
       return;
     }
 
+    // Small batches multiply with the packed layout of constant weights that
+    // is cached by the kernel, instead of packing them on every call. Only
+    // float weights on CPU are packed (see ShouldPackConstantWeights).
+    if (packed_weights_ != nullptr && !transpose_a_ &&
+        a.dim_size(0) <= PackedMatMulWeights::kMaxRows) {
+      packed_weights_->Get(b, transpose_b_)
+          ->Multiply(ctx->eigen_device<CPUDevice>(), a.flat<float>().data(),
+                     a.dim_size(0), out->flat<float>().data());
+      return;
+    }
+
     if (std::is_same<T, bfloat16>::value) {
       bool is_cpu = std::is_same<Device, CPUDevice>::value;
       OP_REQUIRES(ctx, is_cpu,
@@ -535,6 +550,8 @@ class MatMulOp : public OpKernel {
   bool use_autotune_;
   bool transpose_a_;
   bool transpose_b_;
+  // Set if the weights are a constant that should be packed.
+  std::unique_ptr<PackedMatMulWeightsCache> packed_weights_;
 };
 
 namespace functor {
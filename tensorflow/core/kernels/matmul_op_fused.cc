@@ -72,7 +72,8 @@ struct LaunchFusedMatMulOp<CPUDevice, T> {
 
     BiasAddArgs<T> bias_add_args;
     if (BiasAddArgs<T>::IsSupported(fusion)) {
-      OP_REQUIRES_OK(context, InitBiasAddArgs(context, &bias_add_args));
+      OP_REQUIRES_OK(context,
+                     InitBiasAddArgs(context, *output, &bias_add_args));
     }
 
     switch (fusion) {
@@ -92,6 +93,32 @@ struct LaunchFusedMatMulOp<CPUDevice, T> {
         out.device(d) =
             lhs.contract(rhs, dim_pair, WithBiasAddAndElu<T>(bias_add_args));
         break;
+      case FusedComputationType::kBiasAddWithLeakyRelu:
+        out.device(d) = lhs.contract(
+            rhs, dim_pair,
+            WithBiasAddAndLeakyRelu<T>(bias_add_args,
+                                       LeakyRelu(fusion_args.leakyrelu_alpha)));
+        break;
+      case FusedComputationType::kBiasAddWithGeluApproximate:
+        out.device(d) = lhs.contract(
+            rhs, dim_pair, WithBiasAddAndGeluApproximate<T>(bias_add_args));
+        break;
+      case FusedComputationType::kBiasAddWithGeluExact:
+        out.device(d) = lhs.contract(rhs, dim_pair,
+                                     WithBiasAddAndGeluExact<T>(bias_add_args));
+        break;
+      case FusedComputationType::kBiasAddWithSwish:
+        out.device(d) =
+            lhs.contract(rhs, dim_pair, WithBiasAddAndSwish<T>(bias_add_args));
+        break;
+      case FusedComputationType::kBiasAddWithAdd:
+        out.device(d) =
+            lhs.contract(rhs, dim_pair, WithBiasAddAndAdd<T>(bias_add_args));
+        break;
+      case FusedComputationType::kBiasAddWithAddAndRelu:
+        out.device(d) = lhs.contract(
+            rhs, dim_pair, WithBiasAddAndAddAndRelu<T>(bias_add_args));
+        break;
       case FusedComputationType::kUndefined:
         OP_REQUIRES_OK(context, errors::Internal("Fusion type is undefined"));
         break;
@@ -116,7 +143,14 @@ class FusedMatMulOp : public OpKernel {
       patterns = {{FCT::kBiasAdd, {"BiasAdd"}},
                   {FCT::kBiasAddWithRelu, {"BiasAdd", "Relu"}},
                   {FCT::kBiasAddWithRelu6, {"BiasAdd", "Relu6"}},
-                  {FCT::kBiasAddWithElu, {"BiasAdd", "Elu"}}};
+                  {FCT::kBiasAddWithElu, {"BiasAdd", "Elu"}},
+                  {FCT::kBiasAddWithLeakyRelu, {"BiasAdd", "LeakyRelu"}},
+                  {FCT::kBiasAddWithGeluApproximate,
+                   {"BiasAdd", "GeluApproximate"}},
+                  {FCT::kBiasAddWithGeluExact, {"BiasAdd", "GeluExact"}},
+                  {FCT::kBiasAddWithSwish, {"BiasAdd", "Swish"}},
+                  {FCT::kBiasAddWithAdd, {"BiasAdd", "Add"}},
+                  {FCT::kBiasAddWithAddAndRelu, {"BiasAdd", "Add", "Relu"}}};
     }
 
     OP_REQUIRES_OK(context, InitializeFusedComputation(
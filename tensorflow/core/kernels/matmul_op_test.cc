@@ -14,6 +14,7 @@ limitations under the License.
 ==============================================================================*/
 
 #include "absl/algorithm/container.h"
+#include "tensorflow/cc/ops/nn_ops_internal.h"
 #include "tensorflow/cc/ops/standard_ops.h"
 #include "tensorflow/core/common_runtime/kernel_benchmark_testlib.h"
 #include "tensorflow/core/framework/tensor.h"
@@ -135,6 +136,39 @@ class FusedMatMulOpTest : public OpsTestBase {
       ops::Relu6(root.WithOpName("with_activation"), with_bias);
     } else if (activation_type == "Elu") {
       ops::Elu(root.WithOpName("with_activation"), with_bias);
+    } else if (activation_type == "LeakyRelu") {
+      ops::internal::LeakyRelu(root.WithOpName("with_activation"), with_bias);
+    } else if (activation_type == "Swish") {
+      ops::Mul(root.WithOpName("with_activation"), with_bias,
+               ops::Sigmoid(root.WithOpName("sigmoid"), with_bias));
+    } else if (activation_type == "GeluExact" ||
+               activation_type == "GeluApproximate") {
+      // 0.5 * x * (1 + erf(x / sqrt(2))), or
+      // 0.5 * x * (1 + tanh(sqrt(2 / pi) * (x + 0.044715 * x^3)))
+      Output function;
+      if (activation_type == "GeluExact") {
+        function = ops::Erf(
+            root.WithOpName("erf"),
+            ops::RealDiv(root.WithOpName("div"), with_bias,
+                         ops::Const(root, static_cast<T>(M_SQRT2))));
+      } else {
+        Output cube = ops::Pow(root.WithOpName("pow"), with_bias,
+                               ops::Const(root, static_cast<T>(3)));
+        Output sum = ops::AddV2(
+            root.WithOpName("sum"), with_bias,
+            ops::Mul(root.WithOpName("scaled_cube"),
+                     ops::Const(root, static_cast<T>(0.044715)), cube));
+        function = ops::Tanh(
+            root.WithOpName("tanh"),
+            ops::Mul(root.WithOpName("scaled_sum"),
+                     ops::Const(root, static_cast<T>(0.7978845608028654)),
+                     sum));
+      }
+      ops::Mul(root.WithOpName("with_activation"),
+               ops::Mul(root.WithOpName("half_x"),
+                        ops::Const(root, static_cast<T>(0.5)), with_bias),
+               ops::AddV2(root.WithOpName("one_plus"),
+                          ops::Const(root, static_cast<T>(1)), function));
     } else {
       ops::Identity(root.WithOpName("with_activation"), with_bias);
     }
@@ -142,6 +176,34 @@ class FusedMatMulOpTest : public OpsTestBase {
     RunAndFetch(root, "with_activation", output, allow_gpu_device);
   }
 
+  void RunMatMulWithBiasAndAdd(const Tensor& lhs_data, const Tensor& rhs_data,
+                               const Tensor& bias_data,
+                               const Tensor& addend_data, bool with_relu,
+                               Tensor* output) {
+    Scope root = tensorflow::Scope::NewRootScope();
+
+    ops::MatMul matmul = ops::MatMul(
+        root.WithOpName("matmul"),
+        ops::Const(root.WithOpName("lhs"), Input::Initializer(lhs_data)),
+        ops::Const(root.WithOpName("rhs"), Input::Initializer(rhs_data)));
+
+    ops::BiasAdd with_bias = ops::BiasAdd(
+        root.WithOpName("with_bias"), matmul,
+        ops::Const(root.WithOpName("bias"), Input::Initializer(bias_data)));
+
+    ops::AddV2 with_add = ops::AddV2(
+        root.WithOpName("with_add"), with_bias,
+        ops::Const(root.WithOpName("addend"), Input::Initializer(addend_data)));
+
+    if (with_relu) {
+      ops::Relu(root.WithOpName("with_activation"), with_add);
+    } else {
+      ops::Identity(root.WithOpName("with_activation"), with_add);
+    }
+
+    RunAndFetch(root, "with_activation", output, /*allow_gpu_device=*/false);
+  }
+
   void RunFusedMatMulOp(const Tensor& lhs_data, const Tensor& rhs_data,
                         const std::vector<Tensor>& args_data,
                         const std::vector<string>& fused_ops, bool transpose_a,
@@ -255,8 +317,42 @@ class FusedMatMulOpTest : public OpsTestBase {
 
     VerifyBiasAddTensorsNear(m, k, n, run_default, run_fused);
   }
+
+  // Verifies that computing MatMul+BiasAdd+Add+{Relu} in a graph is identical
+  // to FusedMatMul.
+  void VerifyMatMulWithBiasAndAdd(int m, int k, int n, bool with_relu) {
+    DataType dtype = DataTypeToEnum<T>::v();
+
+    Tensor addend(dtype, {m, n});
+    addend.flat<T>() = addend.flat<T>().setRandom();
+    addend.flat<T>() -= addend.flat<T>().constant(static_cast<T>(0.5f));
+
+    std::vector<string> fused_ops = {"BiasAdd", "Add"};
+    if (with_relu) fused_ops.push_back("Relu");
+
+    const BiasAddGraphRunner run_default =
+        [&](const Tensor& input_data, const Tensor& filter_data,
+            const Tensor& bias_data, Tensor* out) {
+          RunMatMulWithBiasAndAdd(input_data, filter_data, bias_data, addend,
+                                  with_relu, out);
+        };
+
+    const BiasAddGraphRunner run_fused =
+        [&](const Tensor& input_data, const Tensor& filter_data,
+            const Tensor& bias_data, Tensor* out) {
+          RunFusedMatMulOp(input_data, filter_data, {bias_data, addend},
+                           fused_ops, false, false, out);
+        };
+
+    VerifyBiasAddTensorsNear(m, k, n, run_default, run_fused);
+  }
 };
 
+// Activations that can be fused into MatMul+BiasAdd.
+static const char* const kActivations[] = {
+    "Relu", "Relu6", "Elu", "LeakyRelu", "GeluApproximate", "GeluExact",
+    "Swish"};
+
 // MatMul with BatchNorm can be tested only with `T=float`, because default
 // `FusedBatchNorm` kernel supports only floats for scale, mean and variance.
 
@@ -289,7 +385,7 @@ TYPED_TEST_P(FusedMatMulWithBiasOpTest, MatMul1x256x1) {
 }
 
 TYPED_TEST_P(FusedMatMulWithBiasOpTest, MatMul256x256x256WithActivation) {
-  for (const string& activation : {"Relu", "Relu6", "Elu"}) {
+  for (const string& activation : kActivations) {
     this->VerifyConv2DWithBiasAndActivation(256, 256, 256, false, false,
                                             activation);
     this->VerifyConv2DWithBiasAndActivation(256, 256, 256, true, false,
@@ -302,26 +398,36 @@ TYPED_TEST_P(FusedMatMulWithBiasOpTest, MatMul256x256x256WithActivation) {
 }
 
 TYPED_TEST_P(FusedMatMulWithBiasOpTest, MatMul1x256x256WithActivation) {
-  for (const string& activation : {"Relu", "Relu6", "Elu"}) {
+  for (const string& activation : kActivations) {
     this->VerifyConv2DWithBiasAndActivation(1, 256, 256, false, false,
                                             activation);
   }
 }
 
 TYPED_TEST_P(FusedMatMulWithBiasOpTest, MatMul256x256x1WithActivation) {
-  for (const string& activation : {"Relu", "Relu6", "Elu"}) {
+  for (const string& activation : kActivations) {
     this->VerifyConv2DWithBiasAndActivation(256, 256, 1, false, false,
                                             activation);
   }
 }
 
 TYPED_TEST_P(FusedMatMulWithBiasOpTest, MatMul1x256x1WithActivation) {
-  for (const string& activation : {"Relu", "Relu6", "Elu"}) {
+  for (const string& activation : kActivations) {
     this->VerifyConv2DWithBiasAndActivation(1, 256, 1, false, false,
                                             activation);
   }
 }
 
+TYPED_TEST_P(FusedMatMulWithBiasOpTest, MatMul256x256x256WithAdd) {
+  this->VerifyMatMulWithBiasAndAdd(256, 256, 256, /*with_relu=*/false);
+  this->VerifyMatMulWithBiasAndAdd(256, 256, 256, /*with_relu=*/true);
+}
+
+TYPED_TEST_P(FusedMatMulWithBiasOpTest, MatMul1x256x1WithAdd) {
+  this->VerifyMatMulWithBiasAndAdd(1, 256, 1, /*with_relu=*/false);
+  this->VerifyMatMulWithBiasAndAdd(1, 256, 1, /*with_relu=*/true);
+}
+
 REGISTER_TYPED_TEST_SUITE_P(FusedMatMulWithBiasOpTest,        //
                             MatMul256x256x256,                //
                             MatMul1x256x256,                  //
@@ -330,7 +436,9 @@ REGISTER_TYPED_TEST_SUITE_P(FusedMatMulWithBiasOpTest,        //
                             MatMul256x256x256WithActivation,  //
                             MatMul1x256x256WithActivation,    //
                             MatMul256x256x1WithActivation,    //
-                            MatMul1x256x1WithActivation);
+                            MatMul1x256x1WithActivation,      //
+                            MatMul256x256x256WithAdd,         //
+                            MatMul1x256x1WithAdd);
 
 // TODO(ezhulenev): Add support for more data types.
 using FusedBiasAddDataTypes = ::testing::Types<float>;
@@ -458,4 +566,48 @@ BM_Matmul(2000, 1, 2000, true, false);
 BM_Matmul(2000, 1, 2000, false, true);
 BM_Matmul(2000, 1, 2000, true, true);
 
+// MatMul with constant weights, that the kernel packs once or not (see
+// packed_matmul.h).
+static Graph* MatmulWithConstWeights(int m, int k, int n, bool transpose_b) {
+  Graph* g = new Graph(OpRegistry::Global());
+  Tensor in0(DT_FLOAT, TensorShape({m, k}));
+  in0.flat<float>().setRandom();
+  Tensor in1(DT_FLOAT, transpose_b ? TensorShape({n, k}) : TensorShape({k, n}));
+  in1.flat<float>().setRandom();
+  Node* matmul =
+      test::graph::Matmul(g, test::graph::Constant(g, in0),
+                          test::graph::Constant(g, in1), false, transpose_b);
+  matmul->AddAttr("_is_weight_const", true);
+  return g;
+}
+
+#define BM_ConstWeightsMatmul(M, K, N, TB, PACK)                              \
+  static void BM_ConstWeightsMatmul##_##M##_##K##_##N##_##TB##_##PACK(        \
+      int iters) {                                                            \
+    testing::UseRealTime();                                                   \
+    testing::ItemsProcessed(static_cast<int64>(iters) * M * K * N * 2);       \
+    setenv("TF_PREPACK_CONSTANT_WEIGHTS", PACK ? "1" : "0", 1 /* replace */); \
+    test::Benchmark("cpu", MatmulWithConstWeights(M, K, N, TB)).Run(iters);   \
+  }                                                                           \
+  BENCHMARK(BM_ConstWeightsMatmul##_##M##_##K##_##N##_##TB##_##PACK);
+
+#define BM_ConstWeightsMatmulBatches(K, N, TB) \
+  BM_ConstWeightsMatmul(1, K, N, TB, false);   \
+  BM_ConstWeightsMatmul(1, K, N, TB, true);    \
+  BM_ConstWeightsMatmul(2, K, N, TB, false);   \
+  BM_ConstWeightsMatmul(2, K, N, TB, true);    \
+  BM_ConstWeightsMatmul(4, K, N, TB, false);   \
+  BM_ConstWeightsMatmul(4, K, N, TB, true);    \
+  BM_ConstWeightsMatmul(8, K, N, TB, false);   \
+  BM_ConstWeightsMatmul(8, K, N, TB, true);    \
+  BM_ConstWeightsMatmul(16, K, N, TB, false);  \
+  BM_ConstWeightsMatmul(16, K, N, TB, true);   \
+  BM_ConstWeightsMatmul(32, K, N, TB, false);  \
+  BM_ConstWeightsMatmul(32, K, N, TB, true);
+
+BM_ConstWeightsMatmulBatches(256, 256, false);
+BM_ConstWeightsMatmulBatches(512, 512, false);
+BM_ConstWeightsMatmulBatches(1024, 1024, false);
+BM_ConstWeightsMatmulBatches(1024, 1024, true);
+
 }  // end namespace tensorflow
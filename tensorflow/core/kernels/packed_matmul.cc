@@ -0,0 +1,181 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#define EIGEN_USE_THREADS
+
+#include "tensorflow/core/kernels/packed_matmul.h"
+
+#include <algorithm>
+
+#include "tensorflow/core/framework/node_def_util.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/util/env_var.h"
+
+namespace tensorflow {
+
+const char* const kIsWeightConstAttr = "_is_weight_const";
+
+namespace {
+
+using Packet = Eigen::internal::packet_traits<float>::type;
+constexpr int64 kPacketSize = Eigen::internal::packet_traits<float>::size;
+constexpr int64 kPanelWidth = 2 * kPacketSize;
+// The number of rows of the left-hand side that are multiplied together, so
+// that each row of a panel is loaded once for all of them.
+constexpr int kRowBlock = 4;
+
+// Computes `num_rows` rows of the `width` <= kPanelWidth columns of a panel.
+// `lhs` has k columns, and the rows of `out` are `out_stride` apart.
+template <int num_rows>
+void MultiplyPanel(const float* lhs, int64 k, const float* panel, int64 width,
+                   float* out, int64 out_stride) {
+  using Eigen::internal::pload;
+  using Eigen::internal::pmadd;
+  using Eigen::internal::pset1;
+  using Eigen::internal::pstoreu;
+
+  Packet acc[num_rows][2];
+  for (int r = 0; r < num_rows; ++r) {
+    acc[r][0] = pset1<Packet>(0.0f);
+    acc[r][1] = pset1<Packet>(0.0f);
+  }
+
+  for (int64 i = 0; i < k; ++i) {
+    const Packet b0 = pload<Packet>(panel + i * kPanelWidth);
+    const Packet b1 = pload<Packet>(panel + i * kPanelWidth + kPacketSize);
+    for (int r = 0; r < num_rows; ++r) {
+      const Packet a = pset1<Packet>(lhs[r * k + i]);
+      acc[r][0] = pmadd(a, b0, acc[r][0]);
+      acc[r][1] = pmadd(a, b1, acc[r][1]);
+    }
+  }
+
+  for (int r = 0; r < num_rows; ++r) {
+    float* row = out + r * out_stride;
+    if (width == kPanelWidth) {
+      pstoreu(row, acc[r][0]);
+      pstoreu(row + kPacketSize, acc[r][1]);
+    } else {
+      // The last panel is padded with zeros past the last column.
+      EIGEN_ALIGN_MAX float buffer[kPanelWidth];
+      pstoreu(buffer, acc[r][0]);
+      pstoreu(buffer + kPacketSize, acc[r][1]);
+      std::copy_n(buffer, width, row);
+    }
+  }
+}
+
+}  // namespace
+
+bool ShouldPackConstantWeights(OpKernelConstruction* context) {
+  bool is_weight_const = false;
+  if (!TryGetNodeAttr(context->def(), kIsWeightConstAttr, &is_weight_const) ||
+      !is_weight_const) {
+    return false;
+  }
+  if (context->device_type() != DeviceType(DEVICE_CPU) ||
+      context->num_inputs() < 2 || context->input_type(1) != DT_FLOAT) {
+    return false;
+  }
+
+  bool enabled;
+  Status status =
+      ReadBoolFromEnvVar("TF_PREPACK_CONSTANT_WEIGHTS", false, &enabled);
+  if (!status.ok()) {
+    LOG(ERROR) << status.error_message();
+    return false;
+  }
+  return enabled;
+}
+
+PackedMatMulWeights::PackedMatMulWeights(const Tensor& weights,
+                                         bool transpose)
+    : source_(weights),
+      transpose_(transpose),
+      k_(weights.dim_size(transpose ? 1 : 0)),
+      n_(weights.dim_size(transpose ? 0 : 1)),
+      num_panels_((n_ + kPanelWidth - 1) / kPanelWidth),
+      packed_(DT_FLOAT, TensorShape({num_panels_ * k_ * kPanelWidth})) {
+  const float* w = weights.flat<float>().data();
+  float* p = packed_.flat<float>().data();
+  for (int64 panel = 0; panel < num_panels_; ++panel) {
+    const int64 col = panel * kPanelWidth;
+    const int64 width = std::min(kPanelWidth, n_ - col);
+    for (int64 i = 0; i < k_; ++i, p += kPanelWidth) {
+      for (int64 j = 0; j < width; ++j) {
+        p[j] = transpose_ ? w[(col + j) * k_ + i] : w[i * n_ + col + j];
+      }
+      std::fill(p + width, p + kPanelWidth, 0.0f);
+    }
+  }
+}
+
+bool PackedMatMulWeights::IsPackedFrom(const Tensor& weights,
+                                       bool transpose) const {
+  return transpose == transpose_ && weights.dtype() == DT_FLOAT &&
+         weights.shape() == source_.shape() &&
+         weights.tensor_data().data() == source_.tensor_data().data();
+}
+
+void PackedMatMulWeights::Multiply(const Eigen::ThreadPoolDevice& device,
+                                   const float* lhs, int64 m,
+                                   float* out) const {
+  const Eigen::TensorOpCost cost(
+      /*bytes_loaded=*/(m + kPanelWidth) * k_ * sizeof(float),
+      /*bytes_stored=*/m * kPanelWidth * sizeof(float),
+      /*compute_cycles=*/2.0 * m * k_);
+  device.parallelFor(num_panels_, cost,
+                     [&](Eigen::Index first, Eigen::Index last) {
+                       MultiplyPanels(lhs, m, out, first, last);
+                     });
+}
+
+void PackedMatMulWeights::MultiplyPanels(const float* lhs, int64 m,
+                                         float* out, int64 first_panel,
+                                         int64 last_panel) const {
+  const float* packed = packed_.flat<float>().data();
+  for (int64 panel = first_panel; panel < last_panel; ++panel) {
+    const float* panel_data = packed + panel * k_ * kPanelWidth;
+    const int64 col = panel * kPanelWidth;
+    const int64 width = std::min(kPanelWidth, n_ - col);
+    int64 row = 0;
+    for (; row + kRowBlock <= m; row += kRowBlock) {
+      MultiplyPanel<kRowBlock>(lhs + row * k_, k_, panel_data, width,
+                               out + row * n_ + col, n_);
+    }
+    for (; row < m; ++row) {
+      MultiplyPanel<1>(lhs + row * k_, k_, panel_data, width,
+                       out + row * n_ + col, n_);
+    }
+  }
+}
+
+std::shared_ptr<const PackedMatMulWeights> PackedMatMulWeightsCache::Get(
+    const Tensor& weights, bool transpose) {
+  {
+    tf_shared_lock l(mu_);
+    if (packed_ != nullptr && packed_->IsPackedFrom(weights, transpose)) {
+      return packed_;
+    }
+  }
+  mutex_lock l(mu_);
+  if (packed_ == nullptr || !packed_->IsPackedFrom(weights, transpose)) {
+    packed_ = std::make_shared<const PackedMatMulWeights>(weights, transpose);
+  }
+  return packed_;
+}
+
+}  // namespace tensorflow
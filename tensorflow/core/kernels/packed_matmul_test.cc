@@ -0,0 +1,113 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#define EIGEN_USE_THREADS
+
+#include "tensorflow/core/kernels/packed_matmul.h"
+
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+class PackedMatMulTest : public ::testing::Test {
+ protected:
+  PackedMatMulTest() : thread_pool_(4), device_(&thread_pool_, 4) {}
+
+  // Checks the product of a random [m, k] matrix and random weights packed
+  // from a [k, n] matrix, or a [n, k] one if `transpose`.
+  void VerifyMultiply(int64 m, int64 k, int64 n, bool transpose) {
+    Tensor lhs(DT_FLOAT, TensorShape({m, k}));
+    lhs.flat<float>().setRandom();
+    Tensor weights(DT_FLOAT, transpose ? TensorShape({n, k})
+                                       : TensorShape({k, n}));
+    weights.flat<float>().setRandom();
+
+    Tensor expected(DT_FLOAT, TensorShape({m, n}));
+    auto lhs_matrix = lhs.matrix<float>();
+    auto weights_matrix = weights.matrix<float>();
+    auto expected_matrix = expected.matrix<float>();
+    for (int64 i = 0; i < m; ++i) {
+      for (int64 j = 0; j < n; ++j) {
+        float sum = 0.0f;
+        for (int64 l = 0; l < k; ++l) {
+          sum += lhs_matrix(i, l) *
+                 (transpose ? weights_matrix(j, l) : weights_matrix(l, j));
+        }
+        expected_matrix(i, j) = sum;
+      }
+    }
+
+    PackedMatMulWeights packed(weights, transpose);
+    EXPECT_EQ(packed.k(), k);
+    EXPECT_EQ(packed.n(), n);
+    EXPECT_TRUE(packed.IsPackedFrom(weights, transpose));
+    EXPECT_FALSE(packed.IsPackedFrom(weights, !transpose));
+
+    Tensor out(DT_FLOAT, TensorShape({m, n}));
+    packed.Multiply(device_, lhs.flat<float>().data(), m,
+                    out.flat<float>().data());
+    test::ExpectTensorNear<float>(out, expected, 1e-4);
+  }
+
+  Eigen::ThreadPool thread_pool_;
+  Eigen::ThreadPoolDevice device_;
+};
+
+TEST_F(PackedMatMulTest, Multiply) {
+  for (bool transpose : {false, true}) {
+    VerifyMultiply(1, 256, 256, transpose);
+    VerifyMultiply(4, 64, 32, transpose);
+    VerifyMultiply(8, 128, 512, transpose);
+    VerifyMultiply(32, 256, 128, transpose);
+  }
+}
+
+TEST_F(PackedMatMulTest, MultiplyUnevenSizes) {
+  for (bool transpose : {false, true}) {
+    // Rows that are not a multiple of the row block, and columns that are not
+    // a multiple of the panel width.
+    VerifyMultiply(1, 1, 1, transpose);
+    VerifyMultiply(3, 17, 5, transpose);
+    VerifyMultiply(7, 33, 61, transpose);
+    VerifyMultiply(31, 100, 1000, transpose);
+  }
+}
+
+TEST_F(PackedMatMulTest, CacheRepacksOtherWeights) {
+  Tensor weights(DT_FLOAT, TensorShape({16, 8}));
+  weights.flat<float>().setRandom();
+  Tensor other_weights(DT_FLOAT, TensorShape({16, 8}));
+  other_weights.flat<float>().setRandom();
+
+  PackedMatMulWeightsCache cache;
+  auto packed = cache.Get(weights, /*transpose=*/false);
+  EXPECT_TRUE(packed->IsPackedFrom(weights, /*transpose=*/false));
+  EXPECT_EQ(cache.Get(weights, /*transpose=*/false), packed);
+
+  // Weights sharing the buffer are packed once.
+  Tensor same_weights = weights;
+  EXPECT_EQ(cache.Get(same_weights, /*transpose=*/false), packed);
+
+  auto other_packed = cache.Get(other_weights, /*transpose=*/false);
+  EXPECT_NE(other_packed, packed);
+  EXPECT_TRUE(other_packed->IsPackedFrom(other_weights, /*transpose=*/false));
+  EXPECT_FALSE(other_packed->IsPackedFrom(weights, /*transpose=*/false));
+}
+
+}  // namespace
+}  // namespace tensorflow
@@ -0,0 +1,168 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Implements the signed int8 convolution created by the fake_quant_to_int8
+// graph optimizer, as an im2col followed by a matrix multiplication.
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/kernels/conv_ops.h"
+#include "tensorflow/core/kernels/quantized_int8_gemm.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/util/tensor_format.h"
+#include "tensorflow/core/util/work_sharder.h"
+
+namespace tensorflow {
+
+namespace {
+
+// Copies the patches of an NHWC `input` to the rows of the [batch * out_rows *
+// out_cols, filter_rows * filter_cols * in_depth] matrix `patches`. Pixels in
+// the padding are set to `pad_value`, which represents 0.
+void Im2Col(OpKernelContext* context, const Conv2DDimensions& dims,
+            const int8* input, int8 pad_value, int8* patches) {
+  const int64 patch_size =
+      static_cast<int64>(dims.filter_rows) * dims.filter_cols * dims.in_depth;
+  const int64 num_patches = dims.batch * dims.out_rows * dims.out_cols;
+  auto copy_patches = [&](int64 start, int64 limit) {
+    for (int64 patch = start; patch < limit; ++patch) {
+      const int64 out_col = patch % dims.out_cols;
+      const int64 out_row = (patch / dims.out_cols) % dims.out_rows;
+      const int64 b = patch / (dims.out_cols * dims.out_rows);
+      int8* dst = patches + patch * patch_size;
+      for (int64 filter_row = 0; filter_row < dims.filter_rows; ++filter_row) {
+        const int64 in_row = out_row * dims.stride_rows +
+                             filter_row * dims.dilation_rows -
+                             dims.pad_rows_before;
+        for (int64 filter_col = 0; filter_col < dims.filter_cols;
+             ++filter_col, dst += dims.in_depth) {
+          const int64 in_col = out_col * dims.stride_cols +
+                               filter_col * dims.dilation_cols -
+                               dims.pad_cols_before;
+          if (in_row < 0 || in_row >= dims.input_rows || in_col < 0 ||
+              in_col >= dims.input_cols) {
+            std::memset(dst, pad_value, dims.in_depth);
+          } else {
+            const int8* src =
+                input +
+                ((b * dims.input_rows + in_row) * dims.input_cols + in_col) *
+                    dims.in_depth;
+            std::memcpy(dst, src, dims.in_depth);
+          }
+        }
+      }
+    }
+  };
+  const DeviceBase::CpuWorkerThreads& worker_threads =
+      *context->device()->tensorflow_cpu_worker_threads();
+  Shard(worker_threads.num_threads, worker_threads.workers, num_patches,
+        patch_size, copy_patches);
+}
+
+}  // namespace
+
+class QuantizedInt8Conv2DOp : public OpKernel {
+ public:
+  explicit QuantizedInt8Conv2DOp(OpKernelConstruction* context)
+      : OpKernel(context) {
+    OP_REQUIRES_OK(context, InitConv2DParameters(context, &params_));
+    OP_REQUIRES(context, params_.data_format == FORMAT_NHWC,
+                errors::Unimplemented(
+                    "_QuantizedInt8Conv2D only supports the NHWC format"));
+  }
+
+  void Compute(OpKernelContext* context) override {
+    const Tensor& input = context->input(0);
+    const Tensor& filter = context->input(1);
+    const Tensor& bias = context->input(2);
+
+    Conv2DDimensions dims;
+    OP_REQUIRES_OK(context,
+                   ComputeConv2DDimension(params_, input, filter, &dims));
+    OP_REQUIRES(context, dims.patch_depth == dims.in_depth,
+                errors::Unimplemented(
+                    "_QuantizedInt8Conv2D does not support grouped "
+                    "convolutions"));
+    OP_REQUIRES(context,
+                TensorShapeUtils::IsVector(bias.shape()) &&
+                    bias.dim_size(0) == dims.out_depth,
+                errors::InvalidArgument("Bias must be a vector of ",
+                                        dims.out_depth, " elements, got ",
+                                        bias.shape().DebugString()));
+
+    QuantizedInt8GemmArgs args;
+    OP_REQUIRES_OK(context,
+                   ReadInt8QuantizationParams(context->input(3),
+                                              context->input(4),
+                                              &args.lhs_params));
+    std::vector<float> filter_scales;
+    OP_REQUIRES_OK(context,
+                   GetInt8WeightScales(context->input(5), context->input(6),
+                                       dims.out_depth, &filter_scales));
+
+    TensorShape out_shape = ShapeFromFormat(
+        FORMAT_NHWC, dims.batch, dims.out_rows, dims.out_cols, dims.out_depth);
+    Tensor* output = nullptr;
+    OP_REQUIRES_OK(context, context->allocate_output(0, out_shape, &output));
+    if (output->NumElements() == 0) return;
+
+    Tensor quantized_input;
+    OP_REQUIRES_OK(context, QuantizeInt8Input(context, input, args.lhs_params,
+                                              &quantized_input));
+
+    // The filter [filter_rows, filter_cols, in_depth, out_depth] is the
+    // row-major [k, n] weights matrix. A 1x1 convolution with unit strides
+    // multiplies the input directly, and other convolutions multiply the
+    // patches of the input.
+    args.m = dims.batch * dims.out_rows * dims.out_cols;
+    args.k = static_cast<int64>(dims.filter_rows) * dims.filter_cols *
+             dims.in_depth;
+    args.n = dims.out_depth;
+    Tensor patches;
+    if (dims.filter_rows == 1 && dims.filter_cols == 1 &&
+        dims.stride_rows == 1 && dims.stride_cols == 1) {
+      args.lhs = quantized_input.flat<int8>().data();
+    } else {
+      OP_REQUIRES_OK(context, context->allocate_temp(
+                                  DT_INT8, TensorShape({args.m, args.k}),
+                                  &patches));
+      Im2Col(context, dims, quantized_input.flat<int8>().data(),
+             static_cast<int8>(args.lhs_params.zero_point),
+             patches.flat<int8>().data());
+      args.lhs = patches.flat<int8>().data();
+    }
+    args.weights = reinterpret_cast<const int8*>(filter.flat<qint8>().data());
+    args.weight_scales = filter_scales.data();
+    args.bias = bias.flat<float>().data();
+    OP_REQUIRES_OK(context,
+                   QuantizedInt8Gemm(context, args, context->input(7),
+                                     context->input(8), output));
+  }
+
+ private:
+  Conv2DParameters params_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(QuantizedInt8Conv2DOp);
+};
+
+REGISTER_KERNEL_BUILDER(Name("_QuantizedInt8Conv2D").Device(DEVICE_CPU),
+                        QuantizedInt8Conv2DOp);
+
+}  // namespace tensorflow
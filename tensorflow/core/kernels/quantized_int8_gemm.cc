@@ -0,0 +1,327 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/kernels/quantized_int8_gemm.h"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <memory>
+
+#include "third_party/eigen3/Eigen/Core"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/util/work_sharder.h"
+#include "tensorflow/lite/experimental/ruy/ruy.h"
+
+namespace tensorflow {
+
+namespace {
+
+// ruy::Context is not thread-safe, so each multiplication borrows a context
+// from a process-wide pool, and returns it when done. Contexts keep their
+// buffers between multiplications. They are single-threaded: the kernels
+// parallelize over the intra-op thread pool instead, see ShardRows.
+class ScopedRuyContext {
+ public:
+  ScopedRuyContext() {
+    {
+      mutex_lock l(*pool_mu());
+      auto* pool = free_contexts();
+      if (!pool->empty()) {
+        context_ = std::move(pool->back());
+        pool->pop_back();
+      }
+    }
+    if (context_ == nullptr) context_.reset(new ruy::Context);
+    context_->max_num_threads = 1;
+  }
+
+  ~ScopedRuyContext() {
+    mutex_lock l(*pool_mu());
+    free_contexts()->push_back(std::move(context_));
+  }
+
+  ruy::Context* get() { return context_.get(); }
+
+ private:
+  static mutex* pool_mu() {
+    static mutex* mu = new mutex;
+    return mu;
+  }
+  static std::vector<std::unique_ptr<ruy::Context>>* free_contexts() {
+    static auto* contexts = new std::vector<std::unique_ptr<ruy::Context>>;
+    return contexts;
+  }
+
+  std::unique_ptr<ruy::Context> context_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(ScopedRuyContext);
+};
+
+// Runs `fn(begin, end)` on blocks of the m rows of the output, in parallel on
+// the intra-op thread pool.
+void ShardRows(OpKernelContext* context, const QuantizedInt8GemmArgs& args,
+               const std::function<void(int64, int64)>& fn) {
+  const DeviceBase::CpuWorkerThreads* worker_threads =
+      context->device()->tensorflow_cpu_worker_threads();
+  if (worker_threads == nullptr) {
+    fn(0, args.m);
+    return;
+  }
+  Shard(worker_threads->num_threads, worker_threads->workers, args.m,
+        args.k * args.n, fn);
+}
+
+// Splits a positive real multiplier into a fixed-point multiplier in
+// [2^30, 2^31) and a power of two exponent, as ruy expects them.
+void QuantizeMultiplier(double multiplier, int32* fixedpoint, int* exponent) {
+  const double q = std::frexp(multiplier, exponent);
+  int64 q_fixed = static_cast<int64>(std::round(q * (1LL << 31)));
+  if (q_fixed == (1LL << 31)) {
+    q_fixed /= 2;
+    ++*exponent;
+  }
+  if (*exponent < -31) {
+    // The multiplier rounds to 0.
+    *exponent = 0;
+    q_fixed = 0;
+  }
+  *fixedpoint = static_cast<int32>(q_fixed);
+}
+
+// Sets up ruy to compute rows [begin, end) of the row-major [m, n] output. Ruy
+// writes column-major destinations, so it computes the column-major
+// [n, end - begin] product weights^T * lhs^T, which has the same layout. The
+// output channels are the rows of the destination, as ruy expects for
+// per-channel multipliers.
+template <typename DstScalar>
+void MakeRuyMatrices(const QuantizedInt8GemmArgs& args, int64 begin,
+                     int64 end, ruy::Matrix<std::int8_t>* lhs,
+                     ruy::Matrix<std::int8_t>* rhs,
+                     ruy::Matrix<DstScalar>* dst) {
+  ruy::MakeSimpleLayout(
+      args.n, args.k,
+      args.transpose_weights ? ruy::Order::kRowMajor : ruy::Order::kColMajor,
+      &lhs->layout);
+  lhs->data = args.weights;
+  lhs->zero_point = 0;
+
+  ruy::MakeSimpleLayout(args.k, end - begin, ruy::Order::kColMajor,
+                        &rhs->layout);
+  rhs->data = args.lhs + begin * args.k;
+  rhs->zero_point = static_cast<std::int8_t>(args.lhs_params.zero_point);
+
+  ruy::MakeSimpleLayout(args.n, end - begin, ruy::Order::kColMajor,
+                        &dst->layout);
+}
+
+}  // namespace
+
+Int8QuantizationParams GetInt8QuantizationParams(float min, float max) {
+  // Same as Nudge() in fake_quant_ops_functor.h, for quantized values in
+  // [0, 255] that are stored shifted by -128.
+  const float scale = (max - min) / 255.0f;
+  const float zero_point_from_min = -min / scale;
+  int32 nudged_zero_point;
+  if (zero_point_from_min < 0.0f) {
+    nudged_zero_point = 0;
+  } else if (zero_point_from_min > 255.0f) {
+    nudged_zero_point = 255;
+  } else {
+    nudged_zero_point = static_cast<int32>(std::round(zero_point_from_min));
+  }
+
+  Int8QuantizationParams params;
+  params.scale = scale;
+  params.zero_point = nudged_zero_point - 128;
+  return params;
+}
+
+Status ReadInt8QuantizationParams(const Tensor& min, const Tensor& max,
+                                  Int8QuantizationParams* params) {
+  if (!TensorShapeUtils::IsScalar(min.shape()) ||
+      !TensorShapeUtils::IsScalar(max.shape())) {
+    return errors::InvalidArgument(
+        "Quantization ranges must be scalars, got min ",
+        min.shape().DebugString(), " and max ", max.shape().DebugString());
+  }
+  const float min_value = min.scalar<float>()();
+  const float max_value = max.scalar<float>()();
+  if (!(min_value < max_value)) {
+    return errors::InvalidArgument("Quantization range min ", min_value,
+                                   " must be less than max ", max_value);
+  }
+  *params = GetInt8QuantizationParams(min_value, max_value);
+  return Status::OK();
+}
+
+void QuantizeToInt8(const float* input, int64 size,
+                    const Int8QuantizationParams& params, int8* output) {
+  const float nudged_min = (-128 - params.zero_point) * params.scale;
+  const float nudged_max = (127 - params.zero_point) * params.scale;
+  for (int64 i = 0; i < size; ++i) {
+    const float clamped = std::min(std::max(input[i], nudged_min), nudged_max);
+    const float quantized =
+        std::floor((clamped - nudged_min) / params.scale + 0.5f);
+    output[i] = static_cast<int8>(static_cast<int32>(quantized) - 128);
+  }
+}
+
+Status QuantizeInt8Input(OpKernelContext* context, const Tensor& input,
+                         const Int8QuantizationParams& params,
+                         Tensor* quantized) {
+  if (input.dtype() == DT_QINT8) {
+    return quantized->BitcastFrom(input, DT_INT8, input.shape());
+  }
+  TF_RETURN_IF_ERROR(
+      context->allocate_temp(DT_INT8, input.shape(), quantized));
+  QuantizeToInt8(input.flat<float>().data(), input.NumElements(), params,
+                 quantized->flat<int8>().data());
+  return Status::OK();
+}
+
+Status GetInt8WeightScales(const Tensor& min, const Tensor& max,
+                           int64 num_channels, std::vector<float>* scales) {
+  const int64 num_ranges = min.NumElements();
+  if (max.NumElements() != num_ranges ||
+      (num_ranges != 1 && num_ranges != num_channels)) {
+    return errors::InvalidArgument(
+        "Weight ranges must be scalars or vectors of ", num_channels,
+        " elements, got min ", min.shape().DebugString(), " and max ",
+        max.shape().DebugString());
+  }
+  auto min_flat = min.flat<float>();
+  auto max_flat = max.flat<float>();
+  scales->resize(num_channels);
+  for (int64 c = 0; c < num_channels; ++c) {
+    const int64 i = num_ranges == 1 ? 0 : c;
+    const float scale =
+        std::max(std::abs(min_flat(i)), std::abs(max_flat(i))) / 127.0f;
+    // The weights of a channel with an empty range are all zero, so any
+    // positive scale represents them.
+    (*scales)[c] = scale > 0.0f ? scale : 1.0f;
+  }
+  return Status::OK();
+}
+
+Status QuantizedInt8Gemm(OpKernelContext* context,
+                         const QuantizedInt8GemmArgs& args, float* output) {
+  Tensor accumulators;
+  TF_RETURN_IF_ERROR(context->allocate_temp(
+      DT_INT32, TensorShape({args.m, args.n}), &accumulators));
+  int32* acc = accumulators.flat<int32>().data();
+
+  Eigen::Array<float, 1, Eigen::Dynamic> scales(args.n);
+  for (int64 c = 0; c < args.n; ++c) {
+    scales(c) = args.lhs_params.scale * args.weight_scales[c];
+  }
+  const Eigen::Map<const Eigen::Array<float, 1, Eigen::Dynamic>> bias(
+      args.bias, args.n);
+
+  ShardRows(context, args, [&](int64 begin, int64 end) {
+    ruy::Matrix<std::int8_t> lhs;
+    ruy::Matrix<std::int8_t> rhs;
+    ruy::Matrix<std::int32_t> dst;
+    MakeRuyMatrices(args, begin, end, &lhs, &rhs, &dst);
+    dst.data = acc + begin * args.n;
+
+    // Ruy returns the raw int32 accumulators, which are dequantized while
+    // they are still in cache.
+    ruy::BasicSpec<std::int32_t, std::int32_t> spec;
+    ScopedRuyContext ruy_context;
+    ruy::Mul<ruy::kAllPaths>(lhs, rhs, spec, ruy_context.get(), &dst);
+
+    using RowMajorArray = Eigen::Array<float, Eigen::Dynamic, Eigen::Dynamic,
+                                       Eigen::RowMajor>;
+    using RowMajorInt32Array = Eigen::Array<int32, Eigen::Dynamic,
+                                            Eigen::Dynamic, Eigen::RowMajor>;
+    const Eigen::Map<const RowMajorInt32Array> acc_block(
+        acc + begin * args.n, end - begin, args.n);
+    Eigen::Map<RowMajorArray> output_block(output + begin * args.n,
+                                           end - begin, args.n);
+    output_block =
+        (acc_block.cast<float>().rowwise() * scales).rowwise() + bias;
+  });
+  return Status::OK();
+}
+
+Status QuantizedInt8Gemm(OpKernelContext* context,
+                         const QuantizedInt8GemmArgs& args,
+                         const Int8QuantizationParams& output_params,
+                         int8* output) {
+  // The bias is quantized with the scale of the accumulators, and the
+  // accumulators are rescaled to the output with per-channel multipliers.
+  std::vector<int32> bias(args.n);
+  std::vector<int32> multipliers(args.n);
+  std::vector<int> exponents(args.n);
+  for (int64 c = 0; c < args.n; ++c) {
+    const double accumulator_scale =
+        static_cast<double>(args.lhs_params.scale) * args.weight_scales[c];
+    bias[c] = static_cast<int32>(std::round(args.bias[c] / accumulator_scale));
+    QuantizeMultiplier(accumulator_scale / output_params.scale,
+                       &multipliers[c], &exponents[c]);
+  }
+
+  ruy::BasicSpec<std::int32_t, std::int8_t> spec;
+  spec.bias = bias.data();
+  spec.multiplier_fixedpoint_perchannel = multipliers.data();
+  spec.multiplier_exponent_perchannel = exponents.data();
+
+  ShardRows(context, args, [&](int64 begin, int64 end) {
+    ruy::Matrix<std::int8_t> lhs;
+    ruy::Matrix<std::int8_t> rhs;
+    ruy::Matrix<std::int8_t> dst;
+    MakeRuyMatrices(args, begin, end, &lhs, &rhs, &dst);
+    dst.data = output + begin * args.n;
+    dst.zero_point = static_cast<std::int8_t>(output_params.zero_point);
+
+    ScopedRuyContext ruy_context;
+    ruy::Mul<ruy::kAllPaths>(lhs, rhs, spec, ruy_context.get(), &dst);
+  });
+  return Status::OK();
+}
+
+Status QuantizedInt8Gemm(OpKernelContext* context,
+                         const QuantizedInt8GemmArgs& args,
+                         const Tensor& min_output, const Tensor& max_output,
+                         Tensor* output) {
+  if (output->NumElements() == 0) return Status::OK();
+  if (output->dtype() == DT_FLOAT) {
+    float* output_data = output->flat<float>().data();
+    if (args.k == 0) {
+      for (int64 i = 0; i < args.m; ++i) {
+        std::copy_n(args.bias, args.n, output_data + i * args.n);
+      }
+      return Status::OK();
+    }
+    return QuantizedInt8Gemm(context, args, output_data);
+  }
+
+  Int8QuantizationParams output_params;
+  TF_RETURN_IF_ERROR(
+      ReadInt8QuantizationParams(min_output, max_output, &output_params));
+  int8* output_data = reinterpret_cast<int8*>(output->flat<qint8>().data());
+  if (args.k == 0) {
+    for (int64 i = 0; i < args.m; ++i) {
+      QuantizeToInt8(args.bias, args.n, output_params,
+                     output_data + i * args.n);
+    }
+    return Status::OK();
+  }
+  return QuantizedInt8Gemm(context, args, output_params, output_data);
+}
+
+}  // namespace tensorflow
@@ -0,0 +1,109 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_KERNELS_QUANTIZED_INT8_GEMM_H_
+#define TENSORFLOW_CORE_KERNELS_QUANTIZED_INT8_GEMM_H_
+
+// Signed int8 matrix multiplication for the _QuantizedInt8MatMul and
+// _QuantizedInt8Conv2D kernels, implemented with ruy
+// (tensorflow/lite/experimental/ruy).
+//
+// Activations are quantized per tensor with a zero point, and weights are
+// quantized symmetrically per output channel. The bias addition and the
+// requantization of the output are fused into the multiplication.
+
+#include <vector>
+
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+// Parameters of a per-tensor affine int8 quantization:
+// real = scale * (quantized - zero_point).
+struct Int8QuantizationParams {
+  float scale = 1.0f;
+  int32 zero_point = 0;
+};
+
+// Returns the quantization of the range [min, max], nudged like
+// FakeQuantWithMinMaxVars (8 bits, not narrow range) so that 0 is exactly
+// representable.
+Int8QuantizationParams GetInt8QuantizationParams(float min, float max);
+
+// Returns the quantization of the range given by the scalar tensors `min` and
+// `max`, or an error if they do not form a non-empty range.
+Status ReadInt8QuantizationParams(const Tensor& min, const Tensor& max,
+                                  Int8QuantizationParams* params);
+
+// Quantizes `size` floats like FakeQuantWithMinMaxVars does.
+void QuantizeToInt8(const float* input, int64 size,
+                    const Int8QuantizationParams& params, int8* output);
+
+// Sets `quantized` to a DT_INT8 tensor with the values of `input`, which is
+// quantized with `params` if it is a float tensor, or shares the buffer of a
+// qint8 `input`.
+Status QuantizeInt8Input(OpKernelContext* context, const Tensor& input,
+                         const Int8QuantizationParams& params,
+                         Tensor* quantized);
+
+// Returns the scales of weights quantized symmetrically per channel, from
+// their ranges [min[c], max[c]]: max(|min[c]|, |max[c]|) / 127. The ranges are
+// vectors of `num_channels` elements, or scalars for all channels.
+Status GetInt8WeightScales(const Tensor& min, const Tensor& max,
+                           int64 num_channels, std::vector<float>* scales);
+
+// Arguments of QuantizedInt8Gemm.
+struct QuantizedInt8GemmArgs {
+  // [m, k] row-major activations.
+  const int8* lhs = nullptr;
+  Int8QuantizationParams lhs_params;
+  // [k, n] row-major weights, or [n, k] if transpose_weights. The scales of
+  // the n channels.
+  const int8* weights = nullptr;
+  bool transpose_weights = false;
+  const float* weight_scales = nullptr;
+  // [n] bias.
+  const float* bias = nullptr;
+  int64 m = 0;
+  int64 k = 0;
+  int64 n = 0;
+};
+
+// Computes the [m, n] row-major `output` = lhs * weights + bias, dequantized
+// to float.
+Status QuantizedInt8Gemm(OpKernelContext* context,
+                         const QuantizedInt8GemmArgs& args, float* output);
+
+// Computes the [m, n] row-major `output` = lhs * weights + bias, requantized
+// with `output_params`.
+Status QuantizedInt8Gemm(OpKernelContext* context,
+                         const QuantizedInt8GemmArgs& args,
+                         const Int8QuantizationParams& output_params,
+                         int8* output);
+
+// Computes `output` = lhs * weights + bias, dequantized to float for a float
+// `output`, or requantized to the range given by the scalar tensors
+// `min_output` and `max_output` for a qint8 `output`.
+Status QuantizedInt8Gemm(OpKernelContext* context,
+                         const QuantizedInt8GemmArgs& args,
+                         const Tensor& min_output, const Tensor& max_output,
+                         Tensor* output);
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_KERNELS_QUANTIZED_INT8_GEMM_H_
@@ -0,0 +1,105 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Implements the signed int8 matmul created by the fake_quant_to_int8 graph
+// optimizer.
+
+#include <vector>
+
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/kernels/quantized_int8_gemm.h"
+#include "tensorflow/core/lib/core/errors.h"
+
+namespace tensorflow {
+
+class QuantizedInt8MatMulOp : public OpKernel {
+ public:
+  explicit QuantizedInt8MatMulOp(OpKernelConstruction* context)
+      : OpKernel(context) {
+    bool transpose_a;
+    OP_REQUIRES_OK(context, context->GetAttr("transpose_a", &transpose_a));
+    OP_REQUIRES(context, !transpose_a,
+                errors::Unimplemented(
+                    "_QuantizedInt8MatMul does not support transpose_a"));
+    OP_REQUIRES_OK(context, context->GetAttr("transpose_b", &transpose_b_));
+  }
+
+  void Compute(OpKernelContext* context) override {
+    const Tensor& a = context->input(0);
+    const Tensor& b = context->input(1);
+    const Tensor& bias = context->input(2);
+    OP_REQUIRES(context, TensorShapeUtils::IsMatrix(a.shape()),
+                errors::InvalidArgument("In[0] is not a matrix: ",
+                                        a.shape().DebugString()));
+    OP_REQUIRES(context, TensorShapeUtils::IsMatrix(b.shape()),
+                errors::InvalidArgument("In[1] is not a matrix: ",
+                                        b.shape().DebugString()));
+
+    const int64 m = a.dim_size(0);
+    const int64 k = a.dim_size(1);
+    const int64 n = b.dim_size(transpose_b_ ? 0 : 1);
+    OP_REQUIRES(context, b.dim_size(transpose_b_ ? 1 : 0) == k,
+                errors::InvalidArgument(
+                    "Matrix size-incompatible: In[0]: ",
+                    a.shape().DebugString(), ", In[1]: ",
+                    b.shape().DebugString()));
+    OP_REQUIRES(context,
+                TensorShapeUtils::IsVector(bias.shape()) &&
+                    bias.dim_size(0) == n,
+                errors::InvalidArgument("Bias must be a vector of ", n,
+                                        " elements, got ",
+                                        bias.shape().DebugString()));
+
+    QuantizedInt8GemmArgs args;
+    OP_REQUIRES_OK(context,
+                   ReadInt8QuantizationParams(context->input(3),
+                                              context->input(4),
+                                              &args.lhs_params));
+    std::vector<float> weight_scales;
+    OP_REQUIRES_OK(context,
+                   GetInt8WeightScales(context->input(5), context->input(6), n,
+                                       &weight_scales));
+
+    Tensor* output = nullptr;
+    OP_REQUIRES_OK(context,
+                   context->allocate_output(0, TensorShape({m, n}), &output));
+    if (output->NumElements() == 0) return;
+
+    Tensor quantized_a;
+    OP_REQUIRES_OK(context, QuantizeInt8Input(context, a, args.lhs_params,
+                                              &quantized_a));
+    args.lhs = quantized_a.flat<int8>().data();
+    args.weights = reinterpret_cast<const int8*>(b.flat<qint8>().data());
+    args.transpose_weights = transpose_b_;
+    args.weight_scales = weight_scales.data();
+    args.bias = bias.flat<float>().data();
+    args.m = m;
+    args.k = k;
+    args.n = n;
+    OP_REQUIRES_OK(context,
+                   QuantizedInt8Gemm(context, args, context->input(7),
+                                     context->input(8), output));
+  }
+
+ private:
+  bool transpose_b_;
+};
+
+REGISTER_KERNEL_BUILDER(Name("_QuantizedInt8MatMul").Device(DEVICE_CPU),
+                        QuantizedInt8MatMulOp);
+
+}  // namespace tensorflow
@@ -0,0 +1,394 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "tensorflow/core/common_runtime/kernel_benchmark_testlib.h"
+#include "tensorflow/core/framework/fake_input.h"
+#include "tensorflow/core/framework/node_def_builder.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/graph/node_builder.h"
+#include "tensorflow/core/graph/testlib.h"
+#include "tensorflow/core/kernels/ops_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+
+namespace tensorflow {
+namespace {
+
+// The activations range [-6.4, 19.1] is quantized with scale 0.1 and zero
+// point -64, so that padding bugs are not hidden by a zero point of 0.
+constexpr float kMinInput = -6.4f;
+constexpr float kMaxInput = 19.1f;
+// The output range [-64, 63.5] is quantized with scale 0.5 and zero point 0.
+constexpr float kMinOutput = -64.0f;
+constexpr float kMaxOutput = 63.5f;
+constexpr float kOutputScale = 0.5f;
+
+int8 QuantizedInput(int64 i) { return static_cast<int8>(i * 37 % 256 - 128); }
+float RealInput(int8 q) { return 0.1f * (q + 64); }
+int8 QuantizedWeight(int64 i) { return static_cast<int8>(i * 53 % 255 - 127); }
+// Weights are quantized symmetrically per channel, with scales 0.001 * (c + 1).
+float WeightScale(int64 c) { return 0.001f * (c + 1); }
+
+class QuantizedInt8OpsTest : public OpsTestBase {
+ protected:
+  // Adds the activations, as floats or qint8 values.
+  void AddInput(DataType type, const TensorShape& shape) {
+    std::vector<int8> quantized(shape.num_elements());
+    for (int64 i = 0; i < quantized.size(); ++i) {
+      quantized[i] = QuantizedInput(i);
+    }
+    if (type == DT_FLOAT) {
+      AddInput<float>(shape, [&quantized](int i) {
+        return RealInput(quantized[i]);
+      });
+    } else {
+      AddInput<qint8>(shape, [&quantized](int i) { return quantized[i]; });
+    }
+  }
+  using OpsTestBase::AddInput;
+
+  // Adds the weights, bias and ranges inputs for `num_channels` channels.
+  void AddWeightsAndRanges(const TensorShape& weights_shape,
+                           int64 num_channels) {
+    AddInput<qint8>(weights_shape, [](int i) { return QuantizedWeight(i); });
+    AddInput<float>(TensorShape({num_channels}),
+                    [](int c) { return 0.25f * c - 0.5f; });
+    AddInputFromArray<float>(TensorShape({}), {kMinInput});
+    AddInputFromArray<float>(TensorShape({}), {kMaxInput});
+    AddInput<float>(TensorShape({num_channels}),
+                    [](int c) { return -127.0f * WeightScale(c); });
+    AddInput<float>(TensorShape({num_channels}),
+                    [](int c) { return 127.0f * WeightScale(c); });
+    AddInputFromArray<float>(TensorShape({}), {kMinOutput});
+    AddInputFromArray<float>(TensorShape({}), {kMaxOutput});
+  }
+
+  // Checks the output against the float result `expected`.
+  void ExpectOutput(DataType output_type, const Tensor& expected) {
+    const Tensor& output = *GetOutput(0);
+    if (output_type == DT_FLOAT) {
+      test::ExpectTensorNear<float>(expected, output, 1e-4);
+      return;
+    }
+    ASSERT_EQ(output.dtype(), DT_QINT8);
+    ASSERT_EQ(output.shape(), expected.shape());
+    auto output_flat = output.flat<qint8>();
+    auto expected_flat = expected.flat<float>();
+    for (int64 i = 0; i < expected.NumElements(); ++i) {
+      const float clamped =
+          std::min(std::max(expected_flat(i), kMinOutput), kMaxOutput);
+      const int32 expected_value =
+          static_cast<int32>(std::round(clamped / kOutputScale));
+      EXPECT_NEAR(output_flat(i).value, expected_value, 1) << "at " << i;
+    }
+  }
+};
+
+class QuantizedInt8MatMulTest : public QuantizedInt8OpsTest {
+ protected:
+  void VerifyMatMul(DataType input_type, DataType output_type,
+                    bool transpose_b, int64 m, int64 k, int64 n) {
+    TF_ASSERT_OK(NodeDefBuilder("matmul", "_QuantizedInt8MatMul")
+                     .Input(FakeInput(input_type))
+                     .Input(FakeInput(DT_QINT8))
+                     .Input(FakeInput(DT_FLOAT))
+                     .Input(FakeInput(DT_FLOAT))
+                     .Input(FakeInput(DT_FLOAT))
+                     .Input(FakeInput(DT_FLOAT))
+                     .Input(FakeInput(DT_FLOAT))
+                     .Input(FakeInput(DT_FLOAT))
+                     .Input(FakeInput(DT_FLOAT))
+                     .Attr("Toutput", output_type)
+                     .Attr("transpose_b", transpose_b)
+                     .Finalize(node_def()));
+    TF_ASSERT_OK(InitOp());
+    AddInput(input_type, TensorShape({m, k}));
+    AddWeightsAndRanges(
+        transpose_b ? TensorShape({n, k}) : TensorShape({k, n}), n);
+    TF_ASSERT_OK(RunOpKernel());
+
+    Tensor expected(DT_FLOAT, TensorShape({m, n}));
+    auto expected_matrix = expected.matrix<float>();
+    for (int64 i = 0; i < m; ++i) {
+      for (int64 j = 0; j < n; ++j) {
+        double sum = 0.25 * j - 0.5;
+        for (int64 l = 0; l < k; ++l) {
+          const int64 w = transpose_b ? j * k + l : l * n + j;
+          sum += RealInput(QuantizedInput(i * k + l)) * QuantizedWeight(w) *
+                 WeightScale(j);
+        }
+        expected_matrix(i, j) = sum;
+      }
+    }
+    ExpectOutput(output_type, expected);
+  }
+};
+
+TEST_F(QuantizedInt8MatMulTest, FloatInputFloatOutput) {
+  VerifyMatMul(DT_FLOAT, DT_FLOAT, false, 3, 5, 4);
+}
+
+TEST_F(QuantizedInt8MatMulTest, Int8InputFloatOutput) {
+  VerifyMatMul(DT_QINT8, DT_FLOAT, false, 7, 33, 17);
+}
+
+TEST_F(QuantizedInt8MatMulTest, TransposeB) {
+  VerifyMatMul(DT_FLOAT, DT_FLOAT, true, 9, 64, 31);
+}
+
+TEST_F(QuantizedInt8MatMulTest, Int8Output) {
+  VerifyMatMul(DT_FLOAT, DT_QINT8, false, 5, 16, 8);
+  VerifyMatMul(DT_QINT8, DT_QINT8, true, 5, 16, 8);
+}
+
+TEST_F(QuantizedInt8MatMulTest, ScalarWeightRanges) {
+  TF_ASSERT_OK(NodeDefBuilder("matmul", "_QuantizedInt8MatMul")
+                   .Input(FakeInput(DT_QINT8))
+                   .Input(FakeInput(DT_QINT8))
+                   .Input(FakeInput(DT_FLOAT))
+                   .Input(FakeInput(DT_FLOAT))
+                   .Input(FakeInput(DT_FLOAT))
+                   .Input(FakeInput(DT_FLOAT))
+                   .Input(FakeInput(DT_FLOAT))
+                   .Input(FakeInput(DT_FLOAT))
+                   .Input(FakeInput(DT_FLOAT))
+                   .Finalize(node_def()));
+  TF_ASSERT_OK(InitOp());
+  // a is [[1, 2], [3, 4]] and b is [[2, 0], [-1, 1]].
+  AddInputFromArray<qint8>(TensorShape({2, 2}), {-54, -44, -34, -24});
+  AddInputFromArray<qint8>(TensorShape({2, 2}), {64, 0, -32, 32});
+  AddInputFromArray<float>(TensorShape({2}), {1.0f, -1.0f});
+  AddInputFromArray<float>(TensorShape({}), {kMinInput});
+  AddInputFromArray<float>(TensorShape({}), {kMaxInput});
+  AddInputFromArray<float>(TensorShape({}), {-3.96875f});
+  AddInputFromArray<float>(TensorShape({}), {3.96875f});
+  AddInputFromArray<float>(TensorShape({}), {kMinOutput});
+  AddInputFromArray<float>(TensorShape({}), {kMaxOutput});
+  TF_ASSERT_OK(RunOpKernel());
+
+  Tensor expected(DT_FLOAT, TensorShape({2, 2}));
+  test::FillValues<float>(&expected, {1.0f, 1.0f, 3.0f, 3.0f});
+  test::ExpectTensorNear<float>(expected, *GetOutput(0), 1e-5);
+}
+
+class QuantizedInt8Conv2DTest : public QuantizedInt8OpsTest {
+ protected:
+  void VerifyConv2D(DataType input_type, DataType output_type,
+                    const string& padding, int stride, int dilation,
+                    int64 batch, int64 rows, int64 cols, int64 in_depth,
+                    int64 filter_size, int64 out_depth) {
+    TF_ASSERT_OK(NodeDefBuilder("conv", "_QuantizedInt8Conv2D")
+                     .Input(FakeInput(input_type))
+                     .Input(FakeInput(DT_QINT8))
+                     .Input(FakeInput(DT_FLOAT))
+                     .Input(FakeInput(DT_FLOAT))
+                     .Input(FakeInput(DT_FLOAT))
+                     .Input(FakeInput(DT_FLOAT))
+                     .Input(FakeInput(DT_FLOAT))
+                     .Input(FakeInput(DT_FLOAT))
+                     .Input(FakeInput(DT_FLOAT))
+                     .Attr("Toutput", output_type)
+                     .Attr("strides", {1, stride, stride, 1})
+                     .Attr("dilations", {1, dilation, dilation, 1})
+                     .Attr("padding", padding)
+                     .Finalize(node_def()));
+    TF_ASSERT_OK(InitOp());
+    AddInput(input_type, TensorShape({batch, rows, cols, in_depth}));
+    AddWeightsAndRanges(
+        TensorShape({filter_size, filter_size, in_depth, out_depth}),
+        out_depth);
+    TF_ASSERT_OK(RunOpKernel());
+
+    const int64 effective_size = (filter_size - 1) * dilation + 1;
+    int64 out_rows, out_cols, pad_rows, pad_cols;
+    if (padding == "SAME") {
+      out_rows = (rows + stride - 1) / stride;
+      out_cols = (cols + stride - 1) / stride;
+      pad_rows = std::max<int64>(
+                     (out_rows - 1) * stride + effective_size - rows, 0) /
+                 2;
+      pad_cols = std::max<int64>(
+                     (out_cols - 1) * stride + effective_size - cols, 0) /
+                 2;
+    } else {
+      out_rows = (rows - effective_size) / stride + 1;
+      out_cols = (cols - effective_size) / stride + 1;
+      pad_rows = 0;
+      pad_cols = 0;
+    }
+
+    Tensor expected(DT_FLOAT,
+                    TensorShape({batch, out_rows, out_cols, out_depth}));
+    auto expected_tensor = expected.tensor<float, 4>();
+    for (int64 b = 0; b < batch; ++b) {
+      for (int64 r = 0; r < out_rows; ++r) {
+        for (int64 c = 0; c < out_cols; ++c) {
+          for (int64 o = 0; o < out_depth; ++o) {
+            double sum = 0.25 * o - 0.5;
+            for (int64 fr = 0; fr < filter_size; ++fr) {
+              const int64 in_r = r * stride + fr * dilation - pad_rows;
+              if (in_r < 0 || in_r >= rows) continue;
+              for (int64 fc = 0; fc < filter_size; ++fc) {
+                const int64 in_c = c * stride + fc * dilation - pad_cols;
+                if (in_c < 0 || in_c >= cols) continue;
+                for (int64 i = 0; i < in_depth; ++i) {
+                  const int64 input_index =
+                      ((b * rows + in_r) * cols + in_c) * in_depth + i;
+                  const int64 filter_index =
+                      ((fr * filter_size + fc) * in_depth + i) * out_depth + o;
+                  sum += RealInput(QuantizedInput(input_index)) *
+                         QuantizedWeight(filter_index) * WeightScale(o);
+                }
+              }
+            }
+            expected_tensor(b, r, c, o) = sum;
+          }
+        }
+      }
+    }
+    ExpectOutput(output_type, expected);
+  }
+};
+
+TEST_F(QuantizedInt8Conv2DTest, SamePadding) {
+  VerifyConv2D(DT_FLOAT, DT_FLOAT, "SAME", 1, 1, 2, 5, 4, 3, 3, 4);
+}
+
+TEST_F(QuantizedInt8Conv2DTest, ValidPaddingWithStrides) {
+  VerifyConv2D(DT_QINT8, DT_FLOAT, "VALID", 2, 1, 1, 7, 6, 2, 3, 5);
+}
+
+TEST_F(QuantizedInt8Conv2DTest, SamePaddingWithStridesAndDilations) {
+  VerifyConv2D(DT_FLOAT, DT_FLOAT, "SAME", 2, 2, 1, 8, 7, 3, 3, 2);
+}
+
+TEST_F(QuantizedInt8Conv2DTest, OneByOne) {
+  VerifyConv2D(DT_FLOAT, DT_FLOAT, "VALID", 1, 1, 2, 3, 3, 16, 1, 8);
+}
+
+TEST_F(QuantizedInt8Conv2DTest, Int8Output) {
+  VerifyConv2D(DT_FLOAT, DT_QINT8, "SAME", 1, 1, 1, 4, 4, 2, 3, 3);
+}
+
+// Benchmarks of the int8 kernels, with float activations and outputs as the
+// fake_quant_to_int8 rewrite produces them, and of the float contractions
+// followed by a BiasAdd that they replace.
+static Node* RandomFloatConstant(Graph* g, const TensorShape& shape) {
+  Tensor tensor(DT_FLOAT, shape);
+  tensor.flat<float>().setRandom();
+  return test::graph::Constant(g, tensor);
+}
+
+static Node* ScalarConstant(Graph* g, float value) {
+  return test::graph::Constant(g, test::AsScalar<float>(value));
+}
+
+// A graph running `op` ("MatMul" or "Conv2D") on `input_shape` activations
+// and `weights_shape` weights with `num_channels` output channels, in int8 if
+// `int8`.
+static Graph* ContractionGraph(const string& op, bool int8,
+                               const TensorShape& input_shape,
+                               const TensorShape& weights_shape,
+                               int64 num_channels) {
+  Graph* g = new Graph(OpRegistry::Global());
+  Node* input = RandomFloatConstant(g, input_shape);
+  Node* bias = RandomFloatConstant(g, TensorShape({num_channels}));
+  NodeBuilder builder(g->NewName("n"), int8 ? "_QuantizedInt8" + op : op);
+  if (int8) {
+    Tensor weights(DT_QINT8, weights_shape);
+    auto weights_flat = weights.flat<qint8>();
+    for (int64 i = 0; i < weights.NumElements(); ++i) {
+      weights_flat(i) = QuantizedWeight(i);
+    }
+    builder.Input(input)
+        .Input(test::graph::Constant(g, weights))
+        .Input(bias)
+        .Input(ScalarConstant(g, kMinInput))
+        .Input(ScalarConstant(g, kMaxInput))
+        .Input(ScalarConstant(g, -1.0f))
+        .Input(ScalarConstant(g, 1.0f))
+        .Input(ScalarConstant(g, kMinOutput))
+        .Input(ScalarConstant(g, kMaxOutput));
+  } else {
+    builder.Input(input).Input(RandomFloatConstant(g, weights_shape));
+  }
+  if (op == "Conv2D") {
+    builder.Attr("strides", {1, 1, 1, 1}).Attr("padding", "SAME");
+  }
+  Node* contraction;
+  TF_CHECK_OK(builder.Finalize(g, &contraction));
+  if (!int8) {
+    TF_CHECK_OK(NodeBuilder(g->NewName("n"), "BiasAdd")
+                    .Input(contraction)
+                    .Input(bias)
+                    .Finalize(g, nullptr));
+  }
+  return g;
+}
+
+#define BM_MatMulInt8VsFloat(M, K, N)                                          \
+  static void BM_MatMul_Float_##M##_##K##_##N(int iters) {                     \
+    testing::ItemsProcessed(static_cast<int64>(iters) * M * K * N * 2);        \
+    test::Benchmark("cpu", ContractionGraph("MatMul", false,                   \
+                                            TensorShape({M, K}),               \
+                                            TensorShape({K, N}), N))           \
+        .Run(iters);                                                           \
+  }                                                                            \
+  BENCHMARK(BM_MatMul_Float_##M##_##K##_##N);                                  \
+  static void BM_MatMul_Int8_##M##_##K##_##N(int iters) {                      \
+    testing::ItemsProcessed(static_cast<int64>(iters) * M * K * N * 2);        \
+    test::Benchmark("cpu", ContractionGraph("MatMul", true,                    \
+                                            TensorShape({M, K}),               \
+                                            TensorShape({K, N}), N))           \
+        .Run(iters);                                                           \
+  }                                                                            \
+  BENCHMARK(BM_MatMul_Int8_##M##_##K##_##N);
+
+BM_MatMulInt8VsFloat(1, 1024, 1024);
+BM_MatMulInt8VsFloat(128, 512, 512);
+BM_MatMulInt8VsFloat(512, 1024, 1024);
+
+#define BM_Conv2DInt8VsFloat(B, S, D_IN, F, D_OUT)                             \
+  static void BM_Conv2D_Float_##B##_##S##_##D_IN##_##F##_##D_OUT(int iters) {  \
+    testing::ItemsProcessed(static_cast<int64>(iters) * B * S * S * F * F *    \
+                            D_IN * D_OUT * 2);                                 \
+    test::Benchmark("cpu", ContractionGraph(                                   \
+                               "Conv2D", false, TensorShape({B, S, S, D_IN}),  \
+                               TensorShape({F, F, D_IN, D_OUT}), D_OUT))       \
+        .Run(iters);                                                           \
+  }                                                                            \
+  BENCHMARK(BM_Conv2D_Float_##B##_##S##_##D_IN##_##F##_##D_OUT);               \
+  static void BM_Conv2D_Int8_##B##_##S##_##D_IN##_##F##_##D_OUT(int iters) {   \
+    testing::ItemsProcessed(static_cast<int64>(iters) * B * S * S * F * F *    \
+                            D_IN * D_OUT * 2);                                 \
+    test::Benchmark("cpu", ContractionGraph(                                   \
+                               "Conv2D", true, TensorShape({B, S, S, D_IN}),   \
+                               TensorShape({F, F, D_IN, D_OUT}), D_OUT))       \
+        .Run(iters);                                                           \
+  }                                                                            \
+  BENCHMARK(BM_Conv2D_Int8_##B##_##S##_##D_IN##_##F##_##D_OUT);
+
+BM_Conv2DInt8VsFloat(8, 28, 64, 3, 64);
+BM_Conv2DInt8VsFloat(8, 14, 256, 1, 256);
+
+}  // namespace
+}  // namespace tensorflow
@@ -39,6 +39,7 @@ limitations under the License.
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/types.h"
 #include "tensorflow/core/util/util.h"
+#include "tensorflow/core/util/work_sharder.h"
 
 #if GOOGLE_CUDA || TENSORFLOW_USE_ROCM
 #include "tensorflow/core/common_runtime/gpu/gpu_event_mgr.h"
@@ -123,34 +124,83 @@ class SegmentReductionOp : public OpKernel {
                 errors::InvalidArgument("segment ids must be >= 0"));
     auto output_flat = output->flat_outer_dims<T>();
 
+    // Validate all segment ids up front so that the reduction below can be
+    // sharded across threads without having to report errors from workers.
+    Index prev_index = internal::SubtleMustCopy(segment_vec(0));
+    for (int64 i = 1; i < num_indices; ++i) {
+      const Index next_index = internal::SubtleMustCopy(segment_vec(i));
+      if (prev_index == next_index) continue;
+      OP_REQUIRES(context, prev_index < next_index,
+                  errors::InvalidArgument("segment ids are not increasing"));
+      OP_REQUIRES(
+          context, FastBoundsCheck(prev_index, output_rows),
+          errors::InvalidArgument(
+              "Segment id ", prev_index, " out of range [0, ", output_rows,
+              "), possibly because 'segment_ids' input is not sorted."));
+      prev_index = next_index;
+    }
+    OP_REQUIRES(context, FastBoundsCheck(prev_index, output_rows),
+                errors::InvalidArgument(
+                    "Segment id ", prev_index, " out of range [0, ",
+                    output_rows,
+                    "), possibly because 'segment_ids' input is not sorted."));
+
+    // Each shard [begin, end) of input rows is widened so that it starts and
+    // ends on a segment boundary. Every segment, and the gap of missing ids
+    // preceding it, is therefore owned by exactly one shard.
+    auto work = [&input_flat, &segment_vec, &output_flat, num_indices, num_col](
+                    int64 begin, int64 end) {
+      while (begin > 0 && begin < num_indices &&
+             segment_vec(begin) == segment_vec(begin - 1)) {
+        ++begin;
+      }
+      while (end < num_indices && segment_vec(end) == segment_vec(end - 1)) {
+        ++end;
+      }
+      if (begin >= end) return;
+      ReduceSegmentRange(input_flat, segment_vec, num_col, begin, end,
+                         begin == 0 ? 0 : segment_vec(begin - 1) + 1,
+                         &output_flat);
+    };
+    // Roughly one load and one reduction step per input element.
+    const int64 cost_per_unit = 2 * num_col;
+    const DeviceBase::CpuWorkerThreads& worker_threads =
+        *context->device()->tensorflow_cpu_worker_threads();
+    Shard(worker_threads.num_threads, worker_threads.workers, num_indices,
+          cost_per_unit, work);
+  }
+
+ private:
+  // Reduces the input rows [start, end) into their output segments. The range
+  // must start and end on segment boundaries, and segment ids must already
+  // have been validated. Output rows in [uninitialized_index, first segment)
+  // are set to the default value.
+  static void ReduceSegmentRange(
+      typename TTypes<T, 2>::ConstTensor input_flat,
+      typename TTypes<Index>::ConstVec segment_vec, int64 num_col, Index start,
+      Index limit, Index uninitialized_index,
+      typename TTypes<T, 2>::Tensor* output_flat) {
 #if !defined(EIGEN_HAS_INDEX_LIST)
     Eigen::DSizes<Eigen::DenseIndex, 1> dims_to_reduce;
     dims_to_reduce[0] = 0;
 #else
     Eigen::IndexList<Eigen::type2index<0> > dims_to_reduce;
 #endif
-    Index start = 0, end = 1;
-
-    Index uninitialized_index = 0;  // Index from which the output is not set.
-    Index out_index = internal::SubtleMustCopy(segment_vec(start));
+    Index end = start + 1;
+    Index out_index = segment_vec(start);
 
-    // TODO(agarwal): if this loop becomes a bottleneck, consider sharding it
-    // across threads.
     Eigen::DSizes<Eigen::DenseIndex, 1> out_slice_shape(num_col);
-    while (end <= num_indices) {
+    while (end <= limit) {
       // We initialize next_index to 0 to avoid "warning: 'next_index' may be
       // used uninitialized in this function" in the Mac build (since the
       // compiler isn't smart enough to realize the code is safe).
       Index next_index = 0;
-      if (end < num_indices) {
-        next_index = internal::SubtleMustCopy(segment_vec(end));
+      if (end < limit) {
+        next_index = segment_vec(end);
         if (out_index == next_index) {
           ++end;
           continue;
         }
-        // We have a new segment here.  Verify that the segment ids are growing.
-        OP_REQUIRES(context, out_index < next_index,
-                    errors::InvalidArgument("segment ids are not increasing"));
       }
 
       // Process segment [start, end)
@@ -159,28 +209,24 @@ class SegmentReductionOp : public OpKernel {
                                Eigen::Unaligned>
           OutT;
 
-      OP_REQUIRES(
-          context, FastBoundsCheck(out_index, output_rows),
-          errors::InvalidArgument(
-              "Segment id ", out_index, " out of range [0, ", output_rows,
-              "), possibly because 'segment_ids' input is not sorted."));
-
       // If there is a gap between two indices, we need to set that gap to the
       // default value.
       if (out_index > uninitialized_index) {
         Eigen::DSizes<Eigen::DenseIndex, 2> gap_slice_shape(
             out_index - uninitialized_index, num_col);
         Eigen::TensorMap<Eigen::Tensor<T, 2, Eigen::RowMajor>, Eigen::Unaligned>
-            gap_slice(&output_flat(uninitialized_index, 0), gap_slice_shape);
+            gap_slice(&(*output_flat)(uninitialized_index, 0),
+                      gap_slice_shape);
         gap_slice.setConstant(T(default_value));
       }
 
-      T* out_slice_ptr = &output_flat(out_index, 0);
+      T* out_slice_ptr = &(*output_flat)(out_index, 0);
       OutT out_slice(out_slice_ptr, out_slice_shape);
       // We don't use out_slice.device(context->eigen_device<Device>)
       // because these pieces of work are likely to be very small and
       // the context switching overhead dwarfs any benefit we get from
-      // using another thread to do this work.
+      // using another thread to do this work. Parallelism comes from
+      // sharding whole segments across threads instead.
       if (start == end - 1) {
         typedef Eigen::TensorMap<Eigen::Tensor<const T, 1, Eigen::RowMajor>,
                                  Eigen::Unaligned>
@@ -197,7 +243,7 @@ class SegmentReductionOp : public OpKernel {
 
         out_slice = in_slice.reduce(dims_to_reduce, Reducer());
       }
-      if (end >= num_indices) break;
+      if (end >= limit) break;
       start = end;
       ++end;
       uninitialized_index = out_index + 1;
@@ -378,6 +424,16 @@ TF_CALL_GPU_NUMBER_TYPES(REGISTER_GPU_SORTED_KERNELS_ALL);
 namespace functor {
 
 // The ReductionFunctor implementation for CPU.
+//
+// Small inputs are reduced serially. Larger inputs are reduced in parallel
+// with segment ownership: the valid input rows are counting-sorted by segment
+// id, and contiguous ranges of the sorted rows, widened to segment
+// boundaries, are handed out to threads. Every output row is thus written by
+// a single thread, which needs no per-thread accumulators, and the rows of a
+// segment are reduced in their original order so the result is identical to
+// the serial one. Sharding by input rows rather than by segments keeps the
+// load balanced under skewed id distributions, except that one very hot
+// segment is still reduced by a single thread.
 template <typename T, typename Index, typename InitialValueF,
           typename ReductionF>
 struct UnsortedSegmentFunctor<CPUDevice, T, Index, InitialValueF, ReductionF> {
@@ -391,9 +447,34 @@ struct UnsortedSegmentFunctor<CPUDevice, T, Index, InitialValueF, ReductionF> {
     }
     const int64 N = segment_ids.dimension(0);
     const int64 num_segments = output.dimension(0);
+    const int64 num_col = data.dimension(1);
+    // Roughly one load and one reduction step per input element.
+    const int64 cost_per_unit = 2 * num_col;
+    const DeviceBase::CpuWorkerThreads& worker_threads =
+        *ctx->device()->tensorflow_cpu_worker_threads();
     ReductionF reduction;
+    if (worker_threads.num_threads <= 1 ||
+        N * cost_per_unit < kMinParallelCost) {
+      for (int64 i = 0; i < N; ++i) {
+        Index j = internal::SubtleMustCopy(segment_ids(i));
+        if (j < 0) {
+          continue;
+        }
+        OP_REQUIRES(ctx, FastBoundsCheck(j, num_segments),
+                    errors::InvalidArgument(
+                        "segment_ids", SliceDebugString(segment_ids_shape, i),
+                        " = ", j, " is out of range [0, ", num_segments, ")"));
+        reduction(data.template chip<0>(i), output.template chip<0>(j));
+      }
+      return;
+    }
+
+    // Copy and validate the segment ids, and count the rows of each segment.
+    std::vector<Index> ids(N);
+    std::vector<int64> segment_starts(num_segments + 1, 0);
     for (int64 i = 0; i < N; ++i) {
       Index j = internal::SubtleMustCopy(segment_ids(i));
+      ids[i] = j;
       if (j < 0) {
         continue;
       }
@@ -401,9 +482,51 @@ struct UnsortedSegmentFunctor<CPUDevice, T, Index, InitialValueF, ReductionF> {
                   errors::InvalidArgument(
                       "segment_ids", SliceDebugString(segment_ids_shape, i),
                       " = ", j, " is out of range [0, ", num_segments, ")"));
-      reduction(data.template chip<0>(i), output.template chip<0>(j));
+      ++segment_starts[j + 1];
+    }
+    for (int64 j = 0; j < num_segments; ++j) {
+      segment_starts[j + 1] += segment_starts[j];
+    }
+    const int64 num_valid = segment_starts[num_segments];
+    if (num_valid == 0) {
+      return;
     }
+
+    // Stable counting sort of the valid input rows by segment id.
+    std::vector<int64> sorted_rows(num_valid);
+    {
+      std::vector<int64> cursor(segment_starts.begin(),
+                                segment_starts.end() - 1);
+      for (int64 i = 0; i < N; ++i) {
+        if (ids[i] >= 0) {
+          sorted_rows[cursor[ids[i]]++] = i;
+        }
+      }
+    }
+
+    auto work = [&ids, &sorted_rows, &data, &output, &reduction, num_valid](
+                    int64 begin, int64 end) {
+      auto segment_of = [&](int64 pos) { return ids[sorted_rows[pos]]; };
+      while (begin > 0 && begin < num_valid &&
+             segment_of(begin) == segment_of(begin - 1)) {
+        ++begin;
+      }
+      while (end < num_valid && segment_of(end) == segment_of(end - 1)) {
+        ++end;
+      }
+      for (int64 pos = begin; pos < end; ++pos) {
+        const int64 i = sorted_rows[pos];
+        reduction(data.template chip<0>(i), output.template chip<0>(ids[i]));
+      }
+    };
+    Shard(worker_threads.num_threads, worker_threads.workers, num_valid,
+          cost_per_unit, work);
   }
+
+ private:
+  // Below this many cost units the counting sort and the thread hand-off cost
+  // more than they save.
+  static constexpr int64 kMinParallelCost = 1 << 16;
 };
 
 template <typename T>
@@ -630,27 +753,35 @@ TF_CALL_complex128(REGISTER_SUM_GPU_UNSORTED_KERNELS_ALL);
 // Same as SegmentReductionOp but takes as input a "sparse" tensor, represented
 // by two dense tensors, one containing the data, and the other containing
 // indices into the data.
+//
+// With `has_gather_indices` the op implements GatherV2 fused with the
+// reduction: it takes an extra `gather_indices` input after the data, and
+// `indices` select entries of `gather_indices`, which in turn select rows of
+// the data.
 template <typename Device, class T>
 class SparseSegmentReductionOpBase : public OpKernel {
  public:
   explicit SparseSegmentReductionOpBase(OpKernelConstruction* context,
                                         bool is_mean, bool is_sqrtn,
-                                        bool has_num_segments, T default_value)
+                                        bool has_num_segments, T default_value,
+                                        bool has_gather_indices = false)
       : OpKernel(context),
         dtidx_(DataTypeToEnum<Index>::v()),
         is_mean_(is_mean),
         is_sqrtn_(is_sqrtn),
         has_num_segments_(has_num_segments),
+        has_gather_indices_(has_gather_indices),
         default_value_(default_value) {}
 
   void Compute(OpKernelContext* context) override {
+    const int input_offset = has_gather_indices_ ? 1 : 0;
     const Tensor& input = context->input(0);
-    const Tensor& indices = context->input(1);
-    const Tensor& segment_ids = context->input(2);
+    const Tensor& indices = context->input(1 + input_offset);
+    const Tensor& segment_ids = context->input(2 + input_offset);
 
     Index output_rows = -1;
     if (has_num_segments_) {
-      const Tensor& num_segments = context->input(3);
+      const Tensor& num_segments = context->input(3 + input_offset);
 
       OP_REQUIRES(
           context, num_segments.shape().dims() == 0,
@@ -673,7 +804,41 @@ class SparseSegmentReductionOpBase : public OpKernel {
 
     auto input_flat = input.flat_outer_dims<T>();
     const int64 num_col = input_flat.dimension(1);
-    const auto indices_vec = indices.vec<Index>();
+    // For the fused gather, rows of the data are looked up through the gather
+    // indices. The composed row indices are materialized, which costs one
+    // integer per index instead of one gathered row per index. They are kept
+    // as int32 unless the data has more rows than int32 can address.
+    Tensor composed_indices;
+    if (has_gather_indices_) {
+      const Tensor& gather_indices = context->input(1);
+      OP_REQUIRES(
+          context, TensorShapeUtils::IsVector(gather_indices.shape()),
+          errors::InvalidArgument("gather_indices should be a vector."));
+      const int64 num_rows = input_flat.dimension(0);
+      const DataType composed_dtype =
+          num_rows <= kint32max ? DT_INT32 : DT_INT64;
+      OP_REQUIRES_OK(context,
+                     context->allocate_temp(composed_dtype, indices.shape(),
+                                            &composed_indices));
+      if (gather_indices.dtype() == DT_INT32) {
+        OP_REQUIRES_OK(context, ComposeGatherIndices<int32>(
+                                    gather_indices, indices, num_rows,
+                                    &composed_indices));
+      } else {
+        OP_REQUIRES_OK(context, ComposeGatherIndices<int64>(
+                                    gather_indices, indices, num_rows,
+                                    &composed_indices));
+      }
+    }
+    const Tensor& row_indices =
+        has_gather_indices_ ? composed_indices : indices;
+    const bool wide_rows = row_indices.dtype() == DT_INT64;
+    const auto indices_vec = wide_rows
+                                 ? typename TTypes<Index>::ConstVec(nullptr, 0)
+                                 : row_indices.vec<Index>();
+    const auto wide_indices_vec =
+        wide_rows ? row_indices.vec<int64>()
+                  : typename TTypes<int64>::ConstVec(nullptr, 0);
     typedef int32 OutputRow;
     const auto segment_vec = segment_ids.vec<OutputRow>();
     // Note that the current implementation assumes that segment_vec values are
@@ -757,11 +922,15 @@ class SparseSegmentReductionOpBase : public OpKernel {
 
       auto out = output_flat.template chip<0>(out_index);
       const int bad_offset =
-          Reduce(input_flat, indices_vec, start, end - start, out);
+          wide_rows ? Reduce<int64>(input_flat, wide_indices_vec, start,
+                                    end - start, out)
+                    : Reduce<Index>(input_flat, indices_vec, start,
+                                    end - start, out);
       OP_REQUIRES(context, bad_offset < 0,
                   errors::InvalidArgument(
-                      "Bad: indices[", start + bad_offset,
-                      "] == ", indices_vec(start + bad_offset),
+                      "Bad: indices[", start + bad_offset, "] == ",
+                      wide_rows ? wide_indices_vec(start + bad_offset)
+                                : indices_vec(start + bad_offset),
                       " out of range [0, ", input_flat.dimension(0), ")"));
 
       start = end;
@@ -785,8 +954,47 @@ class SparseSegmentReductionOpBase : public OpKernel {
   const DataType dtidx_;
   typedef int32 Index;
 
+  // Sets composed(i) = gather_indices(indices(i)), checking both levels of
+  // indirection. `composed` is int32 or int64, as chosen by the caller.
+  template <typename Tgather>
+  static Status ComposeGatherIndices(const Tensor& gather_indices,
+                                     const Tensor& indices, int64 num_rows,
+                                     Tensor* composed) {
+    if (composed->dtype() == DT_INT64) {
+      return ComposeGatherIndicesAs<Tgather, int64>(gather_indices, indices,
+                                                    num_rows, composed);
+    }
+    return ComposeGatherIndicesAs<Tgather, Index>(gather_indices, indices,
+                                                  num_rows, composed);
+  }
+
+  template <typename Tgather, typename Tcomposed>
+  static Status ComposeGatherIndicesAs(const Tensor& gather_indices,
+                                       const Tensor& indices, int64 num_rows,
+                                       Tensor* composed) {
+    const auto gather_vec = gather_indices.vec<Tgather>();
+    const auto indices_vec = indices.vec<Index>();
+    auto composed_vec = composed->vec<Tcomposed>();
+    const int64 num_gather = gather_vec.size();
+    for (int64 i = 0; i < indices_vec.size(); ++i) {
+      const Index index = internal::SubtleMustCopy(indices_vec(i));
+      if (!FastBoundsCheck(index, num_gather)) {
+        return errors::InvalidArgument("indices[", i, "] == ", index,
+                                       " out of range [0, ", num_gather, ")");
+      }
+      const Tgather row = internal::SubtleMustCopy(gather_vec(index));
+      if (!FastBoundsCheck(row, num_rows)) {
+        return errors::InvalidArgument("gather_indices[", index, "] == ", row,
+                                       " out of range [0, ", num_rows, ")");
+      }
+      composed_vec(i) = static_cast<Tcomposed>(row);
+    }
+    return Status::OK();
+  }
+
+  template <typename Tidx>
   int64 Reduce(const typename TTypes<T>::ConstMatrix& input_flat,
-               const typename TTypes<Index>::ConstVec& indices_vec, int64 start,
+               const typename TTypes<Tidx>::ConstVec& indices_vec, int64 start,
                int64 num,
                Eigen::TensorChippingOp<0, typename TTypes<T>::Matrix> out) {
 #define INDEX(n, i)                               \
@@ -915,6 +1123,7 @@ class SparseSegmentReductionOpBase : public OpKernel {
   const bool is_mean_;
   const bool is_sqrtn_;
   const bool has_num_segments_;
+  const bool has_gather_indices_;
   const T default_value_;
 };
 
@@ -981,6 +1190,39 @@ class SparseSegmentReductionSumWithNumSegmentsOp
             true /* has_num_segments */, T(0) /* default_value */) {}
 };
 
+template <typename Device, class T>
+class FusedSparseSegmentReductionSumOp
+    : public SparseSegmentReductionOpBase<Device, T> {
+ public:
+  explicit FusedSparseSegmentReductionSumOp(OpKernelConstruction* context)
+      : SparseSegmentReductionOpBase<Device, T>(
+            context, false /*is_mean*/, false /*is_sqrtn*/,
+            false /* has_num_segments */, T(0) /* default_value */,
+            true /* has_gather_indices */) {}
+};
+
+template <typename Device, class T>
+class FusedSparseSegmentReductionMeanOp
+    : public SparseSegmentReductionOpBase<Device, T> {
+ public:
+  explicit FusedSparseSegmentReductionMeanOp(OpKernelConstruction* context)
+      : SparseSegmentReductionOpBase<Device, T>(
+            context, true /*is_mean*/, false /*is_sqrtn*/,
+            false /* has_num_segments */, T(0) /* default_value */,
+            true /* has_gather_indices */) {}
+};
+
+template <typename Device, class T>
+class FusedSparseSegmentReductionSqrtNOp
+    : public SparseSegmentReductionOpBase<Device, T> {
+ public:
+  explicit FusedSparseSegmentReductionSqrtNOp(OpKernelConstruction* context)
+      : SparseSegmentReductionOpBase<Device, T>(
+            context, false /*is_mean*/, true /*is_sqrtn*/,
+            false /* has_num_segments */, T(0) /* default_value */,
+            true /* has_gather_indices */) {}
+};
+
 #define REGISTER_CPU_SPARSE_KERNELS(type)                                \
   REGISTER_KERNEL_BUILDER(Name("SparseSegmentSum")                       \
                               .Device(DEVICE_CPU)                        \
@@ -1028,11 +1270,36 @@ REGISTER_CPU_SPARSE_KERNELS(float);
 REGISTER_CPU_SPARSE_KERNELS(double);
 #undef REGISTER_CPU_SPARSE_KERNELS
 
+#define REGISTER_CPU_SPARSE_KERNELS(type)                                      \
+  REGISTER_KERNEL_BUILDER(Name("_FusedSparseSegmentSum")                       \
+                              .Device(DEVICE_CPU)                              \
+                              .TypeConstraint<type>("T")                       \
+                              .TypeConstraint<int32>("Tidx"),                  \
+                          FusedSparseSegmentReductionSumOp<CPUDevice, type>);  \
+  REGISTER_KERNEL_BUILDER(Name("_FusedSparseSegmentMean")                      \
+                              .Device(DEVICE_CPU)                              \
+                              .TypeConstraint<type>("T")                       \
+                              .TypeConstraint<int32>("Tidx"),                  \
+                          FusedSparseSegmentReductionMeanOp<CPUDevice, type>); \
+  REGISTER_KERNEL_BUILDER(Name("_FusedSparseSegmentSqrtN")                     \
+                              .Device(DEVICE_CPU)                              \
+                              .TypeConstraint<type>("T")                       \
+                              .TypeConstraint<int32>("Tidx"),                  \
+                          FusedSparseSegmentReductionSqrtNOp<CPUDevice, type>);
+REGISTER_CPU_SPARSE_KERNELS(float);
+REGISTER_CPU_SPARSE_KERNELS(double);
+#undef REGISTER_CPU_SPARSE_KERNELS
+
+// Computes the gradient of SparseSegment{Mean,SqrtN} with respect to the
+// data, or with `is_sum` the gradient of SparseSegmentSum fused with the
+// GatherV2 + UnsortedSegmentSum it is normally expressed with. In the latter
+// case negative indices are skipped, as UnsortedSegmentSum would.
 template <class T>
 class SparseSegmentGradOpBase : public OpKernel {
  public:
-  explicit SparseSegmentGradOpBase(OpKernelConstruction* context, bool is_sqrtn)
-      : OpKernel(context), is_sqrtn_(is_sqrtn) {}
+  explicit SparseSegmentGradOpBase(OpKernelConstruction* context, bool is_sqrtn,
+                                   bool is_sum)
+      : OpKernel(context), is_sqrtn_(is_sqrtn), is_sum_(is_sum) {}
 
   void Compute(OpKernelContext* context) override {
     const Tensor& input = context->input(0);
@@ -1064,7 +1331,11 @@ class SparseSegmentGradOpBase : public OpKernel {
     OP_REQUIRES_OK(context, output_shape.SetDimWithStatus(0, M));
     Tensor* output = nullptr;
     OP_REQUIRES_OK(context, context->allocate_output(0, output_shape, &output));
-    if (M == 0 || N == 0) return;
+    if (M == 0) return;
+    if (N == 0) {
+      output->flat<T>().setZero();
+      return;
+    }
 
     // Note that similar to SparseSegmentMean, we assume that segment_vec is
     // already sorted and has non-negative values.
@@ -1085,7 +1356,9 @@ class SparseSegmentGradOpBase : public OpKernel {
       scaling[idx] += 1;
     }
     for (size_t i = 0; i < scaling.size(); ++i) {
-      if (is_sqrtn_) {
+      if (is_sum_) {
+        scaling[i] = 1.0;
+      } else if (is_sqrtn_) {
         scaling[i] = 1.0 / sqrt(std::max(scaling[i], 1.0));
       } else {
         scaling[i] = 1.0 / std::max(scaling[i], 1.0);
@@ -1098,6 +1371,9 @@ class SparseSegmentGradOpBase : public OpKernel {
 
     for (int64 i = 0; i < N; ++i) {
       const Index output_idx = internal::SubtleMustCopy(indices_vec(i));
+      if (is_sum_ && output_idx < 0) {
+        continue;
+      }
       OP_REQUIRES(context, FastBoundsCheck(output_idx, M),
                   errors::InvalidArgument("Index ", output_idx,
                                           " out of range [0, ", M, ")."));
@@ -1132,20 +1408,31 @@ class SparseSegmentGradOpBase : public OpKernel {
 
  private:
   const bool is_sqrtn_;
+  const bool is_sum_;
 };
 
 template <class T>
 class SparseSegmentMeanGradOp : public SparseSegmentGradOpBase<T> {
  public:
   explicit SparseSegmentMeanGradOp(OpKernelConstruction* context)
-      : SparseSegmentGradOpBase<T>(context, false /*is_sqrtn*/) {}
+      : SparseSegmentGradOpBase<T>(context, false /*is_sqrtn*/,
+                                   false /*is_sum*/) {}
 };
 
 template <class T>
 class SparseSegmentSqrtNGradOp : public SparseSegmentGradOpBase<T> {
  public:
   explicit SparseSegmentSqrtNGradOp(OpKernelConstruction* context)
-      : SparseSegmentGradOpBase<T>(context, true /*is_sqrtn*/) {}
+      : SparseSegmentGradOpBase<T>(context, true /*is_sqrtn*/,
+                                   false /*is_sum*/) {}
+};
+
+template <class T>
+class FusedSparseSegmentSumGradOp : public SparseSegmentGradOpBase<T> {
+ public:
+  explicit FusedSparseSegmentSumGradOp(OpKernelConstruction* context)
+      : SparseSegmentGradOpBase<T>(context, false /*is_sqrtn*/,
+                                   true /*is_sum*/) {}
 };
 
 #define REGISTER_CPU_SPARSE_KERNELS(type)                     \
@@ -1167,4 +1454,14 @@ REGISTER_CPU_SPARSE_KERNELS(double);
 REGISTER_CPU_SPARSE_KERNELS(float);
 REGISTER_CPU_SPARSE_KERNELS(double);
 #undef REGISTER_CPU_SPARSE_KERNELS
+
+#define REGISTER_CPU_SPARSE_KERNELS(type)                     \
+  REGISTER_KERNEL_BUILDER(Name("_FusedSparseSegmentSumGrad")  \
+                              .Device(DEVICE_CPU)             \
+                              .TypeConstraint<type>("T")      \
+                              .TypeConstraint<int32>("Tidx"), \
+                          FusedSparseSegmentSumGradOp<type>);
+REGISTER_CPU_SPARSE_KERNELS(float);
+REGISTER_CPU_SPARSE_KERNELS(double);
+#undef REGISTER_CPU_SPARSE_KERNELS
 }  // namespace tensorflow
@@ -13,9 +13,11 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
+#include <algorithm>
 #include <functional>
 #include <vector>
 
+#include "absl/strings/match.h"
 #include "tensorflow/core/common_runtime/device.h"
 #include "tensorflow/core/common_runtime/device_factory.h"
 #include "tensorflow/core/common_runtime/kernel_benchmark_testlib.h"
@@ -31,6 +33,7 @@ limitations under the License.
 #include "tensorflow/core/graph/testlib.h"
 #include "tensorflow/core/kernels/ops_testutil.h"
 #include "tensorflow/core/kernels/ops_util.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/platform/test.h"
 #include "tensorflow/core/platform/test_benchmark.h"
 #include "tensorflow/core/public/session_options.h"
@@ -38,6 +41,177 @@ limitations under the License.
 
 namespace tensorflow {
 
+// Returns a segment id in [0, num_segments) for row `i`. With `skewed` set,
+// ids follow a power law so a few segments receive most of the rows, as is
+// typical for embedding gradients.
+static int32 SegmentIdForRow(int64 i, int32 num_segments, bool skewed) {
+  const double u = static_cast<double>((i * 2654435761LL) % 1000003) / 1000003;
+  const double v = skewed ? u * u * u * u : u;
+  return std::min(static_cast<int32>(v * num_segments), num_segments - 1);
+}
+
+class SegmentReductionOpTest : public OpsTestBase {};
+
+// Large enough to take the sharded path; the expected values are computed
+// serially in the same order as the kernel, so results must match exactly.
+TEST_F(SegmentReductionOpTest, SegmentSumSharded) {
+  TF_ASSERT_OK(NodeDefBuilder("segment_sum", "SegmentSum")
+                   .Input(FakeInput(DT_FLOAT))
+                   .Input(FakeInput(DT_INT32))
+                   .Finalize(node_def()));
+  TF_ASSERT_OK(InitOp());
+  const int kRows = 20000;
+  const int kCols = 16;
+  std::vector<float> data(kRows * kCols);
+  std::vector<int32> ids(kRows);
+  for (int i = 0; i < kRows; ++i) {
+    // Leave gaps between ids so missing segments must be zero-filled.
+    ids[i] = 3 * SegmentIdForRow(i, 500, /*skewed=*/true);
+    for (int c = 0; c < kCols; ++c) data[i * kCols + c] = (i + c) % 7;
+  }
+  std::sort(ids.begin(), ids.end());
+  AddInputFromArray<float>(TensorShape({kRows, kCols}), data);
+  AddInputFromArray<int32>(TensorShape({kRows}), ids);
+  TF_ASSERT_OK(RunOpKernel());
+
+  const int num_segments = ids.back() + 1;
+  Tensor expected(allocator(), DT_FLOAT, TensorShape({num_segments, kCols}));
+  auto expected_flat = expected.matrix<float>();
+  expected_flat.setZero();
+  for (int i = 0; i < kRows; ++i) {
+    for (int c = 0; c < kCols; ++c) {
+      expected_flat(ids[i], c) += data[i * kCols + c];
+    }
+  }
+  test::ExpectTensorEqual<float>(expected, *GetOutput(0));
+}
+
+TEST_F(SegmentReductionOpTest, SegmentSumNotIncreasing) {
+  TF_ASSERT_OK(NodeDefBuilder("segment_sum", "SegmentSum")
+                   .Input(FakeInput(DT_FLOAT))
+                   .Input(FakeInput(DT_INT32))
+                   .Finalize(node_def()));
+  TF_ASSERT_OK(InitOp());
+  AddInputFromArray<float>(TensorShape({4}), {1, 2, 3, 4});
+  AddInputFromArray<int32>(TensorShape({4}), {0, 2, 1, 3});
+  Status s = RunOpKernel();
+  EXPECT_TRUE(
+      absl::StrContains(s.ToString(), "segment ids are not increasing"))
+      << s;
+}
+
+TEST_F(SegmentReductionOpTest, UnsortedSegmentSumSharded) {
+  TF_ASSERT_OK(NodeDefBuilder("unsorted_segment_sum", "UnsortedSegmentSum")
+                   .Input(FakeInput(DT_FLOAT))
+                   .Input(FakeInput(DT_INT32))
+                   .Input(FakeInput(DT_INT32))
+                   .Finalize(node_def()));
+  TF_ASSERT_OK(InitOp());
+  const int kRows = 20000;
+  const int kCols = 16;
+  const int kSegments = 1000;
+  std::vector<float> data(kRows * kCols);
+  std::vector<int32> ids(kRows);
+  for (int i = 0; i < kRows; ++i) {
+    // Negative ids are dropped by the op.
+    ids[i] = i % 11 == 0 ? -1 : SegmentIdForRow(i, kSegments, /*skewed=*/true);
+    for (int c = 0; c < kCols; ++c) data[i * kCols + c] = 0.1f * ((i * c) % 13);
+  }
+  AddInputFromArray<float>(TensorShape({kRows, kCols}), data);
+  AddInputFromArray<int32>(TensorShape({kRows}), ids);
+  AddInputFromArray<int32>(TensorShape({}), {kSegments});
+  TF_ASSERT_OK(RunOpKernel());
+
+  Tensor expected(allocator(), DT_FLOAT, TensorShape({kSegments, kCols}));
+  auto expected_flat = expected.matrix<float>();
+  expected_flat.setZero();
+  for (int i = 0; i < kRows; ++i) {
+    if (ids[i] < 0) continue;
+    for (int c = 0; c < kCols; ++c) {
+      expected_flat(ids[i], c) += data[i * kCols + c];
+    }
+  }
+  test::ExpectTensorEqual<float>(expected, *GetOutput(0));
+}
+
+TEST_F(SegmentReductionOpTest, UnsortedSegmentSumOutOfRange) {
+  TF_ASSERT_OK(NodeDefBuilder("unsorted_segment_sum", "UnsortedSegmentSum")
+                   .Input(FakeInput(DT_FLOAT))
+                   .Input(FakeInput(DT_INT32))
+                   .Input(FakeInput(DT_INT32))
+                   .Finalize(node_def()));
+  TF_ASSERT_OK(InitOp());
+  const int kRows = 20000;
+  const int kCols = 16;
+  std::vector<int32> ids(kRows, 0);
+  ids[kRows - 1] = 10;
+  AddInputFromArray<float>(TensorShape({kRows, kCols}),
+                           std::vector<float>(kRows * kCols, 1.0f));
+  AddInputFromArray<int32>(TensorShape({kRows}), ids);
+  AddInputFromArray<int32>(TensorShape({}), {10});
+  Status s = RunOpKernel();
+  EXPECT_TRUE(absl::StrContains(s.ToString(), "is out of range [0, 10)")) << s;
+}
+
+TEST_F(SegmentReductionOpTest, FusedSparseSegmentMean) {
+  TF_ASSERT_OK(NodeDefBuilder("fused", "_FusedSparseSegmentMean")
+                   .Input(FakeInput(DT_FLOAT))
+                   .Input(FakeInput(DT_INT64))
+                   .Input(FakeInput(DT_INT32))
+                   .Input(FakeInput(DT_INT32))
+                   .Finalize(node_def()));
+  TF_ASSERT_OK(InitOp());
+  // params has 4 rows of 2 columns; the gathered rows are params[{3, 0, 2}].
+  AddInputFromArray<float>(TensorShape({4, 2}), {0, 1, 10, 11, 20, 21, 30, 31});
+  AddInputFromArray<int64>(TensorShape({3}), {3, 0, 2});
+  AddInputFromArray<int32>(TensorShape({4}), {0, 1, 0, 2});
+  AddInputFromArray<int32>(TensorShape({4}), {0, 0, 2, 2});
+  TF_ASSERT_OK(RunOpKernel());
+
+  Tensor expected(allocator(), DT_FLOAT, TensorShape({3, 2}));
+  test::FillValues<float>(&expected, {15, 16, 0, 0, 25, 26});
+  test::ExpectTensorNear<float>(expected, *GetOutput(0), 1e-5);
+}
+
+TEST_F(SegmentReductionOpTest, FusedSparseSegmentSumBadGatherIndex) {
+  TF_ASSERT_OK(NodeDefBuilder("fused", "_FusedSparseSegmentSum")
+                   .Input(FakeInput(DT_FLOAT))
+                   .Input(FakeInput(DT_INT32))
+                   .Input(FakeInput(DT_INT32))
+                   .Input(FakeInput(DT_INT32))
+                   .Finalize(node_def()));
+  TF_ASSERT_OK(InitOp());
+  AddInputFromArray<float>(TensorShape({2, 1}), {1, 2});
+  AddInputFromArray<int32>(TensorShape({2}), {1, 5});
+  AddInputFromArray<int32>(TensorShape({2}), {0, 1});
+  AddInputFromArray<int32>(TensorShape({2}), {0, 1});
+  Status s = RunOpKernel();
+  EXPECT_TRUE(absl::StrContains(s.ToString(),
+                                "gather_indices[1] == 5 out of range [0, 2)"))
+      << s;
+}
+
+TEST_F(SegmentReductionOpTest, FusedSparseSegmentSumGrad) {
+  TF_ASSERT_OK(NodeDefBuilder("fused_grad", "_FusedSparseSegmentSumGrad")
+                   .Input(FakeInput(DT_FLOAT))
+                   .Input(FakeInput(DT_INT32))
+                   .Input(FakeInput(DT_INT32))
+                   .Input(FakeInput(DT_INT32))
+                   .Finalize(node_def()));
+  TF_ASSERT_OK(InitOp());
+  // Equivalent to UnsortedSegmentSum(Gather(grad, segment_ids), indices, 3);
+  // the negative index is dropped.
+  AddInputFromArray<float>(TensorShape({2, 2}), {1, 2, 10, 20});
+  AddInputFromArray<int32>(TensorShape({4}), {0, 2, 0, -1});
+  AddInputFromArray<int32>(TensorShape({4}), {0, 0, 1, 1});
+  AddInputFromArray<int32>(TensorShape({}), {3});
+  TF_ASSERT_OK(RunOpKernel());
+
+  Tensor expected(allocator(), DT_FLOAT, TensorShape({3, 2}));
+  test::FillValues<float>(&expected, {11, 22, 0, 0, 1, 2});
+  test::ExpectTensorEqual<float>(expected, *GetOutput(0));
+}
+
 template <typename Index>
 static void BM_SegmentReduction(int iters, const string& reduction,
                                 Index num_rows, Index num_cols,
@@ -113,6 +287,119 @@ BM_Reduce_Arg(64, 32, 2);
 BM_Reduce_Arg(4096, 32, 2);
 BM_Reduce_Arg(4096, 128, 2);
 
+BM_Reduce_Arg(1048576, 64, 1);
+BM_Reduce_Arg(1048576, 64, 16);
+
+static void BM_UnsortedSegmentReduction(int iters, const string& reduction,
+                                        int64 num_rows, int64 num_cols,
+                                        int32 num_segments, bool skewed) {
+  testing::StopTiming();
+  Graph* g = new Graph(OpRegistry::Global());
+  Tensor data(DT_FLOAT, TensorShape({num_rows, num_cols}));
+  data.flat<float>().setRandom();
+  Tensor segment_ids(DT_INT32, TensorShape({num_rows}));
+  test::FillFn<int32>(&segment_ids, [num_segments, skewed](int i) -> int32 {
+    return SegmentIdForRow(i, num_segments, skewed);
+  });
+  Tensor num_segments_t(DT_INT32, TensorShape({}));
+  num_segments_t.scalar<int32>()() = num_segments;
+
+  Node* node;
+  TF_CHECK_OK(NodeBuilder(g->NewName("n"), reduction)
+                  .Input(test::graph::Constant(g, data))
+                  .Input(test::graph::Constant(g, segment_ids))
+                  .Input(test::graph::Constant(g, num_segments_t))
+                  .Attr("T", DT_FLOAT)
+                  .Finalize(g, &node));
+  testing::UseRealTime();
+  testing::BytesProcessed(static_cast<int64>(iters) * num_rows * num_cols *
+                          sizeof(float));
+  testing::StartTiming();
+  test::Benchmark("cpu", g).Run(iters);
+}
+
+#define BM_UnsortedReduce(O, R, C, S)                                      \
+  static void BM_##O##_##R##_##C##_##S##_uniform(int iters) {              \
+    BM_UnsortedSegmentReduction(iters, #O, R, C, S, /*skewed=*/false);     \
+  }                                                                        \
+  static void BM_##O##_##R##_##C##_##S##_skewed(int iters) {               \
+    BM_UnsortedSegmentReduction(iters, #O, R, C, S, /*skewed=*/true);      \
+  }                                                                        \
+  BENCHMARK(BM_##O##_##R##_##C##_##S##_uniform);                           \
+  BENCHMARK(BM_##O##_##R##_##C##_##S##_skewed);
+
+BM_UnsortedReduce(UnsortedSegmentSum, 4096, 128, 128);
+BM_UnsortedReduce(UnsortedSegmentSum, 1048576, 64, 100000);
+BM_UnsortedReduce(UnsortedSegmentSum, 1048576, 8, 1000000);
+BM_UnsortedReduce(UnsortedSegmentMax, 1048576, 64, 100000);
+
+// Compares GatherV2 + SparseSegmentSum, as emitted by embedding_lookup_sparse,
+// against the fused kernel that streams rows from the table.
+static void BM_EmbeddingLookupSparse(int iters, bool fused, int num_ids,
+                                     int dim) {
+  testing::StopTiming();
+  Graph* g = new Graph(OpRegistry::Global());
+  const int kVocab = 1 << 20;
+  const int kIdsPerSegment = 16;
+  Tensor params(DT_FLOAT, TensorShape({kVocab, dim}));
+  params.flat<float>().setRandom();
+  // Every id is distinct, as after Unique.
+  Tensor gather_indices(DT_INT32, TensorShape({num_ids}));
+  test::FillFn<int32>(&gather_indices, [kVocab](int i) -> int32 {
+    return (static_cast<int64>(i) * 7919) % kVocab;
+  });
+  Tensor indices(DT_INT32, TensorShape({num_ids}));
+  test::FillFn<int32>(&indices, [](int i) -> int32 { return i; });
+  Tensor segment_ids(DT_INT32, TensorShape({num_ids}));
+  test::FillFn<int32>(&segment_ids, [kIdsPerSegment](int i) -> int32 {
+    return i / kIdsPerSegment;
+  });
+
+  Node* params_node = test::graph::Constant(g, params);
+  Node* gather_node = test::graph::Constant(g, gather_indices);
+  Node* node;
+  if (fused) {
+    TF_CHECK_OK(NodeBuilder(g->NewName("n"), "_FusedSparseSegmentSum")
+                    .Input(params_node)
+                    .Input(gather_node)
+                    .Input(test::graph::Constant(g, indices))
+                    .Input(test::graph::Constant(g, segment_ids))
+                    .Attr("T", DT_FLOAT)
+                    .Finalize(g, &node));
+  } else {
+    Tensor axis(DT_INT32, TensorShape({}));
+    axis.scalar<int32>()() = 0;
+    Node* gathered;
+    TF_CHECK_OK(NodeBuilder(g->NewName("n"), "GatherV2")
+                    .Input(params_node)
+                    .Input(gather_node)
+                    .Input(test::graph::Constant(g, axis))
+                    .Finalize(g, &gathered));
+    TF_CHECK_OK(NodeBuilder(g->NewName("n"), "SparseSegmentSum")
+                    .Input(gathered)
+                    .Input(test::graph::Constant(g, indices))
+                    .Input(test::graph::Constant(g, segment_ids))
+                    .Attr("T", DT_FLOAT)
+                    .Finalize(g, &node));
+  }
+  testing::UseRealTime();
+  testing::BytesProcessed(static_cast<int64>(iters) * num_ids * dim *
+                          sizeof(float));
+  testing::StartTiming();
+  test::Benchmark("cpu", g).Run(iters);
+}
+
+static void BM_EmbeddingLookupSparse_Unfused(int iters, int num_ids) {
+  BM_EmbeddingLookupSparse(iters, false, num_ids, 64);
+}
+
+static void BM_EmbeddingLookupSparse_Fused(int iters, int num_ids) {
+  BM_EmbeddingLookupSparse(iters, true, num_ids, 64);
+}
+
+BENCHMARK(BM_EmbeddingLookupSparse_Unfused)->Arg(4096)->Arg(262144);
+BENCHMARK(BM_EmbeddingLookupSparse_Fused)->Arg(4096)->Arg(262144);
+
 static void SparseSegmentMeanGradHelper(int iters, float uniqueness, int size) {
   testing::StopTiming();
   Graph* g = new Graph(OpRegistry::Global());
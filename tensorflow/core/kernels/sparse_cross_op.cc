@@ -142,25 +142,23 @@ class OutputUpdater {
   OutputUpdater(const std::vector<int64>& output_start_indices,
                 Tensor* indices_out, Tensor* values_out)
       : output_start_indices_(output_start_indices),
-        indices_out_(indices_out),
-        values_out_(values_out) {}
+        indices_matrix_(indices_out->matrix<int64>()),
+        values_vec_(values_out->vec<OutType>()) {}
 
   void Update(const int64 batch_index, const int64 cross_count,
               const OutType& cross) const {
     const int64 output_index = output_start_indices_[batch_index] + cross_count;
 
-    auto indices_matrix = indices_out_->matrix<int64>();
-    indices_matrix(output_index, 0) = batch_index;
-    indices_matrix(output_index, 1) = cross_count;
-
-    auto value_vec = values_out_->vec<OutType>();
-    value_vec(output_index) = cross;
+    indices_matrix_(output_index, 0) = batch_index;
+    indices_matrix_(output_index, 1) = cross_count;
+    values_vec_(output_index) = cross;
   }
 
  private:
   const std::vector<int64>& output_start_indices_;
-  Tensor* indices_out_;
-  Tensor* values_out_;
+  // Maps into the preallocated outputs; every cross is written in place.
+  mutable typename TTypes<int64>::Matrix indices_matrix_;
+  mutable typename TTypes<OutType>::Vec values_vec_;
 };
 
 // Generates the sparse crosses as concatenation of strings.
@@ -205,7 +203,65 @@ class HashCrosser {
       uint64 hash_i = columns_[i]->Feature(batch_index, permutation[i]);
       hashed_output = FingerprintCat64(hashed_output, hash_i);
     }
-    // The return value is int64 based on the number of buckets.
+    return Bucketize(hashed_output);
+  }
+
+  // Writes all crosses of row `batch_index` through `updater`, in the same
+  // order as ProductIterator and with the same values as Generate(). Each
+  // feature of the row is fingerprinted once, and consecutive crosses reuse
+  // the hash of the columns they have in common, so advancing to the next
+  // cross usually costs a single FingerprintCat64. `fingerprints`, `prefix`
+  // and `position` are scratch space reused across rows.
+  void GenerateRow(const int64 batch_index,
+                   const OutputUpdater<int64>& updater,
+                   std::vector<uint64>* fingerprints,
+                   std::vector<uint64>* prefix,
+                   std::vector<int64>* position) const {
+    const int num_columns = columns_.size();
+    position->assign(num_columns, 0);
+    // (*position)[i] is the feature of column i in the current cross, with
+    // features of column i stored at fingerprints[column_start[i]...].
+    gtl::InlinedVector<int64, 8> column_start(num_columns + 1, 0);
+    for (int i = 0; i < num_columns; ++i) {
+      const int64 count = columns_[i]->FeatureCount(batch_index);
+      if (count == 0) return;
+      column_start[i + 1] = column_start[i] + count;
+    }
+    fingerprints->resize(column_start[num_columns]);
+    for (int i = 0; i < num_columns; ++i) {
+      for (int64 n = 0; n < column_start[i + 1] - column_start[i]; ++n) {
+        (*fingerprints)[column_start[i] + n] =
+            columns_[i]->Feature(batch_index, n);
+      }
+    }
+
+    // (*prefix)[i] is the hash of the features of columns [0, i).
+    prefix->resize(num_columns + 1);
+    (*prefix)[0] = hash_key_;
+    int first_changed = 0;
+    for (int64 cross_count = 0;; ++cross_count) {
+      for (int i = first_changed; i < num_columns; ++i) {
+        (*prefix)[i + 1] = FingerprintCat64(
+            (*prefix)[i], (*fingerprints)[column_start[i] + (*position)[i]]);
+      }
+      updater.Update(batch_index, cross_count, Bucketize(prefix->back()));
+
+      // Advance to the next cross, varying the last column fastest.
+      first_changed = num_columns - 1;
+      while (first_changed >= 0 &&
+             ++(*position)[first_changed] ==
+                 column_start[first_changed + 1] -
+                     column_start[first_changed]) {
+        (*position)[first_changed] = 0;
+        --first_changed;
+      }
+      if (first_changed < 0) return;
+    }
+  }
+
+ private:
+  // The return value is int64 based on the number of buckets.
+  int64 Bucketize(const uint64 hashed_output) const {
     if (num_buckets_ > 0) {
       return hashed_output % num_buckets_;
     } else {
@@ -214,7 +270,6 @@ class HashCrosser {
     }
   }
 
- private:
   const std::vector<std::unique_ptr<ColumnInterface<int64>>>& columns_;
   const int64 num_buckets_;
   const uint64 hash_key_;
@@ -269,6 +324,35 @@ class ProductIterator {
   std::vector<int> next_permutation_;
 };
 
+// Generates the crosses of rows [begin, end).
+template <typename InternalType, typename Crosser, typename Updater>
+void CrossRows(
+    const std::vector<std::unique_ptr<ColumnInterface<InternalType>>>& columns,
+    const Crosser& crosser, const Updater& updater, int64 begin, int64 end) {
+  for (int b = begin; b < end; b++) {
+    ProductIterator<InternalType> product_iterator(columns, b);
+    int64 cross_count = 0;
+    while (product_iterator.HasNext()) {
+      const auto permutation = product_iterator.Next();
+      updater.Update(b, cross_count, crosser.Generate(b, permutation));
+      cross_count++;
+    }
+  }
+}
+
+// Hashed output does not need per-cross permutations: rows are crossed from
+// their cached feature fingerprints.
+void CrossRows(const std::vector<std::unique_ptr<ColumnInterface<int64>>>&,
+               const HashCrosser& crosser, const OutputUpdater<int64>& updater,
+               int64 begin, int64 end) {
+  std::vector<uint64> fingerprints;
+  std::vector<uint64> prefix;
+  std::vector<int64> position;
+  for (int64 b = begin; b < end; b++) {
+    crosser.GenerateRow(b, updater, &fingerprints, &prefix, &position);
+  }
+}
+
 template <bool HASHED_OUTPUT, typename InternalType>
 struct CrossTraits;
 
@@ -324,19 +408,12 @@ class SparseCrossOp : public OpKernel {
     std::vector<int64> output_start_indices(batch_size);
     CreateOutputTensors(columns, batch_size, context, &indices_out, &values_out,
                         &shape_out, &output_start_indices);
+    if (!context->status().ok()) return;
 
     typename CrossTraits<HASHED_OUTPUT, InternalType>::Updater updater(
         output_start_indices, indices_out, values_out);
     auto do_work = [&columns, crosser, updater](int64 begin, int64 end) {
-      for (int b = begin; b < end; b++) {
-        ProductIterator<InternalType> product_iterator(columns, b);
-        int64 cross_count = 0;
-        while (product_iterator.HasNext()) {
-          const auto permutation = product_iterator.Next();
-          updater.Update(b, cross_count, crosser.Generate(b, permutation));
-          cross_count++;
-        }
-      }
+      CrossRows(columns, crosser, updater, begin, end);
     };
 
     auto* worker_threads = context->device()->tensorflow_cpu_worker_threads();
@@ -19,12 +19,16 @@ limitations under the License.
 
 #include "tensorflow/core/kernels/sparse_tensor_dense_matmul_op.h"
 
+#include <vector>
+
+#include "third_party/eigen3/Eigen/Core"
 #include "tensorflow/core/framework/bounds_check.h"
 #include "tensorflow/core/framework/op.h"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/kernels/fill_functor.h"
 #include "tensorflow/core/lib/bfloat16/bfloat16.h"
 #include "tensorflow/core/util/env_var.h"
+#include "tensorflow/core/util/work_sharder.h"
 
 namespace tensorflow {
 
@@ -274,10 +278,6 @@ Status SparseTensorDenseMatMulImpl(
   const int lhs_index_a = ADJ_A ? 1 : 0;
   const int rhs_index_a = ADJ_A ? 0 : 1;
 
-  // TODO(ebrevdo): After many failed experiments, can't find a multi-threaded
-  // approach that achieves the performance of the single threaded
-  // one.  Perhaps Eigen threadpool implementation is just too slow?
-
   if (rhs_right < kNumVectorize) {
     // Disable vectorization if the RHS of output is too small
     auto maybe_adjoint_b = MaybeAdjoint<decltype(b), ADJ_B>(b);
@@ -331,6 +331,119 @@ Status SparseTensorDenseMatMulImpl(
   }
   return Status::OK();
 }
+
+// Below this many multiply-adds the serial implementation above is faster
+// than sorting the nonzeros and handing out shards.
+constexpr int64 kMinShardedCost = 1 << 16;
+
+// Multi-threaded version of SparseTensorDenseMatMulImpl. The nonzeros of A
+// are counting-sorted by output row, and contiguous ranges of the sorted
+// nonzeros, widened to row boundaries, are handed out to threads. Each output
+// row is therefore owned by one thread, and its nonzeros are accumulated in
+// their original order, so the result matches the serial implementation.
+// The dense row update is an Eigen array AXPY over a contiguous row of B
+// (or of the conjugate transpose of B, materialized once for ADJ_B).
+template <typename T, typename Tsum, typename Tindices, bool ADJ_A, bool ADJ_B>
+Status SparseTensorDenseMatMulShardedImpl(
+    OpKernelContext* ctx, typename TTypes<Tsum>::Matrix out,
+    typename TTypes<Tindices>::ConstMatrix a_indices,
+    typename TTypes<T>::ConstVec a_values, typename TTypes<T>::ConstMatrix b) {
+  const std::size_t nnz = a_values.size();
+  const std::size_t rhs_right = (ADJ_B ? b.dimension(0) : b.dimension(1));
+  const std::size_t lhs_right = (ADJ_B ? b.dimension(1) : b.dimension(0));
+  const int lhs_index_a = ADJ_A ? 1 : 0;
+  const int rhs_index_a = ADJ_A ? 0 : 1;
+  const int64 out_rows = out.dimension(0);
+
+  // Copy and validate the indices, and count the nonzeros of each output row.
+  std::vector<Tindices> ms(nnz);
+  std::vector<Tindices> ks(nnz);
+  std::vector<int64> row_starts(out_rows + 1, 0);
+  for (std::size_t i = 0; i < nnz; ++i) {
+    const Tindices m = internal::SubtleMustCopy(a_indices(i, lhs_index_a));
+    const Tindices k = internal::SubtleMustCopy(a_indices(i, rhs_index_a));
+    if (!FastBoundsCheck(k, lhs_right)) {
+      return KOutOfBoundsError(k, i, rhs_index_a, lhs_right);
+    }
+    if (!FastBoundsCheck(m, out_rows)) {
+      return MOutOfBoundsError(m, i, lhs_index_a, out_rows);
+    }
+    ms[i] = m;
+    ks[i] = k;
+    ++row_starts[m + 1];
+  }
+  for (int64 m = 0; m < out_rows; ++m) {
+    row_starts[m + 1] += row_starts[m];
+  }
+
+  // Stable counting sort of the nonzeros by output row.
+  std::vector<int64> sorted_nnz(nnz);
+  {
+    std::vector<int64> cursor(row_starts.begin(), row_starts.end() - 1);
+    for (std::size_t i = 0; i < nnz; ++i) {
+      sorted_nnz[cursor[ms[i]]++] = i;
+    }
+  }
+
+  // Row k of the right-hand side must be contiguous.
+  const CPUDevice& d = ctx->eigen_device<CPUDevice>();
+  Tensor b_adjoint_t;
+  const T* b_data = b.data();
+  if (ADJ_B) {
+    TF_RETURN_IF_ERROR(ctx->allocate_temp(
+        DataTypeToEnum<T>::value,
+        TensorShape({static_cast<int64>(lhs_right),
+                     static_cast<int64>(rhs_right)}),
+        &b_adjoint_t));
+    Eigen::array<int, 2> shuffle(1, 0);
+    b_adjoint_t.matrix<T>().device(d) = b.shuffle(shuffle).conjugate();
+    b_data = b_adjoint_t.matrix<T>().data();
+  }
+
+  typedef Eigen::Array<Tsum, Eigen::Dynamic, 1> SumArray;
+  typedef Eigen::Array<T, Eigen::Dynamic, 1> InputArray;
+  auto work = [&ms, &ks, &sorted_nnz, &a_values, &out, b_data, rhs_right,
+               nnz](int64 begin, int64 end) {
+    const int64 total = nnz;
+    auto row_of = [&](int64 pos) { return ms[sorted_nnz[pos]]; };
+    while (begin > 0 && begin < total && row_of(begin) == row_of(begin - 1)) {
+      ++begin;
+    }
+    while (end < total && row_of(end) == row_of(end - 1)) {
+      ++end;
+    }
+    for (int64 pos = begin; pos < end; ++pos) {
+      const int64 i = sorted_nnz[pos];
+      const T a_value = ADJ_A ? MaybeConj(a_values(i)) : a_values(i);
+      Eigen::Map<SumArray> out_row(&out(ms[i], 0), rhs_right);
+      Eigen::Map<const InputArray> b_row(b_data + ks[i] * rhs_right,
+                                         rhs_right);
+      out_row += b_row.template cast<Tsum>() * static_cast<Tsum>(a_value);
+    }
+  };
+  // One multiply-add per element of the dense row.
+  const DeviceBase::CpuWorkerThreads& worker_threads =
+      *ctx->device()->tensorflow_cpu_worker_threads();
+  Shard(worker_threads.num_threads, worker_threads.workers, nnz,
+        2 * rhs_right, work);
+  return Status::OK();
+}
+
+template <typename T, typename Tsum, typename Tindices, bool ADJ_A, bool ADJ_B>
+Status SparseTensorDenseMatMulCPU(
+    OpKernelContext* ctx, typename TTypes<Tsum>::Matrix out,
+    typename TTypes<Tindices>::ConstMatrix a_indices,
+    typename TTypes<T>::ConstVec a_values, typename TTypes<T>::ConstMatrix b) {
+  const int64 rhs_right = (ADJ_B ? b.dimension(0) : b.dimension(1));
+  const int num_threads =
+      ctx->device()->tensorflow_cpu_worker_threads()->num_threads;
+  if (num_threads > 1 && a_values.size() * rhs_right >= kMinShardedCost) {
+    return SparseTensorDenseMatMulShardedImpl<T, Tsum, Tindices, ADJ_A, ADJ_B>(
+        ctx, out, a_indices, a_values, b);
+  }
+  return SparseTensorDenseMatMulImpl<T, Tsum, Tindices, ADJ_A, ADJ_B>(
+      out, a_indices, a_values, b);
+}
 }  // namespace
 
 template <typename T, typename Tindices, bool ADJ_A, bool ADJ_B>
@@ -348,8 +461,8 @@ struct SparseTensorDenseMatMulFunctor<CPUDevice, T, Tindices, ADJ_A, ADJ_B> {
       auto temp_out = temp_out_t.matrix<Tsum>();
       temp_out.setZero();
       TF_RETURN_IF_ERROR(
-          SparseTensorDenseMatMulImpl<T, Tsum, Tindices, ADJ_A, ADJ_B>(
-              temp_out, a_indices, a_values, b));
+          SparseTensorDenseMatMulCPU<T, Tsum, Tindices, ADJ_A, ADJ_B>(
+              ctx, temp_out, a_indices, a_values, b));
       out = temp_out.template cast<T>();
     } else {
       out.setZero();
@@ -358,8 +471,8 @@ struct SparseTensorDenseMatMulFunctor<CPUDevice, T, Tindices, ADJ_A, ADJ_B> {
       auto out_workaround =
           *reinterpret_cast<typename TTypes<Tsum>::Matrix*>(&out);
       TF_RETURN_IF_ERROR(
-          SparseTensorDenseMatMulImpl<T, Tsum, Tindices, ADJ_A, ADJ_B>(
-              out_workaround, a_indices, a_values, b));
+          SparseTensorDenseMatMulCPU<T, Tsum, Tindices, ADJ_A, ADJ_B>(
+              ctx, out_workaround, a_indices, a_values, b));
     }
     return Status::OK();
   }
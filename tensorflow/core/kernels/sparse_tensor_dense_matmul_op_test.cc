@@ -117,4 +117,11 @@ BM_SparseTensorDenseMatmul(16384, 4096, 4096, 4096, false, true);
 BM_SparseTensorDenseMatmul(16384, 4096, 4096, 4096, true, false);
 BM_SparseTensorDenseMatmul(16384, 4096, 4096, 4096, true, true);
 
+// Wide sparse features feeding a dense layer; these take the sharded CPU path.
+BM_SparseTensorDenseMatmulDev(262144, 4096, 65536, 16, false, false, cpu);
+BM_SparseTensorDenseMatmulDev(262144, 4096, 65536, 128, false, false, cpu);
+BM_SparseTensorDenseMatmulDev(262144, 4096, 65536, 128, false, true, cpu);
+BM_SparseTensorDenseMatmulDev(262144, 4096, 65536, 128, true, false, cpu);
+BM_SparseTensorDenseMatmulDev(262144, 4096, 65536, 128, true, true, cpu);
+
 }  // end namespace tensorflow
@@ -24,6 +24,8 @@ limitations under the License.
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/core/stringpiece.h"
 #include "tensorflow/core/lib/strings/str_util.h"
+#include "tensorflow/core/platform/fingerprint.h"
+#include "tensorflow/core/util/work_sharder.h"
 
 namespace tensorflow {
 namespace {
@@ -213,14 +215,10 @@ class StringSplitOp : public OpKernel {
     Tensor* sp_indices_t;
     OP_REQUIRES_OK(ctx, ctx->allocate_output(0, TensorShape({output_size, 2}),
                                              &sp_indices_t));
-    Tensor* sp_tokens_t;
-    OP_REQUIRES_OK(
-        ctx, ctx->allocate_output(1, TensorShape({output_size}), &sp_tokens_t));
     Tensor* sp_shape_t;
     OP_REQUIRES_OK(ctx, ctx->allocate_output(2, TensorShape({2}), &sp_shape_t));
 
     auto sp_indices = sp_indices_t->matrix<int64>();
-    auto sp_tokens = sp_tokens_t->vec<tstring>();
     auto sp_shape = sp_shape_t->vec<int64>();
     sp_shape(0) = batch_size;
     sp_shape(1) = max_num_entries;
@@ -229,16 +227,67 @@ class StringSplitOp : public OpKernel {
       for (size_t j = 0; j < num_indices[i]; ++j) {
         sp_indices(c, 0) = i;
         sp_indices(c, 1) = j;
-        sp_tokens(c).assign(tokens[c].data(), tokens[c].size());
         ++c;
       }
     }
+    OutputTokens(ctx, tokens);
+  }
+
+ protected:
+  // Writes the split tokens, which point into the input, to output 1.
+  virtual void OutputTokens(OpKernelContext* ctx,
+                            const std::vector<StringPiece>& tokens) {
+    Tensor* sp_tokens_t;
+    const int64 num_tokens = tokens.size();
+    OP_REQUIRES_OK(
+        ctx, ctx->allocate_output(1, TensorShape({num_tokens}), &sp_tokens_t));
+    auto sp_tokens = sp_tokens_t->vec<tstring>();
+    for (size_t c = 0; c < tokens.size(); ++c) {
+      sp_tokens(c).assign(tokens[c].data(), tokens[c].size());
+    }
   }
 
  private:
   bool skip_empty_;
 };
 
+// StringSplit followed by StringToHashBucketFast on the tokens. Tokens are
+// fingerprinted straight out of the input strings, so the intermediate string
+// tensor of tokens is never materialized.
+class StringSplitToHashBucketFastOp : public StringSplitOp {
+ public:
+  explicit StringSplitToHashBucketFastOp(OpKernelConstruction* context)
+      : StringSplitOp(context) {
+    OP_REQUIRES_OK(context, context->GetAttr("num_buckets", &num_buckets_));
+  }
+
+ protected:
+  void OutputTokens(OpKernelContext* ctx,
+                    const std::vector<StringPiece>& tokens) override {
+    Tensor* sp_buckets_t;
+    const int64 num_tokens = tokens.size();
+    OP_REQUIRES_OK(
+        ctx, ctx->allocate_output(1, TensorShape({num_tokens}), &sp_buckets_t));
+    auto sp_buckets = sp_buckets_t->vec<int64>();
+    // Rough cost, in cycles, of fingerprinting one token.
+    static constexpr int64 kCostPerToken = 100;
+    const DeviceBase::CpuWorkerThreads& worker_threads =
+        *ctx->device()->tensorflow_cpu_worker_threads();
+    Shard(worker_threads.num_threads, worker_threads.workers, num_tokens,
+          kCostPerToken,
+          [&tokens, &sp_buckets, this](int64 start, int64 limit) {
+            for (int64 c = start; c < limit; ++c) {
+              // Same bucketing as StringToHashBucketFast.
+              sp_buckets(c) =
+                  static_cast<int64>(Fingerprint64(tokens[c]) % num_buckets_);
+            }
+          });
+  }
+
+ private:
+  int64 num_buckets_;
+};
+
 class StringSplitV2Op : public OpKernel {
  public:
   explicit StringSplitV2Op(OpKernelConstruction* context)
@@ -312,5 +361,8 @@ class StringSplitV2Op : public OpKernel {
 REGISTER_KERNEL_BUILDER(Name("StringSplit").Device(DEVICE_CPU), StringSplitOp);
 REGISTER_KERNEL_BUILDER(Name("StringSplitV2").Device(DEVICE_CPU),
                         StringSplitV2Op);
+REGISTER_KERNEL_BUILDER(
+    Name("_StringSplitToHashBucketFast").Device(DEVICE_CPU),
+    StringSplitToHashBucketFastOp);
 
 }  // namespace tensorflow
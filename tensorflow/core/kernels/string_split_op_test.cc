@@ -26,11 +26,38 @@ limitations under the License.
 #include "tensorflow/core/kernels/ops_testutil.h"
 #include "tensorflow/core/kernels/ops_util.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/fingerprint.h"
 #include "tensorflow/core/platform/test.h"
 #include "tensorflow/core/platform/test_benchmark.h"
 
 namespace tensorflow {
 
+class StringSplitToHashBucketFastOpTest : public OpsTestBase {};
+
+TEST_F(StringSplitToHashBucketFastOpTest, MatchesUnfused) {
+  TF_ASSERT_OK(NodeDefBuilder("split", "_StringSplitToHashBucketFast")
+                   .Input(FakeInput(DT_STRING))
+                   .Input(FakeInput(DT_STRING))
+                   .Attr("num_buckets", 10)
+                   .Finalize(node_def()));
+  TF_ASSERT_OK(InitOp());
+  AddInputFromArray<tstring>(TensorShape({3}), {"a b  c", "", "hello world"});
+  AddInputFromArray<tstring>(TensorShape({}), {" "});
+  TF_ASSERT_OK(RunOpKernel());
+
+  test::ExpectTensorEqual<int64>(
+      test::AsTensor<int64>({0, 0, 0, 1, 0, 2, 2, 0, 2, 1}, {5, 2}),
+      *GetOutput(0));
+  std::vector<int64> buckets;
+  for (const char* token : {"a", "b", "c", "hello", "world"}) {
+    buckets.push_back(Fingerprint64(token) % 10);
+  }
+  test::ExpectTensorEqual<int64>(test::AsTensor<int64>(buckets, {5}),
+                                 *GetOutput(1));
+  test::ExpectTensorEqual<int64>(test::AsTensor<int64>({3, 3}, {2}),
+                                 *GetOutput(2));
+}
+
 // Test data from the TensorFlow README.md.
 const char* lines[] = {
     "**TensorFlow** is an open source software library for numerical "
@@ -126,4 +153,50 @@ BENCHMARK(BM_StringSplitV2)
     ->Arg(128)
     ->Arg(256);
 
+Graph* SetupStringSplitHashBucketGraph(const Tensor& input, bool fused) {
+  Graph* g = new Graph(OpRegistry::Global());
+  Tensor delim(DT_STRING, TensorShape({}));
+  delim.flat<tstring>().setConstant(" ");
+
+  if (fused) {
+    TF_CHECK_OK(NodeBuilder("string_split_op", "_StringSplitToHashBucketFast")
+                    .Input(test::graph::Constant(g, input))
+                    .Input(test::graph::Constant(g, delim))
+                    .Attr("num_buckets", 1 << 20)
+                    .Finalize(g, nullptr /* node */));
+  } else {
+    Node* split;
+    TF_CHECK_OK(NodeBuilder("string_split_op", "StringSplit")
+                    .Input(test::graph::Constant(g, input))
+                    .Input(test::graph::Constant(g, delim))
+                    .Finalize(g, &split));
+    TF_CHECK_OK(NodeBuilder("hash_bucket_op", "StringToHashBucketFast")
+                    .Input(split, 1)
+                    .Attr("num_buckets", 1 << 20)
+                    .Finalize(g, nullptr /* node */));
+  }
+  return g;
+}
+
+void BM_StringSplitHashBucket(int iters, int batch_size, bool fused) {
+  testing::StopTiming();
+  testing::ItemsProcessed(static_cast<int64>(iters) * batch_size);
+  testing::UseRealTime();
+  Tensor input = GetTestTensor(batch_size);
+  Graph* g = SetupStringSplitHashBucketGraph(input, fused);
+  testing::StartTiming();
+  test::Benchmark("cpu", g).Run(iters);
+}
+
+void BM_StringSplitHashBucket_Unfused(int iters, int batch_size) {
+  BM_StringSplitHashBucket(iters, batch_size, false);
+}
+
+void BM_StringSplitHashBucket_Fused(int iters, int batch_size) {
+  BM_StringSplitHashBucket(iters, batch_size, true);
+}
+
+BENCHMARK(BM_StringSplitHashBucket_Unfused)->Arg(64)->Arg(1024)->Arg(16384);
+BENCHMARK(BM_StringSplitHashBucket_Fused)->Arg(64)->Arg(1024)->Arg(16384);
+
 }  // end namespace tensorflow
@@ -15,12 +15,149 @@ limitations under the License.
 
 #include "tensorflow/core/kernels/string_to_hash_bucket_op.h"
 
+#include <cstring>
+
 #include "tensorflow/core/lib/hash/hash.h"
+#include "tensorflow/core/platform/byte_order.h"
 #include "tensorflow/core/platform/fingerprint.h"
 #include "tensorflow/core/platform/strong_hash.h"
 
 namespace tensorflow {
 
+namespace {
+
+// The constants and short-string cases of farmhash's Fingerprint64
+// (farmhashna::Hash64), written to run over kLanes strings of the same length
+// class at once.
+constexpr uint64 kK1 = 0xb492b66fbe98f273ULL;
+constexpr uint64 kK2 = 0x9ae16a3b2f90404fULL;
+constexpr int kLanes = 8;
+
+inline uint64 Fetch64(const char* p) {
+  uint64 result;
+  std::memcpy(&result, p, sizeof(result));
+  return result;
+}
+
+inline uint64 Fetch32(const char* p) {
+  uint32 result;
+  std::memcpy(&result, p, sizeof(result));
+  return result;
+}
+
+// Rotates right by 0 < shift < 64 bits.
+inline uint64 Rotate(uint64 value, int shift) {
+  return (value >> shift) | (value << (64 - shift));
+}
+
+inline uint64 HashLen16(uint64 u, uint64 v, uint64 mul) {
+  uint64 a = (u ^ v) * mul;
+  a ^= (a >> 47);
+  uint64 b = (v ^ a) * mul;
+  b ^= (b >> 47);
+  return b * mul;
+}
+
+// Fingerprints the kLanes strings of 4 to 7 bytes at `indices`.
+void HashLen4to7Lanes(const StringPiece* strings, const int64* indices,
+                      uint64* fingerprints) {
+  uint64 len[kLanes], first[kLanes], last[kLanes], hash[kLanes];
+  for (int l = 0; l < kLanes; ++l) {
+    const StringPiece s = strings[indices[l]];
+    len[l] = s.size();
+    first[l] = Fetch32(s.data());
+    last[l] = Fetch32(s.data() + s.size() - 4);
+  }
+  for (int l = 0; l < kLanes; ++l) {
+    hash[l] = HashLen16(len[l] + (first[l] << 3), last[l], kK2 + len[l] * 2);
+  }
+  for (int l = 0; l < kLanes; ++l) fingerprints[indices[l]] = hash[l];
+}
+
+// Fingerprints the kLanes strings of 8 to 16 bytes at `indices`.
+void HashLen8to16Lanes(const StringPiece* strings, const int64* indices,
+                       uint64* fingerprints) {
+  uint64 len[kLanes], first[kLanes], last[kLanes], hash[kLanes];
+  for (int l = 0; l < kLanes; ++l) {
+    const StringPiece s = strings[indices[l]];
+    len[l] = s.size();
+    first[l] = Fetch64(s.data());
+    last[l] = Fetch64(s.data() + s.size() - 8);
+  }
+  for (int l = 0; l < kLanes; ++l) {
+    const uint64 mul = kK2 + len[l] * 2;
+    const uint64 a = first[l] + kK2;
+    const uint64 c = Rotate(last[l], 37) * mul + a;
+    const uint64 d = (Rotate(a, 25) + last[l]) * mul;
+    hash[l] = HashLen16(c, d, mul);
+  }
+  for (int l = 0; l < kLanes; ++l) fingerprints[indices[l]] = hash[l];
+}
+
+// Fingerprints the kLanes strings of 17 to 32 bytes at `indices`.
+void HashLen17to32Lanes(const StringPiece* strings, const int64* indices,
+                        uint64* fingerprints) {
+  uint64 len[kLanes], w0[kLanes], w1[kLanes], w2[kLanes], w3[kLanes];
+  uint64 hash[kLanes];
+  for (int l = 0; l < kLanes; ++l) {
+    const StringPiece s = strings[indices[l]];
+    len[l] = s.size();
+    w0[l] = Fetch64(s.data());
+    w1[l] = Fetch64(s.data() + 8);
+    w2[l] = Fetch64(s.data() + s.size() - 8);
+    w3[l] = Fetch64(s.data() + s.size() - 16);
+  }
+  for (int l = 0; l < kLanes; ++l) {
+    const uint64 mul = kK2 + len[l] * 2;
+    const uint64 a = w0[l] * kK1;
+    const uint64 b = w1[l];
+    const uint64 c = w2[l] * mul;
+    const uint64 d = w3[l] * kK2;
+    hash[l] = HashLen16(Rotate(a + b, 43) + Rotate(c, 30) + d,
+                        a + Rotate(b + kK2, 18) + c, mul);
+  }
+  for (int l = 0; l < kLanes; ++l) fingerprints[indices[l]] = hash[l];
+}
+
+}  // namespace
+
+void Fingerprint64Batch(const StringPiece* strings, int64 n,
+                        uint64* fingerprints) {
+  // The lanes read the bytes of the strings as little-endian words.
+  if (!port::kLittleEndian) {
+    for (int64 i = 0; i < n; ++i) fingerprints[i] = Fingerprint64(strings[i]);
+    return;
+  }
+  typedef void (*LanesFn)(const StringPiece*, const int64*, uint64*);
+  static constexpr int kNumClasses = 3;
+  static constexpr LanesFn kLanesFns[kNumClasses] = {
+      HashLen4to7Lanes, HashLen8to16Lanes, HashLen17to32Lanes};
+  static constexpr int64 kChunkSize = 256;
+  int64 indices[kNumClasses][kChunkSize];
+  for (int64 begin = 0; begin < n; begin += kChunkSize) {
+    const int64 end = std::min(n, begin + kChunkSize);
+    int64 counts[kNumClasses] = {0, 0, 0};
+    for (int64 i = begin; i < end; ++i) {
+      const size_t len = strings[i].size();
+      if (len < 4 || len > 32) {
+        fingerprints[i] = Fingerprint64(strings[i]);
+      } else {
+        const int c = len < 8 ? 0 : len <= 16 ? 1 : 2;
+        indices[c][counts[c]++] = i;
+      }
+    }
+    for (int c = 0; c < kNumClasses; ++c) {
+      int64 j = 0;
+      for (; j + kLanes <= counts[c]; j += kLanes) {
+        kLanesFns[c](strings, &indices[c][j], fingerprints);
+      }
+      for (; j < counts[c]; ++j) {
+        fingerprints[indices[c][j]] = Fingerprint64(strings[indices[c][j]]);
+      }
+    }
+  }
+}
+
 // Deprecated class. It also uses `string_tensor` as Op argument instead of
 // `input`.
 class LegacyStringToHashBucketOp : public OpKernel {
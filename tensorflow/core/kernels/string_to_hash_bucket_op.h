@@ -16,16 +16,44 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_KERNELS_STRING_TO_HASH_BUCKET_OP_H_
 #define TENSORFLOW_CORE_KERNELS_STRING_TO_HASH_BUCKET_OP_H_
 
+#include <algorithm>
 #include <string>
 
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/fingerprint.h"
 #include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/util/work_sharder.h"
 
 namespace tensorflow {
 
+// Rough cost, in cycles, of hashing one short string into a bucket.
+constexpr int64 kStringToHashBucketCostPerString = 100;
+
+// Sets fingerprints[i] to Fingerprint64(strings[i]) for i in [0, n), bit for
+// bit. Strings of 4 to 32 bytes are hashed several at a time in lockstep, so
+// that their 64-bit arithmetic is vectorized across strings.
+void Fingerprint64Batch(const StringPiece* strings, int64 n,
+                        uint64* fingerprints);
+
+// Hashes a batch of strings with `hash`, one string at a time unless `hash`
+// has a batched implementation.
+template <uint64 hash(StringPiece)>
+struct BatchHash {
+  static void Run(const StringPiece* strings, int64 n, uint64* hashes) {
+    for (int64 i = 0; i < n; ++i) hashes[i] = hash(strings[i]);
+  }
+};
+
+template <>
+struct BatchHash<Fingerprint64> {
+  static void Run(const StringPiece* strings, int64 n, uint64* hashes) {
+    Fingerprint64Batch(strings, n, hashes);
+  }
+};
+
 template <uint64 hash(StringPiece)>
 class StringToHashBucketOp : public OpKernel {
  public:
@@ -44,15 +72,29 @@ class StringToHashBucketOp : public OpKernel {
                                             &output_tensor));
     auto output_flat = output_tensor->flat<int64>();
 
-    typedef decltype(input_flat.size()) Index;
-    for (Index i = 0; i < input_flat.size(); ++i) {
-      const uint64 input_hash = hash(input_flat(i));
-      const uint64 bucket_id = input_hash % num_buckets_;
-      // The number of buckets is always in the positive range of int64 so is
-      // the resulting bucket_id. Casting the bucket_id from uint64 to int64 is
-      // safe.
-      output_flat(i) = static_cast<int64>(bucket_id);
-    }
+    // Strings hash independently, so large batches are split across the
+    // intra-op threads.
+    const DeviceBase::CpuWorkerThreads& worker_threads =
+        *context->device()->tensorflow_cpu_worker_threads();
+    Shard(worker_threads.num_threads, worker_threads.workers,
+          input_flat.size(), kStringToHashBucketCostPerString,
+          [&input_flat, &output_flat, this](int64 start, int64 limit) {
+            static constexpr int64 kBatchSize = 64;
+            StringPiece strings[kBatchSize];
+            uint64 hashes[kBatchSize];
+            for (int64 begin = start; begin < limit; begin += kBatchSize) {
+              const int64 n = std::min(kBatchSize, limit - begin);
+              for (int64 i = 0; i < n; ++i) strings[i] = input_flat(begin + i);
+              BatchHash<hash>::Run(strings, n, hashes);
+              for (int64 i = 0; i < n; ++i) {
+                const uint64 bucket_id = hashes[i] % num_buckets_;
+                // The number of buckets is always in the positive range of
+                // int64 so is the resulting bucket_id. Casting the bucket_id
+                // from uint64 to int64 is safe.
+                output_flat(begin + i) = static_cast<int64>(bucket_id);
+              }
+            }
+          });
   }
 
  private:
@@ -86,15 +128,22 @@ class StringToKeyedHashBucketOp : public OpKernel {
                                             &output_tensor));
     auto output_flat = output_tensor->flat<int64>();
 
-    typedef decltype(input_flat.size()) Index;
-    for (Index i = 0; i < input_flat.size(); ++i) {
-      const uint64 input_hash = hash(key_, input_flat(i));
-      const uint64 bucket_id = input_hash % num_buckets_;
-      // The number of buckets is always in the positive range of int64 so is
-      // the resulting bucket_id. Casting the bucket_id from uint64 to int64 is
-      // safe.
-      output_flat(i) = static_cast<int64>(bucket_id);
-    }
+    // Strings hash independently, so large batches are split across the
+    // intra-op threads.
+    const DeviceBase::CpuWorkerThreads& worker_threads =
+        *context->device()->tensorflow_cpu_worker_threads();
+    Shard(worker_threads.num_threads, worker_threads.workers,
+          input_flat.size(), kStringToHashBucketCostPerString,
+          [&input_flat, &output_flat, this](int64 start, int64 limit) {
+            for (int64 i = start; i < limit; ++i) {
+              const uint64 input_hash = hash(key_, input_flat(i));
+              const uint64 bucket_id = input_hash % num_buckets_;
+              // The number of buckets is always in the positive range of int64
+              // so is the resulting bucket_id. Casting the bucket_id from
+              // uint64 to int64 is safe.
+              output_flat(i) = static_cast<int64>(bucket_id);
+            }
+          });
   }
 
  private:
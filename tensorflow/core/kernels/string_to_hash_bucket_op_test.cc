@@ -0,0 +1,83 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/kernels/string_to_hash_bucket_op.h"
+
+#include <vector>
+
+#include "tensorflow/core/framework/fake_input.h"
+#include "tensorflow/core/framework/node_def_builder.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/kernels/ops_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/random/philox_random.h"
+#include "tensorflow/core/lib/random/simple_philox.h"
+#include "tensorflow/core/platform/fingerprint.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+// Strings of every length up to 40 bytes, so that each length class gets full
+// groups of lanes as well as leftovers, interleaved with each other.
+std::vector<string> MixedLengthStrings() {
+  random::PhiloxRandom philox(301, 17);
+  random::SimplePhilox rnd(&philox);
+  std::vector<string> strings;
+  for (int copy = 0; copy < 11; ++copy) {
+    for (int len = 0; len <= 40; ++len) {
+      string s(len, '\0');
+      for (char& c : s) c = static_cast<char>(rnd.Uniform(256));
+      strings.push_back(s);
+    }
+  }
+  return strings;
+}
+
+TEST(Fingerprint64BatchTest, MatchesFingerprint64) {
+  const std::vector<string> strings = MixedLengthStrings();
+  std::vector<StringPiece> pieces(strings.begin(), strings.end());
+  std::vector<uint64> fingerprints(pieces.size());
+  Fingerprint64Batch(pieces.data(), pieces.size(), fingerprints.data());
+  for (int i = 0; i < pieces.size(); ++i) {
+    EXPECT_EQ(Fingerprint64(pieces[i]), fingerprints[i])
+        << "length " << pieces[i].size();
+  }
+}
+
+class StringToHashBucketFastOpTest : public OpsTestBase {};
+
+TEST_F(StringToHashBucketFastOpTest, MatchesFingerprint64Buckets) {
+  const int64 kNumBuckets = 1000003;
+  TF_ASSERT_OK(NodeDefBuilder("hash", "StringToHashBucketFast")
+                   .Input(FakeInput(DT_STRING))
+                   .Attr("num_buckets", kNumBuckets)
+                   .Finalize(node_def()));
+  TF_ASSERT_OK(InitOp());
+  const std::vector<string> strings = MixedLengthStrings();
+  AddInput<tstring>(TensorShape({static_cast<int64>(strings.size())}),
+                    [&strings](int i) { return tstring(strings[i]); });
+  TF_ASSERT_OK(RunOpKernel());
+
+  const auto buckets = GetOutput(0)->flat<int64>();
+  for (int i = 0; i < strings.size(); ++i) {
+    EXPECT_EQ(static_cast<int64>(Fingerprint64(strings[i]) % kNumBuckets),
+              buckets(i))
+        << "length " << strings[i].size();
+  }
+}
+
+}  // namespace
+}  // namespace tensorflow
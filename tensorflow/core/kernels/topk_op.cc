@@ -21,6 +21,7 @@ limitations under the License.
 
 #include <algorithm>
 #include <numeric>
+#include <utility>
 #include <vector>
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
 #include "tensorflow/core/framework/op_kernel.h"
@@ -99,6 +100,121 @@ class TopK : public OpKernel {
 
 namespace functor {
 
+namespace {
+
+// For k at least this large, rows that keep fewer than num_cols values use
+// buffered selection instead of the TopN heap.
+const int kMinSelectionK = 64;
+
+// Rows at least this long may be split across threads when there are too few
+// rows to keep the pool busy.
+const int64 kMinParallelSelectionCols = 1 << 16;
+
+// Rough cost, in cycles, of screening one column during selection.
+const int64 kSelectionCostPerCol = 4;
+
+// Returns true if `a` is ranked above `b` by the selection path. NaN ranks
+// above every other value and all NaNs are equivalent, which keeps the
+// ordering a strict weak ordering for std::sort and std::nth_element. The
+// sort and TopN heap paths keep comparing with operator<.
+template <typename T>
+bool TopKValueGreater(const T& a, const T& b) {
+  // Only NaN compares unequal to itself; unlike isnan this also covers the
+  // integral and bfloat16 types TopK is registered for.
+  const bool a_is_nan = a != a;
+  const bool b_is_nan = b != b;
+  if (a_is_nan || b_is_nan) return a_is_nan && !b_is_nan;
+  return b < a;
+}
+
+// A (value, column) pair ordered the way TopK orders its outputs: larger
+// values first, lower columns first among equal values.
+template <typename T>
+using TopKCandidate = std::pair<T, int32>;
+
+template <typename T>
+bool TopKGreater(const TopKCandidate<T>& a, const TopKCandidate<T>& b) {
+  if (TopKValueGreater(a.first, b.first)) return true;
+  if (TopKValueGreater(b.first, a.first)) return false;
+  return a.second < b.second;
+}
+
+// Keeps the first k candidates of `candidates` in TopK order, discarding the
+// rest without fully sorting them.
+template <typename T>
+void KeepTopK(int k, std::vector<TopKCandidate<T>>* candidates) {
+  if (candidates->size() <= static_cast<size_t>(k)) return;
+  std::nth_element(candidates->begin(), candidates->begin() + (k - 1),
+                   candidates->end(), TopKGreater<T>);
+  candidates->erase(candidates->begin() + k, candidates->end());
+}
+
+// Appends the k largest columns of data[begin, end) to `out`, unordered.
+// Candidates are buffered up to 2k and pruned back to k whenever the buffer
+// fills. Columns arrive in increasing order, so after the first prune a column
+// can only enter the top k by beating the k-th value outright, and most of a
+// long row is rejected with a single comparison.
+template <typename T>
+void SelectTopKCandidates(const T* data, int64 begin, int64 end, int k,
+                          std::vector<TopKCandidate<T>>* out) {
+  std::vector<TopKCandidate<T>> buffer;
+  buffer.reserve(std::min<int64>(2 * k, end - begin));
+  bool pruned = false;
+  T threshold = T();
+  for (int64 c = begin; c < end; ++c) {
+    if (pruned && !TopKValueGreater(data[c], threshold)) continue;
+    buffer.emplace_back(data[c], static_cast<int32>(c));
+    if (buffer.size() == 2 * static_cast<size_t>(k)) {
+      KeepTopK(k, &buffer);
+      threshold = buffer[k - 1].first;
+      pruned = true;
+    }
+  }
+  KeepTopK(k, &buffer);
+  out->insert(out->end(), buffer.begin(), buffer.end());
+}
+
+// Writes the k selected candidates of a row, sorting them first if requested.
+template <typename T>
+void WriteTopK(bool sorted, std::vector<TopKCandidate<T>>* candidates,
+               T* values, int32* indices) {
+  if (sorted) {
+    std::sort(candidates->begin(), candidates->end(), TopKGreater<T>);
+  }
+  for (size_t i = 0; i < candidates->size(); ++i) {
+    values[i] = (*candidates)[i].first;
+    indices[i] = (*candidates)[i].second;
+  }
+}
+
+// Selects the top k of a single long row using all worker threads: each chunk
+// of the row selects its own top k, and the union of those is reduced to the
+// final k. The result does not depend on the number of chunks.
+template <typename T>
+void ParallelTopKRow(const DeviceBase::CpuWorkerThreads& worker_threads,
+                     const T* data, int64 num_cols, int k, int64 num_chunks,
+                     bool sorted, T* values, int32* indices) {
+  const int64 chunk_size = (num_cols + num_chunks - 1) / num_chunks;
+  std::vector<std::vector<TopKCandidate<T>>> chunk_candidates(num_chunks);
+  Shard(worker_threads.num_threads, worker_threads.workers, num_chunks,
+        chunk_size * kSelectionCostPerCol, [&](int64 start, int64 limit) {
+          for (int64 c = start; c < limit; ++c) {
+            SelectTopKCandidates(data, c * chunk_size,
+                                 std::min(num_cols, (c + 1) * chunk_size), k,
+                                 &chunk_candidates[c]);
+          }
+        });
+  std::vector<TopKCandidate<T>> candidates;
+  candidates.reserve(num_chunks * k);
+  for (const auto& chunk : chunk_candidates) {
+    candidates.insert(candidates.end(), chunk.begin(), chunk.end());
+  }
+  KeepTopK(k, &candidates);
+  WriteTopK(sorted, &candidates, values, indices);
+}
+
+}  // namespace
+
 template <typename T>
 struct TopKFunctor<CPUDevice, T> {
   static EIGEN_ALWAYS_INLINE Status
@@ -136,6 +252,23 @@ struct TopKFunctor<CPUDevice, T> {
       return Status::OK();
     }
 
+    auto worker_threads = *(context->device()->tensorflow_cpu_worker_threads());
+
+    // Too few rows to occupy the pool: split each long row across threads.
+    if (k >= kMinSelectionK && k < num_cols &&
+        num_rows < worker_threads.num_threads &&
+        num_cols >= kMinParallelSelectionCols) {
+      const int64 num_chunks =
+          std::min<int64>(worker_threads.num_threads, num_cols / (4 * k));
+      if (num_chunks > 1) {
+        for (int64 b = 0; b < num_rows; ++b) {
+          ParallelTopKRow(worker_threads, &input(b, 0), num_cols, k,
+                          num_chunks, sorted, &values(b, 0), &indices(b, 0));
+        }
+        return Status::OK();
+      }
+    }
+
     auto SortIndices = [&](int64 start_batch, int64 limit_batch) {
       for (int32 b = start_batch; b < limit_batch; ++b) {
         const T* input_data = &input(b, 0);
@@ -151,11 +284,6 @@ struct TopKFunctor<CPUDevice, T> {
         const auto comp = [input_data](const int32 a, const int32 b) {
           return input_data[b] < input_data[a];
         };
-        // TODO(ebrevdo): For large k < num_cols, instead of using
-        // TopN, it may be faster to create a temporary vector of
-        // values 0..num_cols - 1 and then use std::partial_sort_copy
-        // of this into indices. Choosing the appropriate minimum k or
-        // ratio of k/num_cols will require some experimentation.
         if (k == num_cols) {
           auto* begin = &indices(b, 0);
           auto* end = &indices(b, k);
@@ -178,6 +306,13 @@ struct TopKFunctor<CPUDevice, T> {
             }
             run_begin = run_end;
           }
+        } else if (k >= kMinSelectionK) {
+          // The TopN heap costs log(k) per pushed column; selection screens
+          // most columns with a single comparison once its buffer is primed.
+          std::vector<TopKCandidate<T>> candidates;
+          SelectTopKCandidates(input_data, 0, num_cols, k, &candidates);
+          WriteTopK(sorted, &candidates, &values(b, 0), &indices(b, 0));
+          continue;
         } else {
           // Use the TopN heap object to sort.
           gtl::TopN<int32, decltype(stable_comp)> filter(k, stable_comp);
@@ -221,7 +356,6 @@ struct TopKFunctor<CPUDevice, T> {
     const int64 final_cost = (total_cost >= static_cast<double>(kint64max))
                                  ? kint64max
                                  : static_cast<int64>(total_cost);
-    auto worker_threads = *(context->device()->tensorflow_cpu_worker_threads());
     Shard(worker_threads.num_threads, worker_threads.workers, num_rows,
           final_cost, SortIndices);
 
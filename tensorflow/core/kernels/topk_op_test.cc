@@ -0,0 +1,177 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <vector>
+
+#include "tensorflow/core/common_runtime/kernel_benchmark_testlib.h"
+#include "tensorflow/core/framework/fake_input.h"
+#include "tensorflow/core/framework/node_def_builder.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/graph/node_builder.h"
+#include "tensorflow/core/graph/testlib.h"
+#include "tensorflow/core/kernels/ops_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/random/simple_philox.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+
+namespace tensorflow {
+namespace {
+
+class TopKOpTest : public OpsTestBase {
+ protected:
+  void MakeOp(bool sorted) {
+    TF_ASSERT_OK(NodeDefBuilder("top_k", "TopKV2")
+                     .Input(FakeInput(DT_INT32))
+                     .Input(FakeInput(DT_INT32))
+                     .Attr("sorted", sorted)
+                     .Finalize(node_def()));
+    TF_ASSERT_OK(InitOp());
+  }
+
+  // Runs TopK over rows of `num_cols` values drawn from [0, max_value), and
+  // checks the result against a stable sort of each row.
+  void RunAndCheck(int num_rows, int num_cols, int k, int max_value,
+                   bool sorted) {
+    MakeOp(sorted);
+    random::PhiloxRandom philox(301, 17);
+    random::SimplePhilox rnd(&philox);
+    std::vector<int32> data(num_rows * num_cols);
+    for (auto& value : data) value = rnd.Uniform(max_value);
+    AddInputFromArray<int32>(TensorShape({num_rows, num_cols}), data);
+    AddInputFromArray<int32>(TensorShape({}), {k});
+    TF_ASSERT_OK(RunOpKernel());
+
+    const auto values = GetOutput(0)->matrix<int32>();
+    const auto indices = GetOutput(1)->matrix<int32>();
+    for (int r = 0; r < num_rows; ++r) {
+      const int32* row = &data[r * num_cols];
+      std::vector<int32> expected(num_cols);
+      std::iota(expected.begin(), expected.end(), 0);
+      std::stable_sort(expected.begin(), expected.end(),
+                       [row](int32 a, int32 b) { return row[a] > row[b]; });
+      expected.resize(k);
+      std::vector<int32> actual(&indices(r, 0), &indices(r, 0) + k);
+      if (!sorted) {
+        std::sort(expected.begin(), expected.end());
+        std::sort(actual.begin(), actual.end());
+      }
+      ASSERT_EQ(expected, actual) << "row " << r;
+      for (int i = 0; i < k; ++i) {
+        EXPECT_EQ(row[indices(r, i)], values(r, i));
+      }
+    }
+  }
+};
+
+TEST_F(TopKOpTest, SelectionSorted) { RunAndCheck(8, 5000, 100, 1000, true); }
+
+TEST_F(TopKOpTest, SelectionUnsorted) {
+  RunAndCheck(8, 5000, 100, 1000, false);
+}
+
+TEST_F(TopKOpTest, SingleLongRowWithTies) {
+  RunAndCheck(1, 1 << 18, 1000, 5000, true);
+}
+
+TEST_F(TopKOpTest, FewLongRowsUnsorted) {
+  RunAndCheck(2, 1 << 17, 2000, 1 << 20, false);
+}
+
+// NaN ranks above every other value, ties included, on the selection path.
+TEST_F(TopKOpTest, SelectionRanksNaNFirst) {
+  const int num_cols = 1000;
+  const int k = 100;
+  TF_ASSERT_OK(NodeDefBuilder("top_k", "TopKV2")
+                   .Input(FakeInput(DT_FLOAT))
+                   .Input(FakeInput(DT_INT32))
+                   .Attr("sorted", true)
+                   .Finalize(node_def()));
+  TF_ASSERT_OK(InitOp());
+  std::vector<float> data(num_cols);
+  for (int c = 0; c < num_cols; ++c) {
+    data[c] = c % 50 == 3 ? std::numeric_limits<float>::quiet_NaN()
+                          : static_cast<float>((c * 37) % 101);
+  }
+  AddInputFromArray<float>(TensorShape({num_cols}), data);
+  AddInputFromArray<int32>(TensorShape({}), {k});
+  TF_ASSERT_OK(RunOpKernel());
+
+  std::vector<int32> expected(num_cols);
+  std::iota(expected.begin(), expected.end(), 0);
+  std::stable_sort(expected.begin(), expected.end(),
+                   [&data](int32 a, int32 b) {
+                     if (std::isnan(data[a]) || std::isnan(data[b])) {
+                       return std::isnan(data[a]) && !std::isnan(data[b]);
+                     }
+                     return data[a] > data[b];
+                   });
+  const auto values = GetOutput(0)->vec<float>();
+  const auto indices = GetOutput(1)->vec<int32>();
+  for (int i = 0; i < k; ++i) {
+    ASSERT_EQ(expected[i], indices(i)) << "position " << i;
+    if (std::isnan(data[expected[i]])) {
+      EXPECT_TRUE(std::isnan(values(i)));
+    } else {
+      EXPECT_EQ(data[expected[i]], values(i));
+    }
+  }
+}
+
+static Graph* TopKGraph(int rows, int cols, int k) {
+  Graph* g = new Graph(OpRegistry::Global());
+  Tensor input(DT_FLOAT, TensorShape({rows, cols}));
+  input.flat<float>().setRandom();
+  Tensor k_tensor(DT_INT32, TensorShape({}));
+  k_tensor.scalar<int32>()() = k;
+  Node* node;
+  TF_CHECK_OK(NodeBuilder(g->NewName("n"), "TopKV2")
+                  .Input(test::graph::Constant(g, input))
+                  .Input(test::graph::Constant(g, k_tensor))
+                  .Attr("sorted", true)
+                  .Finalize(g, &node));
+  return g;
+}
+
+#define BM_TopKDev(ROWS, COLS, K, DEVICE)                                  \
+  static void BM_TopK_##ROWS##_##COLS##_##K##_##DEVICE(int iters) {        \
+    testing::ItemsProcessed(static_cast<int64>(iters) * ROWS * COLS);      \
+    testing::UseRealTime();                                                \
+    test::Benchmark(#DEVICE, TopKGraph(ROWS, COLS, K)).Run(iters);         \
+  }                                                                        \
+  BENCHMARK(BM_TopK_##ROWS##_##COLS##_##K##_##DEVICE);
+
+#define BM_TopK(ROWS, COLS, K) BM_TopKDev(ROWS, COLS, K, cpu);
+
+// Many short rows: parallel across rows.
+BM_TopK(128, 1000, 10);
+BM_TopK(128, 1000, 100);
+BM_TopK(128, 100000, 100);
+BM_TopK(128, 100000, 1000);
+
+// A few very long rows: each row is split across threads.
+BM_TopK(1, 1000000, 100);
+BM_TopK(1, 1000000, 1000);
+BM_TopK(1, 10000000, 1000);
+BM_TopK(1, 10000000, 5000);
+BM_TopK(4, 10000000, 1000);
+
+}  // namespace
+}  // namespace tensorflow
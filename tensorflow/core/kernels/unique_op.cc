@@ -13,9 +13,11 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
+#include <algorithm>
 #include <functional>
-#include <unordered_map>
+#include <type_traits>
 #include <utility>
+#include <vector>
 
 #include "tensorflow/core/framework/bounds_check.h"
 #include "tensorflow/core/framework/op_kernel.h"
@@ -24,11 +26,231 @@ limitations under the License.
 #include "tensorflow/core/framework/tensor_shape.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/hash/hash.h"
+#include "tensorflow/core/util/work_sharder.h"
 
 namespace tensorflow {
 
 typedef Eigen::ThreadPoolDevice CPUDevice;
 
+namespace {
+
+// Inputs with at least this many elements are deduplicated in parallel.
+const int64 kMinParallelUniqueSize = 1 << 16;
+
+// Rough cost, in cycles, of hashing and probing a single element.
+const int64 kUniqueCostPerElement = 64;
+
+// Spreads the bits of a hash so that both the low bits (table slots) and the
+// high bits (partitions) are usable. std::hash is the identity on integers,
+// which clusters badly under a power-of-two mask.
+inline uint64 MixHash(uint64 h) {
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdULL;
+  h ^= h >> 33;
+  h *= 0xc4ceb9fe1a85ec53ULL;
+  h ^= h >> 33;
+  return h;
+}
+
+// Open-addressing hash table with linear probing that hands out dense ids to
+// distinct keys in insertion order. Slots only hold ids: callers keep the keys
+// and supply an equality predicate over ids. The table is sized up front for
+// `max_keys` insertions and never grows, so no per-key allocation happens.
+template <typename Id>
+class FlatIdTable {
+ public:
+  explicit FlatIdTable(int64 max_keys) {
+    int64 capacity = 16;
+    while (capacity < 2 * max_keys) capacity <<= 1;
+    slots_.assign(capacity, Id(kEmpty));
+    mask_ = capacity - 1;
+  }
+
+  // Returns the id of the key with hash `h` for which `is_equal(id)` holds,
+  // assigning the next free id if there is none. Sets `*inserted` to whether
+  // a new id was assigned.
+  template <typename IsEqual>
+  Id FindOrInsert(uint64 h, const IsEqual& is_equal, bool* inserted) {
+    for (uint64 slot = h & mask_;; slot = (slot + 1) & mask_) {
+      const Id id = slots_[slot];
+      if (id == kEmpty) {
+        slots_[slot] = size_;
+        *inserted = true;
+        return size_++;
+      }
+      if (is_equal(id)) {
+        *inserted = false;
+        return id;
+      }
+    }
+  }
+
+  Id size() const { return size_; }
+
+ private:
+  static constexpr Id kEmpty = -1;
+
+  std::vector<Id> slots_;
+  uint64 mask_;
+  Id size_ = 0;
+};
+
+// Deduplicates `in` into `keys` (in order of first occurrence), writing the
+// index of each element's key to `idx`. Fills `counts` when it is non-null.
+template <typename T, typename TIndex>
+void UniqueSerial(typename TTypes<T>::ConstFlat in,
+                  typename TTypes<TIndex>::Vec idx, std::vector<T>* keys,
+                  std::vector<TIndex>* counts) {
+  const int64 N = in.size();
+  FlatIdTable<TIndex> table(N);
+  for (int64 i = 0; i < N; ++i) {
+    const T& value = in(i);
+    bool inserted;
+    const TIndex id = table.FindOrInsert(
+        MixHash(hash<T>{}(value)),
+        [keys, &value](TIndex id) { return (*keys)[id] == value; }, &inserted);
+    if (inserted) {
+      keys->push_back(value);
+      if (counts != nullptr) counts->push_back(0);
+    }
+    if (counts != nullptr) ++(*counts)[id];
+    idx(i) = id;
+  }
+}
+
+// Same contract as UniqueSerial, with identical results. Elements are
+// partitioned by hash so that every key is owned by exactly one partition;
+// partitions are deduplicated independently, and the per-partition ids are
+// then renumbered in order of first occurrence in the whole input.
+template <typename T, typename TIndex>
+void UniqueParallel(const DeviceBase::CpuWorkerThreads& worker_threads,
+                    typename TTypes<T>::ConstFlat in,
+                    typename TTypes<TIndex>::Vec idx, std::vector<T>* keys,
+                    std::vector<TIndex>* counts) {
+  const int64 N = in.size();
+  const int num_parts = worker_threads.num_threads;
+  const int64 num_chunks = num_parts;
+  const int64 chunk_size = (N + num_chunks - 1) / num_chunks;
+
+  // Runs `fn(chunk, begin, end)` over contiguous chunks of the input.
+  auto for_each_chunk = [&](const std::function<void(int64, int64, int64)>&
+                                fn) {
+    Shard(worker_threads.num_threads, worker_threads.workers, num_chunks,
+          chunk_size * kUniqueCostPerElement, [&](int64 begin, int64 end) {
+            for (int64 c = begin; c < end; ++c) {
+              fn(c, c * chunk_size, std::min(N, (c + 1) * chunk_size));
+            }
+          });
+  };
+  auto for_each_part = [&](const std::function<void(int)>& fn) {
+    Shard(worker_threads.num_threads, worker_threads.workers, num_parts,
+          chunk_size * kUniqueCostPerElement, [&](int64 begin, int64 end) {
+            for (int64 p = begin; p < end; ++p) fn(p);
+          });
+  };
+
+  // Hash every element once and count elements per (chunk, partition).
+  std::vector<uint64> hashes(N);
+  std::vector<int32> part_of(N);
+  std::vector<int64> offsets(num_chunks * num_parts, 0);
+  for_each_chunk([&](int64 c, int64 begin, int64 end) {
+    int64* chunk_counts = &offsets[c * num_parts];
+    for (int64 i = begin; i < end; ++i) {
+      const uint64 h = MixHash(hash<T>{}(in(i)));
+      const int32 p = static_cast<int32>(((h >> 32) * num_parts) >> 32);
+      hashes[i] = h;
+      part_of[i] = p;
+      ++chunk_counts[p];
+    }
+  });
+
+  // Turn the counts into scatter offsets. Partitions are laid out one after
+  // another, and within a partition chunks keep their input order, so every
+  // partition sees its elements in increasing position.
+  std::vector<int64> part_begin(num_parts + 1, 0);
+  {
+    int64 offset = 0;
+    for (int p = 0; p < num_parts; ++p) {
+      part_begin[p] = offset;
+      for (int64 c = 0; c < num_chunks; ++c) {
+        const int64 count = offsets[c * num_parts + p];
+        offsets[c * num_parts + p] = offset;
+        offset += count;
+      }
+    }
+    part_begin[num_parts] = offset;
+  }
+  std::vector<int32> positions(N);
+  for_each_chunk([&](int64 c, int64 begin, int64 end) {
+    int64* chunk_offsets = &offsets[c * num_parts];
+    for (int64 i = begin; i < end; ++i) {
+      positions[chunk_offsets[part_of[i]]++] = static_cast<int32>(i);
+    }
+  });
+
+  // Deduplicate each partition, leaving partition-local ids in `idx` and
+  // flagging the first occurrence of every key.
+  std::vector<std::vector<T>> part_keys(num_parts);
+  std::vector<std::vector<TIndex>> part_counts(num_parts);
+  std::vector<uint8> is_first(N, 0);
+  for_each_part([&](int p) {
+    std::vector<T>& local_keys = part_keys[p];
+    std::vector<TIndex>& local_counts = part_counts[p];
+    FlatIdTable<TIndex> table(part_begin[p + 1] - part_begin[p]);
+    for (int64 k = part_begin[p]; k < part_begin[p + 1]; ++k) {
+      const int32 i = positions[k];
+      const T& value = in(i);
+      bool inserted;
+      const TIndex id = table.FindOrInsert(
+          hashes[i],
+          [&local_keys, &value](TIndex id) { return local_keys[id] == value; },
+          &inserted);
+      if (inserted) {
+        local_keys.push_back(value);
+        local_counts.push_back(0);
+        is_first[i] = 1;
+      }
+      ++local_counts[id];
+      idx(i) = id;
+    }
+  });
+
+  // Number the keys globally in order of first occurrence.
+  std::vector<int64> chunk_base(num_chunks + 1, 0);
+  for_each_chunk([&](int64 c, int64 begin, int64 end) {
+    chunk_base[c + 1] = std::count(is_first.begin() + begin,
+                                   is_first.begin() + end, uint8{1});
+  });
+  for (int64 c = 0; c < num_chunks; ++c) chunk_base[c + 1] += chunk_base[c];
+  std::vector<std::vector<TIndex>> global_id(num_parts);
+  for (int p = 0; p < num_parts; ++p) {
+    global_id[p].resize(part_keys[p].size());
+  }
+  for_each_chunk([&](int64 c, int64 begin, int64 end) {
+    TIndex next = static_cast<TIndex>(chunk_base[c]);
+    for (int64 i = begin; i < end; ++i) {
+      if (is_first[i]) global_id[part_of[i]][idx(i)] = next++;
+    }
+  });
+
+  keys->resize(chunk_base[num_chunks]);
+  if (counts != nullptr) counts->resize(chunk_base[num_chunks]);
+  for_each_part([&](int p) {
+    for (size_t l = 0; l < part_keys[p].size(); ++l) {
+      const TIndex g = global_id[p][l];
+      (*keys)[g] = std::move(part_keys[p][l]);
+      if (counts != nullptr) (*counts)[g] = part_counts[p][l];
+    }
+  });
+  for_each_chunk([&](int64 c, int64 begin, int64 end) {
+    for (int64 i = begin; i < end; ++i) {
+      idx(i) = global_id[part_of[i]][idx(i)];
+    }
+  });
+}
+
+}  // namespace
+
 template <typename T, typename TIndex>
 class UniqueOp : public OpKernel {
  public:
@@ -99,24 +321,32 @@ class UniqueOp : public OpKernel {
     auto idx_vec = idx->template vec<TIndex>();
 
     int64 uniq_size;
+    std::vector<TIndex> counts;
+    bool has_counts = false;
     if (new_sizes[0] == 1 && new_sizes[2] == 1) {
       // Specialized and faster implementation when unique is run over single
-      // elements. Here we put T directly into the map rather than ints pointing
-      // to them as in the general case.
+      // elements. Here we keep T directly as the keys rather than ints
+      // pointing to them as in the general case.
       auto Tin = input.flat<T>();
       const int64 N = static_cast<int64>(Tin.size());
+      std::vector<T> keys;
+      std::vector<TIndex>* counts_ptr =
+          num_outputs() > 2 ? &counts : nullptr;
 
-      std::unordered_map<T, TIndex> uniq;
-      uniq.reserve(2 * N);
-      for (Eigen::Index i = 0, j = 0; i < N; ++i) {
-        auto it = uniq.insert(std::make_pair(Tin(i), j));
-        idx_vec(i) = it.first->second;
-        if (it.second) {
-          ++j;
-        }
+      // Partitioned writes to std::vector<bool> would race, and bool has at
+      // most two keys anyway.
+      const DeviceBase::CpuWorkerThreads& worker_threads =
+          *context->device()->tensorflow_cpu_worker_threads();
+      if (!std::is_same<T, bool>::value && worker_threads.num_threads > 1 &&
+          N >= kMinParallelUniqueSize) {
+        UniqueParallel<T, TIndex>(worker_threads, Tin, idx_vec, &keys,
+                                  counts_ptr);
+      } else {
+        UniqueSerial<T, TIndex>(Tin, idx_vec, &keys, counts_ptr);
       }
+      has_counts = counts_ptr != nullptr;
 
-      uniq_size = static_cast<int64>(uniq.size());
+      uniq_size = static_cast<int64>(keys.size());
       TensorShape output_shape(input.shape());
       output_shape.set_dim(axis, uniq_size);
       Tensor* output = nullptr;
@@ -124,8 +354,8 @@ class UniqueOp : public OpKernel {
                      context->allocate_output(0, output_shape, &output));
       auto Tout = output->flat<T>();
 
-      for (auto it : uniq) {
-        Tout(it.second) = it.first;
+      for (int64 i = 0; i < uniq_size; ++i) {
+        Tout(i) = std::move(keys[i]);
       }
     } else {
       // General implementation when unique is run over multiple elements.
@@ -153,20 +383,18 @@ class UniqueOp : public OpKernel {
         return true;
       };
 
-      std::unordered_map<int64, int64, decltype(hash_fn), decltype(equal_to_fn)>
-          uniq(0, hash_fn, equal_to_fn);
-
-      uniq.reserve(2 * Tin.dimension(1));
-
-      for (int64 i = 0, j = 0; i < Tin.dimension(1); ++i) {
-        auto it = uniq.insert(std::make_pair(i, j));
-        idx_vec(i) = it.first->second;
-        if (it.second) {
-          ++j;
-        }
+      // `rows[id]` is the first row holding the slice with that id.
+      std::vector<int64> rows;
+      FlatIdTable<TIndex> uniq(Tin.dimension(1));
+      for (int64 i = 0; i < Tin.dimension(1); ++i) {
+        bool inserted;
+        idx_vec(i) = uniq.FindOrInsert(
+            MixHash(hash_fn(i)),
+            [&](TIndex id) { return equal_to_fn(rows[id], i); }, &inserted);
+        if (inserted) rows.push_back(i);
       }
 
-      uniq_size = static_cast<int64>(uniq.size());
+      uniq_size = static_cast<int64>(rows.size());
       new_sizes[1] = uniq_size;
       TensorShape output_shape(input.shape());
       output_shape.set_dim(axis, uniq_size);
@@ -175,8 +403,8 @@ class UniqueOp : public OpKernel {
                      context->allocate_output(0, output_shape, &output));
       auto Tout = output->shaped<T, 3>(new_sizes);
 
-      for (auto it : uniq) {
-        Tout.chip(it.second, 1) = Tin.chip(it.first, 1);
+      for (int64 id = 0; id < uniq_size; ++id) {
+        Tout.chip(id, 1) = Tin.chip(rows[id], 1);
       }
     }
 
@@ -185,10 +413,14 @@ class UniqueOp : public OpKernel {
       OP_REQUIRES_OK(context, context->allocate_output(
                                   2, TensorShape({uniq_size}), &output));
       auto count_output_vec = output->template vec<TIndex>();
-      count_output_vec.setZero();
-      const int N = idx_vec.size();
-      for (int64 i = 0; i < N; ++i) {
-        count_output_vec(idx_vec(i))++;
+      if (has_counts) {
+        std::copy(counts.begin(), counts.end(), count_output_vec.data());
+      } else {
+        count_output_vec.setZero();
+        const int N = idx_vec.size();
+        for (int64 i = 0; i < N; ++i) {
+          count_output_vec(idx_vec(i))++;
+        }
       }
     }
   }
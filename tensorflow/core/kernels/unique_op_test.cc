@@ -15,9 +15,14 @@ limitations under the License.
 
 #include <functional>
 #include <memory>
+#include <unordered_map>
+#include <vector>
 
 #include "tensorflow/core/common_runtime/kernel_benchmark_testlib.h"
+#include "tensorflow/core/framework/fake_input.h"
+#include "tensorflow/core/framework/node_def_builder.h"
 #include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
 #include "tensorflow/core/framework/tensor_shape.pb.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/framework/types.pb.h"
@@ -35,6 +40,103 @@ namespace {
 
 const int kMaxStrLen = 40;
 
+class UniqueOpTest : public OpsTestBase {
+ protected:
+  void MakeOp(const string& op, DataType index_type) {
+    NodeDefBuilder builder("unique_op", op);
+    builder.Input(FakeInput(DT_INT64));
+    if (op == "UniqueV2") builder.Input(FakeInput(DT_INT32));
+    TF_ASSERT_OK(builder.Attr("out_idx", index_type).Finalize(node_def()));
+    TF_ASSERT_OK(InitOp());
+  }
+
+  // Checks outputs against a straightforward serial deduplication.
+  void ExpectUnique(const std::vector<int64>& input, bool with_counts) {
+    std::unordered_map<int64, int64> first_id;
+    std::vector<int64> expected_y, expected_count;
+    std::vector<int32> expected_idx;
+    for (int64 value : input) {
+      auto it = first_id.emplace(value, expected_y.size()).first;
+      if (it->second == static_cast<int64>(expected_y.size())) {
+        expected_y.push_back(value);
+        expected_count.push_back(0);
+      }
+      expected_idx.push_back(it->second);
+      ++expected_count[it->second];
+    }
+    const int64 uniq_size = expected_y.size();
+    test::ExpectTensorEqual<int64>(
+        test::AsTensor<int64>(expected_y, {uniq_size}), *GetOutput(0));
+    test::ExpectTensorEqual<int32>(
+        test::AsTensor<int32>(expected_idx, {static_cast<int64>(input.size())}),
+        *GetOutput(1));
+    if (with_counts) {
+      Tensor expected(allocator(), DT_INT32, TensorShape({uniq_size}));
+      auto expected_vec = expected.vec<int32>();
+      for (int64 i = 0; i < uniq_size; ++i) {
+        expected_vec(i) = expected_count[i];
+      }
+      test::ExpectTensorEqual<int32>(expected, *GetOutput(2));
+    }
+  }
+};
+
+// Skewed ids that are large enough to take the parallel path.
+std::vector<int64> MakeLargeIds() {
+  std::vector<int64> ids(1 << 18);
+  for (size_t i = 0; i < ids.size(); ++i) {
+    ids[i] = (i % 7 == 0) ? static_cast<int64>(i) << 20 : (i * i) % 4099;
+  }
+  return ids;
+}
+
+TEST_F(UniqueOpTest, Simple) {
+  MakeOp("Unique", DT_INT32);
+  const std::vector<int64> input = {5, 1, 5, 7, 1, 1, 9, 5};
+  AddInputFromArray<int64>(TensorShape({8}), input);
+  TF_ASSERT_OK(RunOpKernel());
+  ExpectUnique(input, false);
+}
+
+TEST_F(UniqueOpTest, Large) {
+  MakeOp("Unique", DT_INT32);
+  const std::vector<int64> input = MakeLargeIds();
+  AddInputFromArray<int64>(TensorShape({static_cast<int64>(input.size())}),
+                           input);
+  TF_ASSERT_OK(RunOpKernel());
+  ExpectUnique(input, false);
+}
+
+TEST_F(UniqueOpTest, LargeWithCounts) {
+  MakeOp("UniqueWithCounts", DT_INT32);
+  const std::vector<int64> input = MakeLargeIds();
+  AddInputFromArray<int64>(TensorShape({static_cast<int64>(input.size())}),
+                           input);
+  TF_ASSERT_OK(RunOpKernel());
+  ExpectUnique(input, true);
+}
+
+TEST_F(UniqueOpTest, LargeV2NoAxis) {
+  MakeOp("UniqueV2", DT_INT32);
+  const std::vector<int64> input = MakeLargeIds();
+  AddInputFromArray<int64>(TensorShape({static_cast<int64>(input.size())}),
+                           input);
+  AddInputFromArray<int32>(TensorShape({0}), {});
+  TF_ASSERT_OK(RunOpKernel());
+  ExpectUnique(input, false);
+}
+
+TEST_F(UniqueOpTest, V2Axis) {
+  MakeOp("UniqueV2", DT_INT32);
+  AddInputFromArray<int64>(TensorShape({4, 2}), {1, 2, 3, 4, 1, 2, 3, 5});
+  AddInputFromArray<int32>(TensorShape({1}), {0});
+  TF_ASSERT_OK(RunOpKernel());
+  test::ExpectTensorEqual<int64>(
+      test::AsTensor<int64>({1, 2, 3, 4, 3, 5}, {3, 2}), *GetOutput(0));
+  test::ExpectTensorEqual<int32>(test::AsTensor<int32>({0, 1, 0, 2}, {4}),
+                                 *GetOutput(1));
+}
+
 TensorProto GetRandomInt32TensorProto(int dim, int max_int) {
   TensorProto tensor_proto;
   tensor_proto.set_dtype(DT_INT32);
@@ -189,5 +291,35 @@ BENCHMARK(BM_Unique_STRING)
     ->Arg(64 * 1024)
     ->Arg(256 * 1024);
 
+static void BM_UniqueWithCounts_INT64(int iters, int dim, int max_int) {
+  testing::StopTiming();
+  Graph* g = new Graph(OpRegistry::Global());
+
+  Tensor input(DT_INT64, TensorShape({dim}));
+  auto input_vec = input.vec<int64>();
+  for (int i = 0; i < dim; ++i) {
+    input_vec(i) = std::rand() % max_int;
+  }
+
+  Node* node;
+  TF_CHECK_OK(NodeBuilder(g->NewName("n"), "UniqueWithCounts")
+                  .Input(test::graph::Constant(g, input))
+                  .Attr("T", DT_INT64)
+                  .Finalize(g, &node));
+
+  testing::BytesProcessed(static_cast<int64>(iters) * dim * sizeof(int64));
+  testing::UseRealTime();
+  testing::StartTiming();
+  test::Benchmark("cpu", g).Run(iters);
+}
+
+BENCHMARK(BM_UniqueWithCounts_INT64)
+    ->ArgPair(16 * 1024, 1024)
+    ->ArgPair(16 * 1024, 1024 * 1024)
+    ->ArgPair(1024 * 1024, 1024)
+    ->ArgPair(1024 * 1024, 1024 * 1024)
+    ->ArgPair(8 * 1024 * 1024, 1024 * 1024)
+    ->ArgPair(8 * 1024 * 1024, 64 * 1024 * 1024);
+
 }  // namespace
 }  // namespace tensorflow
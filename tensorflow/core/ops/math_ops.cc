@@ -945,6 +945,8 @@ REGISTER_OP("_FusedMatMul")
     .Attr("fused_ops: list(string) = []")
     // Attributes for the FusedBatchNorm ----------- //
     .Attr("epsilon: float = 0.0001")
+    // Attributes for the LeakyRelu ---------------- //
+    .Attr("leakyrelu_alpha: float = 0.2")
     // --------------------------------------------- //
     .SetShapeFn(shape_inference::MatMulShape)
     .Doc(R"doc(
@@ -1167,6 +1169,32 @@ Status SparseSegmentReductionGradShapeFn(InferenceContext* c) {
   return Status::OK();
 }
 
+Status FusedSparseSegmentReductionShapeFn(InferenceContext* c) {
+  ShapeHandle params_shape;
+  TF_RETURN_IF_ERROR(c->WithRankAtLeast(c->input(0), 1, &params_shape));
+
+  ShapeHandle unused;
+  TF_RETURN_IF_ERROR(c->WithRank(c->input(1), 1, &unused));
+
+  ShapeHandle indices_shape;
+  TF_RETURN_IF_ERROR(c->WithRank(c->input(2), 1, &indices_shape));
+
+  ShapeHandle segment_ids_shape;
+  TF_RETURN_IF_ERROR(c->WithRank(c->input(3), 1, &segment_ids_shape));
+
+  // indices and segment_ids should merge cleanly.
+  TF_RETURN_IF_ERROR(c->Merge(indices_shape, segment_ids_shape, &unused));
+
+  ShapeHandle subshape;
+  TF_RETURN_IF_ERROR(c->Subshape(params_shape, 1, &subshape));
+
+  ShapeHandle out;
+  TF_RETURN_IF_ERROR(
+      c->Concatenate(c->Vector(InferenceContext::kUnknownDim), subshape, &out));
+  c->set_output(0, out);
+  return Status::OK();
+}
+
 Status SparseSegmentReductionWithNumSegmentsShapeFn(InferenceContext* c) {
   ShapeHandle data_shape;
   TF_RETURN_IF_ERROR(c->WithRankAtLeast(c->input(0), 1, &data_shape));
@@ -1367,6 +1395,72 @@ REGISTER_OP("SparseSegmentSqrtNGrad")
     .Attr("Tidx: {int32, int64} = DT_INT32")
     .SetShapeFn(SparseSegmentReductionGradShapeFn);
 
+// Fused GatherV2(params, gather_indices) + SparseSegment{Sum,Mean,SqrtN}.
+// Rows of `params` are reduced straight into their output segments without
+// materializing the gathered tensor.
+REGISTER_OP("_FusedSparseSegmentSum")
+    .Input("params: T")
+    .Input("gather_indices: Tgather")
+    .Input("indices: Tidx")
+    .Input("segment_ids: int32")
+    .Output("output: T")
+    .Attr("T: {float, double}")
+    .Attr("Tidx: {int32, int64} = DT_INT32")
+    .Attr("Tgather: {int32, int64} = DT_INT32")
+    .SetShapeFn(FusedSparseSegmentReductionShapeFn)
+    .Doc(R"doc(
+*NOTE*: Do not invoke this operator directly in Python. Grappler is
+expected to create these operators.
+)doc");
+
+REGISTER_OP("_FusedSparseSegmentMean")
+    .Input("params: T")
+    .Input("gather_indices: Tgather")
+    .Input("indices: Tidx")
+    .Input("segment_ids: int32")
+    .Output("output: T")
+    .Attr("T: {float, double}")
+    .Attr("Tidx: {int32, int64} = DT_INT32")
+    .Attr("Tgather: {int32, int64} = DT_INT32")
+    .SetShapeFn(FusedSparseSegmentReductionShapeFn)
+    .Doc(R"doc(
+*NOTE*: Do not invoke this operator directly in Python. Grappler is
+expected to create these operators.
+)doc");
+
+REGISTER_OP("_FusedSparseSegmentSqrtN")
+    .Input("params: T")
+    .Input("gather_indices: Tgather")
+    .Input("indices: Tidx")
+    .Input("segment_ids: int32")
+    .Output("output: T")
+    .Attr("T: {float, double}")
+    .Attr("Tidx: {int32, int64} = DT_INT32")
+    .Attr("Tgather: {int32, int64} = DT_INT32")
+    .SetShapeFn(FusedSparseSegmentReductionShapeFn)
+    .Doc(R"doc(
+*NOTE*: Do not invoke this operator directly in Python. Grappler is
+expected to create these operators.
+)doc");
+
+// Fused GatherV2(grad, segment_ids, axis=0) + UnsortedSegmentSum(indices),
+// i.e. the gradient of SparseSegmentSum with respect to its data. Output rows
+// line up with the gather indices of the forward pass, so together they form
+// the IndexedSlices gradient of the embedding table.
+REGISTER_OP("_FusedSparseSegmentSumGrad")
+    .Input("grad: T")
+    .Input("indices: Tidx")
+    .Input("segment_ids: int32")
+    .Input("output_dim0: int32")
+    .Output("output: T")
+    .Attr("T: {float, double}")
+    .Attr("Tidx: {int32, int64} = DT_INT32")
+    .SetShapeFn(SparseSegmentReductionGradShapeFn)
+    .Doc(R"doc(
+*NOTE*: Do not invoke this operator directly in Python. Grappler is
+expected to create these operators.
+)doc");
+
 REGISTER_OP("All")
     .Input("input: bool")
     .Input("reduction_indices: Tidx")
@@ -1689,6 +1783,47 @@ REGISTER_OP("QuantizedMatMul")
       return Status::OK();
     });
 
+REGISTER_OP("_QuantizedInt8MatMul")
+    .Input("a: Tinput")
+    .Input("b: qint8")
+    .Input("bias: float")
+    .Input("min_a: float")
+    .Input("max_a: float")
+    .Input("min_b: float")
+    .Input("max_b: float")
+    .Input("min_output: float")
+    .Input("max_output: float")
+    .Output("output: Toutput")
+    .Attr("Tinput: {qint8, float}")
+    .Attr("Toutput: {qint8, float} = DT_FLOAT")
+    .Attr("transpose_a: bool = false")
+    .Attr("transpose_b: bool = false")
+    .SetShapeFn([](InferenceContext* c) {
+      TF_RETURN_IF_ERROR(shape_inference::MatMulShape(c));
+      ShapeHandle unused;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(2), 1, &unused));
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(3), 0, &unused));
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(4), 0, &unused));
+      TF_RETURN_IF_ERROR(c->WithRankAtMost(c->input(5), 1, &unused));
+      TF_RETURN_IF_ERROR(c->WithRankAtMost(c->input(6), 1, &unused));
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(7), 0, &unused));
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(8), 0, &unused));
+      return Status::OK();
+    })
+    .Doc(R"doc(
+Computes `output = a * b + bias` with int8 arithmetic.
+
+`a` is quantized per tensor with an asymmetric range [min_a, max_a], which is
+nudged like FakeQuantWithMinMaxVars so that 0 is exactly representable. A float
+`a` is quantized by the kernel. `b` is quantized symmetrically, per output
+channel if `min_b` and `max_b` are vectors: the scale of a channel is
+max(|min_b|, |max_b|) / 127. The output is dequantized to float, or requantized
+to the range [min_output, max_output], which is only used for a qint8 output.
+
+*NOTE*: Do not invoke this operator directly in Python. Grappler is
+expected to create these operators.
+)doc");
+
 // Note: This op is not commutative w.r.t. to all its inputs.
 REGISTER_OP("QuantizedMul")
     .Input("x: T1")
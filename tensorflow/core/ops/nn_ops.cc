@@ -398,6 +398,8 @@ REGISTER_OP("_FusedConv2D")
     .Attr("fused_ops: list(string) = []")
     // Attributes for the FusedBatchNorm ------------------------------------ //
     .Attr("epsilon: float = 0.0001")
+    // Attributes for the LeakyRelu ----------------------------------------- //
+    .Attr("leakyrelu_alpha: float = 0.2")
     // ---------------------------------------------------------------------- //
     .SetShapeFn(shape_inference::Conv2DShapeWithExplicitPadding)
     .Doc(R"doc(
@@ -3212,6 +3214,46 @@ REGISTER_OP("QuantizedConv2DPerChannel")
       return Status::OK();
     });
 
+REGISTER_OP("_QuantizedInt8Conv2D")
+    .Input("input: Tinput")
+    .Input("filter: qint8")
+    .Input("bias: float")
+    .Input("min_input: float")
+    .Input("max_input: float")
+    .Input("min_filter: float")
+    .Input("max_filter: float")
+    .Input("min_output: float")
+    .Input("max_output: float")
+    .Output("output: Toutput")
+    .Attr("Tinput: {qint8, float}")
+    .Attr("Toutput: {qint8, float} = DT_FLOAT")
+    .Attr("strides: list(int)")
+    .Attr(GetPaddingAttrString())
+    .Attr(GetConvnetDataFormatAttrString())
+    .Attr("dilations: list(int) = [1, 1, 1, 1]")
+    .SetShapeFn([](InferenceContext* c) {
+      TF_RETURN_IF_ERROR(shape_inference::Conv2DShape(c));
+      ShapeHandle unused;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(2), 1, &unused));
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(3), 0, &unused));
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(4), 0, &unused));
+      TF_RETURN_IF_ERROR(c->WithRankAtMost(c->input(5), 1, &unused));
+      TF_RETURN_IF_ERROR(c->WithRankAtMost(c->input(6), 1, &unused));
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(7), 0, &unused));
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(8), 0, &unused));
+      return Status::OK();
+    })
+    .Doc(R"doc(
+Computes `output = conv2d(input, filter) + bias` with int8 arithmetic.
+
+The quantization of `input`, `filter` and `output` is the same as the one of
+`a`, `b` and `output` in _QuantizedInt8MatMul, with per output channel filter
+ranges.
+
+*NOTE*: Do not invoke this operator directly in Python. Grappler is
+expected to create these operators.
+)doc");
+
 REGISTER_OP("QuantizedDepthwiseConv2D")
     .Input("input: Tinput")
     .Input("filter: Tfilter")
@@ -216,6 +216,31 @@ REGISTER_OP("StringSplitV2")
       return Status::OK();
     });
 
+REGISTER_OP("_StringSplitToHashBucketFast")
+    .Input("input: string")
+    .Input("delimiter: string")
+    .Output("indices: int64")
+    .Output("values: int64")
+    .Output("shape: int64")
+    .Attr("skip_empty: bool = true")
+    .Attr("num_buckets: int >= 1")
+    .SetShapeFn([](InferenceContext* c) {
+      ShapeHandle unused;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(0), 1, &unused));
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(1), 0, &unused));
+
+      c->set_output(0, c->Matrix(InferenceContext::kUnknownDim, 2));
+      c->set_output(1, c->Vector(InferenceContext::kUnknownDim));
+      c->set_output(2, c->Vector(2));
+      return Status::OK();
+    })
+    .Doc(R"doc(
+StringSplit followed by StringToHashBucketFast on the resulting tokens.
+
+*NOTE*: Do not invoke this operator directly in Python. Grappler is
+expected to create these operators.
+)doc");
+
 REGISTER_OP("StringLower")
     .Input("input: string")
     .Output("output: string")
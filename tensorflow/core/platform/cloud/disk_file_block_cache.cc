@@ -0,0 +1,463 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/platform/cloud/disk_file_block_cache.h"
+#include <algorithm>
+#include <cstring>
+#include <tuple>
+#include "tensorflow/core/lib/core/coding.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/raw_coding.h"
+#include "tensorflow/core/lib/hash/crc32c.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/random/random.h"
+#include "tensorflow/core/lib/strings/str_util.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/file_statistics.h"
+#include "tensorflow/core/platform/fingerprint.h"
+#include "tensorflow/core/platform/logging.h"
+
+namespace tensorflow {
+namespace {
+
+constexpr char kBlockSuffix[] = ".blk";
+constexpr char kTempSuffix[] = ".tmp";
+
+// Block file layout (all integers little-endian):
+//
+//   magic          fixed32
+//   masked crc32c  fixed32  (covers every byte after this field)
+//   signature      fixed64
+//   offset         fixed64
+//   timestamp      fixed64  (seconds since epoch when the block was written)
+//   data size      fixed64
+//   filename size  fixed32
+//   filename       bytes
+//   data           bytes
+constexpr uint32 kBlockMagic = 0x6b6c4246;  // "FBlk"
+constexpr size_t kCrcOffset = 4;
+constexpr size_t kHeaderSize = 44;
+
+// Returns the name of the block file holding `offset` of `filename` at
+// `file_signature`. The name starts with the filename fingerprint so that the
+// blocks of a file form a contiguous range of the index.
+string FilePrefix(const string& filename) {
+  return strings::StrCat(
+      strings::Hex(Fingerprint64(filename), strings::kZeroPad16), "_");
+}
+
+string SignatureString(int64 file_signature) {
+  return strings::StrCat(strings::Hex(file_signature, strings::kZeroPad16));
+}
+
+string BlockName(const string& filename, int64 file_signature, size_t offset) {
+  return strings::StrCat(
+      FilePrefix(filename), SignatureString(file_signature), "_",
+      strings::Hex(static_cast<uint64>(offset), strings::kZeroPad16));
+}
+
+// Returns a new, unique name for a file holding the block `name`. Every insert
+// writes its own file, so a file that was dropped from the index and is about
+// to be deleted is never the file of a later insert of the same block.
+string NewBlockFileName(const string& name) {
+  return strings::StrCat(name, ".",
+                         strings::Hex(random::New64(), strings::kZeroPad16),
+                         kBlockSuffix);
+}
+
+// Returns the block name of the block file `file`, the inverse of
+// NewBlockFileName.
+string BlockNameOfFile(const string& file) {
+  return file.substr(0, file.find('.'));
+}
+
+// Reads exactly `n` bytes at `offset` of `file` into `scratch`.
+Status ReadFully(RandomAccessFile* file, uint64 offset, size_t n,
+                 char* scratch) {
+  StringPiece result;
+  Status s = file->Read(offset, n, &result, scratch);
+  // A short read is reported as OutOfRange, and surfaces as truncation below.
+  if (!s.ok() && !errors::IsOutOfRange(s)) {
+    return s;
+  }
+  if (result.size() != n) {
+    return errors::DataLoss("Truncated block file: read ", result.size(),
+                            " of ", n, " bytes");
+  }
+  if (result.data() != scratch) {
+    memcpy(scratch, result.data(), n);
+  }
+  return Status::OK();
+}
+
+}  // namespace
+
+DiskFileBlockCache::DiskFileBlockCache(size_t block_size, size_t max_bytes,
+                                       uint64 max_staleness,
+                                       const string& cache_dir,
+                                       size_t max_disk_bytes,
+                                       BlockFetcher block_fetcher, Env* env)
+    : block_size_(block_size),
+      max_bytes_(max_bytes),
+      max_staleness_(max_staleness),
+      cache_dir_(cache_dir),
+      max_disk_bytes_(max_disk_bytes),
+      block_fetcher_(block_fetcher),
+      env_(env) {
+  if (block_size_ > 0 && max_disk_bytes_ > 0 && !cache_dir_.empty()) {
+    Status s = env_->RecursivelyCreateDir(cache_dir_);
+    if (s.ok()) {
+      disk_enabled_ = true;
+      LoadIndex();
+    } else {
+      LOG(WARNING) << "Disabling the disk block cache in " << cache_dir_
+                   << ": " << s;
+    }
+  }
+  // The RAM tier always holds at least one block when the disk tier is on, so
+  // that the reads reaching FetchBlock stay block-aligned.
+  const size_t ram_bytes =
+      disk_enabled_ ? std::max(max_bytes_, block_size_) : max_bytes_;
+  ram_cache_.reset(new RamFileBlockCache(
+      block_size_, ram_bytes, max_staleness_,
+      [this](const string& filename, size_t offset, size_t n, char* buffer,
+             size_t* bytes_transferred) {
+        return FetchBlock(filename, offset, n, buffer, bytes_transferred);
+      },
+      env_));
+  VLOG(1) << "GCS disk block cache is "
+          << (disk_enabled_ ? "enabled in " + cache_dir_ : "disabled");
+}
+
+Status DiskFileBlockCache::Read(const string& filename, size_t offset, size_t n,
+                                char* buffer, size_t* bytes_transferred) {
+  return ram_cache_->Read(filename, offset, n, buffer, bytes_transferred);
+}
+
+bool DiskFileBlockCache::ValidateAndUpdateFileSignature(const string& filename,
+                                                        int64 file_signature) {
+  if (disk_enabled_) {
+    std::vector<string> to_delete;
+    {
+      mutex_lock lock(mu_);
+      auto it = file_signature_map_.find(filename);
+      if (it == file_signature_map_.end() || it->second != file_signature) {
+        // Blocks written by an earlier process (or before the file changed)
+        // under a different signature can never be read again.
+        RemoveFile_Locked(filename, &file_signature, &to_delete);
+        file_signature_map_[filename] = file_signature;
+      }
+    }
+    DeleteFiles(to_delete);
+  }
+  return ram_cache_->ValidateAndUpdateFileSignature(filename, file_signature);
+}
+
+void DiskFileBlockCache::RemoveFile(const string& filename) {
+  ram_cache_->RemoveFile(filename);
+  std::vector<string> to_delete;
+  {
+    mutex_lock lock(mu_);
+    RemoveFile_Locked(filename, nullptr, &to_delete);
+    file_signature_map_.erase(filename);
+  }
+  DeleteFiles(to_delete);
+}
+
+void DiskFileBlockCache::Flush() {
+  ram_cache_->Flush();
+  std::vector<string> to_delete;
+  {
+    mutex_lock lock(mu_);
+    while (!index_.empty()) {
+      RemoveDiskBlock_Locked(index_.begin(), &to_delete);
+    }
+  }
+  DeleteFiles(to_delete);
+}
+
+size_t DiskFileBlockCache::DiskCacheSize() const {
+  mutex_lock lock(mu_);
+  return disk_size_;
+}
+
+Status DiskFileBlockCache::FetchBlock(const string& filename, size_t offset,
+                                      size_t n, char* buffer,
+                                      size_t* bytes_transferred) {
+  if (!disk_enabled_ || n != block_size_ || offset % block_size_ != 0) {
+    // Reads larger than the RAM tier bypass the block structure entirely.
+    return block_fetcher_(filename, offset, n, buffer, bytes_transferred);
+  }
+  int64 file_signature = 0;
+  {
+    mutex_lock lock(mu_);
+    auto it = file_signature_map_.find(filename);
+    if (it != file_signature_map_.end()) {
+      file_signature = it->second;
+    }
+  }
+  const string name = BlockName(filename, file_signature, offset);
+  Status s = ReadDiskBlock(name, filename, file_signature, offset, buffer,
+                           bytes_transferred);
+  if (s.ok()) {
+    return s;
+  }
+  if (!errors::IsNotFound(s)) {
+    LOG(WARNING) << "Discarding disk cache block " << name << ": " << s;
+  }
+  TF_RETURN_IF_ERROR(
+      block_fetcher_(filename, offset, n, buffer, bytes_transferred));
+  s = WriteDiskBlock(name, filename, file_signature, offset, buffer,
+                     *bytes_transferred);
+  if (!s.ok()) {
+    // The disk tier is best-effort; the block was still fetched.
+    LOG(WARNING) << "Failed to write disk cache block " << name << ": " << s;
+  }
+  return Status::OK();
+}
+
+Status DiskFileBlockCache::ReadDiskBlock(const string& name,
+                                         const string& filename,
+                                         int64 file_signature, size_t offset,
+                                         char* buffer,
+                                         size_t* bytes_transferred) {
+  *bytes_transferred = 0;
+  string block_file;
+  {
+    mutex_lock lock(mu_);
+    auto entry = index_.find(name);
+    if (entry == index_.end()) {
+      return errors::NotFound("Block ", name, " is not cached on disk");
+    }
+    if (entry->second.lru_iterator != lru_list_.begin()) {
+      lru_list_.erase(entry->second.lru_iterator);
+      lru_list_.push_front(name);
+      entry->second.lru_iterator = lru_list_.begin();
+    }
+    block_file = entry->second.file;
+  }
+  // Drops the block from the index, unless it was replaced by a newer insert
+  // since it was looked up.
+  auto discard = [this, &name, &block_file](const Status& s) {
+    std::vector<string> to_delete;
+    {
+      mutex_lock lock(mu_);
+      auto entry = index_.find(name);
+      if (entry != index_.end() && entry->second.file == block_file) {
+        RemoveDiskBlock_Locked(entry, &to_delete);
+      }
+    }
+    DeleteFiles(to_delete);
+    return s;
+  };
+
+  std::unique_ptr<RandomAccessFile> file;
+  Status s =
+      env_->NewRandomAccessFile(io::JoinPath(cache_dir_, block_file), &file);
+  if (!s.ok()) return discard(s);
+  char header[kHeaderSize];
+  s = ReadFully(file.get(), 0, kHeaderSize, header);
+  if (!s.ok()) return discard(s);
+  if (core::DecodeFixed32(header) != kBlockMagic) {
+    return discard(errors::DataLoss("Bad magic number"));
+  }
+  const uint32 expected_crc =
+      crc32c::Unmask(core::DecodeFixed32(header + kCrcOffset));
+  const int64 stored_signature =
+      static_cast<int64>(core::DecodeFixed64(header + 8));
+  const uint64 stored_offset = core::DecodeFixed64(header + 16);
+  const uint64 timestamp = core::DecodeFixed64(header + 24);
+  const uint64 data_size = core::DecodeFixed64(header + 32);
+  const uint32 filename_size = core::DecodeFixed32(header + 40);
+  if (stored_signature != file_signature || stored_offset != offset ||
+      filename_size != filename.size() || data_size > block_size_) {
+    return discard(errors::DataLoss("Block header does not match ", filename,
+                                    " @ ", offset));
+  }
+  if (max_staleness_ > 0 && env_->NowSeconds() - timestamp > max_staleness_) {
+    return discard(errors::NotFound("Block ", name, " is stale"));
+  }
+  string stored_filename(filename_size, '\0');
+  s = ReadFully(file.get(), kHeaderSize, filename_size, &stored_filename[0]);
+  if (!s.ok()) return discard(s);
+  if (stored_filename != filename) {
+    return discard(errors::DataLoss("Block belongs to ", stored_filename));
+  }
+  s = ReadFully(file.get(), kHeaderSize + filename_size, data_size, buffer);
+  if (!s.ok()) return discard(s);
+  uint32 crc = crc32c::Value(header + kCrcOffset + 4,
+                             kHeaderSize - kCrcOffset - 4);
+  crc = crc32c::Extend(crc, stored_filename.data(), filename_size);
+  crc = crc32c::Extend(crc, buffer, data_size);
+  if (crc != expected_crc) {
+    return discard(errors::DataLoss("Checksum mismatch"));
+  }
+  *bytes_transferred = data_size;
+  return Status::OK();
+}
+
+Status DiskFileBlockCache::WriteDiskBlock(const string& name,
+                                          const string& filename,
+                                          int64 file_signature, size_t offset,
+                                          const char* data, size_t n) {
+  const size_t file_size = kHeaderSize + filename.size() + n;
+  if (file_size > max_disk_bytes_) {
+    return Status::OK();
+  }
+  char header[kHeaderSize];
+  core::EncodeFixed32(header, kBlockMagic);
+  core::EncodeFixed64(header + 8, static_cast<uint64>(file_signature));
+  core::EncodeFixed64(header + 16, offset);
+  core::EncodeFixed64(header + 24, env_->NowSeconds());
+  core::EncodeFixed64(header + 32, n);
+  core::EncodeFixed32(header + 40, filename.size());
+  uint32 crc = crc32c::Value(header + kCrcOffset + 4,
+                             kHeaderSize - kCrcOffset - 4);
+  crc = crc32c::Extend(crc, filename.data(), filename.size());
+  crc = crc32c::Extend(crc, data, n);
+  core::EncodeFixed32(header + kCrcOffset, crc32c::Mask(crc));
+
+  // Write a new file under a temporary name, sync it and rename it into
+  // place, so that the block file is either absent or complete and durable.
+  const string block_file = NewBlockFileName(name);
+  const string path = io::JoinPath(cache_dir_, block_file);
+  const string temp_path = strings::StrCat(path, kTempSuffix);
+  {
+    std::unique_ptr<WritableFile> file;
+    TF_RETURN_IF_ERROR(env_->NewWritableFile(temp_path, &file));
+    Status s = file->Append(StringPiece(header, kHeaderSize));
+    if (s.ok()) s = file->Append(filename);
+    if (s.ok()) s = file->Append(StringPiece(data, n));
+    if (s.ok()) s = file->Sync();
+    if (s.ok()) s = file->Close();
+    if (s.ok()) s = env_->RenameFile(temp_path, path);
+    if (!s.ok()) {
+      env_->DeleteFile(temp_path).IgnoreError();
+      return s;
+    }
+  }
+
+  std::vector<string> to_delete;
+  {
+    mutex_lock lock(mu_);
+    auto entry = index_.find(name);
+    if (entry != index_.end()) {
+      // Another thread cached the same block; keep the newer file.
+      to_delete.push_back(io::JoinPath(cache_dir_, entry->second.file));
+      disk_size_ -= entry->second.size;
+      entry->second.file = block_file;
+      entry->second.size = file_size;
+      disk_size_ += file_size;
+    } else {
+      lru_list_.push_front(name);
+      index_.emplace(name,
+                     DiskBlock{block_file, file_size, lru_list_.begin()});
+      disk_size_ += file_size;
+    }
+    Trim(&to_delete);
+  }
+  DeleteFiles(to_delete);
+  return Status::OK();
+}
+
+void DiskFileBlockCache::LoadIndex() {
+  std::vector<string> children;
+  Status s = env_->GetChildren(cache_dir_, &children);
+  if (!s.ok()) {
+    LOG(WARNING) << "Failed to list the disk block cache in " << cache_dir_
+                 << ": " << s;
+    return;
+  }
+  // (mtime, name, size) of every block file, oldest first.
+  std::vector<std::tuple<int64, string, size_t>> blocks;
+  std::vector<string> to_delete;
+  for (const string& child : children) {
+    const string path = io::JoinPath(cache_dir_, child);
+    if (str_util::EndsWith(child, kTempSuffix)) {
+      // Left behind by a process that died while writing a block.
+      to_delete.push_back(path);
+    } else if (str_util::EndsWith(child, kBlockSuffix)) {
+      FileStatistics stat;
+      if (env_->Stat(path, &stat).ok() && !stat.is_directory) {
+        blocks.emplace_back(stat.mtime_nsec, child, stat.length);
+      }
+    }
+  }
+  std::sort(blocks.begin(), blocks.end());
+  {
+    mutex_lock lock(mu_);
+    for (const auto& block : blocks) {
+      const string& block_file = std::get<1>(block);
+      const string name = BlockNameOfFile(block_file);
+      auto entry = index_.find(name);
+      if (entry != index_.end()) {
+        // An older file of the same block, left by a crash between inserting
+        // a newer file and deleting this one.
+        RemoveDiskBlock_Locked(entry, &to_delete);
+      }
+      lru_list_.push_front(name);
+      index_.emplace(name, DiskBlock{block_file, std::get<2>(block),
+                                     lru_list_.begin()});
+      disk_size_ += std::get<2>(block);
+    }
+    Trim(&to_delete);
+  }
+  DeleteFiles(to_delete);
+  VLOG(1) << "Loaded " << blocks.size() << " blocks from the disk block cache "
+          << "in " << cache_dir_;
+}
+
+void DiskFileBlockCache::Trim(std::vector<string>* to_delete) {
+  while (!lru_list_.empty() && disk_size_ > max_disk_bytes_) {
+    RemoveDiskBlock_Locked(index_.find(lru_list_.back()), to_delete);
+  }
+}
+
+void DiskFileBlockCache::RemoveDiskBlock_Locked(
+    DiskIndex::iterator entry, std::vector<string>* to_delete) {
+  to_delete->push_back(io::JoinPath(cache_dir_, entry->second.file));
+  lru_list_.erase(entry->second.lru_iterator);
+  disk_size_ -= entry->second.size;
+  index_.erase(entry);
+}
+
+void DiskFileBlockCache::RemoveFile_Locked(const string& filename,
+                                           const int64* keep_signature,
+                                           std::vector<string>* to_delete) {
+  const string prefix = FilePrefix(filename);
+  const string keep =
+      keep_signature != nullptr
+          ? strings::StrCat(prefix, SignatureString(*keep_signature), "_")
+          : string();
+  auto it = index_.lower_bound(prefix);
+  while (it != index_.end() && str_util::StartsWith(it->first, prefix)) {
+    auto next = std::next(it);
+    if (keep.empty() || !str_util::StartsWith(it->first, keep)) {
+      RemoveDiskBlock_Locked(it, to_delete);
+    }
+    it = next;
+  }
+}
+
+void DiskFileBlockCache::DeleteFiles(const std::vector<string>& paths) {
+  for (const string& path : paths) {
+    Status s = env_->DeleteFile(path);
+    if (!s.ok() && !errors::IsNotFound(s)) {
+      LOG(WARNING) << "Failed to delete disk cache block " << path << ": " << s;
+    }
+  }
+}
+
+}  // namespace tensorflow
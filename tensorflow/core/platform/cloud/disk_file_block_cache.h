@@ -0,0 +1,187 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_PLATFORM_CLOUD_DISK_FILE_BLOCK_CACHE_H_
+#define TENSORFLOW_CORE_PLATFORM_CLOUD_DISK_FILE_BLOCK_CACHE_H_
+
+#include <list>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/cloud/file_block_cache.h"
+#include "tensorflow/core/platform/cloud/ram_file_block_cache.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+/// \brief A two-tier block cache of file contents, keyed by {filename, offset}.
+///
+/// Blocks are served from an in-memory RamFileBlockCache first. Blocks that
+/// miss in RAM are looked up in a bounded local directory (e.g. on a local SSD)
+/// before being fetched from the backing filesystem, and every block fetched
+/// remotely is written back to that directory.
+///
+/// Each block is stored in its own file together with the filename, file
+/// signature, offset and a crc32c checksum of its contents. Files are written
+/// and synced under a temporary name and renamed into place, so a crash can
+/// leave at most a stray temporary file (removed on the next start) or a block
+/// that fails its checksum (discarded on read). Every insert writes a file
+/// with a new name, so files deleted outside the lock after an eviction never
+/// belong to a concurrent re-insert of the same block. Blocks left by a
+/// previous process are reused as long as the file signature reported through
+/// ValidateAndUpdateFileSignature still matches.
+///
+/// The disk tier is evicted in LRU order once it holds more than
+/// `max_disk_bytes`. Across restarts, the LRU order is rebuilt from the block
+/// files' modification times.
+class DiskFileBlockCache : public FileBlockCache {
+ public:
+  DiskFileBlockCache(size_t block_size, size_t max_bytes, uint64 max_staleness,
+                     const string& cache_dir, size_t max_disk_bytes,
+                     BlockFetcher block_fetcher, Env* env = Env::Default());
+
+  /// Read `n` bytes from `filename` starting at `offset` into `out`. The
+  /// returned status follows the contract of FileBlockCache::Read.
+  Status Read(const string& filename, size_t offset, size_t n, char* buffer,
+              size_t* bytes_transferred) override;
+
+  // Validate the given file signature with the existing file signature in the
+  // cache. Returns true if the signature doesn't change or the file doesn't
+  // exist before. If the signature changes, update the existing signature with
+  // the new one and remove the file from both tiers.
+  bool ValidateAndUpdateFileSignature(const string& filename,
+                                      int64 file_signature) override
+      LOCKS_EXCLUDED(mu_);
+
+  /// Remove all cached blocks for `filename` from both tiers.
+  void RemoveFile(const string& filename) override LOCKS_EXCLUDED(mu_);
+
+  /// Remove all cached data from both tiers.
+  void Flush() override LOCKS_EXCLUDED(mu_);
+
+  /// Accessors for cache parameters. `max_bytes` refers to the RAM tier.
+  size_t block_size() const override { return block_size_; }
+  size_t max_bytes() const override { return max_bytes_; }
+  uint64 max_staleness() const override { return max_staleness_; }
+  const string& cache_dir() const { return cache_dir_; }
+  size_t max_disk_bytes() const { return max_disk_bytes_; }
+
+  /// The current size (in bytes) of the RAM tier.
+  size_t CacheSize() const override { return ram_cache_->CacheSize(); }
+
+  /// The current size (in bytes) of the block files in the disk tier.
+  size_t DiskCacheSize() const LOCKS_EXCLUDED(mu_);
+
+  // Returns true if the cache is enabled. If false, the BlockFetcher callback
+  // is always executed during Read.
+  bool IsCacheEnabled() const override {
+    return block_size_ > 0 && (max_bytes_ > 0 || disk_enabled_);
+  }
+
+ private:
+  /// \brief A block file in the disk tier.
+  struct DiskBlock {
+    /// Name of the block file in `cache_dir_`.
+    string file;
+    /// Size of the block file, including its header.
+    size_t size;
+    /// A list iterator pointing to the block's position in the LRU list.
+    std::list<string>::iterator lru_iterator;
+  };
+
+  /// \brief The disk index type, keyed by block name.
+  ///
+  /// Block names start with the fingerprint of the remote filename, so all
+  /// blocks of one file are adjacent in the map.
+  typedef std::map<string, DiskBlock> DiskIndex;
+
+  /// The fetcher used by the RAM tier: consults the disk tier before falling
+  /// back to `block_fetcher_`.
+  Status FetchBlock(const string& filename, size_t offset, size_t n,
+                    char* buffer, size_t* bytes_transferred)
+      LOCKS_EXCLUDED(mu_);
+
+  /// Reads the block `name` into `buffer`, verifying its header and checksum.
+  /// Block files that fail verification are removed.
+  Status ReadDiskBlock(const string& name, const string& filename,
+                       int64 file_signature, size_t offset, char* buffer,
+                       size_t* bytes_transferred) LOCKS_EXCLUDED(mu_);
+
+  /// Writes a block to a new block file and records it in the index under
+  /// `name`, evicting older blocks as needed.
+  Status WriteDiskBlock(const string& name, const string& filename,
+                        int64 file_signature, size_t offset, const char* data,
+                        size_t n) LOCKS_EXCLUDED(mu_);
+
+  /// Rebuilds the index from the block files found in `cache_dir_`.
+  void LoadIndex() LOCKS_EXCLUDED(mu_);
+
+  /// Evicts blocks from the back of the LRU list until the disk tier fits in
+  /// `max_disk_bytes_`, appending the paths to delete to `to_delete`.
+  void Trim(std::vector<string>* to_delete) EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  /// Drops `entry` from the index and appends its path to `to_delete`.
+  void RemoveDiskBlock_Locked(DiskIndex::iterator entry,
+                              std::vector<string>* to_delete)
+      EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  /// Drops the blocks of `filename` from the index, keeping those written for
+  /// `keep_signature` when it is non-null.
+  void RemoveFile_Locked(const string& filename, const int64* keep_signature,
+                         std::vector<string>* to_delete)
+      EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  /// Deletes block files that are no longer in the index.
+  void DeleteFiles(const std::vector<string>& paths);
+
+  const size_t block_size_;
+  const size_t max_bytes_;
+  const uint64 max_staleness_;
+  const string cache_dir_;
+  const size_t max_disk_bytes_;
+  /// The callback to read a block from the underlying filesystem.
+  const BlockFetcher block_fetcher_;
+  /// The Env used for the block files and timestamps.
+  Env* const env_;  // not owned
+  /// False if the cache directory could not be created.
+  bool disk_enabled_ = false;
+
+  /// The RAM tier.
+  std::unique_ptr<RamFileBlockCache> ram_cache_;
+
+  /// Guards the disk index, LRU list, disk size and signature map.
+  mutable mutex mu_;
+
+  DiskIndex index_ GUARDED_BY(mu_);
+
+  /// The LRU list of block names. The front of the list identifies the
+  /// most recently accessed block.
+  std::list<string> lru_list_ GUARDED_BY(mu_);
+
+  /// The combined size of all block files in the index.
+  size_t disk_size_ GUARDED_BY(mu_) = 0;
+
+  // A filename->file_signature map.
+  std::map<string, int64> file_signature_map_ GUARDED_BY(mu_);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_PLATFORM_CLOUD_DISK_FILE_BLOCK_CACHE_H_
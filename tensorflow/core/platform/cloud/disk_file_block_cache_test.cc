@@ -0,0 +1,270 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/platform/cloud/disk_file_block_cache.h"
+#include <cstring>
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/strings/str_util.h"
+#include "tensorflow/core/platform/cloud/now_seconds_env.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+Status ReadCache(DiskFileBlockCache* cache, const string& filename,
+                 size_t offset, size_t n, std::vector<char>* out) {
+  out->clear();
+  out->resize(n, 0);
+  size_t bytes_transferred = 0;
+  Status status =
+      cache->Read(filename, offset, n, out->data(), &bytes_transferred);
+  EXPECT_LE(bytes_transferred, n);
+  out->resize(bytes_transferred, n);
+  return status;
+}
+
+// Returns an empty cache directory unique to `name`.
+string CacheDir(const string& name) {
+  const string dir =
+      io::JoinPath(testing::TmpDir(), strings::StrCat("disk_fbc_", name));
+  int64 undeleted_files, undeleted_dirs;
+  Env::Default()
+      ->DeleteRecursively(dir, &undeleted_files, &undeleted_dirs)
+      .IgnoreError();
+  return dir;
+}
+
+// Returns the block files currently in `dir`.
+std::vector<string> BlockFiles(const string& dir) {
+  std::vector<string> children, blocks;
+  TF_CHECK_OK(Env::Default()->GetChildren(dir, &children));
+  for (const string& child : children) {
+    if (str_util::EndsWith(child, ".blk")) {
+      blocks.push_back(io::JoinPath(dir, child));
+    }
+  }
+  return blocks;
+}
+
+// A fetcher that fills each block with the character 'a' + block index and
+// counts its calls.
+DiskFileBlockCache::BlockFetcher CountingFetcher(size_t block_size,
+                                                 int* calls) {
+  return [block_size, calls](const string& filename, size_t offset, size_t n,
+                             char* buffer, size_t* bytes_transferred) {
+    (*calls)++;
+    memset(buffer, 'a' + offset / block_size, n);
+    *bytes_transferred = n;
+    return Status::OK();
+  };
+}
+
+TEST(DiskFileBlockCacheTest, IsCacheEnabled) {
+  int calls = 0;
+  const string dir = CacheDir("enabled");
+  DiskFileBlockCache cache1(0, 0, 0, dir, 1024, CountingFetcher(8, &calls));
+  DiskFileBlockCache cache2(8, 0, 0, "", 1024, CountingFetcher(8, &calls));
+  DiskFileBlockCache cache3(8, 0, 0, dir, 0, CountingFetcher(8, &calls));
+  DiskFileBlockCache cache4(8, 0, 0, dir, 1024, CountingFetcher(8, &calls));
+  DiskFileBlockCache cache5(8, 16, 0, "", 0, CountingFetcher(8, &calls));
+
+  EXPECT_FALSE(cache1.IsCacheEnabled());
+  EXPECT_FALSE(cache2.IsCacheEnabled());
+  EXPECT_FALSE(cache3.IsCacheEnabled());
+  EXPECT_TRUE(cache4.IsCacheEnabled());
+  EXPECT_TRUE(cache5.IsCacheEnabled());
+}
+
+TEST(DiskFileBlockCacheTest, ReusesBlocksAcrossInstances) {
+  const size_t block_size = 8;
+  const string dir = CacheDir("reuse");
+  std::vector<char> out;
+  int calls = 0;
+  {
+    DiskFileBlockCache cache(block_size, 2 * block_size, 0, dir, 1 << 20,
+                             CountingFetcher(block_size, &calls));
+    EXPECT_TRUE(cache.ValidateAndUpdateFileSignature("f", 7));
+    TF_EXPECT_OK(ReadCache(&cache, "f", 0, 16, &out));
+    EXPECT_EQ(string(out.begin(), out.end()), "aaaaaaaabbbbbbbb");
+    TF_EXPECT_OK(ReadCache(&cache, "f", 16, 8, &out));
+    EXPECT_EQ(string(out.begin(), out.end()), "cccccccc");
+    EXPECT_EQ(calls, 3);
+    // Only two blocks fit in RAM, so the first block is served from disk.
+    TF_EXPECT_OK(ReadCache(&cache, "f", 0, 8, &out));
+    EXPECT_EQ(calls, 3);
+    EXPECT_EQ(BlockFiles(dir).size(), 3);
+    EXPECT_GT(cache.DiskCacheSize(), 3 * block_size);
+  }
+  // A new cache on the same directory, e.g. after a restart, reuses the blocks
+  // as long as the file signature is unchanged.
+  DiskFileBlockCache cache(block_size, 2 * block_size, 0, dir, 1 << 20,
+                           CountingFetcher(block_size, &calls));
+  EXPECT_TRUE(cache.ValidateAndUpdateFileSignature("f", 7));
+  TF_EXPECT_OK(ReadCache(&cache, "f", 4, 16, &out));
+  EXPECT_EQ(string(out.begin(), out.end()), "aaaabbbbbbbbcccc");
+  EXPECT_EQ(calls, 3);
+}
+
+TEST(DiskFileBlockCacheTest, SignatureChangeDropsDiskBlocks) {
+  const size_t block_size = 8;
+  const string dir = CacheDir("signature");
+  std::vector<char> out;
+  int calls = 0;
+  {
+    DiskFileBlockCache cache(block_size, 2 * block_size, 0, dir, 1 << 20,
+                             CountingFetcher(block_size, &calls));
+    EXPECT_TRUE(cache.ValidateAndUpdateFileSignature("f", 1));
+    TF_EXPECT_OK(ReadCache(&cache, "f", 0, 16, &out));
+    EXPECT_EQ(calls, 2);
+  }
+  DiskFileBlockCache cache(block_size, 2 * block_size, 0, dir, 1 << 20,
+                           CountingFetcher(block_size, &calls));
+  EXPECT_TRUE(cache.ValidateAndUpdateFileSignature("f", 2));
+  EXPECT_TRUE(BlockFiles(dir).empty());
+  TF_EXPECT_OK(ReadCache(&cache, "f", 0, 16, &out));
+  EXPECT_EQ(calls, 4);
+}
+
+TEST(DiskFileBlockCacheTest, CorruptBlockIsRefetched) {
+  const size_t block_size = 8;
+  const string dir = CacheDir("corrupt");
+  std::vector<char> out;
+  int calls = 0;
+  {
+    DiskFileBlockCache cache(block_size, block_size, 0, dir, 1 << 20,
+                             CountingFetcher(block_size, &calls));
+    TF_EXPECT_OK(ReadCache(&cache, "f", 0, 8, &out));
+    EXPECT_EQ(calls, 1);
+  }
+  // Flip the last data byte of the block file.
+  const std::vector<string> blocks = BlockFiles(dir);
+  ASSERT_EQ(blocks.size(), 1);
+  string contents;
+  TF_ASSERT_OK(ReadFileToString(Env::Default(), blocks[0], &contents));
+  contents.back() = 'z';
+  TF_ASSERT_OK(WriteStringToFile(Env::Default(), blocks[0], contents));
+
+  DiskFileBlockCache cache(block_size, block_size, 0, dir, 1 << 20,
+                           CountingFetcher(block_size, &calls));
+  TF_EXPECT_OK(ReadCache(&cache, "f", 0, 8, &out));
+  EXPECT_EQ(string(out.begin(), out.end()), "aaaaaaaa");
+  EXPECT_EQ(calls, 2);
+}
+
+TEST(DiskFileBlockCacheTest, RemovesTemporaryFilesOnStartup) {
+  const string dir = CacheDir("temp");
+  TF_ASSERT_OK(Env::Default()->RecursivelyCreateDir(dir));
+  const string temp = io::JoinPath(dir, "partial.blk.0123.tmp");
+  TF_ASSERT_OK(WriteStringToFile(Env::Default(), temp, "partial"));
+  int calls = 0;
+  DiskFileBlockCache cache(8, 8, 0, dir, 1 << 20, CountingFetcher(8, &calls));
+  EXPECT_TRUE(errors::IsNotFound(Env::Default()->FileExists(temp)));
+}
+
+TEST(DiskFileBlockCacheTest, EvictsLeastRecentlyUsed) {
+  const size_t block_size = 8;
+  const string dir = CacheDir("lru");
+  std::vector<char> out;
+  int calls = 0;
+  // Each block file holds a 44 byte header, the 1 byte filename and the data.
+  const size_t block_file_size = 44 + 1 + block_size;
+  DiskFileBlockCache cache(block_size, block_size, 0, dir, 2 * block_file_size,
+                           CountingFetcher(block_size, &calls));
+  TF_EXPECT_OK(ReadCache(&cache, "f", 0, 8, &out));
+  TF_EXPECT_OK(ReadCache(&cache, "f", 8, 8, &out));
+  TF_EXPECT_OK(ReadCache(&cache, "f", 16, 8, &out));
+  EXPECT_EQ(calls, 3);
+  EXPECT_EQ(cache.DiskCacheSize(), 2 * block_file_size);
+  EXPECT_EQ(BlockFiles(dir).size(), 2);
+  // The block at offset 8 is still on disk; the one at offset 0 was evicted.
+  TF_EXPECT_OK(ReadCache(&cache, "f", 8, 8, &out));
+  EXPECT_EQ(calls, 3);
+  TF_EXPECT_OK(ReadCache(&cache, "f", 0, 8, &out));
+  EXPECT_EQ(string(out.begin(), out.end()), "aaaaaaaa");
+  EXPECT_EQ(calls, 4);
+}
+
+TEST(DiskFileBlockCacheTest, StaleBlocksAreRefetched) {
+  const size_t block_size = 8;
+  const string dir = CacheDir("stale");
+  std::vector<char> out;
+  int calls = 0;
+  std::unique_ptr<NowSecondsEnv> env(new NowSecondsEnv);
+  {
+    DiskFileBlockCache cache(block_size, block_size, 10, dir, 1 << 20,
+                             CountingFetcher(block_size, &calls), env.get());
+    TF_EXPECT_OK(ReadCache(&cache, "f", 0, 8, &out));
+    EXPECT_EQ(calls, 1);
+  }
+  env->SetNowSeconds(100);
+  DiskFileBlockCache cache(block_size, block_size, 10, dir, 1 << 20,
+                           CountingFetcher(block_size, &calls), env.get());
+  TF_EXPECT_OK(ReadCache(&cache, "f", 0, 8, &out));
+  EXPECT_EQ(calls, 2);
+}
+
+TEST(DiskFileBlockCacheTest, RemoveFileAndFlush) {
+  const size_t block_size = 8;
+  const string dir = CacheDir("remove");
+  std::vector<char> out;
+  int calls = 0;
+  DiskFileBlockCache cache(block_size, 2 * block_size, 0, dir, 1 << 20,
+                           CountingFetcher(block_size, &calls));
+  TF_EXPECT_OK(ReadCache(&cache, "a", 0, 16, &out));
+  TF_EXPECT_OK(ReadCache(&cache, "b", 0, 16, &out));
+  EXPECT_EQ(BlockFiles(dir).size(), 4);
+  cache.RemoveFile("a");
+  EXPECT_EQ(BlockFiles(dir).size(), 2);
+  TF_EXPECT_OK(ReadCache(&cache, "b", 0, 8, &out));
+  EXPECT_EQ(calls, 4);
+  cache.Flush();
+  EXPECT_TRUE(BlockFiles(dir).empty());
+  EXPECT_EQ(cache.DiskCacheSize(), 0);
+  EXPECT_EQ(cache.CacheSize(), 0);
+}
+
+TEST(DiskFileBlockCacheTest, ReinsertWritesNewFile) {
+  const size_t block_size = 8;
+  const string dir = CacheDir("reinsert");
+  std::vector<char> out;
+  int calls = 0;
+  DiskFileBlockCache cache(block_size, block_size, 0, dir, 1 << 20,
+                           CountingFetcher(block_size, &calls));
+  TF_EXPECT_OK(ReadCache(&cache, "f", 0, 8, &out));
+  const std::vector<string> first = BlockFiles(dir);
+  ASSERT_EQ(first.size(), 1);
+  // A file dropped from the index may still be deleted by an earlier
+  // eviction, so a re-insert of the same block must not reuse its name.
+  cache.RemoveFile("f");
+  TF_EXPECT_OK(ReadCache(&cache, "f", 0, 8, &out));
+  const std::vector<string> second = BlockFiles(dir);
+  ASSERT_EQ(second.size(), 1);
+  EXPECT_NE(first[0], second[0]);
+  EXPECT_EQ(calls, 2);
+
+  // A restart keeps only the newest file of a block.
+  TF_ASSERT_OK(Env::Default()->CopyFile(second[0], first[0]));
+  DiskFileBlockCache reloaded(block_size, block_size, 0, dir, 1 << 20,
+                              CountingFetcher(block_size, &calls));
+  EXPECT_EQ(BlockFiles(dir).size(), 1);
+  TF_EXPECT_OK(ReadCache(&reloaded, "f", 0, 8, &out));
+  EXPECT_EQ(string(out.begin(), out.end()), "aaaaaaaa");
+  EXPECT_EQ(calls, 2);
+}
+
+}  // namespace
+}  // namespace tensorflow
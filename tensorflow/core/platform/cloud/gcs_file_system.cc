@@ -35,6 +35,7 @@ limitations under the License.
 #include "tensorflow/core/lib/strings/str_util.h"
 #include "tensorflow/core/lib/strings/stringprintf.h"
 #include "tensorflow/core/platform/cloud/curl_http_request.h"
+#include "tensorflow/core/platform/cloud/disk_file_block_cache.h"
 #include "tensorflow/core/platform/cloud/file_block_cache.h"
 #include "tensorflow/core/platform/cloud/google_auth_provider.h"
 #include "tensorflow/core/platform/cloud/ram_file_block_cache.h"
@@ -759,12 +760,36 @@ GcsFileSystem::GcsFileSystem(bool make_default_cache) {
   if (GetEnvVar(kMaxStaleness, strings::safe_strtou64, &value)) {
     max_staleness = value;
   }
+
+  // Apply the overrides for the disk tier directory and max size (MB).
+  StringPiece disk_cache_dir;
+  if (GetEnvVar(kDiskCacheDir, StringPieceIdentity, &disk_cache_dir)) {
+    disk_cache_dir_ = string(disk_cache_dir);
+  }
+  if (GetEnvVar(kMaxDiskCacheSize, strings::safe_strtou64, &value)) {
+    max_disk_cache_bytes_ = value * 1024 * 1024;
+  }
+  int32 read_ahead_parallelism;
+  if (GetEnvVar(kReadAheadParallelism, strings::safe_strto32,
+                &read_ahead_parallelism)) {
+    read_ahead_parallelism_ = read_ahead_parallelism;
+  }
+  if (GetEnvVar(kReadAheadMaxSize, strings::safe_strtou64, &value)) {
+    read_ahead_max_bytes_ = value * 1024 * 1024;
+  }
+  if (GetEnvVar(kReadAheadMaxStreams, strings::safe_strtou64, &value)) {
+    read_ahead_max_streams_ = value;
+  }
   if (!make_default_cache) {
     max_bytes = 0;
+    max_disk_cache_bytes_ = 0;
   }
   VLOG(1) << "GCS cache max size = " << max_bytes << " ; "
           << "block size = " << block_size_ << " ; "
-          << "max staleness = " << max_staleness;
+          << "max staleness = " << max_staleness << " ; "
+          << "disk cache dir = " << disk_cache_dir_ << " ; "
+          << "disk cache max size = " << max_disk_cache_bytes_ << " ; "
+          << "read-ahead parallelism = " << read_ahead_parallelism_;
   file_block_cache_ = MakeFileBlockCache(block_size_, max_bytes, max_staleness);
   // Apply overrides for the stat cache max age and max entries, if provided.
   uint64 stat_cache_max_age = kStatCacheDefaultMaxAge;
@@ -932,6 +957,8 @@ Status GcsFileSystem::NewRandomAccessFile(
         VLOG(1)
             << "File signature has been changed. Refreshing the cache. Path: "
             << fname;
+        // Blocks fetched ahead of the reader belong to the old contents.
+        if (read_ahead_ != nullptr) read_ahead_->DropPrefetches(fname);
       }
       *result = StringPiece();
       size_t bytes_transferred;
@@ -977,16 +1004,75 @@ void GcsFileSystem::ResetFileBlockCache(size_t block_size_bytes,
   }
 }
 
+void GcsFileSystem::ResetFileBlockCache(size_t block_size_bytes,
+                                        size_t max_bytes,
+                                        uint64 max_staleness_secs,
+                                        const string& disk_cache_dir,
+                                        size_t max_disk_bytes) {
+  mutex_lock l(block_cache_lock_);
+  disk_cache_dir_ = disk_cache_dir;
+  max_disk_cache_bytes_ = max_disk_bytes;
+  file_block_cache_ =
+      MakeFileBlockCache(block_size_bytes, max_bytes, max_staleness_secs);
+  if (stats_ != nullptr) {
+    stats_->Configure(this, &throttle_, file_block_cache_.get());
+  }
+}
+
+GcsFileSystem::~GcsFileSystem() {
+  // Wait for the fetches in flight, which use the members declared after the
+  // cache, before those are destroyed.
+  mutex_lock l(block_cache_lock_);
+  file_block_cache_.reset();
+  read_ahead_.reset();
+}
+
+void GcsFileSystem::SetReadAheadParallelism(int num_parallel_reads) {
+  mutex_lock l(block_cache_lock_);
+  read_ahead_parallelism_ = num_parallel_reads;
+  file_block_cache_ = MakeFileBlockCache(file_block_cache_->block_size(),
+                                         file_block_cache_->max_bytes(),
+                                         file_block_cache_->max_staleness());
+  if (stats_ != nullptr) {
+    stats_->Configure(this, &throttle_, file_block_cache_.get());
+  }
+}
+
 // A helper function to build a FileBlockCache for GcsFileSystem.
 std::unique_ptr<FileBlockCache> GcsFileSystem::MakeFileBlockCache(
     size_t block_size, size_t max_bytes, uint64 max_staleness) {
-  std::unique_ptr<FileBlockCache> file_block_cache(new RamFileBlockCache(
-      block_size, max_bytes, max_staleness,
+  FileBlockCache::BlockFetcher block_fetcher =
       [this](const string& filename, size_t offset, size_t n, char* buffer,
              size_t* bytes_transferred) {
         return LoadBufferFromGCS(filename, offset, n, buffer,
                                  bytes_transferred);
-      }));
+      };
+  read_ahead_.reset();
+  if (read_ahead_parallelism_ > 0 && block_size > 0) {
+    // The read-ahead fetcher is shared by the cache, through its fetcher, and
+    // by read_ahead_, through which files dropped from the cache are dropped.
+    const size_t read_ahead_max_bytes =
+        read_ahead_max_bytes_ > 0 ? read_ahead_max_bytes_
+                                  : read_ahead_parallelism_ * block_size;
+    auto read_ahead = std::make_shared<ReadAheadBlockFetcher>(
+        block_size, read_ahead_parallelism_, read_ahead_max_bytes,
+        max_staleness, block_fetcher, read_ahead_max_streams_);
+    block_fetcher = [read_ahead](const string& filename, size_t offset,
+                                 size_t n, char* buffer,
+                                 size_t* bytes_transferred) {
+      return read_ahead->Fetch(filename, offset, n, buffer, bytes_transferred);
+    };
+    read_ahead_ = std::move(read_ahead);
+  }
+  std::unique_ptr<FileBlockCache> file_block_cache;
+  if (!disk_cache_dir_.empty() && max_disk_cache_bytes_ > 0) {
+    file_block_cache.reset(new DiskFileBlockCache(
+        block_size, max_bytes, max_staleness, disk_cache_dir_,
+        max_disk_cache_bytes_, block_fetcher));
+  } else {
+    file_block_cache.reset(new RamFileBlockCache(block_size, max_bytes,
+                                                 max_staleness, block_fetcher));
+  }
   return file_block_cache;
 }
 
@@ -1047,6 +1133,7 @@ Status GcsFileSystem::LoadBufferFromGCS(const string& fname, size_t offset,
 void GcsFileSystem::ClearFileCaches(const string& fname) {
   tf_shared_lock l(block_cache_lock_);
   file_block_cache_->RemoveFile(fname);
+  if (read_ahead_ != nullptr) read_ahead_->DropPrefetches(fname);
   stat_cache_->Delete(fname);
   // TODO(rxsang): Remove the patterns that matche the file in
   // MatchingPathsCache as well.
@@ -1733,6 +1820,7 @@ Status GcsFileSystem::DeleteRecursively(const string& dirname,
 void GcsFileSystem::FlushCaches() {
   tf_shared_lock l(block_cache_lock_);
   file_block_cache_->Flush();
+  if (read_ahead_ != nullptr) read_ahead_->Flush();
   stat_cache_->Clear();
   matching_paths_cache_->Clear();
   bucket_location_cache_->Clear();
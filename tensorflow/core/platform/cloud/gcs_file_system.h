@@ -30,6 +30,7 @@ limitations under the License.
 #include "tensorflow/core/platform/cloud/gcs_dns_cache.h"
 #include "tensorflow/core/platform/cloud/gcs_throttle.h"
 #include "tensorflow/core/platform/cloud/http_request.h"
+#include "tensorflow/core/platform/cloud/read_ahead_block_fetcher.h"
 #include "tensorflow/core/platform/cloud/retrying_file_system.h"
 #include "tensorflow/core/platform/file_system.h"
 
@@ -50,6 +51,27 @@ constexpr size_t kDefaultMaxCacheSize = 0;
 // will be evicted on the next read.
 constexpr char kMaxStaleness[] = "GCS_READ_CACHE_MAX_STALENESS";
 constexpr uint64 kDefaultMaxStaleness = 0;
+// The environment variable that enables a second tier of the block cache in a
+// local directory (e.g. on a local SSD). Blocks kept there are checksummed and
+// reused across process restarts.
+constexpr char kDiskCacheDir[] = "GCS_READ_CACHE_DISK_DIR";
+// The environment variable that overrides the max size of the disk tier of the
+// block cache. Specified in MB. The disk tier is disabled when this is 0.
+constexpr char kMaxDiskCacheSize[] = "GCS_READ_CACHE_DISK_MAX_SIZE_MB";
+constexpr size_t kDefaultMaxDiskCacheSize = 0;
+// The environment variable that sets how many blocks are fetched concurrently
+// ahead of a reader once it reads a file sequentially. Only used when the
+// block cache is enabled. Read-ahead is disabled when this is 0.
+constexpr char kReadAheadParallelism[] = "GCS_READ_AHEAD_PARALLELISM";
+constexpr int kDefaultReadAheadParallelism = 0;
+// The environment variable that overrides the max size of the blocks held
+// ahead of readers, across all files. Specified in MB. When unset, read-ahead
+// holds at most GCS_READ_AHEAD_PARALLELISM blocks in total.
+constexpr char kReadAheadMaxSize[] = "GCS_READ_AHEAD_MAX_SIZE_MB";
+// The environment variable that overrides how many files can be read ahead at
+// the same time. When unset, it is as many as GCS_READ_AHEAD_MAX_SIZE_MB can
+// hold GCS_READ_AHEAD_PARALLELISM blocks of, and at least 4.
+constexpr char kReadAheadMaxStreams[] = "GCS_READ_AHEAD_MAX_STREAMS";
 
 // Helper function to extract an environment variable and convert it into a
 // value of type T.
@@ -124,6 +146,8 @@ class GcsFileSystem : public FileSystem {
                 const std::unordered_set<string>& allowed_locations,
                 std::pair<const string, const string>* additional_header);
 
+  ~GcsFileSystem() override;
+
   Status NewRandomAccessFile(
       const string& fname, std::unique_ptr<RandomAccessFile>* result) override;
 
@@ -253,9 +277,29 @@ class GcsFileSystem : public FileSystem {
   void ResetFileBlockCache(size_t block_size_bytes, size_t max_bytes,
                            uint64 max_staleness_secs);
 
+  /// \brief Resets the block cache with a second tier in a local directory.
+  ///
+  /// Up to `max_disk_bytes` of blocks are kept in `disk_cache_dir` and reused
+  /// by later instances pointed at the same directory. An empty directory or a
+  /// zero size disables the disk tier.
+  void ResetFileBlockCache(size_t block_size_bytes, size_t max_bytes,
+                           uint64 max_staleness_secs,
+                           const string& disk_cache_dir,
+                           size_t max_disk_bytes);
+
+  /// \brief Sets how many blocks are fetched ahead of sequential readers.
+  ///
+  /// Re-creates the block cache with its current parameters, so that up to
+  /// `num_parallel_reads` range requests are kept in flight ahead of each
+  /// file read sequentially through the cache. Zero disables read-ahead.
+  void SetReadAheadParallelism(int num_parallel_reads);
+
  protected:
+  /// Builds a block cache with the current disk tier and read-ahead settings,
+  /// and updates read_ahead_ to match it.
   virtual std::unique_ptr<FileBlockCache> MakeFileBlockCache(
-      size_t block_size, size_t max_bytes, uint64 max_staleness);
+      size_t block_size, size_t max_bytes, uint64 max_staleness)
+      EXCLUSIVE_LOCKS_REQUIRED(block_cache_lock_);
 
   /// Loads file contents from GCS for a given filename, offset, and length.
   Status LoadBufferFromGCS(const string& fname, size_t offset, size_t n,
@@ -340,9 +384,30 @@ class GcsFileSystem : public FileSystem {
   // Reads smaller than block_size_ will trigger a read of block_size_.
   uint64 block_size_;
 
+  // The directory and size of the disk tier of the block cache, and the
+  // read-ahead parallelism. Only read by MakeFileBlockCache; the disk tier is
+  // disabled if either of its settings is unset.
+  string disk_cache_dir_;
+  size_t max_disk_cache_bytes_ = kDefaultMaxDiskCacheSize;
+  // The number of blocks fetched ahead of sequential readers of the cache.
+  int read_ahead_parallelism_ = kDefaultReadAheadParallelism;
+  // The max bytes held ahead of readers, or 0 for read_ahead_parallelism_
+  // blocks.
+  size_t read_ahead_max_bytes_ = 0;
+  // The max number of files read ahead at the same time, or 0 to derive it
+  // from read_ahead_max_bytes_.
+  size_t read_ahead_max_streams_ = 0;
+
   // block_cache_lock_ protects the file_block_cache_ pointer (Note that
   // FileBlockCache instances are themselves threadsafe).
   mutex block_cache_lock_;
+  // The read-ahead fetcher of file_block_cache_, if read-ahead is enabled.
+  // Files dropped from the cache are dropped from it as well. Declared before
+  // file_block_cache_, which MakeFileBlockCache sets it along with. Both are
+  // destroyed first by ~GcsFileSystem, since their fetches in flight use the
+  // members declared after them.
+  std::shared_ptr<ReadAheadBlockFetcher> read_ahead_
+      GUARDED_BY(block_cache_lock_);
   std::unique_ptr<FileBlockCache> file_block_cache_
       GUARDED_BY(block_cache_lock_);
   std::unique_ptr<GcsDnsCache> dns_cache_;
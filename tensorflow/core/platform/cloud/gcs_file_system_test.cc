@@ -17,6 +17,7 @@ limitations under the License.
 #include <fstream>
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/io/path.h"
 #include "tensorflow/core/lib/strings/str_util.h"
 #include "tensorflow/core/platform/cloud/http_request_fake.h"
 #include "tensorflow/core/platform/test.h"
@@ -574,6 +575,152 @@ TEST(GcsFileSystemTest, NewRandomAccessFile_WithBlockCache) {
   EXPECT_EQ("0123", result);
 }
 
+TEST(GcsFileSystemTest, NewRandomAccessFile_WithDiskBlockCache) {
+  // Our underlying file in this test is a 15 byte file with contents
+  // "0123456789abcde".
+  const string disk_cache_dir =
+      io::JoinPath(testing::TmpDir(), "gcs_disk_block_cache");
+  int64 undeleted_files, undeleted_dirs;
+  Env::Default()
+      ->DeleteRecursively(disk_cache_dir, &undeleted_files, &undeleted_dirs)
+      .IgnoreError();
+  const string stat_request =
+      "Uri: https://www.googleapis.com/storage/v1/b/bucket/o/"
+      "random_access.txt?fields=size%2Cgeneration%2Cupdated\n"
+      "Auth Token: fake_token\n"
+      "Timeouts: 5 1 10\n";
+  const string stat_response =
+      "{\"size\": \"15\",\"generation\": \"1\","
+      "\"updated\": \"2016-04-29T23:15:24.896Z\"}";
+  char scratch[100];
+  StringPiece result;
+  {
+    std::vector<HttpRequest*> requests(
+        {new FakeHttpRequest(stat_request, stat_response),
+         new FakeHttpRequest(
+             "Uri: https://storage.googleapis.com/bucket/random_access.txt\n"
+             "Auth Token: fake_token\n"
+             "Range: 0-8\n"
+             "Timeouts: 5 1 20\n",
+             "012345678"),
+         new FakeHttpRequest(
+             "Uri: https://storage.googleapis.com/bucket/random_access.txt\n"
+             "Auth Token: fake_token\n"
+             "Range: 9-17\n"
+             "Timeouts: 5 1 20\n",
+             "9abcde")});
+    GcsFileSystem fs(
+        std::unique_ptr<AuthProvider>(new FakeAuthProvider),
+        std::unique_ptr<HttpRequest::Factory>(
+            new FakeHttpRequestFactory(&requests)),
+        std::unique_ptr<ZoneProvider>(new FakeZoneProvider), 9 /* block size */,
+        18 /* max bytes */, 0 /* max staleness */,
+        3600 /* stat cache max age */, 0 /* stat cache max entries */,
+        0 /* matching paths cache max age */,
+        0 /* matching paths cache max entries */, kTestRetryConfig,
+        kTestTimeoutConfig, *kAllowedLocationsDefault,
+        nullptr /* gcs additional header */);
+    fs.ResetFileBlockCache(9 /* block size */, 18 /* max bytes */,
+                           0 /* max staleness */, disk_cache_dir,
+                           1024 /* max disk bytes */);
+
+    std::unique_ptr<RandomAccessFile> file;
+    TF_EXPECT_OK(
+        fs.NewRandomAccessFile("gs://bucket/random_access.txt", &file));
+    TF_EXPECT_OK(file->Read(0, 9, &result, scratch));
+    EXPECT_EQ("012345678", result);
+    TF_EXPECT_OK(file->Read(9, 6, &result, scratch));
+    EXPECT_EQ("9abcde", result);
+  }
+
+  // A new filesystem using the same directory, e.g. after a restart, only needs
+  // to stat the file: both blocks are read back from the disk cache.
+  std::vector<HttpRequest*> requests(
+      {new FakeHttpRequest(stat_request, stat_response)});
+  GcsFileSystem fs(
+      std::unique_ptr<AuthProvider>(new FakeAuthProvider),
+      std::unique_ptr<HttpRequest::Factory>(
+          new FakeHttpRequestFactory(&requests)),
+      std::unique_ptr<ZoneProvider>(new FakeZoneProvider), 9 /* block size */,
+      18 /* max bytes */, 0 /* max staleness */, 3600 /* stat cache max age */,
+      0 /* stat cache max entries */, 0 /* matching paths cache max age */,
+      0 /* matching paths cache max entries */, kTestRetryConfig,
+      kTestTimeoutConfig, *kAllowedLocationsDefault,
+      nullptr /* gcs additional header */);
+  fs.ResetFileBlockCache(9 /* block size */, 18 /* max bytes */,
+                         0 /* max staleness */, disk_cache_dir,
+                         1024 /* max disk bytes */);
+
+  std::unique_ptr<RandomAccessFile> file;
+  TF_EXPECT_OK(fs.NewRandomAccessFile("gs://bucket/random_access.txt", &file));
+  TF_EXPECT_OK(file->Read(0, 15, &result, scratch));
+  EXPECT_EQ("0123456789abcde", result);
+}
+
+TEST(GcsFileSystemTest, NewRandomAccessFile_WithReadAhead) {
+  // Our underlying file in this test is a 30 byte file with contents
+  // "0123456789abcdefghijklmnopqrst".
+  std::vector<HttpRequest*> requests(
+      {new FakeHttpRequest(
+           "Uri: https://www.googleapis.com/storage/v1/b/bucket/o/"
+           "random_access.txt?fields=size%2Cgeneration%2Cupdated\n"
+           "Auth Token: fake_token\n"
+           "Timeouts: 5 1 10\n",
+           strings::StrCat("{\"size\": \"30\",\"generation\": \"1\","
+                           "\"updated\": \"2016-04-29T23:15:24.896Z\"}")),
+       new FakeHttpRequest(
+           "Uri: https://storage.googleapis.com/bucket/random_access.txt\n"
+           "Auth Token: fake_token\n"
+           "Range: 0-8\n"
+           "Timeouts: 5 1 20\n",
+           "012345678"),
+       new FakeHttpRequest(
+           "Uri: https://storage.googleapis.com/bucket/random_access.txt\n"
+           "Auth Token: fake_token\n"
+           "Range: 9-17\n"
+           "Timeouts: 5 1 20\n",
+           "9abcdefgh"),
+       // The second block continued the first one, so the next block is
+       // requested ahead of the reader.
+       new FakeHttpRequest(
+           "Uri: https://storage.googleapis.com/bucket/random_access.txt\n"
+           "Auth Token: fake_token\n"
+           "Range: 18-26\n"
+           "Timeouts: 5 1 20\n",
+           "ijklmnopq"),
+       new FakeHttpRequest(
+           "Uri: https://storage.googleapis.com/bucket/random_access.txt\n"
+           "Auth Token: fake_token\n"
+           "Range: 27-35\n"
+           "Timeouts: 5 1 20\n",
+           "rst")});
+  GcsFileSystem fs(
+      std::unique_ptr<AuthProvider>(new FakeAuthProvider),
+      std::unique_ptr<HttpRequest::Factory>(
+          new FakeHttpRequestFactory(&requests)),
+      std::unique_ptr<ZoneProvider>(new FakeZoneProvider), 9 /* block size */,
+      45 /* max bytes */, 0 /* max staleness */, 3600 /* stat cache max age */,
+      0 /* stat cache max entries */, 0 /* matching paths cache max age */,
+      0 /* matching paths cache max entries */, kTestRetryConfig,
+      kTestTimeoutConfig, *kAllowedLocationsDefault,
+      nullptr /* gcs additional header */);
+  // A single read-ahead request keeps the order of the fake requests fixed.
+  fs.SetReadAheadParallelism(1);
+
+  char scratch[100];
+  StringPiece result;
+  std::unique_ptr<RandomAccessFile> file;
+  TF_EXPECT_OK(fs.NewRandomAccessFile("gs://bucket/random_access.txt", &file));
+  TF_EXPECT_OK(file->Read(0, 9, &result, scratch));
+  EXPECT_EQ("012345678", result);
+  TF_EXPECT_OK(file->Read(9, 9, &result, scratch));
+  EXPECT_EQ("9abcdefgh", result);
+  TF_EXPECT_OK(file->Read(18, 9, &result, scratch));
+  EXPECT_EQ("ijklmnopq", result);
+  TF_EXPECT_OK(file->Read(27, 3, &result, scratch));
+  EXPECT_EQ("rst", result);
+}
+
 TEST(GcsFileSystemTest, NewRandomAccessFile_WithBlockCache_Flush) {
   // Our underlying file in this test is a 15 byte file with contents
   // "0123456789abcde".
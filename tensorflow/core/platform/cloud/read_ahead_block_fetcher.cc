@@ -0,0 +1,211 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/platform/cloud/read_ahead_block_fetcher.h"
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+namespace tensorflow {
+namespace {
+
+// The number of files that can be read ahead at the same time when neither
+// set explicitly nor allowed by a larger byte budget.
+constexpr size_t kMinReadAheadStreams = 4;
+
+size_t DefaultMaxStreams(size_t block_size, int num_parallel_reads,
+                         size_t max_bytes) {
+  if (block_size == 0 || num_parallel_reads <= 0) return kMinReadAheadStreams;
+  return std::max(kMinReadAheadStreams,
+                  max_bytes / (num_parallel_reads * block_size));
+}
+
+}  // namespace
+
+ReadAheadBlockFetcher::ReadAheadBlockFetcher(
+    size_t block_size, int num_parallel_reads, size_t max_bytes,
+    uint64 max_staleness, FileBlockCache::BlockFetcher block_fetcher,
+    size_t max_streams, Env* env)
+    : block_size_(block_size),
+      num_parallel_reads_(num_parallel_reads),
+      max_bytes_(max_bytes),
+      max_streams_(max_streams > 0 ? max_streams
+                                   : DefaultMaxStreams(block_size,
+                                                       num_parallel_reads,
+                                                       max_bytes)),
+      max_staleness_(max_staleness),
+      block_fetcher_(std::move(block_fetcher)),
+      env_(env) {
+  if (block_size_ > 0 && num_parallel_reads_ > 0 &&
+      max_bytes_ >= block_size_) {
+    thread_pool_.reset(
+        new thread::ThreadPool(env, "gcs_read_ahead", num_parallel_reads_));
+  }
+}
+
+Status ReadAheadBlockFetcher::Fetch(const string& filename, size_t offset,
+                                    size_t n, char* buffer,
+                                    size_t* bytes_transferred) {
+  if (thread_pool_ == nullptr || n != block_size_ ||
+      offset % block_size_ != 0) {
+    return block_fetcher_(filename, offset, n, buffer, bytes_transferred);
+  }
+
+  std::shared_ptr<Prefetch> prefetch;
+  bool sequential;
+  {
+    mutex_lock l(mu_);
+    Stream* stream = GetStream(filename);
+    auto it = stream->prefetches.find(offset);
+    if (it != stream->prefetches.end()) {
+      prefetch = it->second;
+      stream->prefetches.erase(it);
+    }
+    sequential = offset == stream->next_offset;
+    if (!sequential) {
+      // The reader moved; whatever was fetched ahead of it is unlikely to be
+      // read soon.
+      DropPrefetches_Locked(stream);
+      stream->prefetched_end = offset + block_size_;
+      stream->eof = false;
+    }
+    stream->next_offset = offset + block_size_;
+    if (prefetch != nullptr) {
+      while (!prefetch->done) {
+        prefetch_done_.wait(l);
+      }
+      prefetched_bytes_ -= block_size_;
+    }
+  }
+
+  const bool stale = prefetch != nullptr && max_staleness_ > 0 &&
+                     env_->NowSeconds() - prefetch->timestamp > max_staleness_;
+  Status status;
+  if (prefetch != nullptr && prefetch->status.ok() && !stale) {
+    *bytes_transferred = prefetch->data.size();
+    memcpy(buffer, prefetch->data.data(), prefetch->data.size());
+  } else {
+    // Failed prefetches are retried here, so that the caller sees the same
+    // errors (and retries) as without read-ahead.
+    status = block_fetcher_(filename, offset, n, buffer, bytes_transferred);
+  }
+
+  if (status.ok()) {
+    mutex_lock l(mu_);
+    auto it = streams_.find(filename);
+    if (it != streams_.end() && it->second.next_offset == offset + n) {
+      Stream* stream = &it->second;
+      if (*bytes_transferred < n) {
+        stream->eof = true;
+        DropPrefetches_Locked(stream);
+      } else if (sequential && !stream->eof) {
+        ScheduleLocked(filename, stream, offset);
+      }
+    }
+  }
+  return status;
+}
+
+void ReadAheadBlockFetcher::DropPrefetches(const string& filename) {
+  mutex_lock l(mu_);
+  auto it = streams_.find(filename);
+  if (it != streams_.end()) {
+    DropPrefetches_Locked(&it->second);
+    streams_.erase(it);
+  }
+}
+
+void ReadAheadBlockFetcher::Flush() {
+  mutex_lock l(mu_);
+  for (auto& stream : streams_) {
+    DropPrefetches_Locked(&stream.second);
+  }
+  streams_.clear();
+}
+
+size_t ReadAheadBlockFetcher::PrefetchedBytes() const {
+  mutex_lock l(mu_);
+  return prefetched_bytes_;
+}
+
+ReadAheadBlockFetcher::Stream* ReadAheadBlockFetcher::GetStream(
+    const string& filename) {
+  auto it = streams_.find(filename);
+  if (it == streams_.end()) {
+    if (streams_.size() >= max_streams_) {
+      auto lru = std::min_element(
+          streams_.begin(), streams_.end(),
+          [](const std::pair<const string, Stream>& a,
+             const std::pair<const string, Stream>& b) {
+            return a.second.last_use < b.second.last_use;
+          });
+      DropPrefetches_Locked(&lru->second);
+      streams_.erase(lru);
+    }
+    it = streams_.emplace(filename, Stream()).first;
+    // No offset is expected yet, so the first fetch is never sequential.
+    it->second.next_offset = std::numeric_limits<size_t>::max();
+  }
+  it->second.last_use = ++use_counter_;
+  return &it->second;
+}
+
+void ReadAheadBlockFetcher::ScheduleLocked(const string& filename,
+                                           Stream* stream, size_t offset) {
+  const size_t end = offset + (num_parallel_reads_ + 1) * block_size_;
+  size_t pos = std::max(stream->prefetched_end, offset + block_size_);
+  const uint64 now = env_->NowSeconds();
+  for (; pos < end; pos += block_size_) {
+    if (prefetched_bytes_ + block_size_ > max_bytes_) {
+      // Over budget; the remaining blocks are scheduled as earlier ones are
+      // consumed.
+      break;
+    }
+    prefetched_bytes_ += block_size_;
+    auto prefetch = std::make_shared<Prefetch>();
+    prefetch->timestamp = now;
+    stream->prefetches.emplace(pos, prefetch);
+    thread_pool_->Schedule([this, filename, pos, prefetch]() {
+      prefetch->data.resize(block_size_);
+      size_t bytes_transferred = 0;
+      Status status = block_fetcher_(filename, pos, block_size_,
+                                     prefetch->data.data(), &bytes_transferred);
+      prefetch->data.resize(status.ok() ? bytes_transferred : 0);
+      mutex_lock l(mu_);
+      prefetch->status = status;
+      prefetch->done = true;
+      if (prefetch->dropped) {
+        prefetched_bytes_ -= block_size_;
+      }
+      prefetch_done_.notify_all();
+    });
+  }
+  stream->prefetched_end = std::max(stream->prefetched_end, pos);
+}
+
+void ReadAheadBlockFetcher::DropPrefetches_Locked(Stream* stream) {
+  // Fetches still in flight complete into their (now unreferenced) buffers,
+  // and release their bytes then.
+  for (auto& entry : stream->prefetches) {
+    if (entry.second->done) {
+      prefetched_bytes_ -= block_size_;
+    } else {
+      entry.second->dropped = true;
+    }
+  }
+  stream->prefetches.clear();
+}
+
+}  // namespace tensorflow
@@ -0,0 +1,144 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_PLATFORM_CLOUD_READ_AHEAD_BLOCK_FETCHER_H_
+#define TENSORFLOW_CORE_PLATFORM_CLOUD_READ_AHEAD_BLOCK_FETCHER_H_
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/platform/cloud/file_block_cache.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+/// \brief Issues concurrent range reads ahead of sequential block fetches.
+///
+/// This class wraps the BlockFetcher of a FileBlockCache. It watches the
+/// block-aligned fetches made for each file, and once a file is fetched
+/// sequentially (a block directly follows the previously fetched one) it
+/// keeps up to `num_parallel_reads` fetches of the following blocks in flight
+/// on a dedicated thread pool. When the cache later asks for one of those
+/// blocks, the prefetched contents are returned in place of a new fetch, so a
+/// single sequential reader is served by several concurrent requests.
+///
+/// Prefetching for a file stops at the first partial block, and its pending
+/// blocks are dropped as soon as the file is read non-sequentially. At most
+/// `num_parallel_reads` blocks are prefetched per file, for at most
+/// `max_streams` files, and at most `max_bytes` across all files. A
+/// `max_streams` of 0 allows as many files as `max_bytes` can hold
+/// `num_parallel_reads` blocks of, and at least 4. Prefetched blocks
+/// requested more than `max_staleness` seconds ago are fetched again (0 means
+/// no limit).
+///
+/// The owner of the cache must call DropPrefetches() whenever the cache drops
+/// a file (because it was removed, overwritten or its signature changed), and
+/// Flush() when the cache is flushed, so that no stale block is served.
+class ReadAheadBlockFetcher {
+ public:
+  ReadAheadBlockFetcher(size_t block_size, int num_parallel_reads,
+                        size_t max_bytes, uint64 max_staleness,
+                        FileBlockCache::BlockFetcher block_fetcher,
+                        size_t max_streams = 0, Env* env = Env::Default());
+
+  /// Fetches `n` bytes of `filename` at `offset`, with the semantics of
+  /// FileBlockCache::BlockFetcher. Fetches that are not exactly one aligned
+  /// block are passed straight to the underlying fetcher.
+  Status Fetch(const string& filename, size_t offset, size_t n, char* buffer,
+               size_t* bytes_transferred) LOCKS_EXCLUDED(mu_);
+
+  /// Drops the prefetched blocks and the read-ahead state of `filename`.
+  void DropPrefetches(const string& filename) LOCKS_EXCLUDED(mu_);
+
+  /// Drops the prefetched blocks of all files.
+  void Flush() LOCKS_EXCLUDED(mu_);
+
+  size_t block_size() const { return block_size_; }
+  int num_parallel_reads() const { return num_parallel_reads_; }
+  size_t max_bytes() const { return max_bytes_; }
+  size_t max_streams() const { return max_streams_; }
+
+  /// The bytes currently held by (or reserved for) prefetched blocks.
+  size_t PrefetchedBytes() const LOCKS_EXCLUDED(mu_);
+
+ private:
+  /// A block fetched (or being fetched) ahead of the reader.
+  struct Prefetch {
+    /// When the fetch was issued, in seconds since the epoch.
+    uint64 timestamp = 0;
+    bool done = false;
+    /// True once the block was dropped while its fetch was in flight; its
+    /// bytes are released when the fetch completes.
+    bool dropped = false;
+    Status status;
+    std::vector<char> data;
+  };
+
+  /// The read-ahead state of one file.
+  struct Stream {
+    /// The offset of the block expected next if the file is read sequentially.
+    size_t next_offset = 0;
+    /// The end of the range that has been prefetched already.
+    size_t prefetched_end = 0;
+    /// True once a partial block (i.e. the end of the file) was seen.
+    bool eof = false;
+    /// Used to pick the least recently used stream to drop.
+    uint64 last_use = 0;
+    /// Prefetched blocks by offset.
+    std::map<size_t, std::shared_ptr<Prefetch>> prefetches;
+  };
+
+  /// Returns the stream for `filename`, creating it (and dropping the least
+  /// recently used stream if there are too many) if needed.
+  Stream* GetStream(const string& filename) EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  /// Schedules prefetches of the blocks following `offset`.
+  void ScheduleLocked(const string& filename, Stream* stream, size_t offset)
+      EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  /// Drops all prefetched blocks of `stream`.
+  void DropPrefetches_Locked(Stream* stream) EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  const size_t block_size_;
+  const int num_parallel_reads_;
+  const size_t max_bytes_;
+  const size_t max_streams_;
+  const uint64 max_staleness_;
+  const FileBlockCache::BlockFetcher block_fetcher_;
+  Env* const env_;  // not owned
+
+  mutable mutex mu_;
+  /// Signalled whenever a prefetch completes.
+  condition_variable prefetch_done_;
+  std::map<string, Stream> streams_ GUARDED_BY(mu_);
+  uint64 use_counter_ GUARDED_BY(mu_) = 0;
+  /// One block for every prefetch that is scheduled and not yet consumed, or
+  /// dropped and not yet completed.
+  size_t prefetched_bytes_ GUARDED_BY(mu_) = 0;
+
+  /// Runs the prefetches. Declared last so that it is destroyed (and waits
+  /// for the scheduled fetches) before the state they use.
+  std::unique_ptr<thread::ThreadPool> thread_pool_;
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_PLATFORM_CLOUD_READ_AHEAD_BLOCK_FETCHER_H_
@@ -0,0 +1,278 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/platform/cloud/read_ahead_block_fetcher.h"
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/cloud/now_seconds_env.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+constexpr size_t kBlockSize = 8;
+// A byte budget large enough to never limit the tests that do not test it.
+constexpr size_t kMaxBytes = 1 << 20;
+
+// A thread-safe fetcher for a file of `file_size` bytes in which every byte of
+// block i is 'a' + i, or 'A' + i once the file was overwritten. Records how
+// often each offset was fetched.
+class FakeFile {
+ public:
+  explicit FakeFile(size_t file_size) : file_size_(file_size) {}
+
+  FileBlockCache::BlockFetcher fetcher() {
+    return [this](const string& filename, size_t offset, size_t n,
+                  char* buffer, size_t* bytes_transferred) {
+      char first;
+      {
+        mutex_lock l(mu_);
+        fetches_[offset]++;
+        if (fail_next_at_ == static_cast<int64>(offset)) {
+          fail_next_at_ = -1;
+          return errors::Unavailable("Injected failure at ", offset);
+        }
+        first = overwritten_ ? 'A' : 'a';
+      }
+      const size_t end = std::min(offset + n, file_size_);
+      *bytes_transferred = offset < end ? end - offset : 0;
+      for (size_t i = 0; i < *bytes_transferred; ++i) {
+        buffer[i] = first + (offset + i) / kBlockSize;
+      }
+      return Status::OK();
+    };
+  }
+
+  std::map<size_t, int> fetches() {
+    mutex_lock l(mu_);
+    return fetches_;
+  }
+
+  void FailNextFetchAt(size_t offset) {
+    mutex_lock l(mu_);
+    fail_next_at_ = offset;
+  }
+
+  void Overwrite() {
+    mutex_lock l(mu_);
+    overwritten_ = true;
+  }
+
+  // Waits until `offset` was fetched (or started to be fetched) `count` times.
+  void WaitForFetches(size_t offset, int count) {
+    while (fetches()[offset] < count) {
+      Env::Default()->SleepForMicroseconds(1000);
+    }
+  }
+
+ private:
+  const size_t file_size_;
+  mutex mu_;
+  std::map<size_t, int> fetches_ GUARDED_BY(mu_);
+  int64 fail_next_at_ GUARDED_BY(mu_) = -1;
+  bool overwritten_ GUARDED_BY(mu_) = false;
+};
+
+string FetchBlock(ReadAheadBlockFetcher* fetcher, size_t offset,
+                  const string& filename = "file") {
+  char buffer[kBlockSize];
+  size_t bytes_transferred = 0;
+  TF_EXPECT_OK(fetcher->Fetch(filename, offset, kBlockSize, buffer,
+                              &bytes_transferred));
+  return string(buffer, bytes_transferred);
+}
+
+TEST(ReadAheadBlockFetcherTest, PassesThroughUnalignedFetches) {
+  FakeFile file(100);
+  ReadAheadBlockFetcher fetcher(kBlockSize, 2, kMaxBytes, 0, file.fetcher());
+  char buffer[20];
+  size_t bytes_transferred = 0;
+  TF_EXPECT_OK(fetcher.Fetch("file", 3, 20, buffer, &bytes_transferred));
+  EXPECT_EQ(bytes_transferred, 20);
+  TF_EXPECT_OK(fetcher.Fetch("file", 23, 20, buffer, &bytes_transferred));
+  EXPECT_EQ(file.fetches(), (std::map<size_t, int>{{3, 1}, {23, 1}}));
+}
+
+TEST(ReadAheadBlockFetcherTest, NonSequentialFetchesDoNotReadAhead) {
+  FakeFile file(100);
+  {
+    ReadAheadBlockFetcher fetcher(kBlockSize, 2, kMaxBytes, 0, file.fetcher());
+    EXPECT_EQ(FetchBlock(&fetcher, 0), "aaaaaaaa");
+    EXPECT_EQ(FetchBlock(&fetcher, 24), "dddddddd");
+    EXPECT_EQ(FetchBlock(&fetcher, 8), "bbbbbbbb");
+  }
+  EXPECT_EQ(file.fetches(),
+            (std::map<size_t, int>{{0, 1}, {8, 1}, {24, 1}}));
+}
+
+TEST(ReadAheadBlockFetcherTest, SequentialFetchesReadAhead) {
+  const int kNumBlocks = 10;
+  const int kParallelReads = 3;
+  FakeFile file(1000);
+  {
+    ReadAheadBlockFetcher fetcher(kBlockSize, kParallelReads, kMaxBytes, 0,
+                                  file.fetcher());
+    for (int i = 0; i < kNumBlocks; ++i) {
+      EXPECT_EQ(FetchBlock(&fetcher, i * kBlockSize),
+                string(kBlockSize, 'a' + i));
+    }
+  }
+  // Every block was fetched exactly once, and the fetcher stayed
+  // kParallelReads blocks ahead of the reader.
+  std::map<size_t, int> expected;
+  for (int i = 0; i < kNumBlocks + kParallelReads; ++i) {
+    expected[i * kBlockSize] = 1;
+  }
+  EXPECT_EQ(file.fetches(), expected);
+}
+
+TEST(ReadAheadBlockFetcherTest, StopsAtEndOfFile) {
+  // Four full blocks followed by a partial one.
+  FakeFile file(4 * kBlockSize + 4);
+  {
+    ReadAheadBlockFetcher fetcher(kBlockSize, 2, kMaxBytes, 0, file.fetcher());
+    for (int i = 0; i < 4; ++i) {
+      EXPECT_EQ(FetchBlock(&fetcher, i * kBlockSize),
+                string(kBlockSize, 'a' + i));
+    }
+    EXPECT_EQ(FetchBlock(&fetcher, 4 * kBlockSize), "eeee");
+  }
+  // The block after the partial one was requested while the reader was two
+  // blocks behind, but nothing past it.
+  const std::map<size_t, int> fetches = file.fetches();
+  EXPECT_EQ(fetches.size(), 6);
+  EXPECT_EQ(fetches.rbegin()->first, 5 * kBlockSize);
+}
+
+TEST(ReadAheadBlockFetcherTest, FailedPrefetchIsRetried) {
+  FakeFile file(1000);
+  file.FailNextFetchAt(2 * kBlockSize);
+  {
+    ReadAheadBlockFetcher fetcher(kBlockSize, 1, kMaxBytes, 0,
+                                  file.fetcher());
+    EXPECT_EQ(FetchBlock(&fetcher, 0), "aaaaaaaa");
+    EXPECT_EQ(FetchBlock(&fetcher, kBlockSize), "bbbbbbbb");
+    // The prefetch of this block failed, so it is fetched again.
+    EXPECT_EQ(FetchBlock(&fetcher, 2 * kBlockSize), "cccccccc");
+  }
+  EXPECT_EQ(file.fetches()[2 * kBlockSize], 2);
+}
+
+TEST(ReadAheadBlockFetcherTest, ReadsNewContentsAfterOverwrite) {
+  FakeFile file(1000);
+  ReadAheadBlockFetcher fetcher(kBlockSize, 1, kMaxBytes, 0, file.fetcher());
+  EXPECT_EQ(FetchBlock(&fetcher, 0), "aaaaaaaa");
+  EXPECT_EQ(FetchBlock(&fetcher, kBlockSize), "bbbbbbbb");
+  // The next block was prefetched from the old contents.
+  file.WaitForFetches(2 * kBlockSize, 1);
+  file.Overwrite();
+  // What the file system does once the file signature changes.
+  fetcher.DropPrefetches("file");
+  EXPECT_EQ(FetchBlock(&fetcher, 2 * kBlockSize), "CCCCCCCC");
+  EXPECT_EQ(file.fetches()[2 * kBlockSize], 2);
+}
+
+TEST(ReadAheadBlockFetcherTest, StalePrefetchIsRefetched) {
+  FakeFile file(1000);
+  NowSecondsEnv env;
+  ReadAheadBlockFetcher fetcher(kBlockSize, 1, kMaxBytes, 10, file.fetcher(),
+                                /*max_streams=*/0, &env);
+  EXPECT_EQ(FetchBlock(&fetcher, 0), "aaaaaaaa");
+  EXPECT_EQ(FetchBlock(&fetcher, kBlockSize), "bbbbbbbb");
+  file.WaitForFetches(2 * kBlockSize, 1);
+  env.SetNowSeconds(100);
+  EXPECT_EQ(FetchBlock(&fetcher, 2 * kBlockSize), "cccccccc");
+  EXPECT_EQ(file.fetches()[2 * kBlockSize], 2);
+}
+
+TEST(ReadAheadBlockFetcherTest, StaysWithinByteBudget) {
+  const int kNumBlocks = 10;
+  FakeFile file(1000);
+  {
+    // Three reads in parallel, but only two blocks may be held at a time.
+    ReadAheadBlockFetcher fetcher(kBlockSize, 3, 2 * kBlockSize, 0,
+                                  file.fetcher());
+    for (int i = 0; i < kNumBlocks; ++i) {
+      EXPECT_EQ(FetchBlock(&fetcher, i * kBlockSize),
+                string(kBlockSize, 'a' + i));
+      EXPECT_LE(fetcher.PrefetchedBytes(), 2 * kBlockSize);
+    }
+    fetcher.Flush();
+  }
+  std::map<size_t, int> expected;
+  for (int i = 0; i < kNumBlocks + 2; ++i) {
+    expected[i * kBlockSize] = 1;
+  }
+  EXPECT_EQ(file.fetches(), expected);
+}
+
+TEST(ReadAheadBlockFetcherTest, DerivesMaxStreamsFromByteBudget) {
+  FakeFile file(1000);
+  EXPECT_EQ(ReadAheadBlockFetcher(kBlockSize, 2, 2 * kBlockSize, 0,
+                                  file.fetcher())
+                .max_streams(),
+            size_t{4});
+  EXPECT_EQ(ReadAheadBlockFetcher(kBlockSize, 2, 20 * kBlockSize, 0,
+                                  file.fetcher())
+                .max_streams(),
+            size_t{10});
+  EXPECT_EQ(ReadAheadBlockFetcher(kBlockSize, 2, 20 * kBlockSize, 0,
+                                  file.fetcher(), 3)
+                .max_streams(),
+            size_t{3});
+}
+
+TEST(ReadAheadBlockFetcherTest, ReadsAheadOfMoreReadersThanDefaultStreams) {
+  const int kNumReaders = 6;
+  const int kNumBlocks = 4;
+  // Every reader fetches each block once: none of their streams is dropped,
+  // so the blocks prefetched for them are all consumed.
+  std::vector<std::unique_ptr<FakeFile>> files;
+  for (int r = 0; r < kNumReaders; ++r) {
+    files.emplace_back(new FakeFile(1000));
+  }
+  {
+    ReadAheadBlockFetcher fetcher(
+        kBlockSize, 1, kMaxBytes, 0,
+        [&files](const string& filename, size_t offset, size_t n,
+                 char* buffer, size_t* bytes_transferred) {
+          return files[std::stoi(filename)]->fetcher()(
+              filename, offset, n, buffer, bytes_transferred);
+        },
+        kNumReaders);
+    for (int i = 0; i < kNumBlocks; ++i) {
+      for (int r = 0; r < kNumReaders; ++r) {
+        EXPECT_EQ(FetchBlock(&fetcher, i * kBlockSize, std::to_string(r)),
+                  string(kBlockSize, 'a' + i));
+      }
+    }
+    fetcher.Flush();
+  }
+  for (int r = 0; r < kNumReaders; ++r) {
+    for (const auto& entry : files[r]->fetches()) {
+      EXPECT_EQ(entry.second, 1) << "reader " << r << " offset "
+                                 << entry.first;
+    }
+  }
+}
+
+}  // namespace
+}  // namespace tensorflow
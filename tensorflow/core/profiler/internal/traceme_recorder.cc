@@ -14,8 +14,15 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/core/profiler/internal/traceme_recorder.h"
 
+#include <chrono>  // NOLINT(build/c++11)
 #include <cstddef>
+#include <cstring>
+#include <unordered_map>
+#include <utility>
 
+#include "tensorflow/core/lib/core/coding.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/strings/str_util.h"
 #include "tensorflow/core/platform/env.h"
 
 namespace tensorflow {
@@ -23,6 +30,9 @@ namespace profiler {
 
 std::atomic<int> TraceMeRecorder::trace_level_ =
     ATOMIC_VAR_INIT(TraceMeRecorder::kTracingDisabled);
+std::atomic<int> TraceMeRecorder::sampling_period_ = ATOMIC_VAR_INIT(1);
+std::atomic<bool> TraceMeRecorder::streaming_ = ATOMIC_VAR_INIT(false);
+std::atomic<int64> TraceMeRecorder::stream_buffer_size_ = ATOMIC_VAR_INIT(0);
 
 // Implementation of TraceMeRecorder::trace_level_ must be lock-free for faster
 // execution of the TraceMe() public API. This can be commented (if compilation
@@ -152,8 +162,140 @@ class EventQueue {
   std::atomic<size_t> end_;  // Atomic: also read by consumer thread.
 };
 
+// A fixed-size single-producer single-consumer ring buffer of Events.
+//
+// Push is only called by the owner thread, and fails when the buffer is full.
+// PopAll is called with the recorder's mutex held, either by the thread that
+// drains streams or by the owner thread when it shuts down. Slots in
+// [tail_, head_) are only accessed by the consumer, and the others only by
+// the producer.
+class EventRing {
+ public:
+  explicit EventRing(size_t capacity)
+      : capacity_(capacity), events_(new TraceMeRecorder::Event[capacity]) {}
+
+  // Adds an event to the buffer unless it is full. Fast and lock-free.
+  bool Push(TraceMeRecorder::Event&& event) {
+    const uint64 head = head_.load(std::memory_order_relaxed);
+    // Read the tail before reusing the slots it freed.
+    if (head - tail_.load(std::memory_order_acquire) == capacity_) {
+      return false;
+    }
+    events_[head % capacity_] = std::move(event);
+    head_.store(head + 1, std::memory_order_release);  // After contents.
+    return true;
+  }
+
+  uint64 capacity() const { return capacity_; }
+
+  // Moves the events in the buffer at the time of invocation to `events`.
+  void PopAll(std::vector<TraceMeRecorder::Event>* events) {
+    const uint64 head = head_.load(std::memory_order_acquire);
+    uint64 tail = tail_.load(std::memory_order_relaxed);
+    for (; tail != head; ++tail) {
+      events->push_back(std::move(events_[tail % capacity_]));
+    }
+    tail_.store(tail, std::memory_order_release);
+  }
+
+ private:
+  const uint64 capacity_;
+  std::unique_ptr<TraceMeRecorder::Event[]> events_;
+  // Written by the producer and the consumer respectively, so kept on
+  // different cache lines.
+  alignas(64) std::atomic<uint64> head_{0};
+  alignas(64) std::atomic<uint64> tail_{0};
+};
+
+std::atomic<int64> stream_dropped_events(0);
+
+// The stream file format is a magic string followed by a sequence of records.
+// Each record starts with a tag byte, and its fields are varints or
+// length-prefixed strings:
+// - kThreadRecord: tid, name. Precedes the events of a thread.
+// - kNameRecord: name id, name. Precedes the events that use the name id.
+// - kEventRecord: tid, activity id, name id, start time, end time.
+constexpr char kStreamMagic[] = "TFTRACE1";
+constexpr char kThreadRecord = 1;
+constexpr char kNameRecord = 2;
+constexpr char kEventRecord = 3;
+
+// The maximum number of names kept interned. Names are interned again once it
+// is reached, since names built with e.g. StrCat may be unbounded.
+constexpr size_t kMaxInternedNames = 1 << 16;
+
+void PutLengthPrefixedString(string* dst, const string& value) {
+  core::PutVarint32(dst, value.size());
+  dst->append(value);
+}
+
+bool GetLengthPrefixedString(StringPiece* input, string* value) {
+  uint32 size;
+  if (!core::GetVarint32(input, &size) || input->size() < size) return false;
+  value->assign(input->data(), size);
+  input->remove_prefix(size);
+  return true;
+}
+
 }  // namespace
 
+// Encodes streamed events to a file. Only used by one thread at a time.
+class TraceMeRecorder::StreamWriter {
+ public:
+  explicit StreamWriter(std::unique_ptr<WritableFile> file)
+      : file_(std::move(file)) {}
+
+  Status WriteHeader() { return file_->Append(kStreamMagic); }
+
+  // Appends `events` to the file. Errors are reported by Close.
+  void Write(const Events& events) {
+    if (!status_.ok()) return;
+    string buffer;
+    for (const ThreadEvents& thread : events) {
+      if (thread.events.empty()) continue;
+      const uint32 tid = thread.thread.tid;
+      auto thread_it = thread_names_.find(tid);
+      if (thread_it == thread_names_.end() ||
+          thread_it->second != thread.thread.name) {
+        thread_names_[tid] = thread.thread.name;
+        buffer.push_back(kThreadRecord);
+        core::PutVarint32(&buffer, tid);
+        PutLengthPrefixedString(&buffer, thread.thread.name);
+      }
+      for (const Event& event : thread.events) {
+        if (names_.size() >= kMaxInternedNames) names_.clear();
+        auto inserted = names_.emplace(event.name, next_name_id_);
+        if (inserted.second) {
+          buffer.push_back(kNameRecord);
+          core::PutVarint64(&buffer, next_name_id_++);
+          PutLengthPrefixedString(&buffer, event.name);
+        }
+        buffer.push_back(kEventRecord);
+        core::PutVarint32(&buffer, tid);
+        core::PutVarint64(&buffer, event.activity_id);
+        core::PutVarint64(&buffer, inserted.first->second);
+        core::PutVarint64(&buffer, event.start_time);
+        core::PutVarint64(&buffer, event.end_time);
+      }
+    }
+    if (buffer.empty()) return;
+    status_ = file_->Append(buffer);
+    if (status_.ok()) status_ = file_->Flush();
+  }
+
+  Status Close() {
+    if (status_.ok()) status_ = file_->Close();
+    return status_;
+  }
+
+ private:
+  std::unique_ptr<WritableFile> file_;
+  Status status_;
+  std::unordered_map<uint32, string> thread_names_;
+  std::unordered_map<string, uint64> names_;
+  uint64 next_name_id_ = 0;
+};
+
 // To avoid unnecessary synchronization between threads, each thread has a
 // ThreadLocalRecorder that independently records its events.
 class TraceMeRecorder::ThreadLocalRecorder {
@@ -168,18 +310,57 @@ class TraceMeRecorder::ThreadLocalRecorder {
   }
 
   // The destructor is called when the thread shuts down early.
-  ~ThreadLocalRecorder() { TraceMeRecorder::Get()->UnregisterThread(Clear()); }
+  ~ThreadLocalRecorder() {
+    TraceMeRecorder::Get()->UnregisterThread(this);
+    delete ring_.load(std::memory_order_relaxed);
+  }
+
+  int32 tid() const { return info_.tid; }
 
   // Record is only called from the owner thread.
-  void Record(TraceMeRecorder::Event&& event) { queue_.Push(std::move(event)); }
+  void Record(TraceMeRecorder::Event&& event) {
+    if (ABSL_PREDICT_FALSE(streaming_.load(std::memory_order_relaxed))) {
+      RecordToStream(std::move(event));
+      return;
+    }
+    queue_.Push(std::move(event));
+  }
 
   // Clear is called from the control thread when tracing starts/stops, or from
   // the owner thread when it shuts down (see destructor).
   TraceMeRecorder::ThreadEvents Clear() { return {info_, queue_.PopAll()}; }
 
+  // Returns the events buffered for streaming. Only called with the
+  // recorder's mutex held.
+  TraceMeRecorder::ThreadEvents DrainStream() {
+    TraceMeRecorder::ThreadEvents events = {info_, {}};
+    EventRing* ring = ring_.load(std::memory_order_acquire);
+    if (ring != nullptr) ring->PopAll(&events.events);
+    return events;
+  }
+
  private:
+  void RecordToStream(TraceMeRecorder::Event&& event) {
+    // The ring buffer is created by the owner thread on first use, and
+    // replaced when a streaming session asks for another size.
+    EventRing* ring = ring_.load(std::memory_order_relaxed);
+    const uint64 capacity = std::max<int64>(
+        stream_buffer_size_.load(std::memory_order_relaxed), 1);
+    if (ABSL_PREDICT_FALSE(ring == nullptr || ring->capacity() != capacity)) {
+      ring = new EventRing(capacity);
+      // Events of previous sessions are discarded by StartStreaming().
+      TraceMeRecorder* recorder = TraceMeRecorder::Get();
+      mutex_lock lock(recorder->mutex_);
+      delete ring_.exchange(ring, std::memory_order_acq_rel);
+    }
+    if (!ring->Push(std::move(event))) {
+      stream_dropped_events.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+
   TraceMeRecorder::ThreadInfo info_;
   EventQueue queue_;
+  std::atomic<EventRing*> ring_{nullptr};
 };
 
 /*static*/ TraceMeRecorder* TraceMeRecorder::Get() {
@@ -192,10 +373,15 @@ void TraceMeRecorder::RegisterThread(int32 tid, ThreadLocalRecorder* thread) {
   threads_.emplace(tid, thread);
 }
 
-void TraceMeRecorder::UnregisterThread(TraceMeRecorder::ThreadEvents&& events) {
+void TraceMeRecorder::UnregisterThread(ThreadLocalRecorder* thread) {
+  TraceMeRecorder::ThreadEvents events = thread->Clear();
   mutex_lock lock(mutex_);
   threads_.erase(events.thread.tid);
   orphaned_events_.push_back(std::move(events));
+  TraceMeRecorder::ThreadEvents stream_events = thread->DrainStream();
+  if (!stream_events.events.empty()) {
+    orphaned_stream_events_.push_back(std::move(stream_events));
+  }
 }
 
 // This method is performance critical and should be kept fast. It is called
@@ -234,6 +420,8 @@ void TraceMeRecorder::Record(Event event) {
 TraceMeRecorder::Events TraceMeRecorder::StopRecording() {
   TraceMeRecorder::Events events;
   mutex_lock lock(mutex_);
+  // Streaming is only stopped by StopStreaming().
+  if (stream_writer_ != nullptr) return events;
   // Change trace_level_ while holding mutex_.
   if (trace_level_.exchange(kTracingDisabled, std::memory_order_acq_rel) !=
       kTracingDisabled) {
@@ -242,5 +430,154 @@ TraceMeRecorder::Events TraceMeRecorder::StopRecording() {
   return events;
 }
 
+/*static*/ bool TraceMeRecorder::Sample(int period) {
+  static thread_local uint32 counter = 0;
+  return counter++ % period == 0;
+}
+
+/*static*/ int64 TraceMeRecorder::StreamDroppedEvents() {
+  return stream_dropped_events.load(std::memory_order_relaxed);
+}
+
+TraceMeRecorder::Events TraceMeRecorder::DrainStreams() {
+  TraceMeRecorder::Events result;
+  std::swap(orphaned_stream_events_, result);
+  for (const auto& entry : threads_) {
+    result.push_back(entry.second->DrainStream());
+  }
+  return result;
+}
+
+Status TraceMeRecorder::StartStreamingImpl(const StreamOptions& options) {
+  if (options.level < 1 || options.buffer_size < 1 ||
+      options.sampling_period < 1 || options.drain_interval_micros < 0) {
+    return errors::InvalidArgument("Invalid TraceMe streaming options");
+  }
+  std::unique_ptr<WritableFile> file;
+  TF_RETURN_IF_ERROR(Env::Default()->NewWritableFile(options.path, &file));
+  std::unique_ptr<StreamWriter> writer(new StreamWriter(std::move(file)));
+  TF_RETURN_IF_ERROR(writer->WriteHeader());
+
+  mutex_lock lock(mutex_);
+  if (stream_writer_ != nullptr ||
+      trace_level_.load(std::memory_order_acquire) != kTracingDisabled) {
+    return errors::FailedPrecondition("TraceMeRecorder is already started");
+  }
+  // Discard events that raced with the end of the previous session.
+  DrainStreams();
+  stream_dropped_events.store(0, std::memory_order_relaxed);
+  stream_buffer_size_.store(options.buffer_size, std::memory_order_relaxed);
+  sampling_period_.store(options.sampling_period, std::memory_order_relaxed);
+  streaming_.store(true, std::memory_order_release);
+  trace_level_.store(options.level, std::memory_order_release);
+
+  stream_writer_ = std::move(writer);
+  drain_interval_micros_ = options.drain_interval_micros;
+  stop_draining_ = false;
+  StreamWriter* stream_writer = stream_writer_.get();
+  drain_thread_.reset(Env::Default()->StartThread(
+      ThreadOptions(), "TraceMeStreamDrain",
+      [this, stream_writer]() { DrainLoop(stream_writer); }));
+  return Status::OK();
+}
+
+void TraceMeRecorder::DrainLoop(StreamWriter* writer) {
+  bool stop = false;
+  while (!stop) {
+    TraceMeRecorder::Events events;
+    {
+      mutex_lock lock(mutex_);
+      if (!stop_draining_) {
+        drain_cv_.wait_for(
+            lock, std::chrono::microseconds(drain_interval_micros_));
+      }
+      stop = stop_draining_;
+      events = DrainStreams();
+    }
+    // Write without holding the mutex, which new threads need to register.
+    writer->Write(events);
+  }
+}
+
+Status TraceMeRecorder::StopStreamingImpl() {
+  std::unique_ptr<Thread> drain_thread;
+  {
+    mutex_lock lock(mutex_);
+    if (stream_writer_ == nullptr || stop_draining_) {
+      return errors::FailedPrecondition("TraceMeRecorder is not streaming");
+    }
+    trace_level_.store(kTracingDisabled, std::memory_order_release);
+    stop_draining_ = true;
+    drain_cv_.notify_all();
+    drain_thread = std::move(drain_thread_);
+  }
+  // Joins the drain thread, which writes the remaining events.
+  drain_thread.reset();
+  std::unique_ptr<StreamWriter> writer;
+  {
+    mutex_lock lock(mutex_);
+    streaming_.store(false, std::memory_order_release);
+    sampling_period_.store(1, std::memory_order_relaxed);
+    writer = std::move(stream_writer_);
+    stop_draining_ = false;
+  }
+  return writer->Close();
+}
+
+/*static*/ Status TraceMeRecorder::ReadStream(const string& path,
+                                              Events* events) {
+  string contents;
+  TF_RETURN_IF_ERROR(ReadFileToString(Env::Default(), path, &contents));
+  StringPiece input(contents);
+  if (!str_util::ConsumePrefix(&input, kStreamMagic)) {
+    return errors::DataLoss(path, " is not a TraceMe stream");
+  }
+  std::unordered_map<uint64, string> names;
+  std::unordered_map<uint32, size_t> thread_indices;
+  events->clear();
+  while (!input.empty()) {
+    const char tag = input[0];
+    input.remove_prefix(1);
+    bool ok = false;
+    if (tag == kThreadRecord) {
+      uint32 tid;
+      string name;
+      ok = core::GetVarint32(&input, &tid) &&
+           GetLengthPrefixedString(&input, &name);
+      if (ok) {
+        auto inserted = thread_indices.emplace(tid, events->size());
+        if (inserted.second) events->emplace_back();
+        (*events)[inserted.first->second].thread = {static_cast<int32>(tid),
+                                                    name};
+      }
+    } else if (tag == kNameRecord) {
+      uint64 id;
+      string name;
+      ok = core::GetVarint64(&input, &id) &&
+           GetLengthPrefixedString(&input, &name);
+      if (ok) names[id] = std::move(name);
+    } else if (tag == kEventRecord) {
+      uint32 tid;
+      uint64 name_id;
+      Event event;
+      ok = core::GetVarint32(&input, &tid) &&
+           core::GetVarint64(&input, &event.activity_id) &&
+           core::GetVarint64(&input, &name_id) &&
+           core::GetVarint64(&input, &event.start_time) &&
+           core::GetVarint64(&input, &event.end_time) &&
+           thread_indices.count(tid) > 0 && names.count(name_id) > 0;
+      if (ok) {
+        event.name = names[name_id];
+        (*events)[thread_indices[tid]].events.push_back(std::move(event));
+      }
+    }
+    if (!ok) {
+      return errors::DataLoss("Corrupted TraceMe stream record at offset ",
+                              contents.size() - input.size(), " of ", path);
+    }
+  }
+  return Status::OK();
+}
+
 }  // namespace profiler
 }  // namespace tensorflow
@@ -17,11 +17,14 @@ limitations under the License.
 
 #include <atomic>
 #include <cstddef>
+#include <memory>
 #include <string>
 #include <unordered_map>
 #include <vector>
 
 #include "absl/base/optimization.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/types.h"
 
@@ -39,6 +42,12 @@ namespace profiler {
 // events, and the destructor records end events.
 // The profiler then stops the recorder and finds start/end pairs. (Unpaired
 // start/end events are discarded at that point).
+//
+// Alternatively, StartStreaming() and StopStreaming() record continuously:
+// each thread appends its events to a fixed-size lock-free ring buffer, and a
+// background thread periodically drains the buffers to a file in a compact
+// binary format that ReadStream() parses. Events recorded while a thread's
+// buffer is full are dropped and counted.
 class TraceMeRecorder {
  public:
   // An Event is either the start of a TraceMe, the end of a TraceMe, or both.
@@ -74,9 +83,49 @@ class TraceMeRecorder {
                               level);
   }
 
+  // Returns whether an activity at `level` that starts now should be
+  // recorded: we're recording at `level`, and the activity is sampled (see
+  // StreamOptions::sampling_period). As cheap as Active() when not recording.
+  static inline bool ShouldRecord(int level) {
+    if (!Active(level)) return false;
+    const int period = sampling_period_.load(std::memory_order_relaxed);
+    return ABSL_PREDICT_TRUE(period <= 1) || Sample(period);
+  }
+
   // Records an event. Non-blocking.
   static void Record(Event event);
 
+  struct StreamOptions {
+    // The file to write events to. It is overwritten.
+    string path;
+    // Only traces <= level are recorded. Must be >= 1.
+    int level = 1;
+    // The number of events each thread can buffer between drains.
+    int64 buffer_size = 1 << 14;
+    // Records one in `sampling_period` activities of each thread.
+    int sampling_period = 1;
+    // How often the buffers are drained to the file.
+    int64 drain_interval_micros = 100 * 1000;
+  };
+
+  // Starts recording TraceMe() continuously to `options.path`. Fails if the
+  // recorder is already started.
+  static Status StartStreaming(const StreamOptions& options) {
+    return Get()->StartStreamingImpl(options);
+  }
+
+  // Stops streaming, writes all buffered events, and closes the file. Returns
+  // the first error writing to the file, if any.
+  static Status StopStreaming() { return Get()->StopStreamingImpl(); }
+
+  // Returns the number of events dropped because of full buffers since
+  // streaming started.
+  static int64 StreamDroppedEvents();
+
+  // Reads the events of a file written by streaming. The events of each
+  // thread are in the order they were recorded.
+  static Status ReadStream(const string& path, Events* events);
+
  private:
   // Default value for trace_level_ when tracing is disabled
   static constexpr int kTracingDisabled = -1;
@@ -92,12 +141,25 @@ class TraceMeRecorder {
   TraceMeRecorder(const TraceMeRecorder&) = delete;
   TraceMeRecorder& operator=(const TraceMeRecorder&) = delete;
 
+  class StreamWriter;
+
   void RegisterThread(int32 tid, ThreadLocalRecorder* thread);
-  void UnregisterThread(ThreadEvents&& events);
+  void UnregisterThread(ThreadLocalRecorder* thread);
 
   bool StartRecording(int level);
   Events StopRecording();
 
+  Status StartStreamingImpl(const StreamOptions& options);
+  Status StopStreamingImpl();
+  // Writes the events buffered by all threads to `writer` every drain
+  // interval, until streaming stops.
+  void DrainLoop(StreamWriter* writer);
+  // Gathers the events buffered by all threads for streaming.
+  Events DrainStreams() EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
+  // Returns true for one in `period` calls on each thread.
+  static bool Sample(int period);
+
   // Gathers events from all active threads, and clears their buffers.
   Events Clear() EXCLUSIVE_LOCKS_REQUIRED(mutex_);
 
@@ -105,6 +167,10 @@ class TraceMeRecorder {
   // Static atomic so TraceMeRecorder::Active can be fast and non-blocking.
   // Modified by TraceMeRecorder singleton when tracing starts/stops.
   static std::atomic<int> trace_level_;
+  // Static atomics read by every recorded TraceMe while streaming.
+  static std::atomic<int> sampling_period_;
+  static std::atomic<bool> streaming_;
+  static std::atomic<int64> stream_buffer_size_;
 
   mutex mutex_;
   // Map of the static container instances (thread_local storage) for each
@@ -112,6 +178,15 @@ class TraceMeRecorder {
   std::unordered_map<int32, ThreadLocalRecorder*> threads_ GUARDED_BY(mutex_);
   // Events from threads that died during recording.
   TraceMeRecorder::Events orphaned_events_ GUARDED_BY(mutex_);
+
+  // Streaming state, set between StartStreaming() and StopStreaming().
+  std::unique_ptr<StreamWriter> stream_writer_ GUARDED_BY(mutex_);
+  // Streamed events from threads that died since the last drain.
+  TraceMeRecorder::Events orphaned_stream_events_ GUARDED_BY(mutex_);
+  int64 drain_interval_micros_ GUARDED_BY(mutex_) = 0;
+  bool stop_draining_ GUARDED_BY(mutex_) = false;
+  condition_variable drain_cv_;
+  std::unique_ptr<Thread> drain_thread_ GUARDED_BY(mutex_);
 };
 
 }  // namespace profiler
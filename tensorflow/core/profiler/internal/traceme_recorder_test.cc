@@ -18,9 +18,14 @@ limitations under the License.
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 #include "absl/synchronization/notification.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/lib/io/path.h"
 #include "tensorflow/core/platform/env_time.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
 #include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/profiler/lib/traceme.h"
 
 namespace tensorflow {
 namespace profiler {
@@ -181,6 +186,107 @@ TEST(RecorderTest, Multithreaded) {
   }
 }
 
+TEST(RecorderTest, Streaming) {
+  uint64 start_time = Env::Default()->NowNanos();
+  uint64 end_time = start_time + kNanosInSec;
+  const string path =
+      io::JoinPath(testing::TmpDir(), "traceme_recorder_test_streaming");
+
+  TraceMeRecorder::StreamOptions options;
+  options.path = path;
+  options.buffer_size = 4;
+  // Only drained when streaming stops.
+  options.drain_interval_micros = 100 * kNanosInSec / 1000;
+  TF_ASSERT_OK(TraceMeRecorder::StartStreaming(options));
+  // Only one session at a time.
+  EXPECT_FALSE(TraceMeRecorder::Start(/*level=*/1));
+  EXPECT_FALSE(TraceMeRecorder::StartStreaming(options).ok());
+  // Recorded from a thread that exits before streaming stops.
+  {
+    thread::ThreadPool pool(Env::Default(), "testpool", 1);
+    pool.Schedule([start_time, end_time] {
+      TraceMeRecorder::Record({0, "other", start_time, end_time});
+    });
+  }
+  // Overflows the buffer of this thread.
+  for (uint64 i = 1; i <= 10; ++i) {
+    TraceMeRecorder::Record({i, i % 2 ? "odd" : "even", start_time, end_time});
+  }
+  TF_ASSERT_OK(TraceMeRecorder::StopStreaming());
+  EXPECT_FALSE(TraceMeRecorder::StopStreaming().ok());
+  EXPECT_EQ(TraceMeRecorder::StreamDroppedEvents(), 6);
+  TraceMeRecorder::Record({11, "after", start_time, end_time});
+
+  TraceMeRecorder::Events results;
+  TF_ASSERT_OK(TraceMeRecorder::ReadStream(path, &results));
+  ASSERT_EQ(results.size(), 2);
+  EXPECT_THAT(results[0].events, ::testing::ElementsAre(Named("other")));
+  EXPECT_THAT(results[1].events,
+              ::testing::ElementsAre(Named("odd"), Named("even"), Named("odd"),
+                                     Named("even")));
+  EXPECT_EQ(results[1].events[3].activity_id, 4);
+  EXPECT_EQ(results[1].events[3].start_time, start_time);
+  EXPECT_EQ(results[1].events[3].end_time, end_time);
+
+  // Regular recording works again once streaming is stopped.
+  EXPECT_TRUE(TraceMeRecorder::Start(/*level=*/1));
+  TraceMeRecorder::Record({5, "during", start_time, end_time});
+  results = TraceMeRecorder::Stop();
+  ASSERT_EQ(results.size(), 1);
+  EXPECT_THAT(results[0].events, ::testing::ElementsAre(Named("during")));
+}
+
+TEST(RecorderTest, StreamingSampling) {
+  const string path =
+      io::JoinPath(testing::TmpDir(), "traceme_recorder_test_sampling");
+  TraceMeRecorder::StreamOptions options;
+  options.path = path;
+  options.sampling_period = 10;
+  TF_ASSERT_OK(TraceMeRecorder::StartStreaming(options));
+  for (int i = 0; i < 100; ++i) {
+    TraceMe trace("sampled");
+  }
+  TF_ASSERT_OK(TraceMeRecorder::StopStreaming());
+
+  TraceMeRecorder::Events results;
+  TF_ASSERT_OK(TraceMeRecorder::ReadStream(path, &results));
+  ASSERT_EQ(results.size(), 1);
+  EXPECT_EQ(results[0].events.size(), 10);
+}
+
+TEST(RecorderTest, ReadStreamRejectsOtherFiles) {
+  const string path =
+      io::JoinPath(testing::TmpDir(), "traceme_recorder_test_invalid");
+  TF_ASSERT_OK(WriteStringToFile(Env::Default(), path, "not a stream"));
+  TraceMeRecorder::Events results;
+  EXPECT_FALSE(TraceMeRecorder::ReadStream(path, &results).ok());
+}
+
+void BM_TraceMeInactive(int iters) {
+  for (int i = 0; i < iters; ++i) {
+    TraceMe trace("inactive");
+  }
+}
+BENCHMARK(BM_TraceMeInactive);
+
+// Measures the cost of TraceMe while streaming, when recording one out of
+// `sampling_period` activities.
+void BM_TraceMeStreaming(int iters, int sampling_period) {
+  testing::StopTiming();
+  TraceMeRecorder::StreamOptions options;
+  options.path =
+      io::JoinPath(testing::TmpDir(), "traceme_recorder_test_benchmark");
+  options.sampling_period = sampling_period;
+  TF_CHECK_OK(TraceMeRecorder::StartStreaming(options));
+  testing::StartTiming();
+  for (int i = 0; i < iters; ++i) {
+    TraceMe trace("streaming");
+  }
+  testing::StopTiming();
+  TF_CHECK_OK(TraceMeRecorder::StopStreaming());
+}
+BENCHMARK(BM_TraceMeStreaming)->Arg(1)->Arg(100);
+
 }  // namespace
 }  // namespace profiler
 }  // namespace tensorflow
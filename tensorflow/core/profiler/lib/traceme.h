@@ -79,7 +79,7 @@ class TraceMe {
   // out their host traces based on verbosity.
   explicit TraceMe(absl::string_view activity_name, int level = 1) {
     DCHECK_GE(level, 1);
-    if (TraceMeRecorder::Active(level)) {
+    if (TraceMeRecorder::ShouldRecord(level)) {
       new (&no_init_.name) string(activity_name);
       start_time_ = EnvTime::Default()->NowNanos();
     } else {
@@ -94,7 +94,7 @@ class TraceMe {
   // constructor so we avoid copying them when tracing is disabled.
   explicit TraceMe(string &&activity_name, int level = 1) {
     DCHECK_GE(level, 1);
-    if (TraceMeRecorder::Active(level)) {
+    if (TraceMeRecorder::ShouldRecord(level)) {
       new (&no_init_.name) string(std::move(activity_name));
       start_time_ = EnvTime::Default()->NowNanos();
     } else {
@@ -124,7 +124,7 @@ class TraceMe {
   template <typename NameGeneratorT>
   explicit TraceMe(NameGeneratorT name_generator, int level = 1) {
     DCHECK_GE(level, 1);
-    if (TraceMeRecorder::Active(level)) {
+    if (TraceMeRecorder::ShouldRecord(level)) {
       new (&no_init_.name) string(name_generator());
       start_time_ = EnvTime::Default()->NowNanos();
     } else {
@@ -165,8 +165,8 @@ class TraceMe {
   // Record the start time of an activity.
   // Returns the activity ID, which is used to stop the activity.
   static uint64 ActivityStart(absl::string_view name, int level = 1) {
-    return TraceMeRecorder::Active(level) ? ActivityStartImpl(name)
-                                          : kUntracedActivity;
+    return TraceMeRecorder::ShouldRecord(level) ? ActivityStartImpl(name)
+                                                : kUntracedActivity;
   }
 
   // Record the end time of an activity started by ActivityStart().
@@ -0,0 +1,83 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_UTIL_STRING_ARENA_H_
+#define TENSORFLOW_CORE_UTIL_STRING_ARENA_H_
+
+#include <vector>
+
+#include "tensorflow/core/lib/core/stringpiece.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/tstring.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+// A sequence of strings packed back to back into one contiguous byte buffer,
+// plus an array of end offsets. Building strings in an arena does not
+// allocate per element, and clearing it keeps its capacity, so a kernel that
+// reuses one arena across records allocates only while the buffer is growing.
+//
+// Strings are built with Append() calls followed by FinishString(), and read
+// back as StringPieces into the buffer, which stay valid until the next
+// mutation. A StringArena is a scratch buffer for building strings, not a
+// DT_STRING tensor encoding: CopyTo() materializes one tstring per element.
+//
+// Threads must synchronize their access to a StringArena.
+class StringArena {
+ public:
+  StringArena() = default;
+
+  // Appends bytes to the string under construction.
+  void Append(StringPiece piece) {
+    bytes_.insert(bytes_.end(), piece.begin(), piece.end());
+  }
+  void Append(char c) { bytes_.push_back(c); }
+
+  // Ends the string under construction, which becomes element size() - 1.
+  void FinishString() { ends_.push_back(bytes_.size()); }
+
+  // Drops all strings, keeping the allocated capacity.
+  void Clear() {
+    bytes_.clear();
+    ends_.clear();
+  }
+
+  // Number of finished strings.
+  int64 size() const { return ends_.size(); }
+
+  StringPiece operator[](int64 i) const {
+    DCHECK_LT(i, size());
+    const size_t begin = i == 0 ? 0 : ends_[i - 1];
+    return StringPiece(bytes_.data() + begin, ends_[i] - begin);
+  }
+
+  // Copies string `i` into `out`.
+  void CopyTo(int64 i, tstring* out) const {
+    const StringPiece s = (*this)[i];
+    out->assign(s.data(), s.size());
+  }
+
+ private:
+  std::vector<char> bytes_;
+  std::vector<size_t> ends_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(StringArena);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_UTIL_STRING_ARENA_H_
@@ -0,0 +1,67 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/util/string_arena.h"
+
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+TEST(StringArenaTest, AppendAndFinish) {
+  StringArena arena;
+  EXPECT_EQ(0, arena.size());
+
+  arena.Append("hello");
+  arena.FinishString();
+  arena.FinishString();
+  arena.Append("wor");
+  arena.Append('l');
+  arena.Append('d');
+  arena.FinishString();
+
+  ASSERT_EQ(3, arena.size());
+  EXPECT_EQ("hello", arena[0]);
+  EXPECT_EQ("", arena[1]);
+  EXPECT_EQ("world", arena[2]);
+}
+
+TEST(StringArenaTest, ClearKeepsWorking) {
+  StringArena arena;
+  arena.Append("first record");
+  arena.FinishString();
+  arena.Clear();
+  EXPECT_EQ(0, arena.size());
+  arena.Append("a");
+  arena.FinishString();
+  arena.Append("bc");
+  arena.FinishString();
+  ASSERT_EQ(2, arena.size());
+  EXPECT_EQ("a", arena[0]);
+  EXPECT_EQ("bc", arena[1]);
+}
+
+TEST(StringArenaTest, CopyTo) {
+  StringArena arena;
+  arena.Append("a much longer string that does not fit in a small buffer");
+  arena.FinishString();
+
+  tstring copy;
+  arena.CopyTo(0, &copy);
+  EXPECT_EQ("a much longer string that does not fit in a small buffer", copy);
+}
+
+}  // namespace
+}  // namespace tensorflow
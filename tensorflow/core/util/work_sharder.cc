@@ -15,8 +15,17 @@ limitations under the License.
 
 #include "tensorflow/core/util/work_sharder.h"
 
+#include <algorithm>
+#include <cmath>
+#include <deque>
+#include <memory>
+#include <utility>
+
 #include "tensorflow/core/lib/core/blocking_counter.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
 
 namespace tensorflow {
 
@@ -50,6 +59,169 @@ void Shard(int max_parallelism, thread::ThreadPool* workers, int64 total,
               max_parallelism);
 }
 
+double ShardCostModel::CorrectedCostPerUnit(int64 cost_per_unit) const {
+  return std::max(int64{1}, cost_per_unit) * correction_.load();
+}
+
+void ShardCostModel::Update(int64 cost_per_unit, int64 num_units,
+                            int64 nanos) {
+  if (num_units <= 0) return;
+  // Measurements of very short calls are mostly timer noise.
+  static const int64 kMinMeasuredNanos = 1000;
+  if (nanos < kMinMeasuredNanos) return;
+  const double measured = static_cast<double>(nanos) / num_units;
+  const double ratio = measured / std::max(int64{1}, cost_per_unit);
+  // Moving average of the log of the ratio, so that over and under
+  // estimates converge at the same speed.
+  // Retried when another thread updates the correction in between, so that
+  // concurrent measurements are all accounted for.
+  static const double kDecay = 0.75;
+  double correction = correction_.load();
+  double updated;
+  do {
+    updated = std::exp(kDecay * std::log(correction) +
+                       (1 - kDecay) * std::log(ratio));
+  } while (!correction_.compare_exchange_weak(correction, updated));
+}
+
+namespace {
+
+// The state shared by the ranges of one AdaptiveShard() call. It is owned
+// jointly by the caller and the closures scheduled on the workers, which may
+// run after the call returned, once the caller ran their ranges itself.
+struct AdaptiveShardState {
+  AdaptiveShardState(thread::ThreadPool* workers,
+                     const std::function<void(int64, int64)>& work,
+                     int64 total, int64 grain_size)
+      : workers(workers),
+        work(work),
+        grain_size(grain_size),
+        pending_units(total) {}
+
+  thread::ThreadPool* const workers;
+  // Only called while pending_units > 0, i.e. before the caller returns.
+  const std::function<void(int64, int64)>& work;
+  // Ranges of at most grain_size units are not split any more.
+  const int64 grain_size;
+  std::atomic<int64> busy_nanos{0};
+
+  mutex mu;
+  // Signaled when a range is queued or pending_units drops to 0.
+  condition_variable cv;
+  // The split ranges that no thread runs yet, oldest (and largest) first.
+  std::deque<std::pair<int64, int64>> ranges GUARDED_BY(mu);
+  int64 pending_units GUARDED_BY(mu);
+};
+
+void RunAdaptiveShardRange(const std::shared_ptr<AdaptiveShardState>& state,
+                           int64 start, int64 limit);
+
+// Runs the oldest queued range of "state", if any, and returns whether there
+// was one.
+bool RunQueuedAdaptiveShardRange(
+    const std::shared_ptr<AdaptiveShardState>& state) {
+  std::pair<int64, int64> range;
+  {
+    mutex_lock l(state->mu);
+    if (state->ranges.empty()) return false;
+    range = state->ranges.front();
+    state->ranges.pop_front();
+  }
+  RunAdaptiveShardRange(state, range.first, range.second);
+  return true;
+}
+
+// Runs [start, limit), after splitting off its upper halves for other
+// threads until it is at most state->grain_size units. The upper halves are
+// queued in "state" and a worker is woken for each, but whichever thread
+// gets to a range first runs it, including the caller of AdaptiveShard().
+void RunAdaptiveShardRange(const std::shared_ptr<AdaptiveShardState>& state,
+                           int64 start, int64 limit) {
+  while (limit - start > state->grain_size) {
+    const int64 mid = start + (limit - start) / 2;
+    {
+      mutex_lock l(state->mu);
+      state->ranges.emplace_back(mid, limit);
+    }
+    state->cv.notify_all();
+    state->workers->Schedule(
+        [state]() { RunQueuedAdaptiveShardRange(state); });
+    limit = mid;
+  }
+  const uint64 start_nanos = Env::Default()->NowNanos();
+  state->work(start, limit);
+  state->busy_nanos += Env::Default()->NowNanos() - start_nanos;
+  bool done;
+  {
+    mutex_lock l(state->mu);
+    state->pending_units -= limit - start;
+    done = state->pending_units == 0;
+  }
+  if (done) state->cv.notify_all();
+}
+
+}  // namespace
+
+void AdaptiveShard(int max_parallelism, thread::ThreadPool* workers,
+                   int64 total, int64 cost_per_unit,
+                   ShardCostModel* cost_model,
+                   std::function<void(int64, int64)> work) {
+  CHECK_GE(total, 0);
+  if (total == 0) {
+    return;
+  }
+  max_parallelism = std::min(max_parallelism, GetPerThreadMaxParallelism());
+  const double unit_cost =
+      cost_model != nullptr
+          ? cost_model->CorrectedCostPerUnit(cost_per_unit)
+          : static_cast<double>(std::max(int64{1}, cost_per_unit));
+
+  // Like in Sharder::Do(), a range should cost at least 10us to amortize its
+  // scheduling. Expensive work is still split in a few ranges per thread, so
+  // that threads finishing early can steal from the others, but in no more
+  // ranges than "max_parallelism" when it limits the threads. The number of
+  // ranges is rounded down to a power of 2, since ranges are split in halves.
+  static const double kMinCostPerRange = 10000;
+  static const int64 kRangesPerThread = 4;
+  const int64 max_ranges = max_parallelism < workers->NumThreads()
+                               ? max_parallelism
+                               : kRangesPerThread * workers->NumThreads();
+  int64 num_ranges = 1;
+  while (num_ranges * 2 <= max_ranges) num_ranges *= 2;
+  const int64 grain_size = std::max<int64>(
+      (total + num_ranges - 1) / num_ranges,
+      static_cast<int64>(std::min<double>(
+          total, std::ceil(kMinCostPerRange / unit_cost))));
+
+  if (max_parallelism <= 1 || grain_size >= total) {
+    // Run inline, but still measure the cost for the following calls.
+    const uint64 start_nanos = Env::Default()->NowNanos();
+    work(0, total);
+    if (cost_model != nullptr) {
+      cost_model->Update(cost_per_unit, total,
+                         Env::Default()->NowNanos() - start_nanos);
+    }
+    return;
+  }
+
+  auto state =
+      std::make_shared<AdaptiveShardState>(workers, work, total, grain_size);
+  RunAdaptiveShardRange(state, 0, total);
+  // Rather than blocking while the ranges wait for a worker, which starves
+  // nested calls when all the workers are waiting as well, run them here.
+  while (true) {
+    if (RunQueuedAdaptiveShardRange(state)) continue;
+    mutex_lock l(state->mu);
+    while (state->ranges.empty() && state->pending_units > 0) {
+      state->cv.wait(l);
+    }
+    if (state->pending_units == 0) break;
+  }
+  if (cost_model != nullptr) {
+    cost_model->Update(cost_per_unit, total, state->busy_nanos.load());
+  }
+}
+
 // DEPRECATED: Prefer threadpool->TransformRangeConcurrently, which allows you
 // to directly specify the shard size.
 void Sharder::Do(int64 total, int64 cost_per_unit, const Work& work,
@@ -16,9 +16,11 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_UTIL_WORK_SHARDER_H_
 #define TENSORFLOW_CORE_UTIL_WORK_SHARDER_H_
 
+#include <atomic>
 #include <functional>
 
 #include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/platform/macros.h"
 #include "tensorflow/core/platform/types.h"
 
 namespace tensorflow {
@@ -82,6 +84,54 @@ class ScopedPerThreadMaxParallelism {
   int previous_ = -1;
 };
 
+// Learns how the cost of a unit of work measured by AdaptiveShard() compares
+// with the cost_per_unit estimate of its caller. Each call site of
+// AdaptiveShard() keeps its own model, e.g.
+//
+//   static ShardCostModel* cost_model = new ShardCostModel;
+//   AdaptiveShard(max_parallelism, workers, total, cost_per_unit, cost_model,
+//                 work);
+//
+// This class is thread-safe.
+class ShardCostModel {
+ public:
+  ShardCostModel() = default;
+
+  // Returns "cost_per_unit" multiplied by the learned correction factor,
+  // in nanoseconds.
+  double CorrectedCostPerUnit(int64 cost_per_unit) const;
+
+  // Records that "num_units" units of work estimated at "cost_per_unit"
+  // each took "nanos" nanoseconds of CPU time in total.
+  void Update(int64 cost_per_unit, int64 num_units, int64 nanos);
+
+  // Returns the ratio of the measured cost over the estimated cost, which is
+  // 1 until the first update.
+  double correction() const { return correction_.load(); }
+
+ private:
+  std::atomic<double> correction_{1.0};
+
+  TF_DISALLOW_COPY_AND_ASSIGN(ShardCostModel);
+};
+
+// An alternative to Shard() for callers whose "cost_per_unit" is a rough
+// estimate. Instead of cutting [0, total) into a fixed number of shards,
+// AdaptiveShard() recursively splits the range in halves and queues the
+// upper halves, until the ranges are cheap enough to run. Queued ranges are
+// run by whichever thread gets to them first: the "workers" woken for them,
+// or the caller, which keeps running them until the queue is empty instead
+// of blocking, so that nested calls make progress. The size of the smallest
+// ranges follows the corrected cost of "cost_model", which is updated with
+// the measured execution time of each call. "cost_model" may be null, in
+// which case "cost_per_unit" is used as is.
+//
+// The arguments are otherwise the same as for Shard().
+void AdaptiveShard(int max_parallelism, thread::ThreadPool* workers,
+                   int64 total, int64 cost_per_unit,
+                   ShardCostModel* cost_model,
+                   std::function<void(int64, int64)> work);
+
 // Implementation details for Shard().
 class Sharder {
  public:
@@ -16,6 +16,7 @@ limitations under the License.
 #include "tensorflow/core/util/work_sharder.h"
 
 #include <atomic>
+#include <cmath>
 #include <vector>
 #include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/platform/logging.h"
@@ -89,6 +90,125 @@ TEST(Shard, OverflowTest) {
   }
 }
 
+void RunAdaptiveSharding(int64 max_parallelism, int64 total,
+                         int64 cost_per_unit, ShardCostModel* cost_model,
+                         thread::ThreadPool* threads) {
+  mutex mu;
+  int64 num_ranges = 0;
+  int64 num_done_work = 0;
+  std::vector<bool> work(total, false);
+  AdaptiveShard(
+      max_parallelism, threads, total, cost_per_unit, cost_model,
+      [=, &mu, &num_ranges, &num_done_work, &work](int64 start, int64 limit) {
+        EXPECT_GE(start, 0);
+        EXPECT_LT(start, limit);
+        EXPECT_LE(limit, total);
+        mutex_lock l(mu);
+        ++num_ranges;
+        for (; start < limit; ++start) {
+          EXPECT_FALSE(work[start]);  // No duplicate
+          ++num_done_work;
+          work[start] = true;
+        }
+      });
+  EXPECT_EQ(num_done_work, total);
+  const int64 parallelism =
+      std::min<int64>(max_parallelism, GetPerThreadMaxParallelism());
+  if (parallelism < threads->NumThreads()) {
+    EXPECT_LE(num_ranges, std::max<int64>(1, parallelism));
+  }
+}
+
+TEST(AdaptiveShard, Basic) {
+  thread::ThreadPool threads(Env::Default(), "test", 16);
+  ShardCostModel cost_model;
+  for (auto workers : {0, 1, 2, 3, 5, 7, 10, 11, 15, 100, 1000}) {
+    for (auto total : {0, 1, 7, 10, 64, 100, 256, 1000, 9999}) {
+      for (auto cost_per_unit : {0, 1, 11, 102, 1003, 10005, 1000007}) {
+        for (auto maxp : {1, 2, 4, 8, 100}) {
+          ScopedPerThreadMaxParallelism s(maxp);
+          RunAdaptiveSharding(workers, total, cost_per_unit, nullptr,
+                              &threads);
+          RunAdaptiveSharding(workers, total, cost_per_unit, &cost_model,
+                              &threads);
+        }
+      }
+    }
+  }
+}
+
+TEST(AdaptiveShard, OverflowTest) {
+  thread::ThreadPool threads(Env::Default(), "test", 3);
+  for (auto workers : {1, 2, 3}) {
+    const int64 total_elements = 1LL << 32;
+    const int64 cost_per_unit = 10;
+    std::atomic<int64> num_elements(0);
+    AdaptiveShard(workers, &threads, total_elements, cost_per_unit, nullptr,
+                  [&num_elements](int64 start, int64 limit) {
+                    num_elements += limit - start;
+                  });
+    EXPECT_EQ(num_elements.load(), total_elements);
+  }
+}
+
+TEST(AdaptiveShard, Nested) {
+  // Every worker runs an outer range that waits for an inner call, so the
+  // inner ranges only run if the waiting threads run them.
+  thread::ThreadPool threads(Env::Default(), "test", 2);
+  const int64 total = 64;
+  std::atomic<int64> num_elements(0);
+  AdaptiveShard(
+      16, &threads, total, 1000000, nullptr,
+      [&threads, &num_elements](int64 start, int64 limit) {
+        for (; start < limit; ++start) {
+          AdaptiveShard(16, &threads, total, 1000000, nullptr,
+                        [&num_elements](int64 start, int64 limit) {
+                          num_elements += limit - start;
+                        });
+        }
+      });
+  EXPECT_EQ(num_elements.load(), total * total);
+}
+
+TEST(ShardCostModel, LearnsCorrection) {
+  ShardCostModel cost_model;
+  EXPECT_EQ(cost_model.correction(), 1.0);
+  EXPECT_EQ(cost_model.CorrectedCostPerUnit(100), 100.0);
+
+  // Units estimated at 100ns take 1us.
+  for (int i = 0; i < 50; ++i) {
+    cost_model.Update(100, 1000, 1000000);
+  }
+  EXPECT_NEAR(cost_model.correction(), 10.0, 0.01);
+  EXPECT_NEAR(cost_model.CorrectedCostPerUnit(100), 1000.0, 1.0);
+
+  // Units estimated at 100ns take 1ns.
+  for (int i = 0; i < 100; ++i) {
+    cost_model.Update(100, 1000000, 1000000);
+  }
+  EXPECT_NEAR(cost_model.correction(), 0.01, 0.0001);
+
+  // Too short measurements are ignored.
+  cost_model.Update(100, 1, 10);
+  EXPECT_NEAR(cost_model.correction(), 0.01, 0.0001);
+}
+
+TEST(ShardCostModel, ConcurrentUpdates) {
+  ShardCostModel cost_model;
+  {
+    thread::ThreadPool threads(Env::Default(), "test", 4);
+    for (int i = 0; i < 4; ++i) {
+      threads.Schedule([&cost_model]() {
+        for (int j = 0; j < 3; ++j) cost_model.Update(100, 1000, 1000000);
+      });
+    }
+  }
+  // Each update moves the log of the correction a quarter of the way to
+  // log(10), so it only gets there if none of the 12 updates is lost.
+  EXPECT_NEAR(cost_model.correction(),
+              std::exp((1 - std::pow(0.75, 12)) * std::log(10.0)), 1e-6);
+}
+
 void BM_Sharding(int iters, int arg) {
   thread::ThreadPool threads(Env::Default(), "test", 16);
   const int64 total = 1LL << 30;
@@ -100,5 +220,56 @@ void BM_Sharding(int iters, int arg) {
 }
 BENCHMARK(BM_Sharding)->Range(1, 128);
 
+// Runs "total" units of work costing about "cost" nanoseconds each on 16
+// threads, with Shard() or AdaptiveShard(), when the caller estimates the
+// cost at "estimate_percent" percents of the real one.
+void RunShardingGrid(int iters, int total, int cost, bool adaptive,
+                     int estimate_percent) {
+  testing::StopTiming();
+  thread::ThreadPool threads(Env::Default(), "test", 16);
+  ShardCostModel cost_model;
+  const int64 cost_per_unit =
+      std::max<int64>(1, static_cast<int64>(cost) * estimate_percent / 100);
+  std::atomic<int64> sink(0);
+  auto work = [cost, &sink](int64 start, int64 limit) {
+    int64 sum = 0;
+    for (int64 i = start; i < limit; ++i) {
+      // Roughly 1ns per iteration.
+      for (int j = 0; j < cost; ++j) sum = sum * 3 + j;
+    }
+    sink += sum;
+  };
+  testing::StartTiming();
+  for (int i = 0; i < iters; ++i) {
+    if (adaptive) {
+      AdaptiveShard(16, &threads, total, cost_per_unit, &cost_model, work);
+    } else {
+      Shard(16, &threads, total, cost_per_unit, work);
+    }
+  }
+  testing::ItemsProcessed(static_cast<int64>(iters) * total);
+}
+
+// The grid of the number of units and their cost, in nanoseconds.
+#define BM_SHARDING_GRID(name, adaptive, estimate_percent)           \
+  void BM_##name(int iters, int total, int cost) {                   \
+    RunShardingGrid(iters, total, cost, adaptive, estimate_percent); \
+  }                                                                  \
+  BENCHMARK(BM_##name)                                               \
+      ->ArgPair(100, 10)                                             \
+      ->ArgPair(100, 1000)                                           \
+      ->ArgPair(100, 100000)                                         \
+      ->ArgPair(10000, 10)                                           \
+      ->ArgPair(10000, 1000)                                         \
+      ->ArgPair(1000000, 10)                                         \
+      ->ArgPair(1000000, 100);
+
+BM_SHARDING_GRID(ShardExactCost, false, 100);
+BM_SHARDING_GRID(AdaptiveShardExactCost, true, 100);
+BM_SHARDING_GRID(ShardUnderestimatedCost, false, 1);
+BM_SHARDING_GRID(AdaptiveShardUnderestimatedCost, true, 1);
+BM_SHARDING_GRID(ShardOverestimatedCost, false, 10000);
+BM_SHARDING_GRID(AdaptiveShardOverestimatedCost, true, 10000);
+
 }  // namespace
 }  // namespace tensorflow
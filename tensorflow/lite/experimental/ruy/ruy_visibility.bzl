@@ -4,5 +4,7 @@ Control of ruy visibility
 
 def ruy_visibility():
     return [
+        "//tensorflow/core/grappler/optimizers:__pkg__",
+        "//tensorflow/core/kernels:__pkg__",
         "//tensorflow/lite/kernels:__subpackages__",
     ]
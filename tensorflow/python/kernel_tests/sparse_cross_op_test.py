@@ -370,6 +370,35 @@ class SparseCrossOpTest(test.TestCase):
       all_values_are_different = len(out.values) == len(set(out.values))
       self.assertTrue(all_values_are_different)
 
+  @test_util.run_deprecated_v1
+  def test_hashed_3x2x2_matches_single_crosses(self):
+    """Tests that each hashed cross matches crossing its features alone."""
+    fc1 = ['batch1-FC1-F1', 'batch1-FC1-F2', 'batch1-FC1-F3']
+    fc2 = [11, 12]
+    fc3 = ['batch1-FC3-F1', 'batch1-FC3-F2']
+    op = sparse_ops.sparse_cross_hashed(
+        [
+            self._sparse_tensor([fc1]),
+            self._sparse_tensor([fc2]),
+            self._sparse_tensor([fc3])
+        ],
+        num_buckets=1000)
+    single_ops = [
+        sparse_ops.sparse_cross_hashed(
+            [
+                self._sparse_tensor([[f1]]),
+                self._sparse_tensor([[f2]]),
+                self._sparse_tensor([[f3]])
+            ],
+            num_buckets=1000) for f1 in fc1 for f2 in fc2 for f3 in fc3
+    ]
+    with self.cached_session() as sess:
+      out = self.evaluate(op)
+      singles = self.evaluate(single_ops)
+      self.assertAllEqual([[0, i] for i in range(12)], out.indices)
+      self.assertAllEqual([single.values[0] for single in singles],
+                          out.values)
+
   def _assert_sparse_tensor_empty(self, sp):
     self.assertEquals(0, sp.indices.size)
     self.assertEquals(0, sp.values.size)
@@ -241,6 +241,20 @@ class SparseTensorDenseMatMulTestBase(test.TestCase):
     self._testLarge(np.complex64)
     self._testLarge(np.complex128)
 
+  # Tests products with enough nonzeros to be sharded across threads on CPU.
+  @test_util.run_deprecated_v1
+  def testShardedLarge(self):
+    np.random.seed(127)  # Repeatable results
+    for np_dtype in [np.float32, np.float64, np.complex64]:
+      x = _maybe_complex(np.random.rand(300, 400).astype(np_dtype))
+      x[np.abs(x) < 0.5] = 0  # Make it sparse
+      y = _maybe_complex(np.random.randn(400, 64).astype(np_dtype))
+      self._testMatmul(x, y, adjoint_a=False, adjoint_b=False)
+      self._testMatmul(x.transpose(), y, adjoint_a=True, adjoint_b=False)
+      self._testMatmul(x, y.transpose(), adjoint_a=False, adjoint_b=True)
+      self._testMatmul(
+          x.transpose(), y.transpose(), adjoint_a=True, adjoint_b=True)
+
   # Tests random sized matrices.
   @test_util.run_deprecated_v1
   def testFloatRandom(self):
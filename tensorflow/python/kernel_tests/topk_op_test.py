@@ -153,6 +153,17 @@ class TopKTest(test.TestCase):
     self._testMediumTopK(np.float32)
     self._testMediumTopK(np.float16)
 
+  def testLongRowTopK(self):
+    # A couple of long rows, so that each row is split across threads.
+    b = 2
+    n = 200000
+    k = 1000
+    inputs = np.random.randint(0, 50000, size=(b, n)).astype(np.float32)
+    indices = np.argsort(-inputs, axis=1, kind="mergesort")[:, :k]
+    values = -np.sort(-inputs, axis=1)[:, :k]
+    self._validateTopK(inputs, k, values, indices)
+    self._validateTopK(inputs, k, values, indices, sorted=False)
+
   def testStableSort(self):
     b = 5
     n = 500